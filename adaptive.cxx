@@ -0,0 +1,497 @@
+// Title   : adaptive.cxx
+// Purpose : Adaptive short-circuit evaluator subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Operands are ranked by cost / P(decides), the classic ordering for a
+// conjunction or disjunction of independent tests: an operand that is
+// cheap and usually decides the answer goes first. Counts are smoothed
+// (add one decision in two evaluations) so that an operand which has not
+// yet decided anything is not ranked as infinitely expensive.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <algorithm>      // stable_sort
+#include <chrono>         // Operand timing
+#include <mutex>          // Chain numbering lock
+#include <string>         // Standard C++ strings library
+#include <vector>         // Standard C++ vector library
+#include "adaptive.h"     // header for adaptive.cxx
+
+
+
+// Held while an evaluator finds its chains, so a tree's chain numbers are
+// written by the first evaluator built on it before any other reads them,
+// as the workers of a parallel run build theirs at once.
+static mutex numbering;
+
+
+
+//***************************************************************************
+//Chain discovery subprograms.
+//***************************************************************************
+
+static bool pureFactor(Factor *fact);              // *In* Factor
+
+static bool pureExpression(Expression *expr)       // *In* Expression
+{ // An expression is pure if it contains no / or % operator.
+
+  BasicExp *bexp = NULL;                          // Basic expression
+  Term     *term = NULL;                          // Term
+
+  for (int i = 0; i < 2; i++)
+  {
+    bexp = (i == 0) ? expr->be1 : expr->be2;
+    for (; bexp != NULL; bexp = bexp->bexp)
+    {
+      for (term = bexp->term; term != NULL; term = term->term)
+      {
+        if (!pureFactor(term->fact))
+          return false;
+        if (term->term != NULL &&
+          (term->mulOp == "/" || term->mulOp == "%"))
+          return false;
+      }
+    }
+  }
+
+  return true;
+} // pureExpression
+
+
+
+static bool pureFactor(Factor *fact)               // *In* Factor
+{ // Literals and identifiers are pure; otherwise look inside.
+
+  if (fact->bExp != NULL)
+    return pureExpression(fact->bExp);
+  if (fact->nFactor != NULL)
+    return pureFactor(fact->nFactor);
+
+  return true;
+} // pureFactor
+
+
+
+static bool pureTerm(Term *term)                   // *In* Term
+{ // A single operand of a || chain is a whole term list.
+
+  for (; term != NULL; term = term->term)
+  {
+    if (!pureFactor(term->fact))
+      return false;
+    if (term->term != NULL && (term->mulOp == "/" || term->mulOp == "%"))
+      return false;
+  }
+
+  return true;
+} // pureTerm
+
+
+
+AdaptiveEvaluator::AdaptiveEvaluator(AST *a,       // *In* Abs syntax tree
+  int sample,                                      // *In* Profiling period
+  int reorder)                                     // *In* Reorder period
+{ // Records every chain so evaluation can find it by its head node's
+  // chain number.
+
+  ast = a;
+  sampleEvery = (sample < 1) ? 1 : sample;
+  reorderInterval = (reorder < 1) ? 1 : reorder;
+  clearCounters(counters);
+  estimated = 0.0;
+
+  if (ast != NULL && ast->expr != NULL)
+  {
+    lock_guard<mutex> guard(numbering);
+
+    findChains(ast->expr);
+  }
+} // AdaptiveEvaluator
+
+
+
+void AdaptiveEvaluator::findChains(Expression *expr) // *In* Expression
+{ // Both sides of a relational operator may hold chains.
+
+  findChains(expr->be1);
+  if (expr->be2 != NULL)
+    findChains(expr->be2);
+} // findChains
+
+
+
+void AdaptiveEvaluator::findChains(BasicExp *bexp) // *In* BasicExp
+{ // A BasicExp whose operator is || heads a chain of its terms. A chain
+  // shared by shareAST is found once, and so is everything inside it: its
+  // number is below the count found so far. The number is written only by
+  // the first evaluator, as others may be evaluating with it already.
+
+  BasicExp *node = NULL;                          // Chain member
+
+  if (bexp->chain >= 0 && bexp->chain < (int)chains.size())
+    return;
+
+  if (bexp->bexp != NULL && bexp->addOp == "||")
+  {
+    BoolChain chain;                              // New chain
+
+    chain.isAnd = false;
+    chain.evaluations = 0;
+    chain.reordered = false;
+    for (node = bexp; node != NULL; node = node->bexp)
+    {
+      ChainOperand op = { node->term, pureTerm(node->term), 0, 0, 0.0 };
+
+      chain.order.push_back((int)chain.ops.size());
+      chain.ops.push_back(op);
+    }
+    chain.expected = (double)chain.ops.size();
+    if (bexp->chain < 0)
+      bexp->chain = (int)chains.size();
+    chains.push_back(chain);
+  }
+
+  for (node = bexp; node != NULL; node = node->bexp)
+    findChains(node->term);
+} // findChains
+
+
+
+void AdaptiveEvaluator::findChains(Term *term)     // *In* Term
+{ // A Term whose operator is && heads a chain of its factors, found once
+  // as above.
+
+  Term *node = NULL;                              // Chain member
+
+  if (term->chain >= 0 && term->chain < (int)chains.size())
+    return;
+
+  if (term->term != NULL && term->mulOp == "&&")
+  {
+    BoolChain chain;                              // New chain
+
+    chain.isAnd = true;
+    chain.evaluations = 0;
+    chain.reordered = false;
+    for (node = term; node != NULL; node = node->term)
+    {
+      ChainOperand op = { node->fact, pureFactor(node->fact), 0, 0, 0.0 };
+
+      chain.order.push_back((int)chain.ops.size());
+      chain.ops.push_back(op);
+    }
+    chain.expected = (double)chain.ops.size();
+    if (term->chain < 0)
+      term->chain = (int)chains.size();
+    chains.push_back(chain);
+  }
+
+  for (node = term; node != NULL; node = node->term)
+    findChains(node->fact);
+} // findChains
+
+
+
+void AdaptiveEvaluator::findChains(Factor *fact)   // *In* Factor
+{ // Chains may be nested inside brackets and negations.
+
+  if (fact->bExp != NULL)
+    findChains(fact->bExp);
+  else if (fact->nFactor != NULL)
+    findChains(fact->nFactor);
+} // findChains
+
+//***************************************************************************
+//End of chain discovery subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Chain evaluation subprograms.
+//***************************************************************************
+
+void AdaptiveEvaluator::evalOperand(BoolChain &chain, // *In* Chain
+  int op,                                          // *In* Operand position
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // A && operand is a factor, a || operand is a whole term.
+
+  if (chain.isAnd)
+    evalFactor((Factor *)chain.ops[op].node, env, result);
+  else
+    evalTerm((Term *)chain.ops[op].node, env, result);
+} // evalOperand
+
+
+
+bool AdaptiveEvaluator::evalChain(BoolChain &chain, // *In-Out* Chain
+  const Value *env)                                // *In* Bindings
+{ // Runs the operands in the chain's current order until one decides.
+
+  Value     val;                                  // Operand value
+  int       n = (int)chain.order.size();          // Operand count
+  long long ran = 0;                              // Operands evaluated
+  bool      decided = false;                      // Answer found
+
+  chain.evaluations++;
+  counters.chains++;
+
+  if (chain.evaluations % sampleEvery == 0)
+    return sampleChain(chain, env);
+
+  for (int i = 0; i < n && !decided; i++)
+  {
+    evalOperand(chain, chain.order[i], env, val);
+    ran++;
+    decided = (val.boolVal != chain.isAnd);
+  }
+
+  counters.operands += ran;
+  if (chain.reordered)
+    estimated += chain.expected;
+  else
+    counters.sourceOrder += ran;
+
+  // A decisive && operand is false; a decisive || operand is true.
+  return decided ? !chain.isAnd : chain.isAnd;
+} // evalChain
+
+
+
+bool AdaptiveEvaluator::sampleChain(BoolChain &chain, // *In-Out* Chain
+  const Value *env)                                // *In* Bindings
+{ // Profiles the chain in source order. Pure operands all run so that each
+  // gets an unbiased decision rate. An impure operand only runs if source
+  // order would have reached it, so sampling never raises an error that
+  // plain evaluation would not.
+
+  chrono::steady_clock::time_point start;         // Operand start time
+  Value     val;                                  // Operand value
+  int       n = (int)chain.ops.size();            // Operand count
+  int       firstDecider = -1;                    // Source order decider
+  long long ran = 0;                              // Operands evaluated
+
+  counters.samples++;
+
+  for (int op = 0; op < n; op++)
+  {
+    ChainOperand &operand = chain.ops[op];
+
+    if (!operand.pure && firstDecider >= 0)
+      continue;
+
+    start = chrono::steady_clock::now();
+    evalOperand(chain, op, env, val);
+    operand.nanos += chrono::duration<double, nano>(
+      chrono::steady_clock::now() - start).count();
+    operand.evals++;
+    ran++;
+
+    if (val.boolVal != chain.isAnd)
+    {
+      operand.decides++;
+      if (firstDecider < 0)
+        firstDecider = op;
+    }
+  }
+
+  counters.operands += ran;
+  counters.sourceOrder += (firstDecider < 0) ? n : firstDecider + 1;
+
+  if ((chain.evaluations / sampleEvery) % reorderInterval == 0)
+    reorderChain(chain);
+
+  return (firstDecider >= 0) ? !chain.isAnd : chain.isAnd;
+} // sampleChain
+
+
+
+void AdaptiveEvaluator::reorderChain(BoolChain &chain) // *In-Out* Chain
+{ // Sorts each run of pure operands by cost per decision, leaving impure
+  // operands in place, and re-estimates the source order cost.
+
+  int         n = (int)chain.ops.size();          // Operand count
+  vector<int> order(chain.order);                 // Proposed order
+  double      reach = 1.0;                        // P(operand is reached)
+  int         start = 0;                          // Start of a pure run
+
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+
+  while (start < n)
+  {
+    int end = start;                              // End of the pure run
+
+    while (end < n && chain.ops[end].pure)
+      end++;
+
+    stable_sort(order.begin() + start, order.begin() + end,
+      [&chain](int a, int b)
+      {
+        const ChainOperand &x = chain.ops[a];
+        const ChainOperand &y = chain.ops[b];
+        double costX = (x.nanos + 1.0) / (x.evals + 1.0);
+        double costY = (y.nanos + 1.0) / (y.evals + 1.0);
+        double probX = (x.decides + 1.0) / (x.evals + 2.0);
+        double probY = (y.decides + 1.0) / (y.evals + 2.0);
+        return costX / probX < costY / probY;
+      });
+
+    start = end + 1;
+  }
+
+  if (order != chain.order)
+  {
+    chain.order = order;
+    chain.reordered = true;
+    counters.reorders++;
+  }
+
+  // Expected operands in source order, treating the operands as
+  // independent.
+  chain.expected = 0.0;
+  for (int i = 0; i < n; i++)
+  {
+    const ChainOperand &op = chain.ops[i];
+
+    chain.expected += reach;
+    if (op.evals > 0)
+      reach = reach * (1.0 - (double)op.decides / op.evals);
+  }
+} // reorderChain
+
+//***************************************************************************
+//End of chain evaluation subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Tree walk subprograms. These follow evaluator.cxx except that && and ||
+//chains go through evalChain.
+//***************************************************************************
+
+void AdaptiveEvaluator::evalFactor(Factor *fact,   // *In* Factor
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Evaluates a literal, an identifier, a bracketed expression or a
+  // negated factor.
+
+  if (fact->literal)
+    litToValue(fact, result);
+  else if (fact->ident != NULL)
+    result = env[fact->ident->slot];
+  else if (fact->bExp != NULL)
+    evalExpression(fact->bExp, env, result);
+  else if (fact->nFactor != NULL)
+  {
+    evalFactor(fact->nFactor, env, result);
+    result.boolVal = !result.boolVal;
+  }
+  else
+    throw RunReport(307);
+} // evalFactor
+
+
+
+void AdaptiveEvaluator::evalTerm(Term *term,       // *In* Term
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // An && chain is handed to evalChain; an int chain is folded left to
+  // right.
+
+  Value next;                                     // Next factor value
+
+  if (term->term != NULL && term->mulOp == "&&")
+  {
+    result.type = BOOLDATA;
+    result.boolVal = evalChain(chains[term->chain], env);
+    return;
+  }
+
+  evalFactor(term->fact, env, result);
+  while (term->term != NULL)
+  {
+    evalFactor(term->term->fact, env, next);
+    result.intVal = applyIntOp(term->mulOp, result.intVal, next.intVal);
+    term = term->term;
+  }
+} // evalTerm
+
+
+
+void AdaptiveEvaluator::evalBasicExp(BasicExp *bexp, // *In* BasicExp
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // A || chain is handed to evalChain; an int chain is folded left to
+  // right.
+
+  Value next;                                     // Next term value
+
+  if (bexp->bexp != NULL && bexp->addOp == "||")
+  {
+    result.type = BOOLDATA;
+    result.boolVal = evalChain(chains[bexp->chain], env);
+    return;
+  }
+
+  evalTerm(bexp->term, env, result);
+  while (bexp->bexp != NULL)
+  {
+    evalTerm(bexp->bexp->term, env, next);
+    result.intVal = applyIntOp(bexp->addOp, result.intVal, next.intVal);
+    bexp = bexp->bexp;
+  }
+} // evalBasicExp
+
+
+
+void AdaptiveEvaluator::evalExpression(Expression *expr, // *In* Expression
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Evaluates be1 and compares it with be2 if there is a relational
+  // operator.
+
+  Value right;                                    // Second basic exp
+
+  evalBasicExp(expr->be1, env, result);
+
+  if (expr->be2 != NULL)
+  {
+    evalBasicExp(expr->be2, env, right);
+    result.boolVal = compareValues(expr->relOp, result, right);
+    result.type = BOOLDATA;
+  }
+} // evalExpression
+
+//***************************************************************************
+//End of tree walk subprograms.
+//***************************************************************************
+
+
+
+void AdaptiveEvaluator::evalRow(const Value *env,  // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // An SCL program has a single expression.
+
+  if (ast == NULL || ast->expr == NULL)
+    throw RunReport(307);
+
+  evalExpression(ast->expr, env, result);
+} // evalRow
+
+
+
+void AdaptiveEvaluator::addCounters(EvalCounters &total) // *In-Out* Totals
+{ // Adds this evaluator's counters to the totals.
+
+  total.chains += counters.chains;
+  total.operands += counters.operands;
+  total.sourceOrder += counters.sourceOrder + (long long)(estimated + 0.5);
+  total.samples += counters.samples;
+  total.reorders += counters.reorders;
+} // addCounters
@@ -0,0 +1,119 @@
+// Title   : adaptive.h
+// Purpose : Adaptive short-circuit evaluator header file for SCL. Reorders
+//           the operands of && and || chains at runtime.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard vector library and the evaluator header file for the
+// RowEvaluator class.
+#include <vector>          // Standard C++ vector library
+#include "evaluator.h"     // header for evaluator.cxx
+
+
+
+// A bool Term chain is all && and a bool BasicExp chain is all ||, and
+// both give the same answer whatever order their operands run in. What
+// changes is how many operands run before one decides the answer (false
+// for &&, true for ||). The adaptive evaluator profiles each operand's
+// cost and how often it decides the chain, and after every
+// reorderInterval profiled evaluations of a chain sorts its operands by
+// cost per decision.
+//
+// Each chain is numbered in the order the constructor finds it, and the
+// number is kept in its head node (Term::chain or BasicExp::chain), so
+// evaluation goes straight from the node to its chain. The walk is the
+// same for every evaluator of a tree, so the first one built numbers the
+// chains and the rest find the same numbers there.
+//
+// An operand holding a / or % can raise a runtime error, so it must run
+// exactly when source order would run it. Such operands stay where they
+// are and act as barriers: only the side effect free operands between two
+// barriers are reordered among themselves.
+
+// One operand of a chain and its profile. node is the Factor of a Term
+// chain or the Term of a BasicExp chain.
+struct ChainOperand                                // Chain operand
+{
+  void      *node;                                // Factor or Term
+  bool      pure;                                 // Cannot raise errors
+  long long evals;                                // Profiled evaluations
+  long long decides;                              // Times it decided
+  double    nanos;                                // Profiled time
+}; // ChainOperand
+
+
+
+// An && or || chain. order lists operand positions in evaluation order.
+// expected is the estimated operand count per evaluation in source order,
+// worked out from the profile at the last reorder.
+struct BoolChain                                   // && or || chain
+{
+  bool                 isAnd;                     // && chain, else ||
+  vector<ChainOperand> ops;                       // Source order operands
+  vector<int>          order;                     // Evaluation order
+  long long            evaluations;               // Chain evaluations
+  bool                 reordered;                 // Order ever changed
+  double               expected;                  // Source order estimate
+}; // BoolChain
+
+
+
+// The adaptive row evaluator. Evaluates like evalAST except for && and ||
+// chains of two or more operands. One in every sampleEvery evaluations
+// of a chain runs every operand that source order would allow, timing
+// each, to build the profile.
+class AdaptiveEvaluator : public RowEvaluator      // ADAPTIVEEVAL evaluator
+{
+private:
+  // Data members.
+  AST                            *ast;            // Program
+  vector<BoolChain>              chains;          // Chains, by number
+  EvalCounters                   counters;        // Work counters
+  double                         estimated;       // Reordered source cost
+  int                            sampleEvery;     // Profiling period
+  int                            reorderInterval; // Reordering period
+
+  // Tree walk.
+  void findChains(Expression *expr);
+  void findChains(BasicExp *bexp);
+  void findChains(Term *term);
+  void findChains(Factor *fact);
+  void evalExpression(Expression *expr, const Value *env, Value &result);
+  void evalBasicExp(BasicExp *bexp, const Value *env, Value &result);
+  void evalTerm(Term *term, const Value *env, Value &result);
+  void evalFactor(Factor *fact, const Value *env, Value &result);
+
+  // Chain evaluation.
+  void evalOperand(BoolChain &chain, int op, const Value *env,
+    Value &result);
+  bool evalChain(BoolChain &chain, const Value *env);
+  bool sampleChain(BoolChain &chain, const Value *env);
+  void reorderChain(BoolChain &chain);
+public:
+  // Class constructor. Finds the chains in ast.
+  AdaptiveEvaluator(AST *a,                        // *In* Abs syntax tree
+    int sample = 32,                               // *In* Profiling period
+    int reorder = 64);                             // *In* Reorder period
+
+  void evalRow(const Value *env,                   // *In* Bindings
+    Value &result);                                // *Out* Result
+
+  void addCounters(EvalCounters &total);           // *In-Out* Totals
+
+  // Accessor methods.
+  const vector<BoolChain> &getChains()
+  {
+    return chains;
+  }
+}; // class AdaptiveEvaluator
+
+
+#endif
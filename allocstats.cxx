@@ -0,0 +1,205 @@
+// Title   : allocstats.cxx
+// Purpose : Allocation statistics subprograms for SCL, and the replacement
+//           global operator new and delete that count them.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Only the single object forms of new and delete are replaced, plain and
+// over-aligned (for types such as LexPipe that are alignas a cache line).
+// The array and nothrow forms of each call them, so their allocations are
+// counted too, and the counts are made before the memory is asked for so
+// a throwing new is still counted.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <new>           // bad_alloc, get_new_handler
+#include <ostream>       // Standard output streams
+#include <stdlib.h>      // malloc, aligned_alloc, free
+#include <string.h>      // memset
+#include "allocstats.h"  // header for allocstats.cxx
+
+
+
+thread_local AllocStats allocStats;                // This thread's counts
+thread_local bool       allocCounting = false;     // Allocations counted
+thread_local int        allocSite = ALLOCOTHER;    // Site being charged
+
+
+
+// Names of the sites, in enum order.
+static const char *siteNames[ALLOCSITES] = {
+  "tokens", "nodes", "symbols", "reports", "other"
+};
+
+
+
+static inline void countAlloc(size_t size)         // *In* Bytes asked for
+{ // Charges one allocation of size to the phase and site, if counting.
+
+  if (allocCounting)
+  {
+    int row = statsPhase >= 0 ? statsPhase : PHASES; // Phase charged
+
+    allocStats.allocs[row][allocSite]++;
+    allocStats.bytes[row][allocSite] += size;
+  }
+} // countAlloc
+
+
+
+static void newHandled()
+{ // Called when an allocation fails: the new handler may free memory,
+  // and without one the new throws, as the standard new does.
+
+  new_handler handler = get_new_handler();        // Frees memory if set
+
+  if (handler == NULL)
+    throw bad_alloc();
+  handler();
+} // newHandled
+
+
+
+void *operator new(size_t size)                    // *In* Bytes asked for
+{ // Counts the allocation, then allocates as the standard new does: the
+  // new handler is called until malloc succeeds or there is none.
+
+  void *block;                                    // Memory allocated
+
+  countAlloc(size);
+  if (size == 0)
+    size = 1;
+  while ((block = malloc(size)) == NULL)
+    newHandled();
+  return block;
+} // operator new
+
+void *operator new(size_t size,                    // *In* Bytes asked for
+  align_val_t align)                               // *In* Alignment
+{ // As above, with aligned_alloc, whose size must be a multiple of the
+  // alignment.
+
+  size_t alignment = (size_t)align;               // Alignment in bytes
+  void   *block;                                  // Memory allocated
+
+  countAlloc(size);
+  if (size == 0)
+    size = 1;
+  size = (size + alignment - 1) & ~(alignment - 1);
+  while ((block = aligned_alloc(alignment, size)) == NULL)
+    newHandled();
+  return block;
+} // operator new
+
+void operator delete(void *block) noexcept         // *In* Memory freed
+{
+  free(block);
+} // operator delete
+
+void operator delete(void *block,                  // *In* Memory freed
+  size_t) noexcept                                 // *In* Its size
+{
+  free(block);
+} // operator delete
+
+void operator delete(void *block,                  // *In* Memory freed
+  align_val_t) noexcept                            // *In* Alignment
+{
+  free(block);
+} // operator delete
+
+void operator delete(void *block,                  // *In* Memory freed
+  size_t,                                          // *In* Its size
+  align_val_t) noexcept                            // *In* Alignment
+{
+  free(block);
+} // operator delete
+
+
+
+void clearAllocStats(bool counting)                // *In* Count allocations
+{ // Allocations made before this are not counted.
+
+  memset(&allocStats, 0, sizeof allocStats);
+  allocCounting = counting;
+} // clearAllocStats
+
+
+
+void addAllocStats(const AllocStats &allocs)       // *In* Counts added
+{ // Each count, the no phase row included, is added to its own.
+
+  for (int p = 0; p <= PHASES; p++)
+    for (int s = 0; s < ALLOCSITES; s++)
+    {
+      allocStats.allocs[p][s] += allocs.allocs[p][s];
+      allocStats.bytes[p][s] += allocs.bytes[p][s];
+    }
+} // addAllocStats
+
+
+
+const AllocStats &getAllocStats()
+{ // This thread's allocation counts.
+
+  return allocStats;
+} // getAllocStats
+
+
+
+static void allocTable(ostream &out,               // *In-Out* Report
+  const long long counts[PHASES + 1][ALLOCSITES],  // *In* Counts
+  const char *title,                               // *In* Table title
+  long long bytesRead)                             // *In* Source bytes
+{ // One row per phase with a column per site, the phase's total and the
+  // total per source byte. The per byte column is left out if nothing was
+  // read.
+
+  long long total[ALLOCSITES + 1] = {0};          // Column totals
+
+  out << title;
+  for (int s = 0; s < ALLOCSITES; s++)
+    out << '\t' << siteNames[s];
+  out << "\ttotal";
+  if (bytesRead > 0)
+    out << "\tper byte";
+  out << '\n';
+
+  for (int p = 0; p <= PHASES; p++)
+  {
+    long long row = 0;                            // Phase total
+
+    out << (p < PHASES ? phaseNames[p] : "none");
+    for (int s = 0; s < ALLOCSITES; s++)
+    {
+      out << '\t' << counts[p][s];
+      row += counts[p][s];
+      total[s] += counts[p][s];
+    }
+    out << '\t' << row;
+    if (bytesRead > 0)
+      out << '\t' << (double)row / bytesRead;
+    out << '\n';
+    total[ALLOCSITES] += row;
+  }
+
+  out << "total";
+  for (int s = 0; s <= ALLOCSITES; s++)
+    out << '\t' << total[s];
+  if (bytesRead > 0)
+    out << '\t' << (double)total[ALLOCSITES] / bytesRead;
+  out << '\n';
+} // allocTable
+
+
+
+void reportAllocs(ostream &out,                    // *In-Out* Report
+  const AllocStats &allocs,                        // *In* Allocations
+  long long bytesRead)                             // *In* Source bytes
+{ // The allocations table, then the bytes table.
+
+  allocTable(out, allocs.allocs, "Allocs", bytesRead);
+  allocTable(out, allocs.bytes, "Bytes", bytesRead);
+} // reportAllocs
@@ -0,0 +1,98 @@
+// Title   : allocstats.h
+// Purpose : Allocation statistics header file for SCL. Counts the heap
+//           allocations of a compile per phase and per call site.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream library and the stats header file for the
+// phases allocations are charged to.
+#include <ostream>         // Standard output streams
+#include "stats.h"         // header for stats.cxx
+
+
+
+// The kinds of call site an allocation is charged to. Token strings are
+// everything lexAnal allocates, AST nodes everything the expression parse
+// allocates outside lexAnal (the nodes and the strings copied into them),
+// symbols everything synDec allocates outside lexAnal and reports the
+// copies a Report and its handler make. The rest is other.
+enum AllocSite {
+  ALLOCTOKEN,                                      // Token strings
+  ALLOCNODE,                                       // AST nodes
+  ALLOCSYMBOL,                                     // Symbol table
+  ALLOCREPORT,                                     // Error reports
+  ALLOCOTHER,                                      // Anything else
+  ALLOCSITES
+}; // AllocSite
+
+
+
+// Allocations counted on one thread since clearAllocStats, by phase and by
+// site. Row PHASES holds the allocations made in no phase.
+struct AllocStats                                  // Allocation statistics
+{
+  long long allocs[PHASES + 1][ALLOCSITES];       // Allocations made
+  long long bytes[PHASES + 1][ALLOCSITES];        // Bytes asked for
+}; // AllocStats
+
+
+
+// The counts are per thread, like the compile statistics. Every operator
+// new in the program is replaced, the over-aligned forms included, so a
+// LexPipe or anything else alignas a cache line is counted. It only counts
+// on threads where allocCounting is set, so other threads pay a test.
+// Allocations are charged to statsPhase, which is only kept while phases
+// are being timed (see clearCompileStats), and to allocSite.
+extern thread_local AllocStats allocStats;
+extern thread_local bool       allocCounting;
+extern thread_local int        allocSite;
+
+
+
+// An AllocScope charges the allocations made until it is destroyed to
+// site, then restores the site that was being charged.
+class AllocScope                                   // Scoped call site
+{
+private:
+  int outer;                                      // Site restored
+public:
+  // Class constructor and destructor.
+  AllocScope(AllocSite site)                       // *In* Site entered
+  {
+    outer = allocSite;
+    allocSite = site;
+  }
+  ~AllocScope()
+  {
+    allocSite = outer;
+  }
+}; // class AllocScope
+
+
+
+// clearAllocStats zeroes this thread's allocation counts and turns the
+// counting on or off.
+void clearAllocStats(bool counting);               // *In* Count allocations
+
+// addAllocStats adds allocs, counted on another thread, to this thread's.
+void addAllocStats(const AllocStats &allocs);      // *In* Counts added
+
+// getAllocStats returns this thread's allocation counts.
+const AllocStats &getAllocStats();
+
+// reportAllocs writes the allocations and bytes of each phase by site,
+// with each phase's allocations and bytes per source byte read.
+void reportAllocs(ostream &out,                    // *In-Out* Report
+  const AllocStats &allocs,                        // *In* Allocations
+  long long bytesRead);                            // *In* Source bytes
+
+
+#endif
@@ -0,0 +1,796 @@
+// Title   : astimage.cxx
+// Purpose : Binary image subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// writeImage collects the records in vectors and the strings in a pool and
+// writes the whole image with one write. Lists (Term and BasicExp chains)
+// are walked with loops rather than recursion so a long chain cannot run
+// out of stack; only brackets and ! recurse.
+//
+// mapImage does all the checking up front. Apart from range checks on
+// every index it walks the image once from its roots, marking records in
+// progress, so that an image with a cycle in it is rejected rather than
+// sending the printers round forever.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>         // Standard file I/O
+#include <sstream>         // String streams for verifyImage
+#include <string>          // Standard C++ strings library
+#include <string.h>        // memcmp, memcpy
+#include <unordered_map>   // Node and string indices
+#include <vector>          // Standard C++ vector library
+#include "astimage.h"      // header for astimage.cxx
+
+
+
+// Records collected by writeImage. nodeIndex maps each node already
+// written to its index so that shared nodes are written once.
+struct ImageWriter                                 // Image being built
+{
+  vector<ImageSymbol>                   symbols;     // SymTab entries
+  vector<int32_t>                       statements;  // AST entries
+  vector<ImageExpression>               expressions; // Expressions
+  vector<ImageBasicExp>                 basicExps;   // Basic expressions
+  vector<ImageTerm>                     terms;       // Terms
+  vector<ImageFactor>                   factors;     // Factors
+  string                                strings;     // String pool
+  unordered_map<const void *, int32_t>  nodeIndex;   // Node to index
+  unordered_map<string, ImageString>    pooled;      // String to offset
+}; // ImageWriter
+
+
+
+//***************************************************************************
+//Image writing subprograms.
+//***************************************************************************
+
+static ImageString addString(ImageWriter &w,       // *In-Out* Image
+  const string &s)                                 // *In* String
+{ // Operators repeat throughout the tree, so each distinct string is
+  // pooled once.
+
+  unordered_map<string, ImageString>::iterator found = w.pooled.find(s);
+  ImageString offset = (ImageString)w.strings.size(); // New string
+  uint32_t    length = (uint32_t)s.size();        // Length prefix
+
+  if (found != w.pooled.end())
+    return found->second;
+
+  w.strings.append((const char *)&length, sizeof length);
+  w.strings.append(s);
+  w.pooled[s] = offset;
+  return offset;
+} // addString
+
+
+
+static int32_t addFactor(ImageWriter &w,           // *In-Out* Image
+  Factor *fact);                                   // *In* Factor
+
+static int32_t addExpression(ImageWriter &w,       // *In-Out* Image
+  Expression *expr);                               // *In* Expression
+
+
+
+static int32_t addTerm(ImageWriter &w,             // *In-Out* Image
+  Term *term)                                      // *In* Term list
+{ // Writes the list link by link, pointing each link at the next. A link
+  // that has been written before ends the walk.
+
+  int32_t first = imageNone;                      // First link's index
+  int32_t prev = imageNone;                       // Last link written
+
+  for (; term != NULL; term = term->term)
+  {
+    unordered_map<const void *, int32_t>::iterator found =
+      w.nodeIndex.find(term);
+    ImageTerm rec;                                // New record
+    int32_t   index = 0;                          // Its index
+
+    if (found != w.nodeIndex.end())
+    {
+      index = found->second;
+      if (prev == imageNone)
+        first = index;
+      else
+        w.terms[prev].term = index;
+      break;
+    }
+
+    rec.fact = addFactor(w, term->fact);
+    rec.mulOp = addString(w, term->mulOp);
+    rec.term = imageNone;
+    index = (int32_t)w.terms.size();
+    w.terms.push_back(rec);
+    w.nodeIndex[term] = index;
+
+    if (prev == imageNone)
+      first = index;
+    else
+      w.terms[prev].term = index;
+    prev = index;
+  }
+  return first;
+} // addTerm
+
+
+
+static int32_t addBasicExp(ImageWriter &w,         // *In-Out* Image
+  BasicExp *bexp)                                  // *In* BasicExp list
+{ // As addTerm.
+
+  int32_t first = imageNone;                      // First link's index
+  int32_t prev = imageNone;                       // Last link written
+
+  for (; bexp != NULL; bexp = bexp->bexp)
+  {
+    unordered_map<const void *, int32_t>::iterator found =
+      w.nodeIndex.find(bexp);
+    ImageBasicExp rec;                            // New record
+    int32_t       index = 0;                      // Its index
+
+    if (found != w.nodeIndex.end())
+    {
+      index = found->second;
+      if (prev == imageNone)
+        first = index;
+      else
+        w.basicExps[prev].bexp = index;
+      break;
+    }
+
+    rec.term = addTerm(w, bexp->term);
+    rec.addOp = addString(w, bexp->addOp);
+    rec.bexp = imageNone;
+    index = (int32_t)w.basicExps.size();
+    w.basicExps.push_back(rec);
+    w.nodeIndex[bexp] = index;
+
+    if (prev == imageNone)
+      first = index;
+    else
+      w.basicExps[prev].bexp = index;
+    prev = index;
+  }
+  return first;
+} // addBasicExp
+
+
+
+static int32_t addExpression(ImageWriter &w,       // *In-Out* Image
+  Expression *expr)                                // *In* Expression
+{ // Writes the two basic expressions and then the expression.
+
+  unordered_map<const void *, int32_t>::iterator found =
+    w.nodeIndex.find(expr);
+  ImageExpression rec;                            // New record
+  int32_t         index = 0;                      // Its index
+
+  if (found != w.nodeIndex.end())
+    return found->second;
+
+  rec.be1 = addBasicExp(w, expr->be1);
+  rec.relOp = addString(w, expr->relOp);
+  rec.be2 = addBasicExp(w, expr->be2);
+  index = (int32_t)w.expressions.size();
+  w.expressions.push_back(rec);
+  w.nodeIndex[expr] = index;
+  return index;
+} // addExpression
+
+
+
+static int32_t addFactor(ImageWriter &w,           // *In-Out* Image
+  Factor *fact)                                    // *In* Factor
+{ // Identifiers become symbol indices; brackets and ! write their
+  // children first.
+
+  unordered_map<const void *, int32_t>::iterator found;
+  ImageFactor rec;                                // New record
+  int32_t     index = 0;                          // Its index
+
+  if (fact == NULL)
+    return imageNone;
+
+  found = w.nodeIndex.find(fact);
+  if (found != w.nodeIndex.end())
+    return found->second;
+
+  rec.literal = fact->literal ? 1 : 0;
+  rec.type = fact->type;
+  rec.litBool = addString(w, fact->litBool);
+  rec.litString = addString(w, fact->litString);
+  rec.litInt = fact->literal ? fact->litInt : 0;
+  rec.litFloat = addString(w, fact->litFloat);
+  rec.ident = imageNone;
+  rec.bExp = imageNone;
+  rec.nFactor = imageNone;
+
+  if (!fact->literal)
+  {
+    if (fact->ident != NULL)
+      rec.ident = w.nodeIndex[fact->ident];
+    else if (fact->bExp != NULL)
+      rec.bExp = addExpression(w, fact->bExp);
+    else if (fact->nFactor != NULL)
+      rec.nFactor = addFactor(w, fact->nFactor);
+  }
+
+  index = (int32_t)w.factors.size();
+  w.factors.push_back(rec);
+  w.nodeIndex[fact] = index;
+  return index;
+} // addFactor
+
+
+
+template <class T>
+static void appendSection(string &image,           // *In-Out* Image bytes
+  ImageHeader &header,                             // *In-Out* Header
+  ImageSection section,                            // *In* Section
+  const T *records,                                // *In* Records
+  size_t count,                                    // *In* Record count
+  size_t bytes)                                    // *In* Section bytes
+{ // Pads the image to 8 bytes and appends a section.
+
+  image.resize((image.size() + 7) & ~(size_t)7, '\0');
+  header.count[section] = (uint32_t)count;
+  header.offset[section] = (uint32_t)image.size();
+  if (bytes > 0)
+    image.append((const char *)records, bytes);
+} // appendSection
+
+//***************************************************************************
+//End of image writing subprograms.
+//***************************************************************************
+
+
+
+bool writeImage(const char *path,                  // *In* Image file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Symbols are numbered first so that identifier factors, including
+  // those in initialisers, can refer to them.
+
+  ImageWriter w;                                  // Records collected
+  ImageHeader header;                             // File header
+  string      image;                              // Image bytes
+  ofstream    outFile;                            // Image file
+  int32_t     n = 0;                              // Symbol number
+  SymTab      *entry = NULL;                      // Symbol walked
+
+  for (entry = st; entry != NULL; entry = entry->next)
+    w.nodeIndex[entry] = n++;
+
+  for (entry = st; entry != NULL; entry = entry->next)
+  {
+    ImageSymbol rec;                              // New record
+
+    rec.ident = addString(w, entry->ident);
+    rec.type = entry->type;
+    rec.initialise = addFactor(w, entry->initialise);
+    rec.slot = entry->slot;
+    w.symbols.push_back(rec);
+  }
+
+  for (; ast != NULL; ast = ast->next)
+    if (ast->expr != NULL)
+      w.statements.push_back(addExpression(w, ast->expr));
+
+  memset(&header, 0, sizeof header);
+  memcpy(header.magic, imageMagic, sizeof header.magic);
+  header.version = imageVersion;
+  header.byteOrder = imageByteOrder;
+  image.assign(sizeof header, '\0');
+
+  appendSection(image, header, IMGSYMBOLS, w.symbols.data(),
+    w.symbols.size(), w.symbols.size() * sizeof(ImageSymbol));
+  appendSection(image, header, IMGSTATEMENTS, w.statements.data(),
+    w.statements.size(), w.statements.size() * sizeof(int32_t));
+  appendSection(image, header, IMGEXPRESSIONS, w.expressions.data(),
+    w.expressions.size(), w.expressions.size() * sizeof(ImageExpression));
+  appendSection(image, header, IMGBASICEXPS, w.basicExps.data(),
+    w.basicExps.size(), w.basicExps.size() * sizeof(ImageBasicExp));
+  appendSection(image, header, IMGTERMS, w.terms.data(),
+    w.terms.size(), w.terms.size() * sizeof(ImageTerm));
+  appendSection(image, header, IMGFACTORS, w.factors.data(),
+    w.factors.size(), w.factors.size() * sizeof(ImageFactor));
+  appendSection(image, header, IMGSTRINGS, w.strings.data(),
+    w.strings.size(), w.strings.size());
+
+  if (image.size() > 0xFFFFFFFFull)
+    return false;
+  header.size = (uint32_t)image.size();
+  memcpy(&image[0], &header, sizeof header);
+
+  outFile.open(path, ios::binary);
+  if (!outFile)
+    return false;
+  outFile.write(image.data(), image.size());
+  outFile.close();
+  return !outFile.fail();
+} // writeImage
+
+
+
+//***************************************************************************
+//Image checking subprograms.
+//***************************************************************************
+
+static bool validString(const AstImage &image,     // *In* Mapped image
+  ImageString s)                                   // *In* String offset
+{ // The length prefix and the bytes must both lie inside the pool.
+
+  uint32_t pool = image.header->count[IMGSTRINGS]; // Pool bytes
+  uint32_t length = 0;                            // Length prefix
+
+  if (pool < sizeof length || s > pool - sizeof length)
+    return false;
+  memcpy(&length, image.strings + s, sizeof length);
+  return length <= pool - sizeof length - s;
+} // validString
+
+
+
+static bool validIndex(int32_t index,              // *In* Index
+  uint32_t count,                                  // *In* Section records
+  bool optional)                                   // *In* imageNone allowed
+{ // True if index names a record of a section of count records.
+
+  if (index == imageNone)
+    return optional;
+  return index >= 0 && (uint32_t)index < count;
+} // validIndex
+
+
+
+static bool validType(int32_t type)                // *In* DataType
+{ // Only the four SCL types appear in a parsed program, except that
+  // synFactor leaves VOIDDATA on factors whose type it does not record.
+
+  return type >= VOIDDATA && type <= FLOATDATA;
+} // validType
+
+
+
+static bool checkRecords(const AstImage &image)    // *In* Mapped image
+{ // Range checks every field of every record.
+
+  const uint32_t *count = image.header->count;    // Section counts
+
+  for (uint32_t i = 0; i < count[IMGSYMBOLS]; i++)
+  {
+    const ImageSymbol &r = image.symbols[i];
+    if (!validString(image, r.ident) || !validType(r.type) ||
+      !validIndex(r.initialise, count[IMGFACTORS], true))
+      return false;
+  }
+  for (uint32_t i = 0; i < count[IMGSTATEMENTS]; i++)
+    if (!validIndex(image.statements[i], count[IMGEXPRESSIONS], false))
+      return false;
+  for (uint32_t i = 0; i < count[IMGEXPRESSIONS]; i++)
+  {
+    const ImageExpression &r = image.expressions[i];
+    if (!validIndex(r.be1, count[IMGBASICEXPS], false) ||
+      !validString(image, r.relOp) ||
+      !validIndex(r.be2, count[IMGBASICEXPS], true))
+      return false;
+  }
+  for (uint32_t i = 0; i < count[IMGBASICEXPS]; i++)
+  {
+    const ImageBasicExp &r = image.basicExps[i];
+    if (!validIndex(r.term, count[IMGTERMS], false) ||
+      !validString(image, r.addOp) ||
+      !validIndex(r.bexp, count[IMGBASICEXPS], true))
+      return false;
+  }
+  for (uint32_t i = 0; i < count[IMGTERMS]; i++)
+  {
+    const ImageTerm &r = image.terms[i];
+    if (!validIndex(r.fact, count[IMGFACTORS], false) ||
+      !validString(image, r.mulOp) ||
+      !validIndex(r.term, count[IMGTERMS], true))
+      return false;
+  }
+  for (uint32_t i = 0; i < count[IMGFACTORS]; i++)
+  {
+    const ImageFactor &r = image.factors[i];
+    if ((r.literal != 0 && r.literal != 1) || !validType(r.type) ||
+      !validString(image, r.litBool) || !validString(image, r.litString) ||
+      !validString(image, r.litFloat) ||
+      !validIndex(r.ident, count[IMGSYMBOLS], true) ||
+      !validIndex(r.bExp, count[IMGEXPRESSIONS], true) ||
+      !validIndex(r.nFactor, count[IMGFACTORS], true))
+      return false;
+  }
+  return true;
+} // checkRecords
+
+
+
+// A record during the cycle check: its section, its index and how many of
+// its children have been visited.
+struct ImageVisit                                  // DFS stack entry
+{
+  int     section;                                // ImageSection
+  int32_t index;                                  // Record index
+  int     child;                                  // Next child
+}; // ImageVisit
+
+
+
+static int imageChildren(const AstImage &image,    // *In* Mapped image
+  const ImageVisit &v,                             // *In* Record
+  ImageVisit child[2])                             // *Out* Children
+{ // The records v refers to, in the order the printers visit them.
+  // Returns how many there are.
+
+  int n = 0;                                      // Children found
+
+  switch (v.section)
+  {
+  case IMGSYMBOLS     : { const ImageSymbol &r = image.symbols[v.index];
+                          if (r.initialise != imageNone)
+                            child[n++] = { IMGFACTORS, r.initialise, 0 };
+                        }
+                        break;
+  case IMGSTATEMENTS  : child[n++] = { IMGEXPRESSIONS,
+                                       image.statements[v.index], 0 };
+                        break;
+  case IMGEXPRESSIONS : { const ImageExpression &r =
+                            image.expressions[v.index];
+                          child[n++] = { IMGBASICEXPS, r.be1, 0 };
+                          if (r.be2 != imageNone)
+                            child[n++] = { IMGBASICEXPS, r.be2, 0 };
+                        }
+                        break;
+  case IMGBASICEXPS   : { const ImageBasicExp &r = image.basicExps[v.index];
+                          child[n++] = { IMGTERMS, r.term, 0 };
+                          if (r.bexp != imageNone)
+                            child[n++] = { IMGBASICEXPS, r.bexp, 0 };
+                        }
+                        break;
+  case IMGTERMS       : { const ImageTerm &r = image.terms[v.index];
+                          child[n++] = { IMGFACTORS, r.fact, 0 };
+                          if (r.term != imageNone)
+                            child[n++] = { IMGTERMS, r.term, 0 };
+                        }
+                        break;
+  case IMGFACTORS     : { const ImageFactor &r = image.factors[v.index];
+                          if (r.ident != imageNone)
+                            child[n++] = { IMGSYMBOLS, r.ident, 0 };
+                          else if (r.bExp != imageNone)
+                            child[n++] = { IMGEXPRESSIONS, r.bExp, 0 };
+                          else if (r.nFactor != imageNone)
+                            child[n++] = { IMGFACTORS, r.nFactor, 0 };
+                        }
+                        break;
+  }
+  return n;
+} // imageChildren
+
+
+
+static bool checkAcyclic(const AstImage &image)    // *In* Mapped image
+{ // Depth first search from every symbol and statement with an explicit
+  // stack. A record met again while it is still on the stack closes a
+  // cycle. state is 0 for unvisited, 1 for on the stack and 2 for done.
+
+  vector<char>       state[IMGSTRINGS];           // Per record state
+  vector<ImageVisit> stack;                       // Records in progress
+
+  for (int s = 0; s < IMGSTRINGS; s++)
+    state[s].assign(image.header->count[s], 0);
+
+  for (int root = IMGSYMBOLS; root <= IMGSTATEMENTS; root++)
+    for (uint32_t i = 0; i < image.header->count[root]; i++)
+    {
+      if (state[root][i] != 0)
+        continue;
+      state[root][i] = 1;
+      stack.push_back({ root, (int32_t)i, 0 });
+
+      while (!stack.empty())
+      {
+        ImageVisit &top = stack.back();
+        ImageVisit child[2];                      // top's children
+        int        n = imageChildren(image, top, child);
+
+        if (top.child == n)
+        {
+          state[top.section][top.index] = 2;
+          stack.pop_back();
+          continue;
+        }
+
+        ImageVisit next = child[top.child++];     // Child to visit
+        char       &mark = state[next.section][next.index];
+
+        if (mark == 1)
+          return false;
+        if (mark == 0)
+        {
+          mark = 1;
+          stack.push_back(next);
+        }
+      }
+    }
+  return true;
+} // checkAcyclic
+
+//***************************************************************************
+//End of image checking subprograms.
+//***************************************************************************
+
+
+
+bool mapImage(const char *path,                    // *In* Image file name
+  AstImage &image)                                 // *Out* Mapped image
+{ // Checks the header, then the section bounds, then the records.
+
+  static const size_t recordSize[IMAGESECTIONS] = {
+    sizeof(ImageSymbol), sizeof(int32_t), sizeof(ImageExpression),
+    sizeof(ImageBasicExp), sizeof(ImageTerm), sizeof(ImageFactor), 1 };
+  const ImageHeader *header = NULL;               // Mapped header
+  const char        *base = NULL;                 // Mapped bytes
+  bool              valid = true;                 // Checks passed
+
+  memset(&image, 0, sizeof image);
+  if (!mapFile(path, image.file))
+    return false;
+
+  base = image.file.data;
+  header = (const ImageHeader *)base;
+  valid = image.file.size >= sizeof(ImageHeader) &&
+    memcmp(header->magic, imageMagic, sizeof header->magic) == 0 &&
+    header->version == imageVersion &&
+    header->byteOrder == imageByteOrder &&
+    header->size == image.file.size;
+
+  for (int s = 0; valid && s < IMAGESECTIONS; s++)
+    valid = header->offset[s] % 8 == 0 &&
+      header->offset[s] >= sizeof(ImageHeader) &&
+      (unsigned long long)header->offset[s] +
+      (unsigned long long)header->count[s] * recordSize[s] <= header->size;
+
+  if (valid)
+  {
+    image.header = header;
+    image.symbols = (const ImageSymbol *)(base + header->offset[IMGSYMBOLS]);
+    image.statements = (const int32_t *)(base +
+      header->offset[IMGSTATEMENTS]);
+    image.expressions = (const ImageExpression *)(base +
+      header->offset[IMGEXPRESSIONS]);
+    image.basicExps = (const ImageBasicExp *)(base +
+      header->offset[IMGBASICEXPS]);
+    image.terms = (const ImageTerm *)(base + header->offset[IMGTERMS]);
+    image.factors = (const ImageFactor *)(base + header->offset[IMGFACTORS]);
+    image.strings = base + header->offset[IMGSTRINGS];
+    valid = checkRecords(image) && checkAcyclic(image);
+  }
+
+  if (!valid)
+  {
+    unmapImage(image);
+    return false;
+  }
+  return true;
+} // mapImage
+
+
+
+void unmapImage(AstImage &image)                   // *In-Out* Mapped image
+{ // Unmaps and clears the image.
+
+  unmapFile(image.file);
+  memset(&image, 0, sizeof image);
+} // unmapImage
+
+
+
+string_view imageString(const AstImage &image,     // *In* Mapped image
+  ImageString s)                                   // *In* String offset
+{ // The length prefix may not be aligned, so it is copied out.
+
+  uint32_t length = 0;                            // Length prefix
+
+  memcpy(&length, image.strings + s, sizeof length);
+  return string_view(image.strings + s + sizeof length, length);
+} // imageString
+
+
+
+//***************************************************************************
+//Image output subprograms.
+//***************************************************************************
+
+static void printImageExpression(OutSink &outFile, // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  int32_t expr);                                   // *In* Expression
+
+
+
+static void printLiteral(OutSink &outFile,         // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  const ImageFactor &fact)                         // *In* Literal factor
+{ // The literal field for the factor's type, as printFactor prints it.
+
+  string_view text;                               // String literal
+
+  if (fact.type == BOOLDATA)
+    text = imageString(image, fact.litBool);
+  else if (fact.type == STRINGDATA)
+    text = imageString(image, fact.litString);
+  else if (fact.type == INTDATA)
+  {
+    outFile << fact.litInt;
+    return;
+  }
+  else if (fact.type == FLOATDATA)
+    text = imageString(image, fact.litFloat);
+  else
+    text = "Error : claimed literal is not a literal.\n";
+
+  outFile.write(text.data(), text.size());
+} // printLiteral
+
+
+
+static void printImageFactor(OutSink &outFile,     // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  int32_t index)                                   // *In* Factor
+{ // As printFactor.
+
+  const ImageFactor &fact = image.factors[index]; // Factor to print
+
+  if (fact.literal)
+    printLiteral(outFile, image, fact);
+  else if (fact.ident != imageNone)
+  {
+    string_view name = imageString(image, image.symbols[fact.ident].ident);
+    outFile.write(name.data(), name.size());
+  }
+  else if (fact.bExp != imageNone)
+  {
+    outFile << '(';
+    printImageExpression(outFile, image, fact.bExp);
+    outFile << ')';
+  }
+  else if (fact.nFactor != imageNone)
+  {
+    outFile << "!(";
+    printImageFactor(outFile, image, fact.nFactor);
+    outFile << ')';
+  }
+  else
+    outFile << "Error : empty factor.\n";
+} // printImageFactor
+
+
+
+static void printImageOp(OutSink &outFile,         // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  ImageString op)                                  // *In* Operator
+{ // An operator with a space either side.
+
+  string_view text = imageString(image, op);      // Operator text
+
+  outFile << ' ';
+  outFile.write(text.data(), text.size());
+  outFile << ' ';
+} // printImageOp
+
+
+
+static void printImageBasicExp(OutSink &outFile,   // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  int32_t bexp)                                    // *In* BasicExp list
+{ // As printBasicExp and printTerm, with loops for the lists.
+
+  for (; bexp != imageNone; bexp = image.basicExps[bexp].bexp)
+  {
+    for (int32_t term = image.basicExps[bexp].term; term != imageNone;
+      term = image.terms[term].term)
+    {
+      printImageFactor(outFile, image, image.terms[term].fact);
+      if (image.terms[term].term != imageNone)
+        printImageOp(outFile, image, image.terms[term].mulOp);
+    }
+    if (image.basicExps[bexp].bexp != imageNone)
+      printImageOp(outFile, image, image.basicExps[bexp].addOp);
+  }
+} // printImageBasicExp
+
+
+
+static void printImageExpression(OutSink &outFile, // *In-Out* Output sink
+  const AstImage &image,                           // *In* Mapped image
+  int32_t expr)                                    // *In* Expression
+{ // As printExpression.
+
+  const ImageExpression &e = image.expressions[expr]; // Expression
+
+  printImageBasicExp(outFile, image, e.be1);
+  if (e.be2 != imageNone)
+  {
+    printImageOp(outFile, image, e.relOp);
+    printImageBasicExp(outFile, image, e.be2);
+  }
+} // printImageExpression
+
+//***************************************************************************
+//End of image output subprograms.
+//***************************************************************************
+
+
+
+void printImageST(OutSink &outFile,                // *In-Out* Output sink
+  const AstImage &image)                           // *In* Mapped image
+{ // As printST.
+
+  static const char *types[] = { "", "\tbool", "\tstring", "\tint",
+                                 "\tfloat" };
+
+  outFile << "\n\nName\tType\tValue\n";
+  for (uint32_t i = 0; i < image.header->count[IMGSYMBOLS]; i++)
+  {
+    const ImageSymbol &sym = image.symbols[i];    // Entry to print
+    string_view       name = imageString(image, sym.ident);
+
+    outFile.write(name.data(), name.size());
+    outFile << types[sym.type];
+
+    if (sym.initialise != imageNone)
+    {
+      const ImageFactor &init = image.factors[sym.initialise];
+
+      if (init.type >= BOOLDATA)
+      {
+        outFile << '\t';
+        printLiteral(outFile, image, init);
+        outFile << '\n';
+      }
+    }
+    else
+      outFile << "\tNone\n";
+  }
+} // printImageST
+
+
+
+void printImageAST(OutSink &outFile,               // *In-Out* Output sink
+  const AstImage &image)                           // *In* Mapped image
+{ // As printAST.
+
+  for (uint32_t i = 0; i < image.header->count[IMGSTATEMENTS]; i++)
+    printImageExpression(outFile, image, image.statements[i]);
+} // printImageAST
+
+
+
+bool verifyImage(const AstImage &image,            // *In* Mapped image
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Prints both into strings and compares them.
+
+  ostringstream expected;                         // From st and ast
+  ostringstream actual;                           // From the image
+
+  {
+    OutSink sink(expected);
+    printST(sink, st);
+    sink << "\n\nExpression\n";
+    printAST(sink, ast);
+  }
+  {
+    OutSink sink(actual);
+    printImageST(sink, image);
+    sink << "\n\nExpression\n";
+    printImageAST(sink, image);
+  }
+  return expected.str() == actual.str();
+} // verifyImage
@@ -0,0 +1,172 @@
+// Title   : astimage.h
+// Purpose : Binary image header file for SCL. Saves a parsed program's
+//           SymTab and AST to a file that can be mapped and used in place.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef ASTIMAGE_H
+#define ASTIMAGE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the fixed width integer and string view libraries, the output
+// sink, syntax analysis and row binder header files (for MappedFile).
+#include <stdint.h>        // Fixed width integers
+#include <string_view>     // Views of image strings
+#include "outsink.h"       // header for outsink.cxx
+#include "syner.h"         // header for syner.cxx
+#include "csvbind.h"       // header for csvbind.cxx
+
+
+
+// An image holds the SymTab and AST of one program as flat arrays of fixed
+// size records, one array per kind of node, plus a pool of strings. Every
+// pointer in the tree becomes an index into the array for its kind, with
+// imageNone for NULL, and Factor::ident becomes the index of the symbol.
+// Symbols are stored in SymTab list order, so symbol 0 is the head. Nodes
+// that the tree shares are stored once.
+//
+// All fields are 32 bits or smaller and every section starts on an 8 byte
+// boundary, so once the header has been checked the arrays are used
+// straight from the mapped file with no copying and no allocation.
+// Images are written in the byte order of the machine that writes them;
+// mapImage rejects an image of the other byte order or another version.
+//
+//     header | symbols | statements | expressions | basic exps | terms |
+//     factors | strings
+
+const char     imageMagic[4] = { 'S', 'C', 'L', 'I' };
+const uint32_t imageVersion = 1;                   // Bumped on any change
+const uint32_t imageByteOrder = 0x01020304;        // As written
+const int32_t  imageNone = -1;                     // NULL index
+
+
+
+// The sections of an image, in file order.
+enum ImageSection {
+  IMGSYMBOLS, IMGSTATEMENTS, IMGEXPRESSIONS, IMGBASICEXPS, IMGTERMS,
+  IMGFACTORS, IMGSTRINGS, IMAGESECTIONS
+}; // ImageSection
+
+
+
+// count is the number of records in each section, or of bytes for the
+// string pool. offset is where each section starts in the file.
+struct ImageHeader                                 // File header
+{
+  char     magic[4];                              // imageMagic
+  uint32_t version;                               // imageVersion
+  uint32_t byteOrder;                             // imageByteOrder
+  uint32_t size;                                  // Whole file bytes
+  uint32_t count[IMAGESECTIONS];                  // Records per section
+  uint32_t offset[IMAGESECTIONS];                 // Section starts
+}; // ImageHeader
+
+
+
+// A string is the offset in the pool of a 32 bit length followed by that
+// many bytes.
+typedef uint32_t ImageString;                      // String pool offset
+
+struct ImageSymbol                                 // SymTab entry
+{
+  ImageString ident;                              // Var name
+  int32_t     type;                               // DataType
+  int32_t     initialise;                         // Factor or imageNone
+  int32_t     slot;                               // Declaration slot
+}; // ImageSymbol
+
+struct ImageExpression                             // Expression
+{
+  int32_t     be1;                                // First basic exp
+  ImageString relOp;                              // Relational operator
+  int32_t     be2;                                // Second or imageNone
+}; // ImageExpression
+
+struct ImageBasicExp                               // BasicExp
+{
+  int32_t     term;                               // First term
+  ImageString addOp;                              // Addition operator
+  int32_t     bexp;                               // Rest or imageNone
+}; // ImageBasicExp
+
+struct ImageTerm                                   // Term
+{
+  int32_t     fact;                               // First factor
+  ImageString mulOp;                              // Multiplicative op
+  int32_t     term;                               // Rest or imageNone
+}; // ImageTerm
+
+struct ImageFactor                                 // Factor
+{
+  int32_t     literal;                            // Tag field, 0 or 1
+  int32_t     type;                               // DataType
+  ImageString litBool;                            // Boolean literal
+  ImageString litString;                          // String literal
+  int32_t     litInt;                             // Integer literal
+  ImageString litFloat;                           // Float literal
+  int32_t     ident;                              // Symbol or imageNone
+  int32_t     bExp;                               // Expression or none
+  int32_t     nFactor;                            // Factor or imageNone
+}; // ImageFactor
+
+
+
+// A mapped image. The pointers are into the mapping and are valid until
+// unmapImage. Statements are expression indices, in AST list order.
+struct AstImage                                    // Mapped image
+{
+  MappedFile            file;                     // Mapping
+  const ImageHeader     *header;                  // File header
+  const ImageSymbol     *symbols;                 // SymTab entries
+  const int32_t         *statements;              // AST entries
+  const ImageExpression *expressions;             // Expressions
+  const ImageBasicExp   *basicExps;               // Basic expressions
+  const ImageTerm       *terms;                   // Terms
+  const ImageFactor     *factors;                 // Factors
+  const char            *strings;                 // String pool
+}; // AstImage
+
+
+
+// writeImage saves st and ast to the file at path. Returns false if the
+// file cannot be written.
+bool writeImage(const char *path,                  // *In* Image file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast);                                       // *In* Abs syntax tree
+
+// mapImage maps the image at path and checks its header, section bounds,
+// every index and every string reference, so that an image it accepts can
+// be walked without further checks. Returns false, with nothing mapped, if
+// the file cannot be mapped or is not a valid image of this version.
+bool mapImage(const char *path,                    // *In* Image file name
+  AstImage &image);                                // *Out* Mapped image
+
+// unmapImage releases an image mapped by mapImage.
+void unmapImage(AstImage &image);                  // *In-Out* Mapped image
+
+// imageString returns a view of string s of image.
+string_view imageString(const AstImage &image,     // *In* Mapped image
+  ImageString s);                                  // *In* String offset
+
+
+
+// printImageST and printImageAST print an image exactly as printST and
+// printAST print the SymTab and AST it was made from.
+void printImageST(OutSink &outFile,                // *In-Out* Output sink
+  const AstImage &image);                          // *In* Mapped image
+
+void printImageAST(OutSink &outFile,               // *In-Out* Output sink
+  const AstImage &image);                          // *In* Mapped image
+
+// verifyImage checks that image prints exactly as st and ast do. Returns
+// true if both listings are identical.
+bool verifyImage(const AstImage &image,            // *In* Mapped image
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast);                                       // *In* Abs syntax tree
+
+
+#endif
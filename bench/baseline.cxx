@@ -0,0 +1,517 @@
+// Title   : baseline.cxx
+// Purpose : Benchmark baseline subprograms.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The baseline file is read with a small JSON reader of its own that keeps
+// only what a BenchResult holds: strings and numbers at known keys. Keys it
+// does not know are skipped, so fields can be added to the file later
+// without breaking older readers.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <ctype.h>         // isspace
+#include <stdio.h>         // popen, snprintf
+#include <stdlib.h>        // strtod
+#include <string.h>        // strncmp
+#include <unistd.h>        // gethostname
+#include <fstream>         // Standard file I/O
+#include <sstream>         // Reading the file whole
+#include <string>          // Standard C++ strings library
+#include <thread>          // hardware_concurrency
+#include <vector>          // Standard C++ vector library
+#include "baseline.h"      // header for baseline.cxx
+
+
+
+const char *const stageNames[STAGES] = { "lex", "parse", "pipeline",
+  "print" };
+
+
+
+//***************************************************************************
+//JSON reading subprograms.
+//***************************************************************************
+
+// The text being read and the position in it. Errors are thrown as the
+// position they were found at.
+struct JsonReader                                  // JSON input
+{
+  const string *text;                             // Whole document
+  size_t       pos;                               // Next character
+}; // JsonReader
+
+
+
+static void skipSpace(JsonReader &in)              // *In-Out* Input
+{ // White space between tokens.
+
+  while (in.pos < in.text->size() &&
+    isspace((unsigned char)(*in.text)[in.pos]))
+    in.pos++;
+} // skipSpace
+
+
+
+static bool accept(JsonReader &in,                 // *In-Out* Input
+  char c)                                          // *In* Character wanted
+{ // Takes c if it comes next.
+
+  skipSpace(in);
+  if (in.pos < in.text->size() && (*in.text)[in.pos] == c)
+  {
+    in.pos++;
+    return true;
+  }
+  return false;
+} // accept
+
+
+
+static void expect(JsonReader &in,                 // *In-Out* Input
+  char c)                                          // *In* Character needed
+{ // Takes c or fails.
+
+  if (!accept(in, c))
+    throw in.pos;
+} // expect
+
+
+
+static string readString(JsonReader &in)           // *In-Out* Input
+{ // A quoted string. \u escapes below 128 are kept, others become '?'.
+
+  string value;                                   // String read
+
+  expect(in, '"');
+  while (in.pos < in.text->size() && (*in.text)[in.pos] != '"')
+  {
+    char c = (*in.text)[in.pos++];                // Next character
+
+    if (c == '\\' && in.pos < in.text->size())
+    {
+      c = (*in.text)[in.pos++];
+      if (c == 'n')
+        c = '\n';
+      else if (c == 't')
+        c = '\t';
+      else if (c == 'r')
+        c = '\r';
+      else if (c == 'u' && in.pos + 4 <= in.text->size())
+      {
+        long code = strtol(in.text->substr(in.pos, 4).c_str(), NULL, 16);
+
+        in.pos += 4;
+        c = code < 128 ? (char)code : '?';
+      }
+    }
+    value += c;
+  }
+  expect(in, '"');
+  return value;
+} // readString
+
+
+
+static double readNumber(JsonReader &in)           // *In-Out* Input
+{ // A number, or null as 0.
+
+  const char *start = NULL;                       // Number text
+  char       *end = NULL;                         // Just past it
+  double     value = 0.0;                         // Number read
+
+  skipSpace(in);
+  if (in.text->compare(in.pos, 4, "null") == 0)
+  {
+    in.pos += 4;
+    return 0.0;
+  }
+  start = in.text->c_str() + in.pos;
+  value = strtod(start, &end);
+  if (end == start)
+    throw in.pos;
+  in.pos += end - start;
+  return value;
+} // readNumber
+
+
+
+static void skipValue(JsonReader &in)              // *In-Out* Input
+{ // Any value, nested or not.
+
+  skipSpace(in);
+  if (in.pos >= in.text->size())
+    throw in.pos;
+
+  char c = (*in.text)[in.pos];                    // First character
+
+  if (c == '"')
+    readString(in);
+  else if (c == '{' || c == '[')
+  {
+    char close = c == '{' ? '}' : ']';            // Closing bracket
+
+    in.pos++;
+    if (accept(in, close))
+      return;
+    do
+    {
+      if (close == '}')
+      {
+        readString(in);
+        expect(in, ':');
+      }
+      skipValue(in);
+    } while (accept(in, ','));
+    expect(in, close);
+  }
+  else if (in.text->compare(in.pos, 4, "true") == 0)
+    in.pos += 4;
+  else if (in.text->compare(in.pos, 5, "false") == 0)
+    in.pos += 5;
+  else
+    readNumber(in);
+} // skipValue
+
+
+
+static void readStage(JsonReader &in,              // *In-Out* Input
+  StageResult &stage)                              // *Out* Timings
+{ // {"median":..,"mad":..,"min":..}
+
+  stage.median = stage.mad = stage.min = 0.0;
+  expect(in, '{');
+  if (accept(in, '}'))
+    return;
+  do
+  {
+    string key = readString(in);                  // Field name
+
+    expect(in, ':');
+    if (key == "median")
+      stage.median = readNumber(in);
+    else if (key == "mad")
+      stage.mad = readNumber(in);
+    else if (key == "min")
+      stage.min = readNumber(in);
+    else
+      skipValue(in);
+  } while (accept(in, ','));
+  expect(in, '}');
+} // readStage
+
+
+
+static void readResult(JsonReader &in,             // *In-Out* Input
+  BenchResult &result)                             // *Out* Result
+{ // One element of "baselines".
+
+  result = BenchResult();
+  expect(in, '{');
+  if (accept(in, '}'))
+    return;
+  do
+  {
+    string key = readString(in);                  // Field name
+
+    expect(in, ':');
+    if (key == "commit")
+      result.commit = readString(in);
+    else if (key == "machine")
+      result.machine = readString(in);
+    else if (key == "program")
+      result.program = readString(in);
+    else if (key == "bytes")
+      result.bytes = (long long)readNumber(in);
+    else if (key == "tokens")
+      result.tokens = (long long)readNumber(in);
+    else if (key == "reps")
+      result.reps = (int)readNumber(in);
+    else if (key == "stages")
+    {
+      expect(in, '{');
+      if (!accept(in, '}'))
+      {
+        do
+        {
+          string name = readString(in);           // Stage name
+          int    s = 0;                           // Its number
+
+          expect(in, ':');
+          while (s < STAGES && name != stageNames[s])
+            s++;
+          if (s < STAGES)
+            readStage(in, result.stages[s]);
+          else
+            skipValue(in);
+        } while (accept(in, ','));
+        expect(in, '}');
+      }
+    }
+    else
+      skipValue(in);
+  } while (accept(in, ','));
+  expect(in, '}');
+} // readResult
+
+//***************************************************************************
+//End of JSON reading subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Baseline file subprograms.
+//***************************************************************************
+
+bool loadBaselines(const char *path,               // *In* Baseline file
+  vector<BenchResult> &results,                    // *Out* Results
+  string &why)                                     // *Out* Reason if not
+{ // The whole file is read and then parsed.
+
+  ifstream     file(path);                        // Baseline file
+  stringstream whole;                             // Its text
+  string       text;                              // Text to parse
+  JsonReader   in;                                // Parse position
+
+  results.clear();
+  if (!file)
+    return true;
+  whole << file.rdbuf();
+  text = whole.str();
+  in.text = &text;
+  in.pos = 0;
+
+  try
+  {
+    expect(in, '{');
+    if (!accept(in, '}'))
+    {
+      do
+      {
+        string key = readString(in);              // Field name
+
+        expect(in, ':');
+        if (key != "baselines")
+        {
+          skipValue(in);
+          continue;
+        }
+        expect(in, '[');
+        if (accept(in, ']'))
+          continue;
+        do
+        {
+          BenchResult result;                     // Result read
+
+          readResult(in, result);
+          results.push_back(result);
+        } while (accept(in, ','));
+        expect(in, ']');
+      } while (accept(in, ','));
+      expect(in, '}');
+    }
+  }
+  catch (size_t pos)
+  {
+    why = "bad JSON at byte " + to_string(pos);
+    return false;
+  }
+  return true;
+} // loadBaselines
+
+
+
+static void writeString(ostream &out,              // *In-Out* Output
+  const string &s)                                 // *In* String
+{ // Quoted, with " \ and control characters escaped.
+
+  out << '"';
+  for (size_t i = 0; i < s.size(); i++)
+  {
+    unsigned char c = (unsigned char)s[i];        // Character to write
+
+    if (c == '"' || c == '\\')
+      out << '\\' << (char)c;
+    else if (c < 0x20)
+    {
+      char hex[8];                                // \u escape
+
+      snprintf(hex, sizeof hex, "\\u%04x", c);
+      out << hex;
+    }
+    else
+      out << (char)c;
+  }
+  out << '"';
+} // writeString
+
+
+
+bool saveBaselines(const char *path,               // *In* Baseline file
+  const vector<BenchResult> &results)              // *In* Results
+{ // One result per line; times keep 9 significant digits.
+
+  ofstream file(path);                            // Baseline file
+
+  if (!file)
+    return false;
+
+  file.precision(9);
+  file << "{\"baselines\":[";
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const BenchResult &r = results[i];            // Result to write
+
+    file << (i == 0 ? "\n" : ",\n") << "{\"commit\":";
+    writeString(file, r.commit);
+    file << ",\"machine\":";
+    writeString(file, r.machine);
+    file << ",\"program\":";
+    writeString(file, r.program);
+    file << ",\"bytes\":" << r.bytes << ",\"tokens\":" << r.tokens
+         << ",\"reps\":" << r.reps << ",\"stages\":{";
+    for (int s = 0; s < STAGES; s++)
+    {
+      file << (s == 0 ? "" : ",") << '"' << stageNames[s]
+           << "\":{\"median\":" << r.stages[s].median
+           << ",\"mad\":" << r.stages[s].mad
+           << ",\"min\":" << r.stages[s].min << '}';
+    }
+    file << "}}";
+  }
+  file << "\n]}\n";
+
+  file.close();
+  return !file.fail();
+} // saveBaselines
+
+
+
+void recordResult(vector<BenchResult> &results,    // *In-Out* Results
+  const BenchResult &result)                       // *In* Result to keep
+{ // A result replaced moves to the end, as the most recent.
+
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    if (results[i].commit == result.commit &&
+      results[i].machine == result.machine &&
+      results[i].program == result.program)
+    {
+      results.erase(results.begin() + i);
+      break;
+    }
+  }
+  results.push_back(result);
+} // recordResult
+
+
+
+const BenchResult *findBaseline(const vector<BenchResult> &results, // *In*
+  const BenchResult &current,                      // *In* Run to match
+  const char *commit)                              // *In* Commit or null
+{ // Searched from the most recent.
+
+  for (size_t i = results.size(); i > 0; i--)
+  {
+    const BenchResult &r = results[i - 1];        // Candidate
+
+    if (r.machine == current.machine && r.program == current.program &&
+      (commit == NULL || r.commit == commit))
+      return &r;
+  }
+  return NULL;
+} // findBaseline
+
+//***************************************************************************
+//End of baseline file subprograms.
+//***************************************************************************
+
+
+
+bool compareResults(ostream &out,                  // *In-Out* Report
+  const BenchResult &base,                         // *In* Baseline
+  const BenchResult &current,                      // *In* New run
+  double percent,                                  // *In* Allowed slow down
+  double noise)                                    // *In* MADs of noise
+{ // A stage faster by the same margins is reported as faster.
+
+  bool regressed = false;                         // Any stage slower
+
+  out << "Baseline : " << base.commit << " on " << base.machine << '\n';
+  out << "Stage\tBase s\tNew s\tChange %\tNoise s\tResult\n";
+  for (int s = 0; s < STAGES; s++)
+  {
+    const StageResult &b = base.stages[s];        // Baseline timings
+    const StageResult &c = current.stages[s];     // New timings
+    double            diff = c.median - b.median; // Slow down
+    double            bound = noise * (b.mad + c.mad); // Scatter allowed
+    double            change = b.median > 0.0 ? diff / b.median * 100 : 0.0;
+    const char        *verdict = "same";          // Result
+
+    if (b.median <= 0.0)
+      verdict = "new";
+    else if (change > percent && diff > bound)
+    {
+      verdict = "REGRESSED";
+      regressed = true;
+    }
+    else if (-change > percent && -diff > bound)
+      verdict = "faster";
+
+    out << stageNames[s] << '\t' << b.median << '\t' << c.median << '\t'
+        << change << '\t' << bound << '\t' << verdict << '\n';
+  }
+  return regressed;
+} // compareResults
+
+
+
+string currentCommit()
+{ // Asks git; a tree that is not a repository is "unknown".
+
+  FILE   *pipe = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+  char   line[128];                               // git's answer
+  string commit;                                  // Commit id
+
+  if (pipe == NULL)
+    return "unknown";
+  if (fgets(line, sizeof line, pipe) != NULL)
+    commit = line;
+  pclose(pipe);
+
+  while (!commit.empty() && isspace((unsigned char)commit.back()))
+    commit.pop_back();
+  return commit.empty() ? "unknown" : commit;
+} // currentCommit
+
+
+
+string currentMachine()
+{ // The CPU model comes from /proc/cpuinfo where there is one.
+
+  char     host[256] = "";                        // Host name
+  ifstream cpuinfo("/proc/cpuinfo");              // Linux CPU description
+  string   line;                                  // Line of cpuinfo
+  string   model = "unknown CPU";                 // CPU model
+
+  gethostname(host, sizeof host - 1);
+  while (getline(cpuinfo, line))
+  {
+    if (line.compare(0, 10, "model name") == 0)
+    {
+      size_t start = line.find(':');              // Before the model
+
+      if (start != string::npos)
+        start = line.find_first_not_of(" \t", start + 1);
+      if (start != string::npos)
+        model = line.substr(start);
+      break;
+    }
+  }
+
+  return string(host) + " / " + model + " / " +
+    to_string(thread::hardware_concurrency()) + " cpus";
+} // currentMachine
@@ -0,0 +1,108 @@
+// Title   : baseline.h
+// Purpose : Benchmark baseline header file. Stores compilebench results as
+//           JSON keyed by commit and machine, and compares runs with them.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef BASELINE_H
+#define BASELINE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream, string and vector libraries.
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+
+
+
+// The stages compilebench times.
+enum BenchStage { STAGELEX, STAGEPARSE, STAGEPIPELINE, STAGEPRINT, STAGES };
+
+// Names of the stages, in enum order. A result recorded before a stage was
+// added reads as 0 for it.
+extern const char *const stageNames[STAGES];
+
+
+
+// The timings of one stage, in seconds.
+struct StageResult                                 // Stage timings
+{
+  double median;                                  // Median run
+  double mad;                                     // Median abs deviation
+  double min;                                     // Fastest run
+}; // StageResult
+
+// One benchmark run. program identifies what was run (the shape options
+// or the file name); results are only compared for the same program.
+struct BenchResult                                 // Benchmark run
+{
+  string      commit;                             // Commit benchmarked
+  string      machine;                            // Machine it ran on
+  string      program;                            // Program run
+  long long   bytes;                              // Program size
+  long long   tokens;                             // Program tokens
+  int         reps;                               // Timed runs
+  StageResult stages[STAGES];                     // Per stage timings
+}; // BenchResult
+
+
+
+// A baseline file is a JSON document holding results in the order they
+// were recorded:
+//
+//     {"baselines":[
+//       {"commit":"1a2b3c4","machine":"host / CPU model / 8 cpus",
+//        "program":"--decls 200 ...","bytes":21569,"tokens":6980,
+//        "reps":10,"stages":{"lex":{"median":0.00082,"mad":3.7e-05,
+//        "min":0.00069},"parse":{...},"print":{...}}},
+//       ...]}
+
+
+
+// loadBaselines reads the results in path. A file that does not exist
+// holds no results. Returns false, with why set, if it cannot be read.
+bool loadBaselines(const char *path,               // *In* Baseline file
+  vector<BenchResult> &results,                    // *Out* Results
+  string &why);                                    // *Out* Reason if not
+
+// saveBaselines writes results to path. Returns false if it cannot.
+bool saveBaselines(const char *path,               // *In* Baseline file
+  const vector<BenchResult> &results);             // *In* Results
+
+// recordResult adds result to results, replacing any result for the same
+// commit, machine and program.
+void recordResult(vector<BenchResult> &results,    // *In-Out* Results
+  const BenchResult &result);                      // *In* Result to keep
+
+// findBaseline returns the last result recorded for the machine and
+// program of current from commit, or from any commit if commit is null.
+// Returns null if there is none.
+const BenchResult *findBaseline(const vector<BenchResult> &results, // *In*
+  const BenchResult &current,                      // *In* Run to match
+  const char *commit);                             // *In* Commit or null
+
+// compareResults reports each stage of current against base and returns
+// true if any stage regressed. A stage regresses when its median is more
+// than percent slower than the baseline's and the slow down is also more
+// than noise times the two runs' MADs added, so a change within the runs'
+// own scatter is never called a regression. A stage the baseline has no
+// timings for is reported as new.
+bool compareResults(ostream &out,                  // *In-Out* Report
+  const BenchResult &base,                         // *In* Baseline
+  const BenchResult &current,                      // *In* New run
+  double percent,                                  // *In* Allowed slow down
+  double noise);                                   // *In* MADs of noise
+
+// currentCommit returns the git commit of the working directory, or
+// "unknown".
+string currentCommit();
+
+// currentMachine returns the host name, CPU model and CPU count.
+string currentMachine();
+
+
+#endif
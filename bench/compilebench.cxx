@@ -0,0 +1,433 @@
+// Title   : compilebench.cxx
+// Purpose : Benchmark of the lexer, the parser and the printers over
+//           synthetic or given SCL programs.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     compilebench [--file <scl> | shape options] [--reps <n>]
+//         [--warmup <n>] [--program <file>] [--baselines <json>
+//         [--record] [--compare [--against <commit>]] [--commit <id>]
+//         [--threshold <percent>] [--noise <mads>]]
+//
+// Without --file a program is generated (see sclgen.h for the shape
+// options) and written to --program, /tmp/compilebench.scl by default.
+// Each stage is then run warmup times untimed and reps times timed:
+//
+//     lex       skipWhiteComments and lexAnal up to the end token
+//     parse     synAnal, which lexes as it goes
+//     pipeline  synAnal with PARSEPIPELINED, lexing on a second thread
+//     print     printST and printAST into an OutSink on /dev/null
+//
+// For each stage the median, the median absolute deviation (MAD) and the
+// fastest of the timed runs are reported, with MB/s of source and tokens
+// per second at the median. The MAD is a spread that one slow run (a page
+// fault storm, another process) hardly moves; a change smaller than a few
+// MADs is noise. The pipelined parse's speed up over the sequential one
+// is reported after the stages. The last parse's tree is then simplified
+// (see simplify.h), pruned of the declarations it does not use (see
+// prune.h) and its identical subtrees shared (see hashcons.h), and what
+// each did is reported.
+//
+// With --baselines the run can be kept in, and compared with, a JSON file
+// of results keyed by commit and machine (see baseline.h). --record adds
+// it under --commit, the git commit by default. --compare compares it
+// with the last result recorded on this machine for the same program, or
+// with the one from --against, and exits with 1 if any stage regressed:
+// slowed by more than --threshold percent (5 by default) and by more than
+// --noise times the MADs of the two runs added (3 by default). Both may be
+// given; the comparison is made before the run is recorded.
+//
+// The parser recurses once per operator, so the stages are run on a
+// thread with a 1GB stack.
+//
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -o compilebench bench/compilebench.cxx
+//         bench/sclgen.cxx bench/baseline.cxx lexer.cxx lexpipe.cxx
+//         syner.cxx outsink.cxx jsondump.cxx evaluator.cxx adaptive.cxx
+//         kernels.cxx stats.cxx trace.cxx perfcount.cxx allocstats.cxx
+//         hashcons.cxx prune.cxx simplify.cxx budget.cxx -pthread
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <algorithm>         // sort
+#include <chrono>            // Wall clock timing
+#include <pthread.h>         // Large stack threads
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <sstream>           // Shape as a string
+#include <stdlib.h>          // atoi, atof
+#include <string.h>          // strcmp
+#include <string>            // Standard C++ strings library
+#include <vector>            // Standard C++ vector library
+#include "sclgen.h"          // header for sclgen.cxx
+#include "baseline.h"        // header for baseline.cxx
+#include "../outsink.h"      // header for outsink.cxx
+#include "../syner.h"        // header for syner.cxx
+#include "../hashcons.h"     // header for hashcons.cxx
+#include "../prune.h"        // header for prune.cxx
+#include "../simplify.h"     // header for simplify.cxx
+
+
+
+// What the benchmark thread is given and what it finds.
+struct BenchJob                                    // Benchmark run
+{
+  const char        *program;                     // Program file
+  int               reps;                         // Timed runs
+  int               warmup;                       // Untimed runs
+  long long         tokens;                       // Tokens in the program
+  bool              failed;                       // Program did not parse
+  vector<double>    seconds[STAGES];              // Timed runs per stage
+  ShareStats        sharing;                      // Last tree shared
+  PruneStats        pruning;                      // Its unused symbols
+  SimplifyStats     simplifying;                  // Its rules applied
+}; // BenchJob
+
+
+
+//***************************************************************************
+//Stage subprograms.
+//***************************************************************************
+
+static long long runLex(const char *program,       // *In* Program file
+  ofstream &errFile)                               // *In-Out* Error file
+{ // Returns the tokens lexed, the end token included.
+
+  ifstream  inFile(program);                      // Program text
+  LexToken  token;                                // Token lexed
+  long long tokens = 0;                           // Tokens so far
+
+  skipWhiteComments(inFile);
+  do
+  {
+    lexAnal(inFile, errFile, token);
+    tokens++;
+  } while (token.tag != END);
+  return tokens;
+} // runLex
+
+
+
+static bool runParse(const char *program,          // *In* Program file
+  ofstream &errFile,                               // *In-Out* Error file
+  SymTab *&st,                                     // *Out* Symbol table
+  AST *&ast,                                       // *Out* Abs syntax tree
+  ParseMode mode)                                  // *In* Where lexed
+{ // Returns false if the program has an error.
+
+  ifstream inFile(program);                       // Program text
+  int      label = 0;                             // Label number
+
+  synAnal(inFile, errFile, st, ast, label, mode);
+  return ast != NULL;
+} // runParse
+
+
+
+static void runPrint(ofstream &nullFile,           // *In-Out* /dev/null
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // The listing main writes.
+
+  OutSink listing(nullFile);                      // Buffered listing
+
+  printST(listing, st);
+  listing << "\n\nExpression\n";
+  printAST(listing, ast);
+  listing << '\n';
+} // runPrint
+
+
+
+static double since(chrono::steady_clock::time_point start) // *In* Start
+{ // Seconds since start.
+
+  return chrono::duration<double>(chrono::steady_clock::now() -
+    start).count();
+} // since
+
+
+
+static void *benchThread(void *arg)                // *In* BenchJob
+{ // Runs every stage warmup + reps times. The trees of the last parse are
+  // kept for printing until the next parse replaces them, and the last of
+  // them is simplified, pruned and shared at the end.
+
+  BenchJob *job = (BenchJob *)arg;                // Job to run
+  ofstream nullFile("/dev/null");                 // Discarded output
+  SymTab   *st = NULL;                            // Last symbol table
+  AST      *ast = NULL;                           // Last tree
+
+  job->failed = false;
+  for (int run = 0; run < job->warmup + job->reps; run++)
+  {
+    bool timed = run >= job->warmup;              // Counts towards results
+    chrono::steady_clock::time_point start;       // Stage start
+
+    start = chrono::steady_clock::now();
+    job->tokens = runLex(job->program, nullFile);
+    if (timed)
+      job->seconds[STAGELEX].push_back(since(start));
+
+    freeTrees(st, ast);
+    start = chrono::steady_clock::now();
+    if (!runParse(job->program, nullFile, st, ast, PARSESEQUENTIAL))
+    {
+      job->failed = true;
+      return NULL;
+    }
+    if (timed)
+      job->seconds[STAGEPARSE].push_back(since(start));
+
+    freeTrees(st, ast);
+    start = chrono::steady_clock::now();
+    if (!runParse(job->program, nullFile, st, ast, PARSEPIPELINED))
+    {
+      job->failed = true;
+      return NULL;
+    }
+    if (timed)
+      job->seconds[STAGEPIPELINE].push_back(since(start));
+
+    start = chrono::steady_clock::now();
+    runPrint(nullFile, st, ast);
+    if (timed)
+      job->seconds[STAGEPRINT].push_back(since(start));
+  }
+
+  simplifyAST(ast, job->simplifying);
+  pruneST(st, ast, true, job->pruning);
+  shareAST(ast, job->sharing);
+  freeTrees(st, ast);
+  return NULL;
+} // benchThread
+
+//***************************************************************************
+//End of stage subprograms.
+//***************************************************************************
+
+
+
+static double median(vector<double> values)        // *In* Samples
+{ // The middle value, or the mean of the middle two.
+
+  size_t n = values.size();                       // Sample count
+
+  if (n == 0)
+    return 0.0;
+  sort(values.begin(), values.end());
+  return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+} // median
+
+
+
+static double mad(const vector<double> &values)    // *In* Samples
+{ // The median of the distances from the median.
+
+  double         mid = median(values);            // Median
+  vector<double> distances;                       // |value - median|
+
+  for (size_t i = 0; i < values.size(); i++)
+    distances.push_back(values[i] > mid ? values[i] - mid : mid - values[i]);
+  return median(distances);
+} // mad
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Generates the program if need be, runs the stages and reports.
+
+  GenShape       shape;                           // Generated shape
+  const char     *file = NULL;                    // --file program
+  const char     *program = "/tmp/compilebench.scl"; // Program benched
+  BenchJob       job;                             // Benchmark run
+  pthread_attr_t attr;                            // Thread attributes
+  pthread_t      thread;                          // Benchmark thread
+  ifstream       sizeFile;                        // For the program size
+  long long      bytes = 0;                       // Program size
+  const char     *baselinePath = NULL;            // --baselines file
+  bool           record = false;                  // --record given
+  bool           compare = false;                 // --compare given
+  const char     *against = NULL;                 // --against commit
+  string         commit;                          // --commit or git's
+  double         threshold = 5.0;                 // --threshold percent
+  double         noise = 3.0;                     // --noise MADs
+  BenchResult    result;                          // This run
+  vector<BenchResult> baselines;                  // Results recorded
+  string         why;                             // Why they did not load
+  bool           regressed = false;               // A stage regressed
+
+  defaultShape(shape);
+  job.reps = 10;
+  job.warmup = 1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+      file = argv[++i];
+    else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+      job.reps = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+      job.warmup = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--program") == 0 && i + 1 < argc)
+      program = argv[++i];
+    else if (strcmp(argv[i], "--baselines") == 0 && i + 1 < argc)
+      baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--record") == 0)
+      record = true;
+    else if (strcmp(argv[i], "--compare") == 0)
+      compare = true;
+    else if (strcmp(argv[i], "--against") == 0 && i + 1 < argc)
+      against = argv[++i];
+    else if (strcmp(argv[i], "--commit") == 0 && i + 1 < argc)
+      commit = argv[++i];
+    else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+      threshold = atof(argv[++i]);
+    else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+      noise = atof(argv[++i]);
+    else if (!parseShapeOption(argc, argv, i, shape))
+    {
+      cerr << "Usage : compilebench [--file <scl> | shape options]"
+              " [--reps <n>] [--warmup <n>] [--program <file>]"
+              " [--baselines <json> [--record] [--compare [--against <id>]]"
+              " [--commit <id>] [--threshold <percent>] [--noise <mads>]]\n";
+      return 2;
+    }
+  }
+  if (job.reps < 1)
+    job.reps = 1;
+  if ((record || compare) && baselinePath == NULL)
+  {
+    cerr << "--record and --compare need --baselines.\n";
+    return 2;
+  }
+
+  if (file != NULL)
+    program = file;
+  else
+  {
+    ofstream outFile(program);                    // Generated program
+
+    if (!outFile)
+    {
+      cerr << "Unable to open program file " << program << ".\n";
+      return 1;
+    }
+    generateSCL(outFile, shape);
+  }
+
+  sizeFile.open(program, ios::binary | ios::ate);
+  if (!sizeFile)
+  {
+    cerr << "Unable to open program file " << program << ".\n";
+    return 1;
+  }
+  bytes = (long long)sizeFile.tellg();
+  sizeFile.close();
+
+  job.program = program;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, (size_t)1 << 30);
+  pthread_create(&thread, &attr, benchThread, &job);
+  pthread_join(thread, NULL);
+  pthread_attr_destroy(&attr);
+
+  if (job.failed)
+  {
+    cerr << "Program " << program << " does not parse.\n";
+    return 1;
+  }
+
+  cout << "Program : " << program << "\tBytes : " << bytes
+       << "\tTokens : " << job.tokens << '\n';
+  if (file == NULL)
+  {
+    cout << "Shape : ";
+    describeShape(cout, shape);
+    cout << '\n';
+  }
+  cout << "Runs : " << job.reps << " timed, " << job.warmup << " warm up\n";
+  cout << "Stage\tMedian s\tMAD s\tMin s\tMB/s\tTokens/s\n";
+
+  result.commit = commit.empty() ? currentCommit() : commit;
+  result.machine = currentMachine();
+  if (file != NULL)
+    result.program = string("file ") + file;
+  else
+  {
+    ostringstream text;                           // Shape as options
+
+    describeShape(text, shape);
+    result.program = text.str();
+  }
+  result.bytes = bytes;
+  result.tokens = job.tokens;
+  result.reps = job.reps;
+
+  for (int s = 0; s < STAGES; s++)
+  {
+    StageResult &stage = result.stages[s];        // Stage's timings
+
+    stage.median = median(job.seconds[s]);
+    stage.mad = mad(job.seconds[s]);
+    stage.min = *min_element(job.seconds[s].begin(), job.seconds[s].end());
+
+    cout << stageNames[s] << '\t' << stage.median << '\t' << stage.mad
+         << '\t' << stage.min;
+    if (stage.median > 0.0)
+      cout << '\t' << bytes / stage.median / 1e6
+           << '\t' << (long long)(job.tokens / stage.median);
+    cout << '\n';
+  }
+  if (result.stages[STAGEPIPELINE].median > 0.0)
+    cout << "Pipeline speed up : " << result.stages[STAGEPARSE].median /
+      result.stages[STAGEPIPELINE].median << "x\n";
+  reportSimplify(cout, job.simplifying);
+  reportPruning(cout, job.pruning);
+  reportSharing(cout, job.sharing);
+
+  if (baselinePath == NULL)
+    return 0;
+
+  if (!loadBaselines(baselinePath, baselines, why))
+  {
+    cerr << "Unable to read baselines " << baselinePath << ", " << why
+         << ".\n";
+    return 1;
+  }
+
+  if (compare)
+  {
+    const BenchResult *base = findBaseline(baselines, result, against);
+
+    if (base == NULL)
+    {
+      cerr << "No baseline for this machine and program";
+      if (against != NULL)
+        cerr << " from commit " << against;
+      cerr << ".\n";
+      return 1;
+    }
+    regressed = compareResults(cout, *base, result, threshold, noise);
+  }
+
+  if (record)
+  {
+    recordResult(baselines, result);
+    if (!saveBaselines(baselinePath, baselines))
+    {
+      cerr << "Unable to write baselines " << baselinePath << ".\n";
+      return 1;
+    }
+    cout << "Recorded : " << result.commit << " on " << result.machine
+         << '\n';
+  }
+
+  return regressed ? 1 : 0;
+} // main
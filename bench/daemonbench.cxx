@@ -0,0 +1,261 @@
+// Title   : daemonbench.cxx
+// Purpose : Latency benchmark of the SCL compile daemon against starting
+//           a compiler process per program.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     daemonbench --socket <socket> [--file <scl> | shape options]
+//         [--requests <n>] [--warmup <n>] [--program <file>] [--text]
+//         [--client <sclclient>] [--scl <scl>]
+//
+// Without --file a small program is generated (see sclgen.h for the shape
+// options; the default is 10 declarations and 40 operands) and written to
+// --program, /tmp/daemonbench.scl by default. A daemon must already be
+// listening on socket (scl --daemon <socket>). The program is then compiled
+// warmup times untimed and requests times timed in each way asked for:
+//
+//     daemon  a connection, request and reply per compile, made here
+//     client  the sclclient binary run per compile
+//     scl     the scl binary run per compile
+//
+// The daemon requests send the file name, or with --text the program text.
+// client and scl are only run if their binaries are given, and write their
+// listings to /dev/null. For each way the 50th, 90th and 99th percentile
+// and the slowest compile are reported in microseconds, with compiles per
+// second at the median; the last two show what a build that runs a
+// compiler per program pays now, and the first what it would pay with the
+// process start taken away. Exits with 1 if any compile fails.
+//
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -o daemonbench bench/daemonbench.cxx
+//         bench/sclgen.cxx wire.cxx
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <algorithm>         // sort
+#include <chrono>            // Wall clock timing
+#include <fcntl.h>           // O_WRONLY
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <iterator>          // istreambuf_iterator
+#include <limits.h>          // PATH_MAX
+#include <spawn.h>           // posix_spawn
+#include <stdlib.h>          // atoi, realpath
+#include <string.h>          // strcmp
+#include <string>            // Standard C++ strings library
+#include <sys/wait.h>        // waitpid
+#include <unistd.h>          // close
+#include <vector>            // Standard C++ vector library
+#include "sclgen.h"          // header for sclgen.cxx
+#include "../wire.h"         // header for wire.cxx
+
+
+
+extern char **environ;
+
+
+
+// The ways a compile is timed.
+enum BenchWay { WAYDAEMON, WAYCLIENT, WAYSCL, WAYS };
+
+// Names of the ways, in enum order.
+static const char *wayNames[WAYS] = { "daemon", "client", "scl" };
+
+
+
+static bool daemonCompile(const char *socket,      // *In* Daemon socket
+  WireKind kind,                                   // *In* Request kind
+  const string &text,                              // *In* Source or path
+  WireReply &reply)                                // *Out* Reply
+{ // One connection per compile, as sclclient makes. Returns false if the
+  // compile fails.
+
+  string why;                                     // Why it cannot connect
+  int    fd = connectDaemon(socket, why);         // Connection
+  bool   sent;                                    // Request answered
+
+  if (fd < 0)
+    return false;
+  sent = sendRequest(fd, kind, text) && readReply(fd, reply);
+  close(fd);
+  return sent && reply.status == 0;
+} // daemonCompile
+
+
+
+static bool spawnCompile(vector<const char *> &args) // *In* Command
+{ // Runs the command, whose arguments end with NULL, with its output
+  // discarded. Returns false if it fails.
+
+  posix_spawn_file_actions_t actions;             // Output redirection
+  pid_t                      pid;                 // Child
+  int                        status = 0;          // Child's exit status
+  int                        started;             // posix_spawn's result
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+  started = posix_spawn(&pid, args[0], &actions, NULL,
+    (char *const *)args.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (started != 0 || waitpid(pid, &status, 0) != pid)
+    return false;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+} // spawnCompile
+
+
+
+static double percentile(const vector<double> &sorted, // *In* Sorted times
+  double p)                                        // *In* Percentile
+{ // The nearest rank: the smallest time at least p percent are within.
+
+  size_t rank = (size_t)(p / 100 * sorted.size() + 0.999999); // 1 based
+
+  if (rank < 1)
+    rank = 1;
+  if (rank > sorted.size())
+    rank = sorted.size();
+  return sorted[rank - 1];
+} // percentile
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Generates the program if need be, times each way and reports.
+
+  GenShape       shape;                           // Generated shape
+  const char     *file = NULL;                    // --file program
+  const char     *program = "/tmp/daemonbench.scl"; // Program compiled
+  const char     *socket = NULL;                  // --socket path
+  const char     *binaries[WAYS] = { NULL };      // --client and --scl
+  int            requests = 1000;                 // --requests count
+  int            warmup = 50;                     // --warmup count
+  bool           text = false;                    // --text given
+  char           path[PATH_MAX];                  // Absolute program name
+  WireKind       kind = WIREPATH;                 // Daemon request kind
+  string         request;                         // Daemon request text
+  WireReply      reply;                           // Daemon reply
+  vector<double> micros[WAYS];                    // Timed compiles
+  bool           failed = false;                  // A compile failed
+  bool           badOption = false;               // Usage is wrong
+
+  defaultShape(shape);
+  shape.decls = 10;
+  shape.terms = 40;
+  shape.depth = 2;
+  shape.stringSize = 8;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+      socket = argv[++i];
+    else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+      file = argv[++i];
+    else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc)
+      requests = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+      warmup = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--program") == 0 && i + 1 < argc)
+      program = argv[++i];
+    else if (strcmp(argv[i], "--text") == 0)
+      text = true;
+    else if (strcmp(argv[i], "--client") == 0 && i + 1 < argc)
+      binaries[WAYCLIENT] = argv[++i];
+    else if (strcmp(argv[i], "--scl") == 0 && i + 1 < argc)
+      binaries[WAYSCL] = argv[++i];
+    else if (!parseShapeOption(argc, argv, i, shape))
+      badOption = true;
+  }
+  if (socket == NULL || badOption)
+  {
+    cerr << "Usage : daemonbench --socket <socket> [--file <scl> |"
+            " shape options] [--requests <n>] [--warmup <n>]"
+            " [--program <file>] [--text] [--client <sclclient>]"
+            " [--scl <scl>]\n";
+    return 2;
+  }
+  if (requests < 1)
+    requests = 1;
+
+  if (file != NULL)
+    program = file;
+  else
+  {
+    ofstream outFile(program);                    // Generated program
+
+    if (!outFile)
+    {
+      cerr << "Unable to open program file " << program << ".\n";
+      return 1;
+    }
+    generateSCL(outFile, shape);
+  }
+  if (realpath(program, path) == NULL)
+  {
+    cerr << "Unable to open program file " << program << ".\n";
+    return 1;
+  }
+
+  request = path;
+  if (text)
+  {
+    ifstream source(path);                        // Program text
+
+    kind = WIRESOURCE;
+    request.assign(istreambuf_iterator<char>(source),
+      istreambuf_iterator<char>());
+  }
+
+  for (int way = 0; way < WAYS && !failed; way++)
+  {
+    vector<const char *> args;                    // Command run
+
+    if (way != WAYDAEMON && binaries[way] == NULL)
+      continue;
+    if (way == WAYCLIENT)
+      args = { binaries[way], socket, path, "/dev/null", NULL };
+    else if (way == WAYSCL)
+      args = { binaries[way], path, "/dev/null", NULL };
+
+    for (int run = 0; run < warmup + requests && !failed; run++)
+    {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+      if (way == WAYDAEMON)
+        failed = !daemonCompile(socket, kind, request, reply);
+      else
+        failed = !spawnCompile(args);
+      if (run >= warmup)
+        micros[way].push_back(chrono::duration<double, micro>(
+          chrono::steady_clock::now() - start).count());
+    }
+    if (failed)
+      cerr << wayNames[way] << " did not compile " << program << ".\n";
+  }
+  if (failed)
+    return 1;
+
+  cout << "Program : " << program << "\tRequests : " << requests
+       << "\tWarm up : " << warmup << "\tSent as : "
+       << (text ? "text" : "file name") << '\n';
+  cout << "Way\tp50 us\tp90 us\tp99 us\tMax us\tCompiles/s\n";
+  for (int way = 0; way < WAYS; way++)
+  {
+    vector<double> &times = micros[way];          // This way's times
+
+    if (times.empty())
+      continue;
+    sort(times.begin(), times.end());
+    cout << wayNames[way] << '\t' << percentile(times, 50) << '\t'
+         << percentile(times, 90) << '\t' << percentile(times, 99) << '\t'
+         << times.back() << '\t'
+         << (long long)(1e6 / percentile(times, 50)) << '\n';
+  }
+  return 0;
+} // main
@@ -0,0 +1,64 @@
+// Title   : genscl.cxx
+// Purpose : Writes a synthetic SCL program of a chosen shape to a file.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     genscl <file> [shape options]
+//
+// The shape options are described in sclgen.h; the defaults give a mid
+// sized program using every type.
+//
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -o genscl bench/genscl.cxx bench/sclgen.cxx
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include "sclgen.h"          // header for sclgen.cxx
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Generates the program and reports its shape on cout.
+
+  GenShape shape;                                 // Program shape
+  ofstream outFile;                               // Program file
+
+  defaultShape(shape);
+  for (int i = 2; i < argc; i++)
+  {
+    if (!parseShapeOption(argc, argv, i, shape))
+    {
+      cerr << "Usage : genscl <file> [--decls <n>] [--types <i>,<b>,<f>,<s>]"
+              " [--terms <n>] [--depth <n>] [--comments <percent>]"
+              " [--strings <n>] [--seed <n>]\n";
+      return 2;
+    }
+  }
+  if (argc < 2)
+  {
+    cerr << "Usage : genscl <file> [shape options]\n";
+    return 2;
+  }
+
+  outFile.open(argv[1]);
+  if (!outFile)
+  {
+    cerr << "Unable to open program file " << argv[1] << ".\n";
+    return 1;
+  }
+
+  generateSCL(outFile, shape);
+  outFile.close();
+
+  describeShape(cout, shape);
+  cout << '\n';
+  return 0;
+} // main
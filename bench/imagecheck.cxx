@@ -0,0 +1,735 @@
+// Title   : imagecheck.cxx
+// Purpose : Round trip test of the binary image. Checks that images print
+//           as the trees they were made from and that damaged images are
+//           rejected.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     imagecheck [--image <file>] [scl]...
+//
+// Every program checked (the ones below, two generated ones, see sclgen.h,
+// and any given) is parsed eight times, with each combination of
+// simplifyAST, pruneST and shareAST applied in the order scl applies them.
+// Each tree is saved with writeImage and mapped back with mapImage, and
+// printImageST and printImageAST must write exactly what printST and
+// printAST write for the tree.
+//
+// The plain image of each program is then damaged in one way at a time
+// and written back, and mapImage must reject it: truncated, with its size
+// or a section out of bounds, with an index or string out of range, or
+// with a cycle through brackets, !, a list or a declaration. An undamaged
+// copy written the same way must still load.
+//
+// Each failure is reported on cerr and the exit code is 1 if there were
+// any. The images are written to --image, /tmp/imagecheck.img by default.
+//
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -o imagecheck bench/imagecheck.cxx
+//         bench/sclgen.cxx lexer.cxx lexpipe.cxx syner.cxx outsink.cxx
+//         astimage.cxx csvbind.cxx jsondump.cxx evaluator.cxx adaptive.cxx
+//         kernels.cxx stats.cxx trace.cxx perfcount.cxx allocstats.cxx
+//         hashcons.cxx prune.cxx simplify.cxx budget.cxx -pthread
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <iterator>          // Reading a whole file
+#include <sstream>           // Programs and listings in memory
+#include <stdio.h>           // remove
+#include <string.h>          // memcpy
+#include <string>            // Standard C++ strings library
+#include <string_view>       // Options
+#include <vector>            // Standard C++ vector library
+#include "sclgen.h"          // header for sclgen.cxx
+#include "../outsink.h"      // header for outsink.cxx
+#include "../syner.h"        // header for syner.cxx
+#include "../astimage.h"     // header for astimage.cxx
+#include "../hashcons.h"     // header for hashcons.cxx
+#include "../prune.h"        // header for prune.cxx
+#include "../simplify.h"     // header for simplify.cxx
+
+
+
+// A program to check.
+struct Program                                     // Source and its name
+{
+  string name;                                    // Reported as
+  string text;                                    // SCL source
+}; // Program
+
+
+
+// Between them these use every type, operator and kind of factor, repeat
+// subtrees for shareAST, give simplifyAST rules to apply and declare what
+// pruneST removes, all of it in the last.
+static const Program builtIn[] = {
+  { "types", "// test\nlet int x = 3 in\nlet int y = 4 in\n"
+    "let bool b = true in\nlet float f = 1.5^2 in\n"
+    "let string s = \"a b\" in\n"
+    "(x * 2 + y - 1 > 10) && b || (f > 100.0)\nend\n" },
+  { "arith", "let int x = 3 in\nlet int y = 4 in\n"
+    "x - y - 1 + (x * y % 5) / 2\nend\n" },
+  { "not", "let bool b = true in\nlet float f = 1.0 in\n"
+    "!b || (f >= 150.5) == true\nend\n" },
+  { "string", "let string s = \"q\" in\ns\nend\n" },
+  { "shared", "let int x = 3 in\nlet int y = 4 in\n"
+    "(x * y + 1 > 2) && (x * y + 1 > 2) || !(x * y + 1 > 2) && "
+    "(y * x + 1 > 2)\nend\n" },
+  { "simplify", "let int x = 3 in\nlet bool b = false in\n"
+    "((x + 0) * 1 > 2 * 3) && !!b || false && b || (x - x < 1)\nend\n" },
+  { "unused", "let int x = 1 in\nlet int y = 2 in\nlet float f = 1.5 in\n"
+    "let string s = \"s\" in\ny > 1\nend\n" },
+  { "constant", "let int x = 1 in\nlet bool b = true in\n2 > 1\nend\n" }
+};
+
+
+
+//***************************************************************************
+//Round trip subprograms.
+//***************************************************************************
+
+static string treeListing(SymTab *st,              // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // The listing scl prints.
+
+  ostringstream out;                              // Listing
+
+  {
+    OutSink sink(out);
+    printST(sink, st);
+    sink << "\n\nExpression\n";
+    printAST(sink, ast);
+  }
+  return out.str();
+} // treeListing
+
+
+
+static string imageListing(const AstImage &image)  // *In* Mapped image
+{ // The listing scl --from-image prints.
+
+  ostringstream out;                              // Listing
+
+  {
+    OutSink sink(out);
+    printImageST(sink, image);
+    sink << "\n\nExpression\n";
+    printImageAST(sink, image);
+  }
+  return out.str();
+} // imageListing
+
+
+
+static int firstDifference(const string &a,        // *In* Listing
+  const string &b)                                 // *In* Listing
+{ // The line number of the first line that differs.
+
+  int line = 1;                                   // Line reached
+
+  for (size_t i = 0; i < a.size() && i < b.size() && a[i] == b[i]; i++)
+    if (a[i] == '\n')
+      line++;
+  return line;
+} // firstDifference
+
+
+
+static bool checkTrees(const Program &program,     // *In* Program
+  int variant,                                     // *In* Passes, 3 bits
+  const char *imagePath)                           // *In* Image file name
+{ // Parses the program, applies the passes in variant, and compares the
+  // listing of the tree with that of its image. Returns false on failure.
+
+  istringstream  inFile(program.text);            // Source
+  ostringstream  errors;                          // Parse errors
+  SymTab         *st = NULL;                      // Symbol table
+  AST            *ast = NULL;                     // Abs syntax tree
+  int            label = 0;                       // Label number
+  SimplifyStats  simplifying;                     // Unused results
+  PruneStats     pruning;                         // Unused results
+  ShareStats     sharing;                         // Unused results
+  AstImage       image;                           // Image mapped back
+  string         expected;                        // Tree listing
+  string         actual;                          // Image listing
+  string         passes;                          // Variant's name
+
+  synAnal(inFile, errors, st, ast, label);
+  if (ast == NULL)
+  {
+    cerr << program.name << " : does not parse\n" << errors.str();
+    freeTrees(st, ast);
+    return false;
+  }
+
+  if (variant & 1)
+  {
+    simplifyAST(ast, simplifying);
+    passes += " simplify";
+  }
+  if (variant & 2)
+  {
+    pruneST(st, ast, true, pruning);
+    passes += " prune";
+  }
+  if (variant & 4)
+  {
+    shareAST(ast, sharing);
+    passes += " share";
+  }
+  if (passes.empty())
+    passes = " plain";
+
+  expected = treeListing(st, ast);
+  if (!writeImage(imagePath, st, ast))
+  {
+    cerr << "Unable to write image file " << imagePath << ".\n";
+    freeTrees(st, ast);
+    return false;
+  }
+  freeTrees(st, ast);
+
+  if (!mapImage(imagePath, image))
+  {
+    cerr << program.name << passes << " : image does not load\n";
+    return false;
+  }
+  actual = imageListing(image);
+  unmapImage(image);
+
+  if (actual != expected)
+  {
+    cerr << program.name << passes << " : image listing differs at line "
+         << firstDifference(expected, actual) << '\n';
+    return false;
+  }
+  return true;
+} // checkTrees
+
+//***************************************************************************
+//End of round trip subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Damage subprograms. Each damages a copy of a valid image in place, and
+//returns false if the image has nothing to damage that way.
+//***************************************************************************
+
+static ImageHeader &header(string &bytes)          // *In-Out* Image
+{ // The header of the image.
+
+  return *(ImageHeader *)&bytes[0];
+} // header
+
+
+
+static void *record(string &bytes,                 // *In-Out* Image
+  int section,                                     // *In* ImageSection
+  int32_t index,                                   // *In* Record index
+  size_t size)                                     // *In* Record size
+{ // Record index of the section. Sections start on 8 byte boundaries, so
+  // the record is aligned as it is in a mapping.
+
+  return &bytes[header(bytes).offset[section] + index * size];
+} // record
+
+
+
+static ImageExpression &firstExpression(string &bytes) // *In-Out* Image
+{ // The expression of the first statement.
+
+  int32_t e = *(int32_t *)record(bytes, IMGSTATEMENTS, 0, sizeof(int32_t));
+
+  return *(ImageExpression *)record(bytes, IMGEXPRESSIONS, e,
+    sizeof(ImageExpression));
+} // firstExpression
+
+
+
+static ImageBasicExp &firstBasicExp(string &bytes) // *In-Out* Image
+{ // The first basic expression of the first statement.
+
+  return *(ImageBasicExp *)record(bytes, IMGBASICEXPS,
+    firstExpression(bytes).be1, sizeof(ImageBasicExp));
+} // firstBasicExp
+
+
+
+static ImageTerm &firstTerm(string &bytes)         // *In-Out* Image
+{ // The first term of the first statement.
+
+  return *(ImageTerm *)record(bytes, IMGTERMS, firstBasicExp(bytes).term,
+    sizeof(ImageTerm));
+} // firstTerm
+
+
+
+static ImageFactor &firstFactor(string &bytes)     // *In-Out* Image
+{ // The first factor of the first statement.
+
+  return *(ImageFactor *)record(bytes, IMGFACTORS, firstTerm(bytes).fact,
+    sizeof(ImageFactor));
+} // firstFactor
+
+
+
+static bool noDamage(string &bytes)                // *In-Out* Image
+{ // The control: written back as it is, it must load.
+
+  return !bytes.empty();
+} // noDamage
+
+
+
+static bool cutInHeader(string &bytes)             // *In-Out* Image
+{ // Shorter than a header.
+
+  bytes.resize(sizeof(ImageHeader) - 1);
+  return true;
+} // cutInHeader
+
+
+
+static bool cutByOne(string &bytes)                // *In-Out* Image
+{ // One byte short of the size in the header.
+
+  bytes.resize(bytes.size() - 1);
+  return true;
+} // cutByOne
+
+
+
+static bool cutInHalf(string &bytes)               // *In-Out* Image
+{ // Half the size in the header.
+
+  bytes.resize(bytes.size() / 2);
+  return true;
+} // cutInHalf
+
+
+
+static bool cutPoolWithSize(string &bytes)         // *In-Out* Image
+{ // Cut inside the string pool, with the size in the header cut to match,
+  // so only the section bounds show it.
+
+  ImageHeader h = header(bytes);                  // Header as written
+
+  bytes.resize(h.offset[IMGSTRINGS] + h.count[IMGSTRINGS] - 1);
+  header(bytes).size = (uint32_t)bytes.size();
+  return true;
+} // cutPoolWithSize
+
+
+
+static bool otherVersion(string &bytes)            // *In-Out* Image
+{ // A version this build does not read.
+
+  header(bytes).version = imageVersion + 1;
+  return true;
+} // otherVersion
+
+
+
+static bool otherByteOrder(string &bytes)          // *In-Out* Image
+{ // Written by a machine of the other byte order.
+
+  header(bytes).byteOrder = 0x04030201;
+  return true;
+} // otherByteOrder
+
+
+
+static bool misalignedSection(string &bytes)       // *In-Out* Image
+{ // A section that does not start on an 8 byte boundary.
+
+  header(bytes).offset[IMGTERMS] += 4;
+  return true;
+} // misalignedSection
+
+
+
+static bool sectionPastEnd(string &bytes)          // *In-Out* Image
+{ // More records in a section than the file holds.
+
+  ImageHeader &h = header(bytes);                 // Header
+
+  h.count[IMGFACTORS] += (h.size - h.offset[IMGFACTORS]) /
+    sizeof(ImageFactor) + 1;
+  return true;
+} // sectionPastEnd
+
+
+
+static bool statementPastEnd(string &bytes)        // *In-Out* Image
+{ // A statement one past the last expression.
+
+  *(int32_t *)record(bytes, IMGSTATEMENTS, 0, sizeof(int32_t)) =
+    header(bytes).count[IMGEXPRESSIONS];
+  return true;
+} // statementPastEnd
+
+
+
+static bool statementNegative(string &bytes)       // *In-Out* Image
+{ // A negative statement other than imageNone.
+
+  *(int32_t *)record(bytes, IMGSTATEMENTS, 0, sizeof(int32_t)) = -2;
+  return true;
+} // statementNegative
+
+
+
+static bool statementNone(string &bytes)           // *In-Out* Image
+{ // imageNone where an expression is required.
+
+  *(int32_t *)record(bytes, IMGSTATEMENTS, 0, sizeof(int32_t)) = imageNone;
+  return true;
+} // statementNone
+
+
+
+static bool basicExpPastEnd(string &bytes)         // *In-Out* Image
+{ // A basic expression one past the last.
+
+  firstExpression(bytes).be1 = header(bytes).count[IMGBASICEXPS];
+  return true;
+} // basicExpPastEnd
+
+
+
+static bool termPastEnd(string &bytes)             // *In-Out* Image
+{ // A term one past the last.
+
+  firstBasicExp(bytes).term = header(bytes).count[IMGTERMS];
+  return true;
+} // termPastEnd
+
+
+
+static bool factorPastEnd(string &bytes)           // *In-Out* Image
+{ // A factor one past the last.
+
+  firstTerm(bytes).fact = header(bytes).count[IMGFACTORS];
+  return true;
+} // factorPastEnd
+
+
+
+static bool identPastEnd(string &bytes)            // *In-Out* Image
+{ // A symbol one past the last.
+
+  firstFactor(bytes).ident = header(bytes).count[IMGSYMBOLS];
+  return true;
+} // identPastEnd
+
+
+
+static bool initialisePastEnd(string &bytes)       // *In-Out* Image
+{ // A declaration whose value is one past the last factor.
+
+  if (header(bytes).count[IMGSYMBOLS] == 0)
+    return false;
+  ((ImageSymbol *)record(bytes, IMGSYMBOLS, 0,
+    sizeof(ImageSymbol)))->initialise = header(bytes).count[IMGFACTORS];
+  return true;
+} // initialisePastEnd
+
+
+
+static bool stringPastPool(string &bytes)          // *In-Out* Image
+{ // A string that starts at the end of the pool.
+
+  firstExpression(bytes).relOp = header(bytes).count[IMGSTRINGS];
+  return true;
+} // stringPastPool
+
+
+
+static bool stringLengthPastPool(string &bytes)    // *In-Out* Image
+{ // A string that starts in the pool but runs past its end.
+
+  ImageString s = firstExpression(bytes).relOp;   // Operator string
+  uint32_t    length = header(bytes).count[IMGSTRINGS]; // Too long
+
+  memcpy(&bytes[header(bytes).offset[IMGSTRINGS] + s], &length,
+    sizeof length);
+  return true;
+} // stringLengthPastPool
+
+
+
+static bool bracketCycle(string &bytes)            // *In-Out* Image
+{ // The first factor made a bracket around the expression it is in.
+
+  ImageFactor &fact = firstFactor(bytes);         // Factor changed
+
+  fact.literal = 0;
+  fact.ident = imageNone;
+  fact.nFactor = imageNone;
+  fact.bExp = *(int32_t *)record(bytes, IMGSTATEMENTS, 0, sizeof(int32_t));
+  return true;
+} // bracketCycle
+
+
+
+static bool notCycle(string &bytes)                // *In-Out* Image
+{ // The first factor made the negation of itself.
+
+  ImageFactor &fact = firstFactor(bytes);         // Factor changed
+
+  fact.literal = 0;
+  fact.ident = imageNone;
+  fact.bExp = imageNone;
+  fact.nFactor = firstTerm(bytes).fact;
+  return true;
+} // notCycle
+
+
+
+static bool termListCycle(string &bytes)           // *In-Out* Image
+{ // The first term made the rest of its own list.
+
+  firstTerm(bytes).term = firstBasicExp(bytes).term;
+  return true;
+} // termListCycle
+
+
+
+static bool basicExpListCycle(string &bytes)       // *In-Out* Image
+{ // The first basic expression made the rest of its own list.
+
+  firstBasicExp(bytes).bexp = firstExpression(bytes).be1;
+  return true;
+} // basicExpListCycle
+
+
+
+static bool declarationCycle(string &bytes)        // *In-Out* Image
+{ // A declaration whose value is the identifier declared.
+
+  for (uint32_t i = 0; i < header(bytes).count[IMGSYMBOLS]; i++)
+  {
+    ImageSymbol &sym = *(ImageSymbol *)record(bytes, IMGSYMBOLS, i,
+      sizeof(ImageSymbol));
+    if (sym.initialise == imageNone)
+      continue;
+
+    ImageFactor &fact = *(ImageFactor *)record(bytes, IMGFACTORS,
+      sym.initialise, sizeof(ImageFactor));
+    fact.literal = 0;
+    fact.ident = i;
+    return true;
+  }
+  return false;
+} // declarationCycle
+
+//***************************************************************************
+//End of damage subprograms.
+//***************************************************************************
+
+
+
+// The ways an image is damaged, each with whether mapImage must load it.
+struct Damage                                      // One way of damaging
+{
+  const char *name;                               // Reported as
+  bool       (*apply)(string &bytes);             // Damages a copy
+  bool       loads;                               // Expected result
+}; // Damage
+
+static const Damage damages[] = {
+  { "undamaged", noDamage, true },
+  { "cut in header", cutInHeader, false },
+  { "cut by one byte", cutByOne, false },
+  { "cut in half", cutInHalf, false },
+  { "cut in pool, size to match", cutPoolWithSize, false },
+  { "other version", otherVersion, false },
+  { "other byte order", otherByteOrder, false },
+  { "misaligned section", misalignedSection, false },
+  { "section past end", sectionPastEnd, false },
+  { "statement past end", statementPastEnd, false },
+  { "statement negative", statementNegative, false },
+  { "statement none", statementNone, false },
+  { "basic exp past end", basicExpPastEnd, false },
+  { "term past end", termPastEnd, false },
+  { "factor past end", factorPastEnd, false },
+  { "ident past end", identPastEnd, false },
+  { "initialise past end", initialisePastEnd, false },
+  { "string past pool", stringPastPool, false },
+  { "string length past pool", stringLengthPastPool, false },
+  { "bracket cycle", bracketCycle, false },
+  { "not cycle", notCycle, false },
+  { "term list cycle", termListCycle, false },
+  { "basic exp list cycle", basicExpListCycle, false },
+  { "declaration cycle", declarationCycle, false }
+};
+
+
+
+static bool readBytes(const char *path,            // *In* File name
+  string &bytes)                                   // *Out* Its contents
+{ // Returns false if the file cannot be read.
+
+  ifstream     inFile(path, ios::binary);         // File read
+  stringstream contents;                          // Its bytes
+
+  if (!inFile)
+    return false;
+  contents << inFile.rdbuf();
+  bytes = contents.str();
+  return true;
+} // readBytes
+
+
+
+static bool writeBytes(const char *path,           // *In* File name
+  const string &bytes)                             // *In* Contents
+{ // Returns false if the file cannot be written.
+
+  ofstream outFile(path, ios::binary | ios::trunc); // File written
+
+  outFile.write(bytes.data(), bytes.size());
+  outFile.close();
+  return !outFile.fail();
+} // writeBytes
+
+
+
+static int checkDamage(const Program &program,     // *In* Program
+  const char *imagePath,                           // *In* Image file name
+  int &checks)                                     // *In-Out* Checks made
+{ // Damages the plain image of the program each way in turn. Returns the
+  // number of failures.
+
+  istringstream inFile(program.text);             // Source
+  ostringstream errors;                           // Parse errors
+  SymTab        *st = NULL;                       // Symbol table
+  AST           *ast = NULL;                      // Abs syntax tree
+  int           label = 0;                        // Label number
+  string        valid;                            // Image as written
+  int           failures = 0;                     // Checks failed
+
+  checks++;
+  synAnal(inFile, errors, st, ast, label);
+  if (ast == NULL || !writeImage(imagePath, st, ast) ||
+    !readBytes(imagePath, valid))
+  {
+    cerr << program.name << " : no image to damage\n";
+    freeTrees(st, ast);
+    return 1;
+  }
+  freeTrees(st, ast);
+
+  for (const Damage &damage : damages)
+  {
+    string   bytes = valid;                       // Copy damaged
+    AstImage image;                               // Image mapped back
+    bool     loads = false;                       // mapImage's result
+
+    if (!damage.apply(bytes))
+      continue;
+    checks++;
+    if (!writeBytes(imagePath, bytes))
+    {
+      cerr << "Unable to write image file " << imagePath << ".\n";
+      return failures + 1;
+    }
+
+    loads = mapImage(imagePath, image);
+    if (loads)
+      unmapImage(image);
+    if (loads != damage.loads)
+    {
+      cerr << program.name << " " << damage.name << " : image "
+           << (loads ? "loads" : "does not load") << '\n';
+      failures++;
+    }
+  }
+  return failures;
+} // checkDamage
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Checks the built in, generated and given programs.
+
+  const char      *imagePath = "/tmp/imagecheck.img"; // Image file
+  vector<Program> programs(begin(builtIn), end(builtIn)); // To check
+  GenShape        shape;                          // Generated program
+  int             failures = 0;                   // Checks failed
+  int             checks = 0;                     // Checks made
+
+  for (int i = 1; i < argc; i++)
+  {
+    string_view arg = argv[i];                    // Option or file
+
+    if (arg == "--image" && i + 1 < argc)
+      imagePath = argv[++i];
+    else if (arg.substr(0, 2) == "--")
+    {
+      cerr << "Usage : imagecheck [--image <file>] [scl]...\n";
+      return 2;
+    }
+    else
+    {
+      Program program;                            // Given program
+      ifstream inFile(argv[i]);                   // Its source
+
+      if (!inFile)
+      {
+        cerr << "Unable to open " << argv[i] << ".\n";
+        return 2;
+      }
+      program.name = argv[i];
+      program.text.assign(istreambuf_iterator<char>(inFile),
+        istreambuf_iterator<char>());
+      programs.push_back(program);
+    }
+  }
+
+  // The default shape, and a smaller one bracketed deeper with more
+  // string literals.
+  defaultShape(shape);
+  for (int g = 0; g < 2; g++)
+  {
+    ostringstream text;                           // Generated source
+    ostringstream name;                           // Its shape
+
+    if (g == 1)
+    {
+      shape.decls = 50;
+      shape.stringWeight = 40;
+      shape.terms = 300;
+      shape.depth = 6;
+      shape.seed = 2;
+    }
+    generateSCL(text, shape);
+    describeShape(name, shape);
+    programs.push_back({ "generated " + name.str(), text.str() });
+  }
+
+  for (const Program &program : programs)
+  {
+    for (int variant = 0; variant < 8; variant++)
+    {
+      checks++;
+      if (!checkTrees(program, variant, imagePath))
+        failures++;
+    }
+    failures += checkDamage(program, imagePath, checks);
+  }
+  remove(imagePath);
+
+  cout << "Programs : " << programs.size() << "\tChecks : " << checks
+       << "\tFailures : " << failures << '\n';
+  return failures == 0 ? 0 : 1;
+} // main
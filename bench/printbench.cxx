@@ -0,0 +1,405 @@
+// Title   : printbench.cxx
+// Purpose : Benchmark of the listing printers, comparing the OutSink
+//           printers with the ofstream and endl printing they replaced.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     printbench [entries] [terms] [depth] [file]
+//
+// Builds a symbol table of entries declarations, an expression of terms
+// int operands and an expression nested depth brackets deep. The table is
+// printed with the printer as it was (ofstream, endl after every row), with
+// printST through an OutSink and as NDJSON. The expressions are printed
+// with the recursive printers as they were, with printAST and (for the
+// flat one) as NDJSON. Reports seconds and MB/s for each, and checks that
+// printAST wrote exactly what the recursive printers did. Defaults are
+// 1000000 entries, 1000000 terms, 100000 deep and /tmp/printbench.out.
+//
+// The recursive printers need a frame per operand, so they are run on a
+// thread with a 1GB stack.
+//
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -o printbench bench/printbench.cxx lexer.cxx
+//         lexpipe.cxx syner.cxx outsink.cxx jsondump.cxx evaluator.cxx adaptive.cxx
+//         kernels.cxx stats.cxx trace.cxx perfcount.cxx allocstats.cxx
+//         budget.cxx -pthread
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <chrono>            // Wall clock timing
+#include <pthread.h>         // Large stack threads
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <stdlib.h>          // atoi
+#include <sstream>           // Reading back the output
+#include <string>            // Standard C++ strings library
+#include "../outsink.h"      // header for outsink.cxx
+#include "../syner.h"        // header for syner.cxx
+#include "../jsondump.h"     // header for jsondump.cxx
+
+
+
+static Factor *newFactor(DataType type)            // *In* Literal type
+{ // An empty literal Factor of the given type.
+
+  Factor *fact = new Factor;                      // New factor
+
+  fact->literal = true;
+  fact->type = type;
+  fact->litInt = 0;
+  fact->ident = NULL;
+  fact->bExp = NULL;
+  fact->nFactor = NULL;
+  return fact;
+} // newFactor
+
+
+
+static SymTab *buildST(int entries)                // *In* Declarations
+{ // Cycles through the four types so every row shape is printed.
+
+  SymTab *st = NULL;                              // Table built
+
+  for (int i = 0; i < entries; i++)
+  {
+    SymTab *entry = new SymTab;                   // New head
+
+    entry->ident = "v" + to_string(i);
+    entry->type = (DataType)(BOOLDATA + i % 4);
+    entry->initialise = newFactor(entry->type);
+    entry->initialise->litBool = "true";
+    entry->initialise->litString = "text";
+    entry->initialise->litInt = i % 32768;
+    entry->initialise->litFloat = "1.5^3";
+    entry->slot = i;
+    entry->next = st;
+    st = entry;
+  }
+  return st;
+} // buildST
+
+
+
+static AST *buildAST(SymTab *st,                   // *In* Symbol table
+  int terms)                                       // *In* Operands
+{ // A single + and - chain alternating an identifier and int literals.
+
+  AST      *ast = new AST;                        // Tree built
+  BasicExp *bexp = NULL;                          // Chain built backwards
+
+  for (int i = terms - 1; i >= 0; i--)
+  {
+    BasicExp *link = new BasicExp;                // New chain head
+
+    link->term = new Term;
+    link->term->term = NULL;
+    link->term->chain = -1;
+    link->term->fact = newFactor(INTDATA);
+    link->term->fact->litInt = i;
+    if (i % 2 == 0 && st != NULL)
+    {
+      link->term->fact->literal = false;
+      link->term->fact->ident = st;
+    }
+    link->addOp = (i % 2 == 0) ? "+" : "-";
+    link->bexp = bexp;
+    link->chain = -1;
+    bexp = link;
+  }
+
+  ast->expr = new Expression;
+  ast->expr->be1 = bexp;
+  ast->expr->be2 = NULL;
+  ast->next = NULL;
+  ast->shared = false;
+  return ast;
+} // buildAST
+
+
+
+static Expression *wrapExpression(Factor *fact)    // *In* Only factor
+{ // An expression of a single factor.
+
+  Expression *expr = new Expression;              // New expression
+
+  expr->be1 = new BasicExp;
+  expr->be1->term = new Term;
+  expr->be1->term->fact = fact;
+  expr->be1->term->term = NULL;
+  expr->be1->term->chain = -1;
+  expr->be1->bexp = NULL;
+  expr->be1->chain = -1;
+  expr->be2 = NULL;
+  return expr;
+} // wrapExpression
+
+
+
+static AST *buildNested(int depth)                 // *In* Bracket depth
+{ // ((( ... !(1) ... ))), alternating brackets and !.
+
+  AST    *ast = new AST;                          // Tree built
+  Factor *fact = newFactor(INTDATA);              // Innermost factor
+
+  fact->litInt = 1;
+  for (int i = 0; i < depth; i++)
+  {
+    Factor *outer = newFactor(VOIDDATA);          // Enclosing factor
+
+    outer->literal = false;
+    if (i % 2 == 0)
+      outer->nFactor = fact;
+    else
+      outer->bExp = wrapExpression(fact);
+    fact = outer;
+  }
+
+  ast->expr = wrapExpression(fact);
+  ast->next = NULL;
+  ast->shared = false;
+  return ast;
+} // buildNested
+
+
+
+static void endlST(ofstream &outFile,              // *In-Out* Output file
+  SymTab *st)                                      // *In* Symbol table
+{ // printST as it was, with endl after every row.
+
+  static const char *types[] = { "", "\tbool", "\tstring", "\tint",
+                                 "\tfloat" };
+
+  outFile << "\n\nName\tType\tValue\n";
+  for (; st != NULL; st = st->next)
+  {
+    outFile << st->ident << types[st->type] << '\t';
+    if (st->type == BOOLDATA)
+      outFile << st->initialise->litBool << endl;
+    else if (st->type == STRINGDATA)
+      outFile << st->initialise->litString << endl;
+    else if (st->type == INTDATA)
+      outFile << st->initialise->litInt << endl;
+    else
+      outFile << st->initialise->litFloat << endl;
+  }
+} // endlST
+
+
+
+// The recursive expression printers as they were, writing to an
+// OutSink so that only the recursion differs from printAST.
+static void recursiveExpression(OutSink &outFile, Expression *expr);
+
+static void recursiveFactor(OutSink &outFile,      // *In-Out* Output file
+  Factor *fact)                                    // *In* Factor
+{ // printFactor as it was.
+
+  if (fact->literal)
+    outFile << fact->litInt;
+  else if (fact->ident != NULL)
+    outFile << fact->ident->ident;
+  else if (fact->bExp != NULL)
+  {
+    outFile << '(';
+    recursiveExpression(outFile, fact->bExp);
+    outFile << ')';
+  }
+  else if (fact->nFactor != NULL)
+  {
+    outFile << "!(";
+    recursiveFactor(outFile, fact->nFactor);
+    outFile << ')';
+  }
+} // recursiveFactor
+
+static void recursiveTerm(OutSink &outFile,        // *In-Out* Output file
+  Term *term)                                      // *In* Term
+{ // printTerm as it was.
+
+  recursiveFactor(outFile, term->fact);
+  if (term->term != NULL)
+  {
+    outFile << ' ' << term->mulOp << ' ';
+    recursiveTerm(outFile, term->term);
+  }
+} // recursiveTerm
+
+static void recursiveBasicExp(OutSink &outFile,    // *In-Out* Output file
+  BasicExp *bexp)                                  // *In* BasicExp
+{ // printBasicExp as it was.
+
+  recursiveTerm(outFile, bexp->term);
+  if (bexp->bexp != NULL)
+  {
+    outFile << ' ' << bexp->addOp << ' ';
+    recursiveBasicExp(outFile, bexp->bexp);
+  }
+} // recursiveBasicExp
+
+static void recursiveExpression(OutSink &outFile,  // *In-Out* Output file
+  Expression *expr)                                // *In* Expression
+{ // printExpression as it was.
+
+  recursiveBasicExp(outFile, expr->be1);
+  if (expr->be2 != NULL)
+  {
+    outFile << ' ' << expr->relOp << ' ';
+    recursiveBasicExp(outFile, expr->be2);
+  }
+} // recursiveExpression
+
+
+
+// Arguments for a recursive print on a large stack thread.
+struct RecursiveJob                                // Thread arguments
+{
+  ofstream *outFile;                              // Output file
+  AST      *ast;                                  // Tree to print
+}; // RecursiveJob
+
+static void *recursiveJob(void *arg)               // *In* RecursiveJob
+{ // Thread body.
+
+  RecursiveJob *job = (RecursiveJob *)arg;        // Arguments
+  OutSink      sink(*job->outFile);               // Buffered output
+
+  recursiveExpression(sink, job->ast->expr);
+  return NULL;
+} // recursiveJob
+
+static void printRecursive(ofstream &outFile,      // *In-Out* Output file
+  AST *ast)                                        // *In* Tree to print
+{ // Runs the recursive printers on a thread with a 1GB stack.
+
+  pthread_attr_t attr;                            // Thread attributes
+  pthread_t      thread;                          // Printing thread
+  RecursiveJob   job = { &outFile, ast };         // Its arguments
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, (size_t)1 << 30);
+  pthread_create(&thread, &attr, recursiveJob, &job);
+  pthread_join(thread, NULL);
+  pthread_attr_destroy(&attr);
+} // printRecursive
+
+
+
+static string readBack(const char *path)           // *In* File written
+{ // The whole of a file, for comparing outputs.
+
+  ifstream      inFile(path, ios::binary);        // File to read
+  ostringstream text;                             // Its contents
+
+  text << inFile.rdbuf();
+  return text.str();
+} // readBack
+
+
+
+static void report(const char *name,               // *In* Case name
+  chrono::steady_clock::time_point start,          // *In* Start time
+  const char *path)                                // *In* File written
+{ // Prints the time taken and the rate for one case.
+
+  double    seconds = chrono::duration<double>(chrono::steady_clock::now()
+                        - start).count();
+  ifstream  written(path, ios::binary | ios::ate);
+  long long bytes = (long long)written.tellg();
+
+  cout << name << "\tBytes : " << bytes << "\tSeconds : " << seconds;
+  if (seconds > 0.0)
+    cout << "\tMB/s : " << bytes / seconds / 1e6;
+  cout << '\n';
+} // report
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Runs the cases in turn, each into a freshly truncated file.
+
+  int        entries = (argc > 1) ? atoi(argv[1]) : 1000000;
+  int        terms = (argc > 2) ? atoi(argv[2]) : 1000000;
+  int        depth = (argc > 3) ? atoi(argv[3]) : 100000;
+  const char *path = (argc > 4) ? argv[4] : "/tmp/printbench.out";
+  SymTab     *st = buildST(entries);             // Symbol table
+  AST        *flat = buildAST(st, terms);        // Long chain
+  AST        *nested = buildNested(depth);       // Deep brackets
+  chrono::steady_clock::time_point start;        // Case start
+  string     expected;                           // Recursive output
+
+  {
+    ofstream outFile(path);
+    start = chrono::steady_clock::now();
+    endlST(outFile, st);
+    outFile.close();
+    report("ST endl", start, path);
+  }
+  {
+    ofstream outFile(path);
+    start = chrono::steady_clock::now();
+    {
+      OutSink sink(outFile);
+      printST(sink, st);
+    }
+    outFile.close();
+    report("ST sink", start, path);
+  }
+  {
+    ofstream outFile(path);
+    start = chrono::steady_clock::now();
+    {
+      OutSink sink(outFile);
+      jsonST(sink, st, NDJSON);
+    }
+    outFile.close();
+    report("ST ndjson", start, path);
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+    AST        *ast = (i == 0) ? flat : nested;   // Tree for this round
+    const char *name = (i == 0) ? "flat" : "nested";
+
+    {
+      ofstream outFile(path);
+      start = chrono::steady_clock::now();
+      printRecursive(outFile, ast);
+      outFile.close();
+      cout << "AST " << name << " recursive";
+      report("", start, path);
+      expected = readBack(path);
+    }
+    {
+      ofstream outFile(path);
+      start = chrono::steady_clock::now();
+      {
+        OutSink sink(outFile);
+        printAST(sink, ast);
+      }
+      outFile.close();
+      cout << "AST " << name << " iterative";
+      report("", start, path);
+      cout << "AST " << name << " output "
+           << (readBack(path) == expected ? "identical" : "DIFFERS") << '\n';
+    }
+  }
+
+  {
+    ofstream outFile(path);
+    start = chrono::steady_clock::now();
+    {
+      OutSink sink(outFile);
+      jsonAST(sink, flat, NDJSON);
+    }
+    outFile.close();
+    report("AST flat ndjson", start, path);
+  }
+
+  return 0;
+} // main
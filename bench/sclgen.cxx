@@ -0,0 +1,451 @@
+// Title   : sclgen.cxx
+// Purpose : Synthetic SCL program generator subprograms.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The random numbers come from a xorshift generator of our own rather than
+// <random>, whose distributions differ between libraries, so a seed gives
+// the same program everywhere. Bracket groups are written with loops, so
+// any depth can be generated without recursion.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <stdlib.h>        // atoi, atoll, strtoul
+#include <string.h>        // strcmp
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "sclgen.h"        // header for sclgen.cxx
+
+
+
+// Lines are broken once they pass this column.
+const int genLineWidth = 72;
+
+
+
+// A xorshift64* random number generator.
+class GenRandom                                    // Random numbers
+{
+private:
+  unsigned long long state;                       // Generator state
+public:
+  // Class constructor.
+  GenRandom(unsigned seed)                         // *In* Seed
+  {
+    state = 0x9e3779b97f4a7c15ULL ^ seed;
+    if (state == 0)
+      state = 1;
+  }
+
+  // below returns a number from 0 to n - 1.
+  unsigned long long below(unsigned long long n)   // *In* Range
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (state * 0x2545f4914f6cdd1dULL >> 11) % n;
+  }
+}; // class GenRandom
+
+
+
+// Writes tokens with spaces between them, breaking lines at genLineWidth
+// and writing comment lines after some of the breaks.
+class GenWriter                                    // Token writer
+{
+private:
+  ostream   *out;                                 // Program text
+  GenRandom *random;                              // Shared generator
+  int       commentRate;                          // Comments per 100 lines
+  int       column;                               // Current column
+  bool      glue;                                 // No space before next
+public:
+  // Class constructor.
+  GenWriter(ostream &text,                         // *In-Out* Program text
+    GenRandom &rng,                                // *In-Out* Generator
+    int rate)                                      // *In* Comment rate
+  {
+    out = &text;
+    random = &rng;
+    commentRate = rate;
+    column = 0;
+    glue = true;
+  }
+
+  // newLine ends the line, and perhaps writes a comment line.
+  void newLine()
+  {
+    static const char *words[] = {
+      "check", "the", "totals", "for", "each", "row", "before", "summing",
+      "limit", "keeps", "values", "in", "range", "see", "notes", "above"
+    };
+
+    *out << '\n';
+    column = 0;
+    glue = true;
+    if ((int)random->below(100) < commentRate)
+    {
+      int length = 2;                             // Comment so far
+
+      *out << "//";
+      while (length < 60)
+      {
+        const char *word = words[random->below(16)];
+
+        *out << ' ' << word;
+        length += 1 + (int)strlen(word);
+      }
+      *out << '\n';
+    }
+  }
+
+  // token writes text, breaking the line first if it is full. A ( or !
+  // is glued to what follows it and a ) to what precedes it.
+  void token(const string &text)                   // *In* Token text
+  {
+    if (column >= genLineWidth)
+      newLine();
+    if (!glue && text != ")")
+    {
+      *out << ' ';
+      column++;
+    }
+    *out << text;
+    column += (int)text.size();
+    glue = (text == "(" || text == "!");
+  }
+
+  // stringLit writes a string literal of size characters. Its line breaks
+  // count as line breaks of the program.
+  void stringLit(int size)                         // *In* Characters
+  {
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz     ,.";
+    string text = "\"";                           // Literal built
+
+    for (int i = 0; i < size; i++)
+    {
+      if (i % 64 == 63)
+        text += '\n';
+      else
+        text += chars[random->below(sizeof chars - 1)];
+    }
+    text += '"';
+    token(text);
+    if (size >= 63)
+      column = (int)(size % 64) + 1;
+  }
+}; // class GenWriter
+
+
+
+//***************************************************************************
+//Shape subprograms.
+//***************************************************************************
+
+void defaultShape(GenShape &shape)                 // *Out* Program shape
+{ // About 20KB of source.
+
+  shape.decls = 200;
+  shape.intWeight = 40;
+  shape.boolWeight = 20;
+  shape.floatWeight = 20;
+  shape.stringWeight = 20;
+  shape.terms = 2000;
+  shape.depth = 3;
+  shape.commentRate = 10;
+  shape.stringSize = 16;
+  shape.seed = 1;
+} // defaultShape
+
+
+
+bool parseShapeOption(int argc,                    // *In* Argument count
+  char *argv[],                                    // *In* Arguments
+  int &i,                                          // *In-Out* Argument
+  GenShape &shape)                                 // *In-Out* Program shape
+{ // Every shape option takes one value.
+
+  const char *option = argv[i];                   // Option name
+  const char *value = NULL;                       // Its value
+
+  if (i + 1 >= argc)
+    return false;
+  value = argv[i + 1];
+
+  if (strcmp(option, "--decls") == 0)
+    shape.decls = atoll(value);
+  else if (strcmp(option, "--types") == 0)
+  {
+    int weights[4] = {0, 0, 0, 0};               // int, bool, float, string
+    int n = 0;                                    // Weights read
+
+    for (const char *p = value; *p != '\0' && n < 4; n++)
+    {
+      weights[n] = atoi(p);
+      while (*p != '\0' && *p != ',')
+        p++;
+      if (*p == ',')
+        p++;
+    }
+    shape.intWeight = weights[0];
+    shape.boolWeight = weights[1];
+    shape.floatWeight = weights[2];
+    shape.stringWeight = weights[3];
+  }
+  else if (strcmp(option, "--terms") == 0)
+    shape.terms = atoll(value);
+  else if (strcmp(option, "--depth") == 0)
+    shape.depth = atoi(value);
+  else if (strcmp(option, "--comments") == 0)
+    shape.commentRate = atoi(value);
+  else if (strcmp(option, "--strings") == 0)
+    shape.stringSize = atoi(value);
+  else if (strcmp(option, "--seed") == 0)
+    shape.seed = (unsigned)strtoul(value, NULL, 10);
+  else
+    return false;
+
+  i++;
+  return true;
+} // parseShapeOption
+
+
+
+void describeShape(ostream &out,                   // *In-Out* Output
+  const GenShape &shape)                           // *In* Program shape
+{ // In the form parseShapeOption reads.
+
+  out << "--decls " << shape.decls
+      << " --types " << shape.intWeight << ',' << shape.boolWeight << ','
+      << shape.floatWeight << ',' << shape.stringWeight
+      << " --terms " << shape.terms << " --depth " << shape.depth
+      << " --comments " << shape.commentRate
+      << " --strings " << shape.stringSize << " --seed " << shape.seed;
+} // describeShape
+
+//***************************************************************************
+//End of shape subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Generation subprograms.
+//***************************************************************************
+
+// The types a declaration can have, and the identifiers declared with
+// each.
+enum GenType { GENINT, GENBOOL, GENFLOAT, GENSTRING, GENTYPES };
+
+struct GenNames                                    // Declared identifiers
+{
+  vector<string> names[GENTYPES];                 // Names by type
+}; // GenNames
+
+
+
+static string floatLit(GenRandom &random)          // *In-Out* Generator
+{ // d.d or d.d^e.
+
+  string text = to_string(random.below(100)) + "." +
+    to_string(random.below(100));                 // Literal built
+
+  if (random.below(2) == 0)
+    text += "^" + to_string(random.below(4));
+  return text;
+} // floatLit
+
+
+
+static void intLeaf(GenWriter &w,                  // *In-Out* Writer
+  GenRandom &random,                               // *In-Out* Generator
+  const GenNames &names)                           // *In* Identifiers
+{ // An int identifier or a literal.
+
+  const vector<string> &ints = names.names[GENINT];
+
+  if (!ints.empty() && random.below(2) == 0)
+    w.token(ints[random.below(ints.size())]);
+  else
+    w.token(to_string(random.below(1000)));
+} // intLeaf
+
+
+
+static void intOperand(GenWriter &w,               // *In-Out* Writer
+  GenRandom &random,                               // *In-Out* Generator
+  const GenNames &names)                           // *In* Identifiers
+{ // An operator and the leaf after it. / and % are only followed by a
+  // literal from 1 to 9, so the program never divides by zero.
+
+  static const char *ops[] = {"+", "-", "+", "-", "*", "/", "%"};
+  const char *op = ops[random.below(7)];          // Operator chosen
+
+  w.token(op);
+  if (op[0] == '/' || op[0] == '%')
+    w.token(to_string(1 + random.below(9)));
+  else
+    intLeaf(w, random, names);
+} // intOperand
+
+
+
+static void intChain(GenWriter &w,                 // *In-Out* Writer
+  GenRandom &random,                               // *In-Out* Generator
+  const GenNames &names,                           // *In* Identifiers
+  long long leaves,                                // *In* Operands, 1 or more
+  int depth)                                       // *In* Bracket depth
+{ // Each level of brackets holds half of the operands left, the innermost
+  // at least one: after[d] is the operands following level d's group.
+
+  vector<long long> after(depth + 1);             // Operands per level
+  long long         inner = leaves;               // Operands still inside
+
+  for (int d = 0; d < depth; d++)
+  {
+    long long half = inner / 2 > 0 ? inner / 2 : 1; // Left in the group
+
+    after[d] = inner - half;
+    inner = half;
+  }
+  after[depth] = inner;
+
+  for (int d = 0; d < depth; d++)
+    w.token("(");
+
+  intLeaf(w, random, names);
+  for (long long i = 1; i < after[depth]; i++)
+    intOperand(w, random, names);
+
+  for (int d = depth - 1; d >= 0; d--)
+  {
+    w.token(")");
+    for (long long i = 0; i < after[d]; i++)
+      intOperand(w, random, names);
+  }
+} // intChain
+
+
+
+static long long clause(GenWriter &w,              // *In-Out* Writer
+  GenRandom &random,                               // *In-Out* Generator
+  const GenNames &names,                           // *In* Identifiers
+  long long budget,                                // *In* Operands left
+  int depth)                                       // *In* Bracket depth
+{ // One bracketed bool operand of the top level chain. Returns the
+  // operands it used.
+
+  static const char *relops[] = {"<", ">", "<=", ">=", "==", "!="};
+  const vector<string> &bools = names.names[GENBOOL];
+  const vector<string> &floats = names.names[GENFLOAT];
+  unsigned long long    kind = random.below(8);   // Clause kind
+
+  if (budget >= 2 && kind == 0 && !floats.empty())
+  {
+    w.token("(");
+    w.token(floats[random.below(floats.size())]);
+    w.token(relops[random.below(6)]);
+    w.token(floatLit(random));
+    w.token(")");
+    return 2;
+  }
+
+  if (budget < 2 || (kind == 1 && !bools.empty()))
+  {
+    if (random.below(2) == 0)
+      w.token("!");
+    if (!bools.empty())
+      w.token(bools[random.below(bools.size())]);
+    else
+      w.token(random.below(2) == 0 ? "true" : "false");
+    return 1;
+  }
+
+  // An int comparison of up to 16 operands.
+  long long size = 2 + (long long)random.below(15); // Operands used
+  long long left = 0;                              // Left side's share
+
+  if (size > budget)
+    size = budget;
+  left = 1 + (long long)random.below(size - 1);
+
+  w.token("(");
+  intChain(w, random, names, left, depth);
+  w.token(relops[random.below(6)]);
+  intChain(w, random, names, size - left, 0);
+  w.token(")");
+  return size;
+} // clause
+
+
+
+void generateSCL(ostream &out,                     // *In-Out* Program text
+  const GenShape &shape)                           // *In* Program shape
+{ // Declarations one to a line, then the expression and end.
+
+  static const char *typeWords[GENTYPES] = {"int", "bool", "float", "string"};
+  GenRandom random(shape.seed);                   // Random numbers
+  GenWriter w(out, random, shape.commentRate);    // Token writer
+  GenNames  names;                                // Declared so far
+  int       weights[GENTYPES] = {
+    shape.intWeight, shape.boolWeight, shape.floatWeight, shape.stringWeight
+  };
+  int       total = 0;                            // Sum of the weights
+  long long budget = shape.terms > 0 ? shape.terms : 1; // Operands left
+
+  for (int t = 0; t < GENTYPES; t++)
+    total += weights[t] > 0 ? weights[t] : 0;
+  if (total == 0)
+  {
+    weights[GENINT] = 1;
+    total = 1;
+  }
+
+  for (long long d = 0; d < shape.decls; d++)
+  {
+    int    pick = (int)random.below(total);       // Weighted type choice
+    int    type = 0;                              // Type chosen
+    string name;                                  // Identifier
+
+    while (weights[type] <= 0 || pick >= weights[type])
+    {
+      if (weights[type] > 0)
+        pick -= weights[type];
+      type++;
+    }
+
+    name = string(1, "ibfs"[type]) + to_string(d);
+    w.token("let");
+    w.token(typeWords[type]);
+    w.token(name);
+    w.token("=");
+    if (type == GENINT)
+      w.token(to_string(random.below(32768)));
+    else if (type == GENBOOL)
+      w.token(random.below(2) == 0 ? "true" : "false");
+    else if (type == GENFLOAT)
+      w.token(floatLit(random));
+    else
+      w.stringLit(shape.stringSize);
+    w.token("in");
+    w.newLine();
+    names.names[type].push_back(name);
+  }
+
+  budget -= clause(w, random, names, budget, shape.depth);
+  while (budget > 0)
+  {
+    w.token(random.below(2) == 0 ? "&&" : "||");
+    budget -= clause(w, random, names, budget, shape.depth);
+  }
+  w.newLine();
+  w.token("end");
+  out << '\n';
+} // generateSCL
+
+//***************************************************************************
+//End of generation subprograms.
+//***************************************************************************
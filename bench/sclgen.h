@@ -0,0 +1,71 @@
+// Title   : sclgen.h
+// Purpose : Synthetic SCL program generator header file. Writes valid,
+//           type correct SCL programs of a chosen shape for benchmarks.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef SCLGEN_H
+#define SCLGEN_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream and string libraries.
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+
+
+
+// The shape of a generated program. The let declarations come first, with
+// their types drawn in the proportions of the four weights, then one bool
+// expression of terms operands (identifiers and literals). The expression
+// is a chain of bracketed comparisons joined by && and ||, each comparing
+// two int chains of + - * / % (or a float with a float literal, or a bool);
+// every comparison starts with a bracket group nested up to depth deep.
+// Strings are declared but not used, as no SCL operator takes them.
+//
+// Lines are broken at about 72 columns, and a // comment line is written
+// after a line break with the chance of commentRate percent. String
+// literals are stringSize characters long, and may contain spaces and
+// line breaks. The same shape and seed always give the same program.
+struct GenShape                                    // Program shape
+{
+  long long decls;                                // let declarations
+  int       intWeight;                            // Share of int
+  int       boolWeight;                           // Share of bool
+  int       floatWeight;                          // Share of float
+  int       stringWeight;                         // Share of string
+  long long terms;                                // Expression operands
+  int       depth;                                // Bracket depth
+  int       commentRate;                          // Comments per 100 lines
+  int       stringSize;                           // String literal length
+  unsigned  seed;                                 // Random seed
+}; // GenShape
+
+
+
+// defaultShape sets shape to a mid sized program of every type.
+void defaultShape(GenShape &shape);                // *Out* Program shape
+
+// parseShapeOption reads the option at argv[i] (and its value) into shape
+// and advances i past it. Returns false if it is not a shape option:
+//
+//     --decls <n> --types <int>,<bool>,<float>,<string> --terms <n>
+//     --depth <n> --comments <percent> --strings <n> --seed <n>
+bool parseShapeOption(int argc,                    // *In* Argument count
+  char *argv[],                                    // *In* Arguments
+  int &i,                                          // *In-Out* Argument
+  GenShape &shape);                                // *In-Out* Program shape
+
+// describeShape writes shape as its options.
+void describeShape(ostream &out,                   // *In-Out* Output
+  const GenShape &shape);                          // *In* Program shape
+
+// generateSCL writes a program of the given shape to out.
+void generateSCL(ostream &out,                     // *In-Out* Program text
+  const GenShape &shape);                          // *In* Program shape
+
+
+#endif
@@ -0,0 +1,139 @@
+// Title   : budget.cxx
+// Purpose : Compile budget subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <errno.h>         // errno
+#include <limits.h>        // LLONG_MAX
+#include <stdlib.h>        // strtoll
+#include <streambuf>       // Standard stream buffers
+#include <string.h>        // strcmp
+#include "budget.h"        // header for budget.cxx
+#include "stats.h"         // header for stats.cxx
+
+
+
+thread_local CompileBudget compileBudget = {};    // This thread's limits
+thread_local BudgetUse     budgetUse = {};        // This compile's use
+
+
+
+// Names and lexer messages of the budgets, in enum order. The messages
+// are numbered as the parser's Reports are.
+const char *const budgetNames[BUDGETS] = {
+  "bytes", "tokens", "nodes", "symbols", "depth", "ms"
+};
+
+const char *const budgetMessages[BUDGETS] = {
+  "Limit error 401.\nSource is larger than the byte budget.",
+  "Limit error 402.\nMore tokens than the token budget.",
+  NULL,
+  NULL,
+  NULL,
+  "Limit error 406.\nCompile ran past the time budget."
+};
+
+
+
+// 64MB of source, 8M tokens, 4M nodes, 1M declarations, brackets 10000
+// deep and 10 seconds. The parser and printers take about 1KB of stack
+// per bracket and 110 bytes per operator of a chain, so neither the depth
+// nor a chain of as many nodes as the budget allows fills a quarter of a
+// daemon worker's 1GB stack.
+const CompileBudget tenantBudget = {
+  { 64LL << 20, 8LL << 20, 4LL << 20, 1LL << 20, 10000, 10000 }
+};
+
+
+
+static long long allowed(BudgetKind kind)          // *In* Budget
+{ // The limit of kind, or LLONG_MAX if it has none.
+
+  return compileBudget.limit[kind] > 0 ? compileBudget.limit[kind] :
+    LLONG_MAX;
+} // allowed
+
+
+
+void startBudget()
+{ // The lexer checks before the first token if it has any budget.
+
+  budgetUse.tokens = 0;
+  budgetUse.lexCheck = -1;
+  if (compileBudget.limit[BUDGETBYTES] > 0 ||
+      compileBudget.limit[BUDGETTOKENS] > 0 ||
+      compileBudget.limit[BUDGETTIME] > 0)
+    budgetUse.lexCheck = 0;
+  budgetUse.nodesLeft = allowed(BUDGETNODES);
+  budgetUse.depthLeft = allowed(BUDGETDEPTH);
+  budgetUse.deadline = 0;
+  if (compileBudget.limit[BUDGETTIME] > 0)
+    budgetUse.deadline = statsClock() +
+      compileBudget.limit[BUDGETTIME] * 1000000LL;
+} // startBudget
+
+
+
+void nextLexCheck(long long lexed)                 // *In* Tokens lexed
+{ // The token budget, or 256 tokens on if the clock is due first.
+
+  budgetUse.lexCheck = -1;
+  if (compileBudget.limit[BUDGETTOKENS] > 0)
+    budgetUse.lexCheck = compileBudget.limit[BUDGETTOKENS];
+  if (budgetUse.deadline != 0 &&
+      (budgetUse.lexCheck < 0 || lexed + 256 < budgetUse.lexCheck))
+    budgetUse.lexCheck = lexed + 256;
+} // nextLexCheck
+
+
+
+bool overTime()
+{ // A compile with no deadline is never over.
+
+  return budgetUse.deadline != 0 && statsClock() > budgetUse.deadline;
+} // overTime
+
+
+
+long long sourceLeft(streambuf *buf)               // *In-Out* Source buffer
+{ // The end is found by seeking to it, then the buffer is put back.
+
+  streampos here = buf->pubseekoff(0, ios::cur, ios::in); // Where it is
+  streampos end;                                  // Its end
+
+  if (here == streampos(-1))
+    return -1;
+  end = buf->pubseekoff(0, ios::end, ios::in);
+  buf->pubseekpos(here, ios::in);
+  if (end == streampos(-1))
+    return -1;
+  return (long long)(end - here);
+} // sourceLeft
+
+
+
+bool setBudget(CompileBudget &budget,              // *In-Out* Limits
+  const char *name,                                // *In* Budget name
+  const char *value)                               // *In* Limit
+{ // The whole of value must be the number.
+
+  char      *rest;                                // After the number
+  long long limit;                                // Number read
+
+  errno = 0;
+  limit = strtoll(value, &rest, 10);
+  if (errno != 0 || rest == value || *rest != '\0' || limit < 0)
+    return false;
+
+  for (int kind = 0; kind < BUDGETS; kind++)
+    if (strcmp(name, budgetNames[kind]) == 0)
+    {
+      budget.limit[kind] = limit;
+      return true;
+    }
+  return false;
+} // setBudget
@@ -0,0 +1,115 @@
+// Title   : budget.h
+// Purpose : Compile budget header file for SCL. Limits on what one compile
+//           of untrusted source may read, build and spend.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the stream buffer library for the source size.
+#include <streambuf>       // Standard stream buffers
+
+
+
+// A compile can be limited in the source bytes it reads, the tokens it
+// lexes, the AST nodes (Expression, BasicExp, Term and Factor) it builds,
+// the let declarations it holds, the brackets and ! it is nested inside
+// and the milliseconds it runs for. A limit of 0 is no limit, and by
+// default there are none, so scl compiles whatever it is given.
+//
+// The lexer checks the first three it can see: the bytes left in the
+// source before it lexes the first token, then the token count, and the
+// clock every 256 tokens. A breach is a lexer error, written and exited
+// with (or thrown, see lexThrows) by lexFail with limitExitCode. The parser
+// checks the rest as it builds each node and declaration and enters each
+// bracket or !, and a breach is a Report numbered from minLimitError (see
+// syner.h), so the tree built so far is freed as for any other error. A
+// recovering parse (see synRecover) gives up at a breach.
+//
+// Each check is one count and one compare: the lexer counts tokens up to
+// the count at which it next has something to check, and the parser counts
+// nodes and brackets down to zero from their limits, or from LLONG_MAX if
+// there are none.
+//
+// The source is only measured if its buffer can seek, as files and string
+// streams can; the other budgets still hold a stream that cannot.
+enum BudgetKind { BUDGETBYTES, BUDGETTOKENS, BUDGETNODES, BUDGETSYMBOLS,
+  BUDGETDEPTH, BUDGETTIME, BUDGETS };
+
+// Names of the budgets, in enum order, as scl's --limit takes them.
+extern const char *const budgetNames[BUDGETS];
+
+// The lexer's messages for a breach of the bytes, tokens or time budget,
+// indexed by BudgetKind, and the exit code it gives for them.
+extern const char *const budgetMessages[BUDGETS];
+const int limitExitCode = 11;
+
+
+
+// Limits for the compiles run on a thread, indexed by BudgetKind.
+struct CompileBudget                               // Compile limits
+{
+  long long limit[BUDGETS];                       // Limit, 0 for none
+}; // CompileBudget
+
+// Where the compile running on a thread is in the budgets that are not
+// read off the source or the symbol table.
+struct BudgetUse                                   // Budget used
+{
+  long long tokens;                               // Tokens lexed
+  long long lexCheck;                             // Next check, -1 if none
+  long long nodesLeft;                            // Nodes still allowed
+  long long depthLeft;                            // Brackets and ! allowed
+  long long deadline;                             // statsClock limit, or 0
+}; // BudgetUse
+
+// The limits are per thread, like the statistics. A compile daemon sets
+// them on each worker; a lexer thread takes its parser's.
+extern thread_local CompileBudget compileBudget;
+extern thread_local BudgetUse     budgetUse;
+
+// Limits a daemon compiling other people's programs starts from: big
+// enough for any program written or generated for real, small enough that
+// no one program takes a worker's stack, memory or time from the rest.
+extern const CompileBudget tenantBudget;
+
+
+
+// overBudget returns true if used is over the limit of kind on this thread.
+inline bool overBudget(BudgetKind kind,            // *In* Budget checked
+  long long used)                                  // *In* Amount used
+{
+  return compileBudget.limit[kind] > 0 && used > compileBudget.limit[kind];
+}
+
+// startBudget starts a compile on this thread: nothing used and, if there
+// is a time budget, the deadline set from now. Called by synAnal, and by a
+// lexer thread as it starts.
+void startBudget();
+
+// nextLexCheck sets the token count at which the lexer next checks its
+// budgets, from the count lexed when it checked them last.
+void nextLexCheck(long long lexed);                // *In* Tokens lexed
+
+// overTime returns true if this thread's compile has passed its deadline.
+bool overTime();
+
+// sourceLeft returns the bytes in buf from where it is to its end, or -1
+// if it cannot seek. buf is left where it was.
+long long sourceLeft(streambuf *buf);              // *In-Out* Source buffer
+
+// setBudget sets the limit called name in budget to the number in value.
+// Returns false, leaving budget as it was, if there is no such limit or
+// value is not a number from 0 up.
+bool setBudget(CompileBudget &budget,              // *In-Out* Limits
+  const char *name,                                // *In* Budget name
+  const char *value);                              // *In* Limit
+
+
+#endif
@@ -0,0 +1,476 @@
+// Title   : csvbind.cxx
+// Purpose : Streaming CSV/TSV row binder subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The data file is mapped rather than read so that fields can be converted
+// where they lie, without copying each line into a string first. The first
+// line names the columns; every later non-empty line is a row. Fields are
+// separated by commas (CSV) or tabs (TSV). In CSV a field may be quoted
+// with " and a doubled "" inside quotes stands for one ". A trailing \r is
+// ignored so files written on Windows bind the same way.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fcntl.h>       // open
+#include <string.h>      // memchr
+#include <sys/mman.h>    // mmap, madvise, munmap
+#include <sys/stat.h>    // fstat
+#include <unistd.h>      // close
+#include <chrono>        // Wall clock timing
+#include <ostream>       // Standard output streams
+#include <string>        // Standard C++ strings library
+#include <vector>        // Standard C++ vector library
+#include "csvbind.h"     // header for csvbind.cxx
+#include "trace.h"       // header for trace.cxx
+
+
+
+// Results are staged in a buffer of this size and written to the output
+// stream once per morsel.
+const size_t outBufferSize = 1 << 20;
+
+
+
+//***************************************************************************
+//File mapping subprograms.
+//***************************************************************************
+
+bool mapFile(const char *path,                     // *In* File name
+  MappedFile &file)                                // *Out* Mapping
+{ // Maps the whole file and tells the kernel it will be read front to
+  // back so that pages behind the scan can be dropped.
+
+  struct stat info;                               // File size
+  int         fd = -1;                            // File descriptor
+  void        *base = NULL;                       // Mapped address
+  TraceSpan   span("read");                       // Traced as a file read
+
+  file.data = NULL;
+  file.size = 0;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  if (fstat(fd, &info) != 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  if (info.st_size > 0)
+  {
+    base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      close(fd);
+      return false;
+    }
+    madvise(base, info.st_size, MADV_SEQUENTIAL);
+    file.data = (const char *)base;
+    file.size = info.st_size;
+  }
+
+  // The mapping keeps the file alive.
+  close(fd);
+  return true;
+} // mapFile
+
+
+
+void unmapFile(MappedFile &file)                   // *In-Out* Mapping
+{ // Unmaps and clears the mapping.
+
+  if (file.data != NULL)
+    munmap((void *)file.data, file.size);
+
+  file.data = NULL;
+  file.size = 0;
+} // unmapFile
+
+//***************************************************************************
+//End of file mapping subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Field parsing subprograms.
+//***************************************************************************
+
+size_t nextLine(const char *data,                  // *In* Data bytes
+  size_t pos,                                      // *In* Line start
+  size_t size,                                     // *In* Data length
+  size_t &lineEnd)                                 // *Out* End of line
+{ // memchr is vectorised by the C library, which is much faster than a
+  // byte at a time loop over long lines.
+
+  const char *nl = (const char *)memchr(data + pos, '\n', size - pos);
+
+  if (nl == NULL)
+  {
+    lineEnd = size;
+    return size;
+  }
+
+  lineEnd = nl - data;
+  return lineEnd + 1;
+} // nextLine
+
+
+
+static const char *nextField(const char *pos,      // *In* Field start
+  const char *end,                                 // *In* End of line
+  char delim,                                      // *In* Delimiter
+  const char *&fieldEnd,                           // *Out* End of field
+  bool &quoted,                                    // *Out* Field quoted
+  bool &last)                                      // *Out* No more fields
+{ // Finds the end of the field at pos and returns the start of the next
+  // field. A quoted field's bounds exclude the quotes. last is set when
+  // the field is not followed by a delimiter.
+
+  const char *d = NULL;                           // Next delimiter
+
+  quoted = (delim == ',' && pos < end && *pos == '\"');
+
+  if (quoted)
+  { // Skip to the closing quote, stepping over doubled quotes.
+    const char *q = pos + 1;                      // Scan position
+
+    while (q < end)
+    {
+      if (*q == '\"')
+      {
+        if (q + 1 < end && q[1] == '\"')
+          q += 2;
+        else
+          break;
+      }
+      else
+        q++;
+    }
+    fieldEnd = q;
+    if (q < end)
+      q++;
+    last = !(q < end && *q == delim);
+    return last ? end : q + 1;
+  }
+
+  d = (const char *)memchr(pos, delim, end - pos);
+  last = (d == NULL);
+  if (last)
+  {
+    fieldEnd = end;
+    return end;
+  }
+
+  fieldEnd = d;
+  return d + 1;
+} // nextField
+
+
+
+static bool parseIntField(const char *text,        // *In* Field text
+  size_t len,                                      // *In* Field length
+  int &result)                                     // *Out* Integer value
+{ // Integers are 16 bit in SCL. Returns false on a malformed field and
+  // sets result outside the 16 bit range if the value is too large.
+
+  size_t pos = 0;                                 // Current character
+  bool   negative = false;                        // Leading minus sign
+  long   value = 0;                               // Accumulated value
+
+  if (pos < len && (text[pos] == '-' || text[pos] == '+'))
+  {
+    negative = (text[pos] == '-');
+    pos++;
+  }
+
+  if (pos == len)
+    return false;
+
+  while (pos < len)
+  {
+    if (text[pos] < '0' || text[pos] > '9')
+      return false;
+    if (value <= 100000)
+      value = value * 10 + (text[pos] - '0');
+    pos++;
+  }
+
+  result = negative ? -value : value;
+  return true;
+} // parseIntField
+
+
+
+static void bindField(const char *text,            // *In* Field text
+  size_t len,                                      // *In* Field length
+  bool quoted,                                     // *In* Field quoted
+  Value &val,                                      // *In-Out* Binding
+  long long row,                                   // *In* Row number
+  int column)                                      // *In* Column number
+{ // Converts one field to the declared type of its binding.
+
+  if (val.type == INTDATA)
+  {
+    if (!parseIntField(text, len, val.intVal))
+      throw RunReport(303, row, column);
+    if (val.intVal > 32767 || val.intVal < -32768)
+      throw RunReport(304, row, column);
+  }
+  else if (val.type == BOOLDATA)
+  {
+    if (len == 4 && memcmp(text, "true", 4) == 0)
+      val.boolVal = true;
+    else if (len == 5 && memcmp(text, "false", 5) == 0)
+      val.boolVal = false;
+    else
+      throw RunReport(303, row, column);
+  }
+  else if (val.type == FLOATDATA)
+  {
+    if (!parseFloatLit(text, len, val.floatVal))
+      throw RunReport(303, row, column);
+  }
+  else if (val.type == STRINGDATA)
+  {
+    // Reuse the binding's storage; only quoted fields containing a
+    // doubled quote need unescaping.
+    if (!quoted || memchr(text, '\"', len) == NULL)
+      val.stringVal.assign(text, len);
+    else
+    {
+      val.stringVal.clear();
+      for (size_t i = 0; i < len; i++)
+      {
+        val.stringVal += text[i];
+        if (text[i] == '\"')
+          i++;
+      }
+    }
+  }
+} // bindField
+
+
+
+void bindRow(const char *line,                     // *In* First byte
+  const char *end,                                 // *In* End of line
+  const CsvLayout &layout,                         // *In* Layout
+  Value *env,                                      // *In-Out* Bindings
+  long long row)                                   // *In* Row number
+{ // Walks the fields of the row, binding those with a declaration.
+
+  const char *fieldEnd = NULL;                    // End of current field
+  bool       quoted = false;                      // Current field quoted
+  bool       last = false;                        // Final field reached
+  size_t     columns = layout.colSlot.size();     // Expected field count
+  size_t     col = 0;                             // Current column
+
+  if (end > line && end[-1] == '\r')
+    end--;
+
+  while (!last)
+  {
+    const char *next = NULL;                      // Following field
+
+    if (col == columns)
+      throw RunReport(305, row, col + 1);
+
+    next = nextField(line, end, layout.delim, fieldEnd, quoted, last);
+    if (layout.colSlot[col] >= 0)
+    {
+      const char *text = quoted ? line + 1 : line;
+      bindField(text, fieldEnd - text, quoted, env[layout.colSlot[col]],
+        row, col + 1);
+    }
+
+    col++;
+    line = next;
+  }
+
+  if (col != columns)
+    throw RunReport(305, row, col + 1);
+} // bindRow
+
+
+
+void readLayout(const MappedFile &file,            // *In* Data file
+  SymTab *st,                                      // *In* Symbol table
+  CsvLayout &layout)                               // *Out* Layout
+{ // Splits the header line and matches each name against the SymTab.
+
+  size_t     lineEnd = 0;                         // End of header
+  const char *pos = file.data;                    // Current field
+  const char *end = NULL;                         // End of header
+  const char *fieldEnd = NULL;                    // End of name
+  bool       quoted = false;                      // Name quoted
+  bool       last = false;                        // Final name reached
+
+  layout.colSlot.clear();
+  layout.colType.clear();
+  layout.body = 0;
+  layout.delim = ',';
+
+  if (file.size == 0)
+    return;
+
+  layout.body = nextLine(file.data, 0, file.size, lineEnd);
+  end = file.data + lineEnd;
+  if (end > pos && end[-1] == '\r')
+    end--;
+
+  if (memchr(pos, '\t', end - pos) != NULL)
+    layout.delim = '\t';
+
+  while (!last)
+  {
+    const char *next = nextField(pos, end, layout.delim, fieldEnd, quoted,
+      last);
+    const char *name = quoted ? pos + 1 : pos;
+    SymTab     *entry = st;                       // Matching declaration
+
+    while (entry != NULL &&
+      entry->ident.compare(0, string::npos, name, fieldEnd - name) != 0)
+      entry = entry->next;
+
+    layout.colSlot.push_back(entry != NULL ? entry->slot : -1);
+    layout.colType.push_back(entry != NULL ? entry->type : VOIDDATA);
+
+    pos = next;
+  }
+} // readLayout
+
+//***************************************************************************
+//End of field parsing subprograms.
+//***************************************************************************
+
+
+
+size_t lineStart(const MappedFile &file,           // *In* Data file
+  size_t pos)                                      // *In* Any offset
+{ // A position just after a newline (or the start of the file) is already
+  // a line start; otherwise skip to the end of the line pos is in.
+
+  size_t lineEnd = 0;                             // Unused line end
+
+  if (pos >= file.size)
+    return file.size;
+  if (pos == 0 || file.data[pos - 1] == '\n')
+    return pos;
+
+  return nextLine(file.data, pos, file.size, lineEnd);
+} // lineStart
+
+
+
+void bindRange(const MappedFile &file,             // *In* Data file
+  size_t begin,                                    // *In* First line start
+  size_t end,                                      // *In* Range end
+  const CsvLayout &layout,                         // *In* Layout
+  RowEvaluator &eval,                              // *In-Out* Evaluator
+  Value *env,                                      // *In-Out* Bindings
+  string &results,                                 // *In-Out* Result text
+  long long &rows)                                 // *In-Out* Row count
+{ // Binds, evaluates and formats each row in turn. Errors from the
+  // evaluator are given the row number before being passed on.
+
+  Value  result;                                  // Row result
+  size_t pos = begin;                             // Current line start
+  size_t lineEnd = 0;                             // Current line end
+
+  while (pos < end)
+  {
+    size_t next = nextLine(file.data, pos, file.size, lineEnd);
+
+    // Blank lines (including a final "\r\n") are not rows.
+    if (lineEnd > pos && !(lineEnd == pos + 1 && file.data[pos] == '\r'))
+    {
+      rows++;
+      bindRow(file.data + pos, file.data + lineEnd, layout, env, rows);
+      try
+      {
+        eval.evalRow(env, result);
+      }
+      catch (RunReport r)
+      {
+        r.setRow(rows);
+        throw r;
+      }
+      appendValue(results, result);
+      results += '\n';
+    }
+
+    pos = next;
+  }
+} // bindRange
+
+
+
+void bindCSV(const char *dataPath,                 // *In* Data file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  EvalMode mode,                                   // *In* Evaluation mode
+  ostream &out,                                    // *In-Out* Results
+  BindStats &stats)                                // *Out* Statistics
+{ // Maps the file, reads the header and then works through the rows a
+  // morsel at a time, writing each morsel's results before starting the
+  // next. The mapping and evaluator are released even if a row fails.
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  MappedFile    file;                             // Mapped data file
+  CsvLayout     layout;                           // Header layout
+  vector<Value> env;                              // Bindings by slot
+  string        buffer;                           // Staged output
+  size_t        pos = 0;                          // Current morsel start
+  RowEvaluator  *eval = NULL;                     // Row evaluator
+  TraceSpan     span("bindCSV");                  // Traced as evaluation
+
+  stats.rows = 0;
+  stats.bytes = 0;
+  stats.seconds = 0.0;
+  clearCounters(stats.counters);
+
+  if (!mapFile(dataPath, file))
+    throw RunReport(306);
+
+  eval = newRowEvaluator(mode, ast);
+  bindDefaults(st, env);
+  buffer.reserve(outBufferSize);
+
+  try
+  {
+    readLayout(file, st, layout);
+    pos = layout.body;
+
+    while (pos < file.size)
+    {
+      size_t end = lineStart(file, pos + morselSize);
+
+      bindRange(file, pos, end, layout, *eval, env.data(), buffer,
+        stats.rows);
+      out.write(buffer.data(), buffer.size());
+      buffer.clear();
+
+      pos = end;
+    }
+  }
+  catch (RunReport r)
+  {
+    out.write(buffer.data(), buffer.size());
+    delete eval;
+    unmapFile(file);
+    throw;
+  }
+
+  eval->addCounters(stats.counters);
+  delete eval;
+  stats.bytes = file.size;
+  unmapFile(file);
+
+  stats.seconds = chrono::duration<double>(chrono::steady_clock::now() -
+    start).count();
+} // bindCSV
@@ -0,0 +1,140 @@
+// Title   : csvbind.h
+// Purpose : Streaming CSV/TSV row binder header file for SCL. Binds each
+//           data row to the let declarations and evaluates the program.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef CSVBIND_H
+#define CSVBIND_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream, string and vector libraries and the evaluator
+// header file for the Value type.
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "evaluator.h"     // header for evaluator.cxx
+
+
+
+// A data file mapped read-only into memory. size is 0 for an empty file, in
+// which case data is NULL.
+struct MappedFile                                  // Mapped data file
+{
+  const char *data;                               // First byte
+  size_t     size;                                // Length in bytes
+}; // MappedFile
+
+
+
+// The layout of a data file, worked out from its header line. Each column
+// is bound to the slot of the let declaration with the same name, or to -1
+// if no declaration has that name (the column is then skipped). body is
+// the offset of the first data row.
+struct CsvLayout                                   // Data file layout
+{
+  char             delim;                         // ',' or '\t'
+  vector<int>      colSlot;                       // Slot per column
+  vector<DataType> colType;                       // Type per column
+  size_t           body;                          // First data row
+}; // CsvLayout
+
+
+
+// Running totals for a bind. seconds is wall clock time for the whole
+// bind including mapping the file. counters are summed over every row
+// evaluator used.
+struct BindStats                                   // Bind statistics
+{
+  long long    rows;                              // Data rows evaluated
+  long long    bytes;                             // Data bytes scanned
+  double       seconds;                           // Elapsed time
+  EvalCounters counters;                          // Evaluator counters
+}; // BindStats
+
+
+
+// mapFile maps the named file read-only. Returns false if the file cannot
+// be opened or mapped.
+bool mapFile(const char *path,                     // *In* File name
+  MappedFile &file);                               // *Out* Mapping
+
+// unmapFile releases a mapping made by mapFile.
+void unmapFile(MappedFile &file);                  // *In-Out* Mapping
+
+
+
+// readLayout parses the header line of file. The delimiter is a tab if the
+// header line contains one and a comma otherwise.
+void readLayout(const MappedFile &file,            // *In* Data file
+  SymTab *st,                                      // *In* Symbol table
+  CsvLayout &layout);                              // *Out* Layout
+
+
+
+// nextLine finds the end of the line starting at pos (the '\n' or the end
+// of the data) and returns the offset of the line after it.
+size_t nextLine(const char *data,                  // *In* Data bytes
+  size_t pos,                                      // *In* Line start
+  size_t size,                                     // *In* Data length
+  size_t &lineEnd);                                // *Out* End of line
+
+
+
+// The data rows are processed in morsels of about this many bytes. Morsel
+// boundaries are moved forward to the next line start.
+const size_t morselSize = 1 << 20;
+
+
+
+// lineStart returns pos if it is the start of a line, otherwise the start
+// of the next line (or the end of the data).
+size_t lineStart(const MappedFile &file,           // *In* Data file
+  size_t pos);                                     // *In* Any offset
+
+
+
+// bindRow parses the fields of one data row straight into env, converting
+// each to the DataType of its declaration. row is only used to report
+// errors. Throws RunReport on a malformed row.
+void bindRow(const char *line,                     // *In* First byte
+  const char *end,                                 // *In* End of line
+  const CsvLayout &layout,                         // *In* Layout
+  Value *env,                                      // *In-Out* Bindings
+  long long row);                                  // *In* Row number
+
+
+
+// bindRange binds and evaluates every row that starts in [begin, end) and
+// appends one result line per row to results. begin must be a line start.
+// rows is incremented for each row and is the row number given in errors.
+// Throws RunReport on a data or evaluation error.
+void bindRange(const MappedFile &file,             // *In* Data file
+  size_t begin,                                    // *In* First line start
+  size_t end,                                      // *In* Range end
+  const CsvLayout &layout,                         // *In* Layout
+  RowEvaluator &eval,                              // *In-Out* Evaluator
+  Value *env,                                      // *In-Out* Bindings
+  string &results,                                 // *In-Out* Result text
+  long long &rows);                                // *In-Out* Row count
+
+
+
+// bindCSV evaluates ast once per data row of the file at dataPath and writes
+// one result line per row to out. Identifiers with no column keep their
+// initialisation literal. Results are staged in a fixed size buffer so
+// memory use does not grow with the file. mode picks the row evaluator.
+// Throws RunReport on a data or evaluation error.
+void bindCSV(const char *dataPath,                 // *In* Data file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  EvalMode mode,                                   // *In* Evaluation mode
+  ostream &out,                                    // *In-Out* Results
+  BindStats &stats);                               // *Out* Statistics
+
+
+#endif
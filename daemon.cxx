@@ -0,0 +1,327 @@
+// Title   : daemon.cxx
+// Purpose : Compile daemon subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The workers all block in accept on the one listening socket, so the
+// kernel hands each new connection to a worker that is free and nothing
+// is queued in the daemon itself. A stop request sets stopping and shuts
+// the listening socket down, which wakes every worker blocked in accept.
+// Each worker keeps its request and reply buffers for the life of the
+// daemon, so a steady stream of small programs reuses their memory.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <algorithm>         // min
+#include <atomic>            // Stop flag
+#include <chrono>            // Accept back off
+#include <errno.h>           // errno
+#include <exception>         // exception
+#include <fstream>           // Source files
+#include <iostream>          // Standard console I/O
+#include <pthread.h>         // Large stack threads
+#include <sstream>           // Source text and listing streams
+#include <string.h>          // strcpy, strerror
+#include <sys/socket.h>      // Sockets
+#include <sys/stat.h>        // stat, S_ISSOCK
+#include <sys/un.h>          // Unix socket addresses
+#include <thread>            // hardware_concurrency
+#include <unistd.h>          // close, unlink
+#include <utility>           // move
+#include <vector>            // Standard C++ vector library
+#include "daemon.h"          // header for daemon.cxx
+#include "syner.h"           // header for syner.cxx
+#include "lexer.h"           // header for lexer.cxx
+#include "stats.h"           // header for stats.cxx
+#include "budget.h"          // header for budget.cxx
+
+
+
+// Stack for each worker. The parser recurses once per operator.
+const size_t workerStack = (size_t)1 << 30;
+
+// Connections waiting to be accepted before new ones are refused.
+const int backlog = 128;
+
+// Longest wait, in milliseconds, between tries of an accept that keeps
+// failing, as it does while the process is out of file descriptors.
+const int acceptBackOff = 1000;
+
+
+
+struct Daemon                                      // Running daemon
+{
+  int          listenFd;                          // Listening socket
+  atomic<bool> stopping;                          // Stop asked for
+  CompileBudget budget;                           // Each compile's limits
+}; // Daemon
+
+
+
+void compileRequest(char kind,                     // *In* Request kind
+  const string &text,                              // *In* Source or path
+  WireReply &reply)                                // *Out* Reply
+{ // What scl writes to the output file goes to the listing and what it
+  // writes to cerr to the errors. A lexer error leaves its trees built so
+  // far with the caller, as it skips synAnal's handler, so they are freed
+  // here.
+
+  ifstream      file;                             // WIREPATH source
+  istringstream source;                           // WIRESOURCE source
+  istream       *in = &source;                    // Source compiled
+  ostringstream out;                              // Listing
+  SymTab        *st = NULL;                       // Symbol table
+  AST           *ast = NULL;                      // Abs syntax tree
+  int           label = 0;                        // Label number
+
+  reply.status = 0;
+  reply.listing.clear();
+  reply.errors.clear();
+
+  if (kind == WIREPATH)
+  {
+    file.open(text);
+    if (!file)
+    {
+      reply.status = 1;
+      reply.errors = "Unable to open source file " + text + ".\n";
+      return;
+    }
+    in = &file;
+  }
+  else if (kind == WIRESOURCE)
+    source.str(text);
+  else
+  {
+    reply.status = 2;
+    reply.errors = "Unknown request.\n";
+    return;
+  }
+
+  try
+  {
+    synAnal(*in, out, st, ast, label);
+    if (ast == NULL)
+      reply.status = 1;
+    else
+    {
+      OutSink listing(out);                       // Buffered listing
+
+      printST(listing, st);
+      listing << "\n\nExpression\n";
+      printAST(listing, ast);
+      listing << '\n';
+    }
+  }
+  catch (LexError error)
+  {
+    if (error.message != NULL)
+      out << error.message << '\n';
+    reply.status = error.code;
+  }
+  catch (exception &error)
+  {
+    reply.status = 1;
+    reply.errors = string("Unable to compile, ") + error.what() + ".\n";
+  }
+
+  freeTrees(st, ast);
+  reply.listing = move(out).str();
+} // compileRequest
+
+
+
+static void serveConnection(Daemon *daemon,        // *In-Out* Daemon
+  int fd,                                          // *In* Connection
+  string &text,                                    // *In-Out* Request text
+  WireReply &reply)                                // *In-Out* Reply
+{ // Answers requests until the client closes the connection or asks the
+  // daemon to stop.
+
+  char kind;                                      // Request kind
+
+  while (readRequest(fd, kind, text))
+  {
+    if (kind == WIRESTOP)
+    {
+      reply.status = 0;
+      reply.listing.clear();
+      reply.errors.clear();
+      sendReply(fd, reply);
+      daemon->stopping.store(true);
+      shutdown(daemon->listenFd, SHUT_RDWR);
+      return;
+    }
+
+    compileRequest(kind, text, reply);
+    if (!sendReply(fd, reply))
+      return;
+  }
+} // serveConnection
+
+
+
+static void *worker(void *arg)                     // *In* Daemon
+{ // Serves connections until the daemon stops.
+
+  Daemon    *daemon = (Daemon *)arg;              // Daemon served
+  string    text;                                 // Request text
+  WireReply reply;                                // Reply
+  int       wait = 0;                             // Back off, milliseconds
+
+  lexThrows = true;
+  compileBudget = daemon->budget;
+  clearCompileStats(false, false);
+
+  while (!daemon->stopping.load())
+  {
+    int fd = accept(daemon->listenFd, NULL, NULL); // Next connection
+
+    // A signal, or a client that went away before it was accepted, is
+    // tried again at once. Any other failure lasts until something else
+    // changes, so it is written to cerr when it starts and then waited
+    // out, each wait twice the last up to acceptBackOff, rather than spun
+    // on. The stop request's shutdown fails accept too.
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED ||
+        daemon->stopping.load())
+        continue;
+      if (wait == 0)
+        cerr << "Unable to accept a connection, " << strerror(errno)
+             << ".\n";
+      wait = (wait == 0) ? 10 : min(2 * wait, acceptBackOff);
+      this_thread::sleep_for(chrono::milliseconds(wait));
+      continue;
+    }
+
+    wait = 0;
+    serveConnection(daemon, fd, text, reply);
+    close(fd);
+  }
+  return NULL;
+} // worker
+
+
+
+static int listenOn(const char *path,              // *In* Socket path
+  string &why)                                     // *Out* Reason if not
+{ // Binds a socket to path, first removing a socket there that no daemon
+  // answers on. Returns the socket, or -1 with why set.
+
+  sockaddr_un address;                            // Daemon's address
+  struct stat info;                               // What is at path
+  int         fd;                                 // Socket
+  mode_t      mask;                               // Process's umask
+
+  memset(&address, 0, sizeof address);
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof address.sun_path)
+  {
+    why = "socket path too long";
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  if (stat(path, &info) == 0)
+  {
+    int live = connectDaemon(path, why);          // A daemon answering
+
+    if (live >= 0)
+    {
+      close(live);
+      why = "a daemon is already listening there";
+      return -1;
+    }
+    if (!S_ISSOCK(info.st_mode))
+    {
+      why = "it is not a socket";
+      return -1;
+    }
+    unlink(path);
+  }
+
+  // The socket is made readable and writable by its owner only, so only
+  // the user running the daemon (and root) can connect to it. It is never
+  // there with a wider mode, as the umask is set for the bind.
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  mask = umask(0177);
+  if (fd < 0 || bind(fd, (sockaddr *)&address, sizeof address) != 0)
+  {
+    why = strerror(errno);
+    umask(mask);
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  umask(mask);
+  if (listen(fd, backlog) != 0)
+  {
+    why = strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+} // listenOn
+
+
+
+int runDaemon(const char *path,                    // *In* Socket path
+  int threads,                                     // *In* Worker count
+  const CompileBudget &budget)                     // *In* Compile limits
+{ // The socket is removed when the daemon stops. If a worker cannot be
+  // started, those that were are stopped as a stop request would stop
+  // them and the daemon fails.
+
+  Daemon            daemon;                       // This daemon
+  string            why;                          // Why it cannot listen
+  pthread_attr_t    attr;                         // Worker attributes
+  vector<pthread_t> workers;                      // Worker threads
+  int               started = 0;                  // Workers running
+  int               error = 0;                    // pthread_create's error
+
+  if (threads < 1)
+    threads = thread::hardware_concurrency();
+  if (threads < 1)
+    threads = 1;
+
+  daemon.listenFd = listenOn(path, why);
+  if (daemon.listenFd < 0)
+  {
+    cerr << "Unable to listen on " << path << ", " << why << ".\n";
+    return 1;
+  }
+  daemon.stopping.store(false);
+  daemon.budget = budget;
+
+  cout << "Listening : " << path << "\tWorkers : " << threads << '\n';
+  cout.flush();
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, workerStack);
+  workers.resize(threads);
+  while (started < threads && error == 0)
+  {
+    error = pthread_create(&workers[started], &attr, worker, &daemon);
+    if (error == 0)
+      started++;
+  }
+  pthread_attr_destroy(&attr);
+
+  if (error != 0)
+  {
+    cerr << "Unable to start worker " << started + 1 << ", "
+         << strerror(error) << ".\n";
+    daemon.stopping.store(true);
+    shutdown(daemon.listenFd, SHUT_RDWR);
+  }
+
+  for (int i = 0; i < started; i++)
+    pthread_join(workers[i], NULL);
+
+  close(daemon.listenFd);
+  unlink(path);
+  return (error == 0) ? 0 : 1;
+} // runDaemon
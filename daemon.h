@@ -0,0 +1,52 @@
+// Title   : daemon.h
+// Purpose : Compile daemon header file for SCL. Serves compiles over a
+//           Unix socket from a long running process.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the protocol header file for WireReply and the budget header
+// file for CompileBudget.
+#include <string>          // Standard C++ strings library
+#include "wire.h"          // header for wire.cxx
+#include "budget.h"        // header for budget.cxx
+
+
+
+// runDaemon listens on a Unix socket at path and answers requests (see
+// wire.h) until one asks it to stop. Each request is compiled as scl would
+// compile it, by synAnal with the listing printed by printST and printAST,
+// and its trees are then freed, so a daemon that has served many programs
+// holds no more than one per worker. Lexer errors are thrown rather than
+// exiting (see lexThrows) and come back with lexAnal's exit code. Every
+// compile is held to budget (see budget.h), so one program too large or
+// too deep for it gets a limit error and the worker goes on to the next.
+//
+// threads workers, one per hardware thread if it is below 1, wait on the
+// socket, each serving one connection at a time on a stack large enough
+// for deeply nested programs. A stale socket left by a daemon that died
+// is removed; a live one is not. Returns the process exit code, 1 if the
+// socket or a worker cannot be made.
+//
+// The socket is created with mode 0600. Any client that can connect can
+// stop the daemon and have it open any file its user can read, so only
+// the daemon's own user may.
+int runDaemon(const char *path,                    // *In* Socket path
+  int threads,                                     // *In* Worker count
+  const CompileBudget &budget);                    // *In* Compile limits
+
+// compileRequest compiles the source or the file named by text, as kind
+// says, into reply. Used by runDaemon on each request.
+void compileRequest(char kind,                     // *In* Request kind
+  const string &text,                              // *In* Source or path
+  WireReply &reply);                               // *Out* Reply
+
+
+#endif
@@ -0,0 +1,448 @@
+// Title   : evaluator.cxx
+// Purpose : Expression evaluator subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The evaluator walks the AST built by synAnal. By the time it runs the
+// tree has been type checked, so every chain in a Term or BasicExp has a
+// single type: an int Term chain mixes *, / and %, a bool Term chain is all
+// &&, an int BasicExp chain mixes + and - and a bool BasicExp chain is all
+// ||. The chains are lists, so they are applied left to right:
+//
+//     a - b - c   is   (a - b) - c
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <stdio.h>      // snprintf
+#include <string>       // Standard C++ strings library
+#include <vector>       // Standard C++ vector library
+#include "evaluator.h"  // header for evaluator.cxx
+#include "adaptive.h"   // header for adaptive.cxx
+#include "kernels.h"    // header for kernels.cxx
+
+
+
+//***************************************************************************
+//Binding and literal subprograms.
+//***************************************************************************
+
+int countSlots(SymTab *st)                         // *In* Symbol table
+{ // The head of the table is the most recent declaration so it holds the
+  // highest slot.
+
+  if (st == NULL)
+    return 0;
+
+  return st->slot + 1;
+} // countSlots
+
+
+
+bool parseFloatLit(const char *text,               // *In* Literal text
+  size_t len,                                      // *In* Text length
+  double &result)                                  // *Out* Float value
+{ // Reads digits[.digits][^digits] by hand so that the text does not need
+  // to be NUL terminated (data fields point straight into a mapped file).
+  // A leading sign is accepted for data fields.
+
+  size_t pos = 0;                                 // Current character
+  bool   negative = false;                        // Leading minus sign
+  bool   digits = false;                          // Any mantissa digits
+  double mantissa = 0.0;                          // Mantissa value
+  double scale = 1.0;                             // Fraction place value
+  int    exponent = 0;                            // Power of ten
+
+  if (pos < len && (text[pos] == '-' || text[pos] == '+'))
+  {
+    negative = (text[pos] == '-');
+    pos++;
+  }
+
+  // Whole part.
+  while (pos < len && text[pos] >= '0' && text[pos] <= '9')
+  {
+    mantissa = mantissa * 10.0 + (text[pos] - '0');
+    digits = true;
+    pos++;
+  }
+
+  // Fraction part.
+  if (pos < len && text[pos] == '.')
+  {
+    pos++;
+    while (pos < len && text[pos] >= '0' && text[pos] <= '9')
+    {
+      scale = scale / 10.0;
+      mantissa = mantissa + (text[pos] - '0') * scale;
+      digits = true;
+      pos++;
+    }
+  }
+
+  if (!digits)
+    return false;
+
+  // Exponent part, SCL spells it with ^.
+  if (pos < len && text[pos] == '^')
+  {
+    bool expNegative = false;                     // Negative exponent
+    bool expDigits = false;                       // Any exponent digits
+
+    pos++;
+    if (pos < len && text[pos] == '-')
+    {
+      expNegative = true;
+      pos++;
+    }
+    while (pos < len && text[pos] >= '0' && text[pos] <= '9')
+    {
+      if (exponent < 10000)
+        exponent = exponent * 10 + (text[pos] - '0');
+      expDigits = true;
+      pos++;
+    }
+    if (!expDigits)
+      return false;
+    if (expNegative)
+      exponent = -exponent;
+  }
+
+  if (pos != len)
+    return false;
+
+  // Apply the exponent.
+  while (exponent > 0)
+  {
+    mantissa = mantissa * 10.0;
+    exponent--;
+  }
+  while (exponent < 0)
+  {
+    mantissa = mantissa / 10.0;
+    exponent++;
+  }
+
+  result = negative ? -mantissa : mantissa;
+  return true;
+} // parseFloatLit
+
+
+
+void litToValue(Factor *fact,                      // *In* Literal factor
+  Value &val)                                      // *Out* Value
+{ // Converts the literal field selected by fact->type.
+
+  val.type = fact->type;
+
+  if (fact->type == BOOLDATA)
+    val.boolVal = (fact->litBool == "true");
+  else if (fact->type == STRINGDATA)
+    val.stringVal = fact->litString;
+  else if (fact->type == INTDATA)
+    val.intVal = fact->litInt;
+  else if (fact->type == FLOATDATA)
+  {
+    val.floatVal = 0.0;
+    parseFloatLit(fact->litFloat.c_str(), fact->litFloat.size(),
+      val.floatVal);
+  }
+} // litToValue
+
+
+
+void bindDefaults(SymTab *st,                      // *In* Symbol table
+  vector<Value> &env)                              // *Out* Bindings
+{ // Every declaration has an initialiser (synDec insists on one) so every
+  // slot receives a value of the declared type.
+
+  env.resize(countSlots(st));
+
+  while (st != NULL)
+  {
+    env[st->slot].type = st->type;
+    if (st->initialise != NULL)
+      litToValue(st->initialise, env[st->slot]);
+
+    st = st->next;
+  }
+} // bindDefaults
+
+//***************************************************************************
+//End of binding and literal subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Expression evaluation subprograms.
+//***************************************************************************
+
+static int wrap16(int n)                           // *In* Integer result
+{ // Reduce an int result to SCL's 16 bit range.
+
+  return (int)(short)n;
+} // wrap16
+
+
+
+int applyIntOp(const string &op,                   // *In* Operator
+  int left,                                        // *In* Left operand
+  int right)                                       // *In* Right operand
+{ // Applies an integer additive or multiplicative operator.
+
+  switch (op[0])
+  {
+  case '+' : return wrap16(left + right);
+  case '-' : return wrap16(left - right);
+  case '*' : return wrap16(left * right);
+  case '/' : if (right == 0)
+               throw RunReport(301);
+             return wrap16(left / right);
+  case '%' : if (right == 0)
+               throw RunReport(302);
+             return wrap16(left % right);
+  }
+
+  throw RunReport(307);
+} // applyIntOp
+
+
+
+static void evalFactor(Factor *fact,               // *In* Factor
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Evaluates a literal, an identifier, a bracketed expression or a
+  // negated factor.
+
+  if (fact->literal)
+    litToValue(fact, result);
+  else if (fact->ident != NULL)
+    result = env[fact->ident->slot];
+  else if (fact->bExp != NULL)
+    evalExpression(fact->bExp, env, result);
+  else if (fact->nFactor != NULL)
+  {
+    evalFactor(fact->nFactor, env, result);
+    result.boolVal = !result.boolVal;
+  }
+  else
+    throw RunReport(307);
+} // evalFactor
+
+
+
+static void evalTerm(Term *term,                   // *In* Term
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Folds the factor list left to right. A bool chain is all && so it
+  // stops at the first false factor.
+
+  Value next;                                     // Next factor value
+
+  evalFactor(term->fact, env, result);
+
+  while (term->term != NULL)
+  {
+    if (result.type == BOOLDATA)
+    {
+      if (!result.boolVal)
+        return;
+      evalFactor(term->term->fact, env, result);
+    }
+    else
+    {
+      evalFactor(term->term->fact, env, next);
+      result.intVal = applyIntOp(term->mulOp, result.intVal, next.intVal);
+    }
+    term = term->term;
+  }
+} // evalTerm
+
+
+
+static void evalBasicExp(BasicExp *bexp,           // *In* BasicExp
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Folds the term list left to right. A bool chain is all || so it stops
+  // at the first true term.
+
+  Value next;                                     // Next term value
+
+  evalTerm(bexp->term, env, result);
+
+  while (bexp->bexp != NULL)
+  {
+    if (result.type == BOOLDATA)
+    {
+      if (result.boolVal)
+        return;
+      evalTerm(bexp->bexp->term, env, result);
+    }
+    else
+    {
+      evalTerm(bexp->bexp->term, env, next);
+      result.intVal = applyIntOp(bexp->addOp, result.intVal, next.intVal);
+    }
+    bexp = bexp->bexp;
+  }
+} // evalBasicExp
+
+
+
+bool compareValues(const string &relOp,            // *In* Relational op
+  const Value &left,                               // *In* Left operand
+  const Value &right)                              // *In* Right operand
+{ // The type checker has rejected relational operators on strings, so
+  // only bool, int and float operands arrive here. false < true.
+
+  double l = 0.0;                                 // Left as a number
+  double r = 0.0;                                 // Right as a number
+
+  if (left.type == FLOATDATA)
+  {
+    l = left.floatVal;
+    r = right.floatVal;
+  }
+  else if (left.type == INTDATA)
+  {
+    l = left.intVal;
+    r = right.intVal;
+  }
+  else
+  {
+    l = left.boolVal;
+    r = right.boolVal;
+  }
+
+  if (relOp == "==")
+    return l == r;
+  else if (relOp == "!=")
+    return l != r;
+  else if (relOp == "<")
+    return l < r;
+  else if (relOp == "<=")
+    return l <= r;
+  else if (relOp == ">")
+    return l > r;
+  else
+    return l >= r;
+} // compareValues
+
+
+
+void evalExpression(Expression *expr,              // *In* Expression
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // Evaluates be1 and, if there is a relational operator, compares it with
+  // be2 giving a bool.
+
+  Value right;                                    // Second basic exp
+
+  evalBasicExp(expr->be1, env, result);
+
+  if (expr->be2 != NULL)
+  {
+    evalBasicExp(expr->be2, env, right);
+    result.boolVal = compareValues(expr->relOp, result, right);
+    result.type = BOOLDATA;
+  }
+} // evalExpression
+
+
+
+void evalAST(AST *ast,                             // *In* Abs syntax tree
+  const Value *env,                                // *In* Bindings
+  Value &result)                                   // *Out* Result
+{ // An SCL program has a single expression.
+
+  if (ast == NULL || ast->expr == NULL)
+    throw RunReport(307);
+
+  evalExpression(ast->expr, env, result);
+} // evalAST
+
+//***************************************************************************
+//End of expression evaluation subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Row evaluator subprograms.
+//***************************************************************************
+
+// The plain row evaluator just walks the tree.
+class TreeEvaluator : public RowEvaluator          // TREEEVAL evaluator
+{
+private:
+  AST *ast;                                       // Program
+public:
+  // Class constructor.
+  TreeEvaluator(AST *a)                            // *In* Abs syntax tree
+  {
+    ast = a;
+  }
+
+  void evalRow(const Value *env,                   // *In* Bindings
+    Value &result)                                 // *Out* Result
+  {
+    evalAST(ast, env, result);
+  }
+}; // class TreeEvaluator
+
+
+
+RowEvaluator *newRowEvaluator(EvalMode mode,       // *In* Evaluation mode
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Picks the evaluator class for the mode.
+
+  if (mode == ADAPTIVEEVAL)
+    return new AdaptiveEvaluator(ast);
+  else if (mode == KERNELEVAL)
+    return new KernelEvaluator(ast);
+
+  return new TreeEvaluator(ast);
+} // newRowEvaluator
+
+
+
+void clearCounters(EvalCounters &counters)         // *Out* Counters
+{ // Zeroes every counter.
+
+  counters.chains = 0;
+  counters.operands = 0;
+  counters.sourceOrder = 0;
+  counters.samples = 0;
+  counters.reorders = 0;
+} // clearCounters
+
+//***************************************************************************
+//End of row evaluator subprograms.
+//***************************************************************************
+
+
+
+void appendValue(string &out,                      // *In-Out* Output text
+  const Value &val)                                // *In* Value to print
+{ // Formats val onto the end of out without building temporaries.
+
+  char digits[32];                                // Number formatting
+  int  len = 0;                                   // Formatted length
+
+  if (val.type == BOOLDATA)
+    out += val.boolVal ? "true" : "false";
+  else if (val.type == STRINGDATA)
+    out += val.stringVal;
+  else if (val.type == INTDATA)
+  {
+    len = snprintf(digits, sizeof(digits), "%d", val.intVal);
+    out.append(digits, len);
+  }
+  else if (val.type == FLOATDATA)
+  {
+    len = snprintf(digits, sizeof(digits), "%g", val.floatVal);
+    out.append(digits, len);
+  }
+} // appendValue
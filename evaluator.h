@@ -0,0 +1,226 @@
+// Title   : evaluator.h
+// Purpose : Expression evaluator header file for SCL. Evaluates the AST
+//           produced by synAnal against a set of identifier bindings.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard string and vector libraries and the syntax analysis
+// header file for the AST and SymTab types.
+#include <string>  // Standard C++ strings library
+#include <vector>  // Standard C++ vector library
+#include "syner.h" // header for syner.cxx
+
+
+
+// A value is the result of evaluating an expression or the value bound to
+// an identifier. Like Factor it uses a struct with a tag field rather than
+// a union because strings aren't allowed as union members. Integers follow
+// SCL's 16 bit semantics so intVal always lies in -32768..32767. Floats are
+// held as doubles; a float literal such as 1.5^2 is 1.5 * 10^2.
+struct Value                                       // Runtime value
+{
+  DataType type;                                  // Tag field
+  bool     boolVal;                               // Boolean value
+  int      intVal;                                // Integer value
+  double   floatVal;                              // Float value
+  string   stringVal;                             // String value
+}; // Value
+
+
+
+// Runtime errors follow the same scheme as the syntax, static and type
+// errors in syner.h. Position 0 is a dummy entry and the numbers start at
+// minRunError.
+const int maxRunError = 8;                        // Nmr of runtime errors
+const int minRunError = 300;                      // First runtime error
+
+const string runtime[maxRunError]                 // Runtime error messages
+= { "Not a runtime error.\n",                                       // 300
+
+"Attempt to divide by zero.\n",                                 // 301
+"Attempt to use % operator with zero divisor.\n",               // 302
+"Malformed value in data field.\n",                             // 303
+"Integer value in data field out of range.\n",                  // 304
+"Wrong number of fields in data row.\n",                        // 305
+"Unable to open data file.\n",                                  // 306
+
+"Unknown runtime error.\n"
+};
+
+
+
+// Runtime exception. Carries the error number and, for data binding errors,
+// the 1-based row and column of the offending field (0 when not known).
+class RunReport                                    // Runtime exceptions
+{
+private:
+  // Data members.
+  int       number;                       // Error number
+  long long row;                          // Offending data row
+  int       column;                       // Offending data column
+public:
+  // Class constructor.
+  RunReport(int n,                                 // *In* number value
+    long long r = 0,                               // *In* row value
+    int c = 0)                                     // *In* column value
+  {
+    number = n;                            // Copy parameters
+    row = r;                               // into data
+    column = c;                            // members
+  }
+
+  // Accessor methods.
+  int getNumber()
+  {
+    return number;
+  }
+  long long getRow()
+  {
+    return row;
+  }
+  int getColumn()
+  {
+    return column;
+  }
+  void setRow(long long r)
+  {
+    row = r;
+  }
+}; // class RunReport
+
+
+
+// countSlots returns the number of binding slots needed for st, which is
+// one more than the slot of the most recent declaration.
+int countSlots(SymTab *st);                        // *In* Symbol table
+
+
+
+// bindDefaults sizes env to hold every declaration in st and binds each
+// identifier to its initialisation literal.
+void bindDefaults(SymTab *st,                      // *In* Symbol table
+  vector<Value> &env);                             // *Out* Bindings
+
+
+
+// litToValue converts the literal held in fact into a Value.
+void litToValue(Factor *fact,                      // *In* Literal factor
+  Value &val);                                     // *Out* Value
+
+
+
+// parseFloatLit converts an SCL float literal (digits.digits with an
+// optional ^exponent) held in text[0..len) into a double. Returns false if
+// the text is not a well formed float.
+bool parseFloatLit(const char *text,               // *In* Literal text
+  size_t len,                                      // *In* Text length
+  double &result);                                 // *Out* Float value
+
+
+
+// evalExpression evaluates expr with identifiers bound by env, which is
+// indexed by SymTab slot. Operator chains in Term and BasicExp are applied
+// left to right; && and || short circuit. Throws RunReport on a runtime
+// error.
+void evalExpression(Expression *expr,              // *In* Expression
+  const Value *env,                                // *In* Bindings
+  Value &result);                                  // *Out* Result
+
+
+
+// applyIntOp applies an integer + - * / or % operator with 16 bit
+// wraparound. Throws RunReport on division or modulus by zero.
+int applyIntOp(const string &op,                   // *In* Operator
+  int left,                                        // *In* Left operand
+  int right);                                      // *In* Right operand
+
+// compareValues applies a relational operator to two values of the same
+// (non-string) type.
+bool compareValues(const string &relOp,            // *In* Relational op
+  const Value &left,                               // *In* Left operand
+  const Value &right);                             // *In* Right operand
+
+
+
+// evalAST evaluates the expression of the first statement in ast.
+void evalAST(AST *ast,                             // *In* Abs syntax tree
+  const Value *env,                                // *In* Bindings
+  Value &result);                                  // *Out* Result
+
+
+
+// The ways a program can be evaluated once per data row. TREEEVAL walks
+// the AST with evalAST. ADAPTIVEEVAL profiles the operands of && and ||
+// chains and reorders them so the cheapest, most decisive run first (see
+// adaptive.h). KERNELEVAL lowers the AST once to type specialised kernels
+// (see kernels.h).
+enum EvalMode { TREEEVAL, ADAPTIVEEVAL, KERNELEVAL };
+
+
+
+// Work counters for evaluation modes that keep them. The source order
+// figure is what evaluating every chain in source order would have cost;
+// it is exact while a chain is in source order and estimated from the
+// profile once it has been reordered.
+struct EvalCounters                                // Evaluation counters
+{
+  long long chains;                               // Chains evaluated
+  long long operands;                             // Operands evaluated
+  long long sourceOrder;                          // Source order operands
+  long long samples;                              // Profiled evaluations
+  long long reorders;                             // Order changes made
+}; // EvalCounters
+
+
+
+// A row evaluator evaluates one program for a row of bindings at a time.
+// It may keep state between rows (profiles, caches) so each thread needs
+// its own. The data binders create them with newRowEvaluator.
+class RowEvaluator                                 // Per row evaluator
+{
+public:
+  // Class destructor.
+  virtual ~RowEvaluator()
+  {
+  }
+
+  // Evaluates the program with identifiers bound by env.
+  virtual void evalRow(const Value *env,           // *In* Bindings
+    Value &result) = 0;                            // *Out* Result
+
+  // Adds this evaluator's counters into total. Modes without counters add
+  // nothing.
+  virtual void addCounters(EvalCounters &)         // *In-Out* Totals
+  {
+  }
+}; // class RowEvaluator
+
+
+
+// newRowEvaluator creates a row evaluator for ast in the given mode. The
+// caller deletes it.
+RowEvaluator *newRowEvaluator(EvalMode mode,       // *In* Evaluation mode
+  AST *ast);                                       // *In* Abs syntax tree
+
+
+
+// clearCounters zeroes every counter in counters.
+void clearCounters(EvalCounters &counters);        // *Out* Counters
+
+
+
+// appendValue appends the printed form of val to out. Booleans, integers
+// and strings are spelt as printAST spells literals; floats use %g.
+void appendValue(string &out,                      // *In-Out* Output text
+  const Value &val);                               // *In* Value to print
+
+
+#endif
@@ -0,0 +1,299 @@
+// Title   : hashcons.cxx
+// Purpose : Hash-consing subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Every node is looked up in one table by a NodeKey of its kind, its own
+// fields and its (already shared) child pointers. The key's strings are
+// views into the node, so a key in the table stays valid for as long as
+// the node it came from, which is the canonical one, and looking a node up
+// copies no strings. A node found in the table is deleted and its parent
+// pointed at the one in the table; its children are shared already, so
+// only the node itself goes.
+//
+// A Factor the parser left with no operand (an empty expression) is never
+// shared, as its fields are not all set.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <functional>      // hash
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <string_view>     // Strings in keys
+#include <unordered_map>   // Intern table
+#include <vector>          // Standard C++ vector library
+#include "hashcons.h"      // header for hashcons.cxx
+
+
+
+// The kinds of node in the table. A literal Factor's kind includes its
+// type, as the same text may be two literals.
+enum NodeKind { KINDEXPRESSION, KINDBASICEXP, KINDTERM, KINDIDENT,
+  KINDBRACKET, KINDNOT, KINDBOOL, KINDSTRING, KINDINT, KINDFLOAT };
+
+
+
+// What makes two nodes of the same kind identical.
+struct NodeKey                                     // Interned node
+{
+  int         kind;                               // NodeKind
+  const void  *left;                              // First child or ident
+  const void  *right;                             // Second child
+  string_view text;                               // Operator or literal
+  int         number;                             // Integer literal
+}; // NodeKey
+
+
+
+struct NodeKeyHash                                 // Hash of a NodeKey
+{
+  size_t operator()(const NodeKey &k) const
+  {
+    size_t h = hash<string_view>()(k.text);       // Combined hash
+
+    h = h * 31 + hash<const void *>()(k.left);
+    h = h * 31 + hash<const void *>()(k.right);
+    return h * 31 + (size_t)(k.kind * 65537 + k.number);
+  }
+}; // NodeKeyHash
+
+
+
+struct NodeKeyEqual                                // NodeKey equality
+{
+  bool operator()(const NodeKey &a, const NodeKey &b) const
+  {
+    return a.kind == b.kind && a.left == b.left && a.right == b.right &&
+      a.number == b.number && a.text == b.text;
+  }
+}; // NodeKeyEqual
+
+
+
+// The table and the running counts.
+struct Sharing                                     // Sharing in progress
+{
+  unordered_map<NodeKey, void *, NodeKeyHash, NodeKeyEqual> nodes; // Table
+  ShareStats stats;                               // Savings so far
+}; // Sharing
+
+
+
+//***************************************************************************
+//Interning subprograms.
+//***************************************************************************
+
+static long long heapBytes(const string &s)        // *In* String
+{ // The bytes s owns on the heap: none while it is short enough to be
+  // held inside the string itself.
+
+  const char *inside = (const char *)&s;          // The string object
+
+  if (s.data() >= inside && s.data() < inside + sizeof s)
+    return 0;
+  return (long long)s.capacity() + 1;
+} // heapBytes
+
+
+
+template <class T>
+static T *intern(Sharing &sh,                      // *In-Out* Sharing
+  const NodeKey &key,                              // *In* Node's key
+  T *node,                                         // *In* Node
+  long long bytes)                                 // *In* Node's bytes
+{ // Returns the node in the table identical to node, deleting node, or
+  // adds node to the table and returns it.
+
+  pair<unordered_map<NodeKey, void *, NodeKeyHash,
+    NodeKeyEqual>::iterator, bool> added = sh.nodes.emplace(key, node);
+
+  sh.stats.nodesBefore++;
+  sh.stats.bytesBefore += bytes;
+  if (added.second)
+    return node;
+
+  sh.stats.nodesAfter--;
+  sh.stats.bytesAfter -= bytes;
+  delete node;
+  return (T *)added.first->second;
+} // intern
+
+
+
+static Expression *shareExpression(Sharing &sh,    // *In-Out* Sharing
+  Expression *expr);                               // *In* Expression
+
+
+
+static Factor *shareFactor(Sharing &sh,            // *In-Out* Sharing
+  Factor *fact)                                    // *In* Factor
+{ // Brackets and ! recurse, as the parser did.
+
+  NodeKey   key = { KINDIDENT, NULL, NULL, string_view(), 0 }; // Its key
+  long long bytes = sizeof(Factor) + heapBytes(fact->litBool) +
+    heapBytes(fact->litString) + heapBytes(fact->litFloat); // Its size
+
+  if (fact->bExp != NULL)
+  {
+    fact->bExp = shareExpression(sh, fact->bExp);
+    key.kind = KINDBRACKET;
+    key.left = fact->bExp;
+  }
+  else if (fact->nFactor != NULL)
+  {
+    fact->nFactor = shareFactor(sh, fact->nFactor);
+    key.kind = KINDNOT;
+    key.left = fact->nFactor;
+  }
+  else if (fact->ident != NULL)
+    key.left = fact->ident;
+  else if (fact->literal && fact->type == BOOLDATA)
+  {
+    key.kind = KINDBOOL;
+    key.text = fact->litBool;
+  }
+  else if (fact->literal && fact->type == STRINGDATA)
+  {
+    key.kind = KINDSTRING;
+    key.text = fact->litString;
+  }
+  else if (fact->literal && fact->type == INTDATA)
+  {
+    key.kind = KINDINT;
+    key.number = fact->litInt;
+  }
+  else if (fact->literal && fact->type == FLOATDATA)
+  {
+    key.kind = KINDFLOAT;
+    key.text = fact->litFloat;
+  }
+  else
+  {
+    sh.stats.nodesBefore++;
+    sh.stats.bytesBefore += bytes;
+    return fact;
+  }
+
+  return intern(sh, key, fact, bytes);
+} // shareFactor
+
+
+
+static Term *shareTerm(Sharing &sh,                // *In-Out* Sharing
+  Term *term)                                      // *In* Term list
+{ // The list is interned from its last node back, each node after the
+  // rest of the list it points to.
+
+  vector<Term *> list;                            // The list's nodes
+  Term           *rest = NULL;                    // Shared rest of list
+
+  for (; term != NULL; term = term->term)
+    list.push_back(term);
+
+  for (size_t i = list.size(); i-- > 0;)
+  {
+    Term    *node = list[i];                      // Node interned
+    NodeKey key;                                  // Its key
+
+    node->fact = shareFactor(sh, node->fact);
+    node->term = rest;
+    key = { KINDTERM, node->fact, node->term, node->mulOp, 0 };
+    rest = intern(sh, key, node,
+      (long long)sizeof(Term) + heapBytes(node->mulOp));
+  }
+
+  return rest;
+} // shareTerm
+
+
+
+static BasicExp *shareBasicExp(Sharing &sh,        // *In-Out* Sharing
+  BasicExp *bexp)                                  // *In* BasicExp list
+{ // As shareTerm.
+
+  vector<BasicExp *> list;                        // The list's nodes
+  BasicExp           *rest = NULL;                // Shared rest of list
+
+  for (; bexp != NULL; bexp = bexp->bexp)
+    list.push_back(bexp);
+
+  for (size_t i = list.size(); i-- > 0;)
+  {
+    BasicExp *node = list[i];                     // Node interned
+    NodeKey  key;                                 // Its key
+
+    node->term = shareTerm(sh, node->term);
+    node->bexp = rest;
+    key = { KINDBASICEXP, node->term, node->bexp, node->addOp, 0 };
+    rest = intern(sh, key, node,
+      (long long)sizeof(BasicExp) + heapBytes(node->addOp));
+  }
+
+  return rest;
+} // shareBasicExp
+
+
+
+static Expression *shareExpression(Sharing &sh,    // *In-Out* Sharing
+  Expression *expr)                                // *In* Expression
+{ // Both sides, then the expression.
+
+  NodeKey key;                                    // Its key
+
+  expr->be1 = shareBasicExp(sh, expr->be1);
+  if (expr->be2 != NULL)
+    expr->be2 = shareBasicExp(sh, expr->be2);
+
+  key = { KINDEXPRESSION, expr->be1, expr->be2, expr->relOp, 0 };
+  return intern(sh, key, expr,
+    (long long)sizeof(Expression) + heapBytes(expr->relOp));
+} // shareExpression
+
+//***************************************************************************
+//End of interning subprograms.
+//***************************************************************************
+
+
+
+void shareAST(AST *ast,                            // *In-Out* Abs syntax tree
+  ShareStats &stats)                               // *Out* Savings
+{ // nodesAfter and bytesAfter count down from zero as copies are deleted,
+  // and are added to the totals at the end.
+
+  Sharing sh;                                     // Table and counts
+
+  sh.stats.nodesBefore = 0;
+  sh.stats.nodesAfter = 0;
+  sh.stats.bytesBefore = 0;
+  sh.stats.bytesAfter = 0;
+
+  if (ast != NULL && !ast->shared && ast->expr != NULL)
+  {
+    ast->expr = shareExpression(sh, ast->expr);
+    ast->shared = true;
+  }
+
+  sh.stats.nodesAfter += sh.stats.nodesBefore;
+  sh.stats.bytesAfter += sh.stats.bytesBefore;
+  stats = sh.stats;
+} // shareAST
+
+
+
+void reportSharing(ostream &out,                   // *In-Out* Output
+  const ShareStats &stats)                         // *In* Savings
+{ // Counts, then the savings as percentages of the tree.
+
+  out << "Shared : Nodes : " << stats.nodesBefore << " -> "
+      << stats.nodesAfter << "\tBytes : " << stats.bytesBefore << " -> "
+      << stats.bytesAfter;
+  if (stats.nodesBefore > 0 && stats.bytesBefore > 0)
+    out << "\tSaved : "
+        << 100.0 * (stats.nodesBefore - stats.nodesAfter) /
+             stats.nodesBefore << "% nodes, "
+        << 100.0 * (stats.bytesBefore - stats.bytesAfter) /
+             stats.bytesBefore << "% bytes";
+  out << '\n';
+} // reportSharing
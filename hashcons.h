@@ -0,0 +1,69 @@
+// Title   : hashcons.h
+// Purpose : Hash-consing header file for SCL. Shares identical subtrees of
+//           the expression tree so that the AST becomes a DAG.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef HASHCONS_H
+#define HASHCONS_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard output streams and the syntax analysis header file for
+// the AST types.
+#include <ostream>         // Standard output streams
+#include "syner.h"         // header for syner.cxx
+
+
+
+// Generated programs repeat the same subexpressions many times: the same
+// identifiers and literals in every chain, and often the same bracketed
+// Expression in several Terms. shareAST keeps one node for each distinct
+// Expression, BasicExp, Term and Factor and points every parent at it, so
+// that
+//
+//     (x * 2 + y) > 10 && (x * 2 + y) < 20
+//
+// holds one copy of (x * 2 + y), and of its x, 2 and y, referenced twice.
+// Nodes are interned bottom up: once a node's children are shared, two
+// nodes are identical exactly when their own fields and child pointers
+// are, so each node is hashed and compared in constant time. Term and
+// BasicExp lists are interned from their last node back, so lists with
+// the same tail share it.
+//
+// The tree is only read afterwards: the printers, evaluators, dumps and
+// images all walk it as they would the tree, with the same results. The
+// kernel evaluator lowers a shared bracketed Expression once and computes
+// it once per row (see kernels.h). freeTrees frees each node once.
+
+
+
+// What sharing saved. Nodes are the Expression, BasicExp, Term and Factor
+// nodes of the expression; bytes are their sizes and the string storage
+// they own on the heap.
+struct ShareStats                                  // Sharing results
+{
+  long long nodesBefore;                          // Nodes in the tree
+  long long nodesAfter;                           // Nodes in the DAG
+  long long bytesBefore;                          // Bytes in the tree
+  long long bytesAfter;                           // Bytes in the DAG
+}; // ShareStats
+
+
+
+// shareAST shares the identical subtrees of the expression of ast, which
+// must be the result of a successful synAnal, deleting the copies, and
+// sets ast->shared. An AST already shared is left as it is, with no
+// savings.
+void shareAST(AST *ast,                            // *In-Out* Abs syntax tree
+  ShareStats &stats);                              // *Out* Savings
+
+// reportSharing writes stats as one line to out.
+void reportSharing(ostream &out,                   // *In-Out* Output
+  const ShareStats &stats);                        // *In* Savings
+
+
+#endif
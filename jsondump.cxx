@@ -0,0 +1,401 @@
+// Title   : jsondump.cxx
+// Purpose : JSON and NDJSON dump subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Term and BasicExp lists are walked with loops, twice each (once for the
+// operands and once for the operators), so a long chain costs no stack.
+// Only brackets and ! recurse, as they do in the printers.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>         // Standard file I/O
+#include <math.h>          // isfinite
+#include <stdio.h>         // snprintf
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "jsondump.h"      // header for jsondump.cxx
+#include "evaluator.h"     // header for evaluator.cxx (parseFloatLit)
+#include "stats.h"         // header for stats.cxx
+#include "trace.h"         // header for trace.cxx
+
+
+
+// Names of the DataType values, in enum order.
+static const char *typeNames[] = {
+  "\"void\"", "\"bool\"", "\"string\"", "\"int\"", "\"float\""
+};
+
+
+
+//***************************************************************************
+//Value output subprograms.
+//***************************************************************************
+
+void jsonString(OutSink &out,                      // *In-Out* Output sink
+  const string &s)                                 // *In* String
+{ // Runs of characters that need no escaping are written in one go.
+
+  static const char hex[] = "0123456789abcdef";
+  size_t            run = 0;                      // Start of current run
+
+  out << '"';
+  for (size_t i = 0; i < s.size(); i++)
+  {
+    unsigned char c = (unsigned char)s[i];        // Character to check
+
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+
+    out.write(s.data() + run, i - run);
+    run = i + 1;
+
+    if (c == '"')
+      out << "\\\"";
+    else if (c == '\\')
+      out << "\\\\";
+    else if (c == '\n')
+      out << "\\n";
+    else if (c == '\t')
+      out << "\\t";
+    else if (c == '\r')
+      out << "\\r";
+    else
+    {
+      out << "\\u00";
+      out << hex[c >> 4] << hex[c & 15];
+    }
+  }
+  out.write(s.data() + run, s.size() - run);
+  out << '"';
+} // jsonString
+
+
+
+static void jsonFloat(OutSink &out,                // *In-Out* Output sink
+  const string &text)                              // *In* SCL float literal
+{ // Writes "text" and "value" fields. A literal too large for a double
+  // has a null value.
+
+  char   digits[32];                              // Formatted value
+  double value = 0.0;                             // Parsed literal
+
+  out << "\"text\":";
+  jsonString(out, text);
+  out << ",\"value\":";
+  if (parseFloatLit(text.data(), text.size(), value) && isfinite(value))
+  {
+    snprintf(digits, sizeof digits, "%.17g", value);
+    out << digits;
+  }
+  else
+    out << "null";
+} // jsonFloat
+
+
+
+static void jsonLiteral(OutSink &out,              // *In-Out* Output sink
+  Factor *fact)                                    // *In* Literal factor
+{ // The literal's value as a JSON value.
+
+  if (fact->type == BOOLDATA)
+    out << (fact->litBool == "true" ? "true" : "false");
+  else if (fact->type == STRINGDATA)
+    jsonString(out, fact->litString);
+  else if (fact->type == INTDATA)
+    out << fact->litInt;
+  else if (fact->type == FLOATDATA)
+  {
+    out << '{';
+    jsonFloat(out, fact->litFloat);
+    out << '}';
+  }
+  else
+    out << "null";
+} // jsonLiteral
+
+
+
+static void beginRecord(OutSink &out,              // *In-Out* Output sink
+  JsonMode mode,                                   // *In* Output mode
+  long long &records)                              // *In-Out* Records so far
+{ // Separates records: a comma between array elements in JSONDOC mode.
+
+  if (mode == JSONDOC && records > 0)
+    out << ',';
+  records++;
+} // beginRecord
+
+
+
+static void endRecord(OutSink &out,                // *In-Out* Output sink
+  JsonMode mode)                                   // *In* Output mode
+{ // Ends an NDJSON line.
+
+  if (mode == NDJSON)
+    out << '\n';
+} // endRecord
+
+//***************************************************************************
+//End of value output subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Expression output subprograms.
+//***************************************************************************
+
+static void jsonExpression(OutSink &out,           // *In-Out* Output sink
+  Expression *expr);                               // *In* Expression
+
+
+
+static void jsonFactor(OutSink &out,               // *In-Out* Output sink
+  Factor *fact)                                    // *In* Factor
+{ // One of the four kinds of factor.
+
+  if (fact->literal)
+  {
+    out << "{\"kind\":\"literal\",\"type\":" << typeNames[fact->type];
+    if (fact->type == FLOATDATA)
+    {
+      out << ',';
+      jsonFloat(out, fact->litFloat);
+    }
+    else
+    {
+      out << ",\"value\":";
+      jsonLiteral(out, fact);
+    }
+    out << '}';
+  }
+  else if (fact->ident != NULL)
+  {
+    out << "{\"kind\":\"ident\",\"name\":";
+    jsonString(out, fact->ident->ident);
+    out << ",\"slot\":" << fact->ident->slot
+        << ",\"type\":" << typeNames[fact->ident->type] << '}';
+  }
+  else if (fact->bExp != NULL)
+  {
+    out << "{\"kind\":\"paren\",\"expr\":";
+    jsonExpression(out, fact->bExp);
+    out << '}';
+  }
+  else if (fact->nFactor != NULL)
+  {
+    out << "{\"kind\":\"not\",\"factor\":";
+    jsonFactor(out, fact->nFactor);
+    out << '}';
+  }
+  else
+    out << "null";
+} // jsonFactor
+
+
+
+static void jsonTerm(OutSink &out,                 // *In-Out* Output sink
+  Term *term)                                      // *In* Term list
+{ // The factors, then the operators between them.
+
+  out << "{\"kind\":\"term\",\"factors\":[";
+  for (Term *t = term; t != NULL; t = t->term)
+  {
+    jsonFactor(out, t->fact);
+    if (t->term != NULL)
+      out << ',';
+  }
+  out << "],\"ops\":[";
+  for (Term *t = term; t != NULL && t->term != NULL; t = t->term)
+  {
+    if (t != term)
+      out << ',';
+    jsonString(out, t->mulOp);
+  }
+  out << "]}";
+} // jsonTerm
+
+
+
+static void jsonBasicExp(OutSink &out,             // *In-Out* Output sink
+  BasicExp *bexp)                                  // *In* BasicExp list
+{ // The terms, then the operators between them.
+
+  out << "{\"kind\":\"basic\",\"terms\":[";
+  for (BasicExp *b = bexp; b != NULL; b = b->bexp)
+  {
+    jsonTerm(out, b->term);
+    if (b->bexp != NULL)
+      out << ',';
+  }
+  out << "],\"ops\":[";
+  for (BasicExp *b = bexp; b != NULL && b->bexp != NULL; b = b->bexp)
+  {
+    if (b != bexp)
+      out << ',';
+    jsonString(out, b->addOp);
+  }
+  out << "]}";
+} // jsonBasicExp
+
+
+
+static void jsonExpression(OutSink &out,           // *In-Out* Output sink
+  Expression *expr)                                // *In* Expression
+{ // The relational operator and right side only if there is one.
+
+  out << "{\"kind\":\"expression\",\"left\":";
+  jsonBasicExp(out, expr->be1);
+  if (expr->be2 != NULL)
+  {
+    out << ",\"relop\":";
+    jsonString(out, expr->relOp);
+    out << ",\"right\":";
+    jsonBasicExp(out, expr->be2);
+  }
+  out << '}';
+} // jsonExpression
+
+//***************************************************************************
+//End of expression output subprograms.
+//***************************************************************************
+
+
+
+void jsonTokens(ifstream &inFile,                  // *In-Out* Source file
+  ofstream &errFile,                               // *In-Out* Error file
+  OutSink &out,                                    // *In-Out* Output sink
+  JsonMode mode)                                   // *In* Output mode
+{ // lexAnal assumes the input is at the start of a token, so leading
+  // white space and comments are skipped first, as synAnal does.
+
+  LexToken  token;                                // Token lexed
+  long long records = 0;                          // Tokens written
+  TraceSpan span("jsonTokens");                   // Lexing and writing
+
+  if (mode == JSONDOC)
+    out << '[';
+
+  skipWhiteComments(inFile);
+  do
+  {
+    lexAnal(inFile, errFile, token);
+    beginRecord(out, mode, records);
+    out << "{\"record\":\"token\",\"tag\":\"" << lexTagNames[token.tag] << '"';
+
+    switch (token.tag)
+    {
+    case IDENT     : out << ",\"text\":";
+                     jsonString(out, token.ident);
+                     break;
+    case BOOLLIT   : out << ",\"value\":"
+                         << (token.boolLit == "true" ? "true" : "false");
+                     break;
+    case STRINGLIT : out << ",\"value\":";
+                     jsonString(out, token.stringLit);
+                     break;
+    case INTLIT    : out << ",\"value\":" << token.intLit;
+                     break;
+    case FLOATLIT  : out << ',';
+                     jsonFloat(out, token.floatLit);
+                     break;
+    case ADDOP     : out << ",\"op\":";
+                     jsonString(out, token.addOp);
+                     break;
+    case RELOP     : out << ",\"op\":";
+                     jsonString(out, token.relOp);
+                     break;
+    case MULOP     : out << ",\"op\":";
+                     jsonString(out, token.mulOp);
+                     break;
+    default        : break;
+    }
+
+    out << '}';
+    endRecord(out, mode);
+  } while (token.tag != END);
+
+  if (mode == JSONDOC)
+    out << ']';
+} // jsonTokens
+
+
+
+void jsonST(OutSink &out,                          // *In-Out* Output sink
+  SymTab *st,                                      // *In* Symbol table
+  JsonMode mode)                                   // *In* Output mode
+{ // The table is a list in reverse order of declaration; the entries are
+  // indexed by slot so they can be written in declaration order.
+
+  vector<SymTab *> bySlot;                        // Entries by slot
+  long long        records = 0;                   // Symbols written
+
+  PhaseTimer timer(PHASEPRINT);                   // Charged to printers
+  TraceSpan  span("jsonST");                      // Traced as jsonST
+
+  for (SymTab *entry = st; entry != NULL; entry = entry->next)
+  {
+    if (entry->slot >= (int)bySlot.size())
+      bySlot.resize(entry->slot + 1, NULL);
+    bySlot[entry->slot] = entry;
+  }
+
+  if (mode == JSONDOC)
+    out << '[';
+
+  for (size_t i = 0; i < bySlot.size(); i++)
+  {
+    SymTab *entry = bySlot[i];                    // Entry to write
+
+    if (entry == NULL)
+      continue;
+
+    beginRecord(out, mode, records);
+    out << "{\"record\":\"symbol\",\"slot\":" << entry->slot << ",\"ident\":";
+    jsonString(out, entry->ident);
+    out << ",\"type\":" << typeNames[entry->type] << ",\"init\":";
+    if (entry->initialise != NULL)
+      jsonLiteral(out, entry->initialise);
+    else
+      out << "null";
+    out << '}';
+    endRecord(out, mode);
+  }
+
+  if (mode == JSONDOC)
+    out << ']';
+} // jsonST
+
+
+
+void jsonAST(OutSink &out,                         // *In-Out* Output sink
+  AST *ast,                                        // *In* Abs syntax tree
+  JsonMode mode)                                   // *In* Output mode
+{ // One record per statement.
+
+  long long records = 0;                          // Statements written
+
+  PhaseTimer timer(PHASEPRINT);                   // Charged to printers
+  TraceSpan  span("jsonAST");                     // Traced as jsonAST
+
+  if (mode == JSONDOC)
+    out << '[';
+
+  for (; ast != NULL; ast = ast->next)
+  {
+    if (ast->expr == NULL)
+      continue;
+
+    beginRecord(out, mode, records);
+    out << "{\"record\":\"statement\",\"expr\":";
+    jsonExpression(out, ast->expr);
+    out << '}';
+    endRecord(out, mode);
+  }
+
+  if (mode == JSONDOC)
+    out << ']';
+} // jsonAST
@@ -0,0 +1,76 @@
+// Title   : jsondump.h
+// Purpose : JSON and NDJSON dump header file for SCL. Writes the token
+//           stream, the symbol table and the AST in machine readable form.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef JSONDUMP_H
+#define JSONDUMP_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include file IO library, the output sink and syntax analysis header
+// files.
+#include <fstream>         // Standard file I/O
+#include "outsink.h"       // header for outsink.cxx
+#include "syner.h"         // header for syner.cxx
+
+
+
+// The emitters write straight from LexToken, SymTab and the AST into an
+// OutSink, one record at a time; nothing is built in memory first. Every
+// record is a JSON object with a "record" field of "token", "symbol" or
+// "statement":
+//
+//     {"record":"token","tag":"INTLIT","value":42}
+//     {"record":"symbol","slot":0,"ident":"x","type":"int","init":42}
+//     {"record":"statement","expr":EXPR}
+//
+// Symbols are written in declaration (slot) order. Statements hold the
+// expression tree, with each list as an array and its operators alongside:
+//
+//     EXPR   {"kind":"expression","left":BASIC[,"relop":"<","right":BASIC]}
+//     BASIC  {"kind":"basic","terms":[TERM,...],"ops":["+",...]}
+//     TERM   {"kind":"term","factors":[FACTOR,...],"ops":["*",...]}
+//     FACTOR {"kind":"literal","type":"int","value":3}
+//            {"kind":"ident","name":"x","slot":0,"type":"int"}
+//            {"kind":"paren","expr":EXPR}
+//            {"kind":"not","factor":FACTOR}
+//
+// Literal values are JSON booleans, strings and numbers. Float literals
+// keep their SCL spelling in "text" as well as a numeric "value", so a
+// float "init" is the object {"text":"1.5^3","value":1500}.
+//
+// In JSONDOC mode a list of records is written as a JSON array; in NDJSON
+// mode each record is written on a line of its own.
+enum JsonMode { JSONDOC, NDJSON };
+
+
+
+// jsonTokens lexes the program in inFile up to and including its end token
+// and writes one record per token. Lexical errors are reported to errFile
+// by lexAnal.
+void jsonTokens(ifstream &inFile,                  // *In-Out* Source file
+  ofstream &errFile,                               // *In-Out* Error file
+  OutSink &out,                                    // *In-Out* Output sink
+  JsonMode mode);                                  // *In* Output mode
+
+// jsonST writes one record per symbol table entry.
+void jsonST(OutSink &out,                          // *In-Out* Output sink
+  SymTab *st,                                      // *In* Symbol table
+  JsonMode mode);                                  // *In* Output mode
+
+// jsonAST writes one record per AST entry.
+void jsonAST(OutSink &out,                         // *In-Out* Output sink
+  AST *ast,                                        // *In* Abs syntax tree
+  JsonMode mode);                                  // *In* Output mode
+
+// jsonString writes s as a quoted, escaped JSON string.
+void jsonString(OutSink &out,                      // *In-Out* Output sink
+  const string &s);                                // *In* String
+
+
+#endif
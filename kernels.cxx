@@ -0,0 +1,464 @@
+// Title   : kernels.cxx
+// Purpose : Lowering of the SCL AST to type specialised kernels.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Lowering walks the tree once, using the types synAnal recorded in each
+// Factor to pick the kernel class for every node. All the decisions on
+// DataType and operator strings happen here and nowhere else.
+//
+// In a shared AST the bracketed Expressions are first counted the way
+// lowering will reach them: each time a parent reaches one, but inside it
+// only the first time, as lowering stops at one already lowered. Those
+// reached more than once are cached, unless they are a lone identifier or
+// literal, which is cheaper to read again than to cache.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <string>        // Standard C++ strings library
+#include <unordered_map> // Shared brackets by node
+#include <vector>        // Standard C++ vector library
+#include "kernels.h"     // header for kernels.cxx
+
+
+
+// A kernel that has been lowered but whose C++ type is only known through
+// its DataType tag.
+struct Lowered                                     // Lowered subtree
+{
+  DataType   type;                                // Result type
+  KernelNode *node;                               // Kernel
+}; // Lowered
+
+
+
+// What lowering is building, and the shared brackets.
+struct Lowering                                    // Lowering in progress
+{
+  KernelTree                                 &tree; // Kernel tree
+  RowCounter                                 *rows; // Its row number
+  unordered_map<const Expression *, int>     uses;  // Times reached
+  unordered_map<const Expression *, Lowered> done;  // Cached kernels
+}; // Lowering
+
+
+
+//***************************************************************************
+//Kernel construction subprograms.
+//***************************************************************************
+
+template <class K>
+static K *addKernel(KernelTree &tree,              // *In-Out* Kernel tree
+  K *kernel)                                       // *In* New kernel
+{ // Records kernel in the tree so that freeKernels can delete it.
+
+  tree.nodes.push_back(kernel);
+  return kernel;
+} // addKernel
+
+
+
+template <class T>
+static const Kernel<T> *as(const Lowered &low)     // *In* Lowered subtree
+{ // The type checker guarantees the tag matches what the caller expects.
+
+  return static_cast<const Kernel<T> *>(low.node);
+} // as
+
+
+
+template <class T>
+static Lowered lowered(KernelNode *node)           // *In* New kernel
+{ // Tags a kernel with the DataType of T.
+
+  Lowered low = { ValueField<T>::type, node };
+  return low;
+} // lowered
+
+
+
+static Lowered makeIntOp(KernelTree &tree,         // *In-Out* Kernel tree
+  const string &op,                                // *In* Operator
+  const Lowered &left,                             // *In* Left operand
+  const Lowered &right)                            // *In* Right operand
+{ // Picks the IntBinaryKernel for an arithmetic operator.
+
+  const Kernel<int> *l = as<int>(left);           // Left operand
+  const Kernel<int> *r = as<int>(right);          // Right operand
+
+  if (op == "+")
+    return lowered<int>(addKernel(tree, new IntBinaryKernel<AddOp>(l, r)));
+  else if (op == "-")
+    return lowered<int>(addKernel(tree, new IntBinaryKernel<SubOp>(l, r)));
+  else if (op == "*")
+    return lowered<int>(addKernel(tree, new IntBinaryKernel<MulOp>(l, r)));
+  else if (op == "/")
+    return lowered<int>(addKernel(tree, new IntBinaryKernel<DivOp>(l, r)));
+  else if (op == "%")
+    return lowered<int>(addKernel(tree, new IntBinaryKernel<ModOp>(l, r)));
+
+  throw RunReport(307);
+} // makeIntOp
+
+
+
+static int powerOfTwo(const string &op,            // *In* Operator
+  Factor *fact)                                    // *In* Right operand
+{ // k if op is * / or % and fact is the int literal 2^k for k of 1 or
+  // more, otherwise 0.
+
+  int k = 0;                                      // Power found
+
+  if ((op != "*" && op != "/" && op != "%") || !fact->literal ||
+    fact->type != INTDATA || fact->litInt < 2 ||
+    (fact->litInt & (fact->litInt - 1)) != 0)
+    return 0;
+
+  while ((1 << k) != fact->litInt)
+    k++;
+  return k;
+} // powerOfTwo
+
+
+
+static Lowered makePowerOp(KernelTree &tree,       // *In-Out* Kernel tree
+  const string &op,                                // *In* * / or %
+  const Lowered &left,                             // *In* Left operand
+  int k)                                           // *In* Power of two
+{ // Picks the shift or mask that does op by 2^k.
+
+  const Kernel<int> *l = as<int>(left);           // Left operand
+
+  if (op == "*")
+    return lowered<int>(addKernel(tree,
+      new IntConstKernel<ShiftLeftOp>(l, k)));
+  else if (op == "/")
+    return lowered<int>(addKernel(tree,
+      new IntConstKernel<ShiftRightOp>(l, k)));
+
+  return lowered<int>(addKernel(tree,
+    new IntConstKernel<MaskOp>(l, (1 << k) - 1)));
+} // makePowerOp
+
+
+
+template <class T>
+static Lowered makeCompare(KernelTree &tree,       // *In-Out* Kernel tree
+  const string &relOp,                             // *In* Relational op
+  const Lowered &left,                             // *In* Left operand
+  const Lowered &right)                            // *In* Right operand
+{ // Picks the CompareKernel for a relational operator on T.
+
+  const Kernel<T> *l = as<T>(left);               // Left operand
+  const Kernel<T> *r = as<T>(right);              // Right operand
+  KernelNode      *k = NULL;                      // New kernel
+
+  if (relOp == "==")
+    k = addKernel(tree, new CompareKernel<T, EqualOp>(l, r));
+  else if (relOp == "!=")
+    k = addKernel(tree, new CompareKernel<T, NotEqualOp>(l, r));
+  else if (relOp == "<")
+    k = addKernel(tree, new CompareKernel<T, LessOp>(l, r));
+  else if (relOp == "<=")
+    k = addKernel(tree, new CompareKernel<T, LessEqualOp>(l, r));
+  else if (relOp == ">")
+    k = addKernel(tree, new CompareKernel<T, GreaterOp>(l, r));
+  else if (relOp == ">=")
+    k = addKernel(tree, new CompareKernel<T, GreaterEqualOp>(l, r));
+  else
+    throw RunReport(307);
+
+  return lowered<bool>(k);
+} // makeCompare
+
+//***************************************************************************
+//End of kernel construction subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Lowering subprograms.
+//***************************************************************************
+
+static Lowered lowerExpression(Lowering &lowering, // *In-Out* Lowering
+  Expression *expr);                               // *In* Expression
+
+
+
+static void countBrackets(Lowering &lowering,      // *In-Out* Lowering
+  Expression *expr)                                // *In* Expression
+{ // Counts the times lowering will reach each bracketed Expression, with
+  // the recursion and loops that lowering has.
+
+  for (BasicExp *bexp : { expr->be1, expr->be2 })
+    for (; bexp != NULL; bexp = bexp->bexp)
+      for (Term *term = bexp->term; term != NULL; term = term->term)
+      {
+        Factor *fact = term->fact;                // Operand
+
+        while (fact->nFactor != NULL)
+          fact = fact->nFactor;
+        if (fact->bExp != NULL && ++lowering.uses[fact->bExp] == 1)
+          countBrackets(lowering, fact->bExp);
+      }
+} // countBrackets
+
+
+
+static bool leafExpression(Expression *expr)       // *In* Expression
+{ // A lone identifier or literal.
+
+  Factor *fact = expr->be1->term->fact;           // The operand, if lone
+
+  return expr->be2 == NULL && expr->be1->bexp == NULL &&
+    expr->be1->term->term == NULL && fact->bExp == NULL &&
+    fact->nFactor == NULL;
+} // leafExpression
+
+
+
+template <class T>
+static Lowered cached(Lowering &lowering,          // *In-Out* Lowering
+  const Lowered &low)                              // *In* Subexpression
+{ // Puts low under a CachedKernel of its type.
+
+  return lowered<T>(addKernel(lowering.tree,
+    new CachedKernel<T>(as<T>(low), lowering.rows)));
+} // cached
+
+
+
+static Lowered lowerBracket(Lowering &lowering,    // *In-Out* Lowering
+  Expression *expr)                                // *In* Bracketed exp
+{ // A bracket reached more than once is lowered the first time, and its
+  // cached kernel handed back each time after.
+
+  unordered_map<const Expression *, Lowered>::iterator found; // Done
+  Lowered low;                                    // Lowered bracket
+
+  if (lowering.uses[expr] < 2 || leafExpression(expr))
+    return lowerExpression(lowering, expr);
+
+  found = lowering.done.find(expr);
+  if (found != lowering.done.end())
+    return found->second;
+
+  low = lowerExpression(lowering, expr);
+  if (low.type == BOOLDATA)
+    low = cached<bool>(lowering, low);
+  else if (low.type == INTDATA)
+    low = cached<int>(lowering, low);
+  else if (low.type == FLOATDATA)
+    low = cached<double>(lowering, low);
+  else
+    low = cached<string>(lowering, low);
+
+  lowering.done[expr] = low;
+  return low;
+} // lowerBracket
+
+
+
+static Lowered lowerFactor(Lowering &lowering,     // *In-Out* Lowering
+  Factor *fact)                                    // *In* Factor
+{ // Literals are converted here, once, rather than on every row.
+
+  KernelTree &tree = lowering.tree;               // Kernel tree
+  Value      lit;                                 // Converted literal
+
+  if (fact->literal)
+  {
+    litToValue(fact, lit);
+    if (fact->type == BOOLDATA)
+      return lowered<bool>(addKernel(tree,
+        new LiteralKernel<bool>(lit.boolVal)));
+    else if (fact->type == INTDATA)
+      return lowered<int>(addKernel(tree,
+        new LiteralKernel<int>(lit.intVal)));
+    else if (fact->type == FLOATDATA)
+      return lowered<double>(addKernel(tree,
+        new LiteralKernel<double>(lit.floatVal)));
+    else if (fact->type == STRINGDATA)
+      return lowered<string>(addKernel(tree,
+        new LiteralKernel<string>(lit.stringVal)));
+  }
+  else if (fact->ident != NULL)
+  {
+    int slot = fact->ident->slot;                 // Binding slot
+
+    if (fact->type == BOOLDATA)
+      return lowered<bool>(addKernel(tree, new IdentKernel<bool>(slot)));
+    else if (fact->type == INTDATA)
+      return lowered<int>(addKernel(tree, new IdentKernel<int>(slot)));
+    else if (fact->type == FLOATDATA)
+      return lowered<double>(addKernel(tree, new IdentKernel<double>(slot)));
+    else if (fact->type == STRINGDATA)
+      return lowered<string>(addKernel(tree, new IdentKernel<string>(slot)));
+  }
+  else if (fact->bExp != NULL)
+    return lowerBracket(lowering, fact->bExp);
+  else if (fact->nFactor != NULL)
+    return lowered<bool>(addKernel(tree,
+      new NotKernel(as<bool>(lowerFactor(lowering, fact->nFactor)))));
+
+  throw RunReport(307);
+} // lowerFactor
+
+
+
+static Lowered lowerTerm(Lowering &lowering,       // *In-Out* Lowering
+  Term *term)                                      // *In* Term
+{ // An && list becomes one ChainKernel; an int list becomes a left deep
+  // tree of IntBinaryKernels so that it still folds left to right, with
+  // an IntConstKernel for each * / or % by a power of two. A literal 2^k
+  // times the next operand is that operand shifted, as the literal cannot
+  // throw and * does not care which side it is on.
+
+  KernelTree &tree = lowering.tree;               // Kernel tree
+  Lowered    acc;                                 // Result so far
+  int        k = 0;                               // Power of two
+
+  if (term->term != NULL && term->mulOp == "*")
+    k = powerOfTwo(term->mulOp, term->fact);
+  if (k != 0)
+  {
+    term = term->term;
+    acc = makePowerOp(tree, "*", lowerFactor(lowering, term->fact), k);
+  }
+  else
+    acc = lowerFactor(lowering, term->fact);
+
+  if (term->term != NULL && term->mulOp == "&&")
+  {
+    vector<const Kernel<bool> *> ops;             // Chain operands
+
+    for (; term != NULL; term = term->term)
+      ops.push_back(as<bool>(ops.empty() ? acc :
+        lowerFactor(lowering, term->fact)));
+
+    return lowered<bool>(addKernel(tree, new ChainKernel<true>(ops)));
+  }
+
+  for (; term->term != NULL; term = term->term)
+  {
+    k = powerOfTwo(term->mulOp, term->term->fact);
+    if (k != 0)
+      acc = makePowerOp(tree, term->mulOp, acc, k);
+    else
+      acc = makeIntOp(tree, term->mulOp, acc,
+        lowerFactor(lowering, term->term->fact));
+  }
+
+  return acc;
+} // lowerTerm
+
+
+
+static Lowered lowerBasicExp(Lowering &lowering,   // *In-Out* Lowering
+  BasicExp *bexp)                                  // *In* BasicExp
+{ // A || list becomes one ChainKernel; an int list becomes a left deep
+  // tree of IntBinaryKernels.
+
+  KernelTree &tree = lowering.tree;               // Kernel tree
+  Lowered    acc = lowerTerm(lowering, bexp->term); // Result so far
+
+  if (bexp->bexp != NULL && bexp->addOp == "||")
+  {
+    vector<const Kernel<bool> *> ops;             // Chain operands
+
+    for (; bexp != NULL; bexp = bexp->bexp)
+      ops.push_back(as<bool>(ops.empty() ? acc :
+        lowerTerm(lowering, bexp->term)));
+
+    return lowered<bool>(addKernel(tree, new ChainKernel<false>(ops)));
+  }
+
+  for (; bexp->bexp != NULL; bexp = bexp->bexp)
+    acc = makeIntOp(tree, bexp->addOp, acc,
+      lowerTerm(lowering, bexp->bexp->term));
+
+  return acc;
+} // lowerBasicExp
+
+
+
+static Lowered lowerExpression(Lowering &lowering, // *In-Out* Lowering
+  Expression *expr)                                // *In* Expression
+{ // A relational operator picks its CompareKernel by operand type.
+
+  KernelTree &tree = lowering.tree;               // Kernel tree
+  Lowered    left = lowerBasicExp(lowering, expr->be1); // First basic exp
+  Lowered    right;                               // Second basic exp
+
+  if (expr->be2 == NULL)
+    return left;
+
+  right = lowerBasicExp(lowering, expr->be2);
+
+  if (left.type == BOOLDATA)
+    return makeCompare<bool>(tree, expr->relOp, left, right);
+  else if (left.type == INTDATA)
+    return makeCompare<int>(tree, expr->relOp, left, right);
+  else if (left.type == FLOATDATA)
+    return makeCompare<double>(tree, expr->relOp, left, right);
+
+  // Relational operators on strings are rejected by synExpression.
+  throw RunReport(307);
+} // lowerExpression
+
+//***************************************************************************
+//End of lowering subprograms.
+//***************************************************************************
+
+
+
+void lowerAST(AST *ast,                            // *In* Abs syntax tree
+  KernelTree &tree)                                // *Out* Kernel tree
+{ // Lowers the expression and puts a RootKernel of the right type on top,
+  // counting the shared brackets first if there can be any.
+
+  Lowering   lowering = { tree, NULL, {}, {} };   // Lowering state
+  Lowered    top;                                 // Lowered expression
+  RowCounter *rows;                               // Row number
+
+  tree.root = NULL;
+  tree.nodes.clear();
+
+  if (ast == NULL || ast->expr == NULL)
+    throw RunReport(307);
+
+  rows = addKernel(tree, new RowCounter);
+  lowering.rows = rows;
+  tree.rows = rows;
+  if (ast->shared)
+    countBrackets(lowering, ast->expr);
+
+  top = lowerExpression(lowering, ast->expr);
+
+  if (top.type == BOOLDATA)
+    tree.root = addKernel(tree, new RootKernel<bool>(as<bool>(top), rows));
+  else if (top.type == INTDATA)
+    tree.root = addKernel(tree, new RootKernel<int>(as<int>(top), rows));
+  else if (top.type == FLOATDATA)
+    tree.root = addKernel(tree,
+      new RootKernel<double>(as<double>(top), rows));
+  else
+    tree.root = addKernel(tree,
+      new RootKernel<string>(as<string>(top), rows));
+} // lowerAST
+
+
+
+void freeKernels(KernelTree &tree)                 // *In-Out* Kernel tree
+{ // Every kernel was recorded by addKernel.
+
+  for (size_t i = 0; i < tree.nodes.size(); i++)
+    delete tree.nodes[i];
+
+  tree.nodes.clear();
+  tree.root = NULL;
+  tree.rows = NULL;
+} // freeKernels
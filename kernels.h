@@ -0,0 +1,499 @@
+// Title   : kernels.h
+// Purpose : Type specialised evaluation kernels header file for SCL. The
+//           type checked AST is lowered to a tree of kernels, each bound at
+//           compile time to one operator and one data type.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard string and vector libraries and the evaluator header
+// file for the Value and RowEvaluator types.
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "evaluator.h"     // header for evaluator.cxx
+
+
+
+// evalAST looks at Factor::type, the operator strings and the Value tags at
+// every node of every row, although synTerm, synBasicExp and synExpression
+// have already fixed all of them. lowerAST does that work once: each node
+// becomes a kernel whose C++ type encodes its operator and operand type,
+// and whose eval returns a plain bool, int, double or string. A kernel
+// tree for
+//
+//     x * 2 + y > 10
+//
+// is Compare<int, Greater>(IntBinary<Add>(IntBinary<Mul>(Ident<int>,
+// Literal<int>), Ident<int>), Literal<int>), and evaluating it makes no
+// decisions on type or operator at all.
+//
+// A * / or % whose right operand is the int literal 2^k, for 2^k from 2 to
+// 16384, is lowered to a shift or a mask by the constant, which gives the
+// same result: x << k wraps to 16 bits as x * 2^k does, x >> k rounds
+// towards zero as x / 2^k does, and x & (2^k - 1) keeps the sign of x as
+// x % 2^k does. So does 2^k * x at the head of a term. The listing still
+// shows the * / and %.
+//
+// In an AST shared by shareAST (see hashcons.h) a bracketed Expression
+// reached more than once is lowered once, under a CachedKernel that
+// evaluates it at most once per row and hands back the same result each
+// time it is reached after that.
+
+
+
+//***************************************************************************
+//Kernel base classes.
+//***************************************************************************
+
+// Every kernel is a KernelNode so that a KernelTree can delete them.
+class KernelNode                                   // Any kernel
+{
+public:
+  // Class destructor.
+  virtual ~KernelNode()
+  {
+  }
+}; // class KernelNode
+
+
+
+// A kernel producing a value of C++ type T.
+template <class T>
+class Kernel : public KernelNode                   // Typed kernel
+{
+public:
+  virtual T eval(const Value *env) const = 0;
+}; // class Kernel
+
+
+
+// String kernels hand back a reference to the literal or binding so that
+// no string is copied during evaluation.
+template <>
+class Kernel<string> : public KernelNode           // String kernel
+{
+public:
+  virtual const string &eval(const Value *env) const = 0;
+}; // class Kernel<string>
+
+
+
+// The number of the row being evaluated, counted by the root, so that a
+// CachedKernel knows when its result is out of date.
+class RowCounter : public KernelNode               // Row number
+{
+public:
+  mutable unsigned long long row = 0;             // Rows evaluated
+}; // class RowCounter
+
+
+
+// The root of a kernel tree, which converts its child's result to a Value.
+class ValueKernel : public KernelNode              // Root kernel
+{
+public:
+  virtual void evalValue(const Value *env, Value &result) const = 0;
+}; // class ValueKernel
+
+//***************************************************************************
+//End of kernel base classes.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Type and operator traits.
+//***************************************************************************
+
+// ValueField selects the field of a Value that holds a T, and the DataType
+// tag that goes with it.
+template <class T> struct ValueField;
+
+template <> struct ValueField<bool>
+{
+  static const DataType type = BOOLDATA;
+  static bool get(const Value &v) { return v.boolVal; }
+  static void set(Value &v, bool x) { v.boolVal = x; }
+};
+
+template <> struct ValueField<int>
+{
+  static const DataType type = INTDATA;
+  static int get(const Value &v) { return v.intVal; }
+  static void set(Value &v, int x) { v.intVal = x; }
+};
+
+template <> struct ValueField<double>
+{
+  static const DataType type = FLOATDATA;
+  static double get(const Value &v) { return v.floatVal; }
+  static void set(Value &v, double x) { v.floatVal = x; }
+};
+
+template <> struct ValueField<string>
+{
+  static const DataType type = STRINGDATA;
+  static const string &get(const Value &v) { return v.stringVal; }
+  static void set(Value &v, const string &x) { v.stringVal = x; }
+};
+
+
+
+// Integer operators, with SCL's 16 bit wraparound.
+struct AddOp { static int apply(int a, int b) { return (short)(a + b); } };
+struct SubOp { static int apply(int a, int b) { return (short)(a - b); } };
+struct MulOp { static int apply(int a, int b) { return (short)(a * b); } };
+
+struct DivOp
+{
+  static int apply(int a, int b)
+  {
+    if (b == 0)
+      throw RunReport(301);
+    return (short)(a / b);
+  }
+};
+
+struct ModOp
+{
+  static int apply(int a, int b)
+  {
+    if (b == 0)
+      throw RunReport(302);
+    return (short)(a % b);
+  }
+};
+
+// * / and % by 2^k as lowered by lowerAST: b is k for the shifts and
+// 2^k - 1 for the mask.
+struct ShiftLeftOp { static int apply(int a, int b)
+                     { return (short)(a << b); } };
+struct ShiftRightOp { static int apply(int a, int b)
+                      { return (a < 0 ? a + (1 << b) - 1 : a) >> b; } };
+struct MaskOp { static int apply(int a, int b)
+                { return (a < 0) ? -(-a & b) : a & b; } };
+
+
+
+// Relational operators.
+struct EqualOp { template <class T> static bool apply(T a, T b)
+                 { return a == b; } };
+struct NotEqualOp { template <class T> static bool apply(T a, T b)
+                    { return a != b; } };
+struct LessOp { template <class T> static bool apply(T a, T b)
+                { return a < b; } };
+struct LessEqualOp { template <class T> static bool apply(T a, T b)
+                     { return a <= b; } };
+struct GreaterOp { template <class T> static bool apply(T a, T b)
+                   { return a > b; } };
+struct GreaterEqualOp { template <class T> static bool apply(T a, T b)
+                        { return a >= b; } };
+
+//***************************************************************************
+//End of type and operator traits.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Kernels.
+//***************************************************************************
+
+// A literal, converted once when the tree is lowered.
+template <class T>
+class LiteralKernel : public Kernel<T>             // Literal
+{
+private:
+  T value;                                        // Literal value
+public:
+  LiteralKernel(const T &v) : value(v)
+  {
+  }
+  T eval(const Value *) const
+  {
+    return value;
+  }
+}; // class LiteralKernel
+
+template <>
+class LiteralKernel<string> : public Kernel<string> // String literal
+{
+private:
+  string value;                                   // Literal value
+public:
+  LiteralKernel(const string &v) : value(v)
+  {
+  }
+  const string &eval(const Value *) const
+  {
+    return value;
+  }
+}; // class LiteralKernel<string>
+
+
+
+// An identifier, read from its binding slot.
+template <class T>
+class IdentKernel : public Kernel<T>               // Identifier
+{
+private:
+  int slot;                                       // Binding slot
+public:
+  IdentKernel(int s) : slot(s)
+  {
+  }
+  T eval(const Value *env) const
+  {
+    return ValueField<T>::get(env[slot]);
+  }
+}; // class IdentKernel
+
+template <>
+class IdentKernel<string> : public Kernel<string>  // String identifier
+{
+private:
+  int slot;                                       // Binding slot
+public:
+  IdentKernel(int s) : slot(s)
+  {
+  }
+  const string &eval(const Value *env) const
+  {
+    return env[slot].stringVal;
+  }
+}; // class IdentKernel<string>
+
+
+
+// An integer operator applied to two integer kernels.
+template <class Op>
+class IntBinaryKernel : public Kernel<int>         // Int operator
+{
+private:
+  const Kernel<int> *left;                        // Left operand
+  const Kernel<int> *right;                       // Right operand
+public:
+  IntBinaryKernel(const Kernel<int> *l, const Kernel<int> *r)
+    : left(l), right(r)
+  {
+  }
+  int eval(const Value *env) const
+  {
+    int l = left->eval(env);                      // Left runs first
+    return Op::apply(l, right->eval(env));
+  }
+}; // class IntBinaryKernel
+
+
+
+// An integer operator applied to an integer kernel and a constant, for
+// * / and % by a power of two.
+template <class Op>
+class IntConstKernel : public Kernel<int>          // Int operator by constant
+{
+private:
+  const Kernel<int> *left;                        // Left operand
+  int               right;                        // Constant
+public:
+  IntConstKernel(const Kernel<int> *l, int r) : left(l), right(r)
+  {
+  }
+  int eval(const Value *env) const
+  {
+    return Op::apply(left->eval(env), right);
+  }
+}; // class IntConstKernel
+
+
+
+// A relational operator applied to two kernels of type T.
+template <class T, class Rel>
+class CompareKernel : public Kernel<bool>          // Relational operator
+{
+private:
+  const Kernel<T> *left;                          // Left operand
+  const Kernel<T> *right;                         // Right operand
+public:
+  CompareKernel(const Kernel<T> *l, const Kernel<T> *r)
+    : left(l), right(r)
+  {
+  }
+  bool eval(const Value *env) const
+  {
+    T l = left->eval(env);                        // Left runs first
+    return Rel::apply(l, right->eval(env));
+  }
+}; // class CompareKernel
+
+
+
+// An && chain (IsAnd true) or || chain (IsAnd false), stopping at the
+// first operand that decides it.
+template <bool IsAnd>
+class ChainKernel : public Kernel<bool>            // && or || chain
+{
+private:
+  vector<const Kernel<bool> *> ops;               // Source order operands
+public:
+  ChainKernel(const vector<const Kernel<bool> *> &o) : ops(o)
+  {
+  }
+  bool eval(const Value *env) const
+  {
+    for (size_t i = 0; i < ops.size(); i++)
+      if (ops[i]->eval(env) != IsAnd)
+        return !IsAnd;
+    return IsAnd;
+  }
+}; // class ChainKernel
+
+
+
+// The ! operator.
+class NotKernel : public Kernel<bool>              // Negation
+{
+private:
+  const Kernel<bool> *operand;                    // Negated factor
+public:
+  NotKernel(const Kernel<bool> *o) : operand(o)
+  {
+  }
+  bool eval(const Value *env) const
+  {
+    return !operand->eval(env);
+  }
+}; // class NotKernel
+
+
+
+// A shared subexpression, evaluated once per row. The result of a row
+// whose evaluation threw is never kept, so the next row evaluates afresh.
+template <class T>
+class CachedKernel : public Kernel<T>              // Shared subexpression
+{
+private:
+  const Kernel<T>            *child;              // Subexpression
+  const RowCounter           *rows;               // Current row
+  mutable unsigned long long stamp;               // Row value is from
+  mutable T                  value;               // Result for the row
+public:
+  CachedKernel(const Kernel<T> *c, const RowCounter *r)
+    : child(c), rows(r), stamp(0), value()
+  {
+  }
+  T eval(const Value *env) const
+  {
+    if (stamp != rows->row)
+    {
+      value = child->eval(env);
+      stamp = rows->row;
+    }
+    return value;
+  }
+}; // class CachedKernel
+
+template <>
+class CachedKernel<string> : public Kernel<string> // Shared string
+{
+private:
+  const Kernel<string>       *child;              // Subexpression
+  const RowCounter           *rows;               // Current row
+  mutable unsigned long long stamp;               // Row value is from
+  mutable const string       *value;              // Result for the row
+public:
+  CachedKernel(const Kernel<string> *c, const RowCounter *r)
+    : child(c), rows(r), stamp(0), value(NULL)
+  {
+  }
+  const string &eval(const Value *env) const
+  {
+    if (stamp != rows->row)
+    {
+      value = &child->eval(env);
+      stamp = rows->row;
+    }
+    return *value;
+  }
+}; // class CachedKernel<string>
+
+
+
+// The root, boxing a T result into a Value. Each evaluation is a new row.
+template <class T>
+class RootKernel : public ValueKernel              // Tree root
+{
+private:
+  const Kernel<T>  *child;                        // Whole expression
+  const RowCounter *rows;                         // Row number
+public:
+  RootKernel(const Kernel<T> *c, const RowCounter *r) : child(c), rows(r)
+  {
+  }
+  void evalValue(const Value *env, Value &result) const
+  {
+    rows->row++;
+    result.type = ValueField<T>::type;
+    ValueField<T>::set(result, child->eval(env));
+  }
+}; // class RootKernel
+
+//***************************************************************************
+//End of kernels.
+//***************************************************************************
+
+
+
+// A lowered program. nodes owns every kernel in the tree; root is the
+// kernel that evaluates the whole expression and rows counts its rows.
+struct KernelTree                                  // Lowered program
+{
+  const ValueKernel  *root;                       // Expression kernel
+  const RowCounter   *rows;                       // Row number
+  vector<KernelNode *> nodes;                     // Every kernel
+}; // KernelTree
+
+
+
+// lowerAST lowers the type checked expression of ast into tree. ast must
+// be the result of a successful synAnal.
+void lowerAST(AST *ast,                            // *In* Abs syntax tree
+  KernelTree &tree);                               // *Out* Kernel tree
+
+// freeKernels deletes every kernel in tree.
+void freeKernels(KernelTree &tree);                // *In-Out* Kernel tree
+
+
+
+// The KERNELEVAL row evaluator, which lowers the AST once and evaluates
+// the kernel tree for each row.
+class KernelEvaluator : public RowEvaluator        // KERNELEVAL evaluator
+{
+private:
+  KernelTree tree;                                // Lowered program
+public:
+  // Class constructor and destructor.
+  KernelEvaluator(AST *ast)                        // *In* Abs syntax tree
+  {
+    lowerAST(ast, tree);
+  }
+  ~KernelEvaluator()
+  {
+    freeKernels(tree);
+  }
+
+  void evalRow(const Value *env,                   // *In* Bindings
+    Value &result)                                 // *Out* Result
+  {
+    tree.root->evalValue(env, result);
+  }
+}; // class KernelEvaluator
+
+
+#endif
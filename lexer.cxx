@@ -5,10 +5,16 @@
 
 // Includes the header file from an external directory.
 #include "lexer.h"
+#include "stats.h"  // Phase timers and token counts
+#include "trace.h"  // Trace spans per token
+#include "allocstats.h" // Allocations per call site
+#include "budget.h" // Byte, token and time budgets
+#include "lextable.h" // Generated state transition table
 #include <fstream>  // Includes file IO library
 #include <ctype.h>  // Includes header to classify and transform chars
 #include <stdlib.h> // Includes the C++ standard library
 #include <string>   // Includes the string class for C++
+#include <utility>  // Includes move
 
 
 
@@ -16,220 +22,112 @@ using namespace std; // Using standard library
 
 
 
-void checkIdent(ifstream &inFile,                  // *In-Out* Input file
-                LexToken &LexToken)                // *Out* Token lexed
-{ // checkIdent will take in the next input as a char and then add it onto
-  // the end of a string. It will then check for when the string ends and
-  // then compare it to various reserved words and for bool literals. If
-  // it comes across and none of these, then it will presume the string is
-  // the name for an identifier.
+// Names of the token tags, in LexTokenTag order.
+const char *const lexTagNames[END + 1] = {
+  "IDENT",
+  "BOOLLIT", "STRINGLIT", "INTLIT", "FLOATLIT",
+  "ASSIGN",
+  "LPAREN", "RPAREN",
+  "ADDOP", "RELOP", "MULOP", "NOTOP",
+  "BOOL", "STRING", "INT", "FLOAT",
+  "LET", "IN",
+  "END"
+};
 
-  char next = ' ';           // Holds a character for the next char of input
-  string  inputCheck = "";  // Holds a string for the current input
 
-  inFile.get(next);         // Gets the next character of input
 
-  while (isalnum(next) || next == '_')
-  { // A While loop to place the next char into the string.
-    inputCheck += next;
-    inFile.get(next);
-  }
-  inFile.putback(next);
-
-  // Checks inputCheck to see if the input was a matches any reserved words,
-  // if so then it sets the token accordingly. It will also check for a
-  // bool literal. If it is does not match any of the reserved words then
-  // it will presume it is a indentifier name.
-  if (inputCheck == "true" || inputCheck == "false")
-  {
-    LexToken.tag = BOOLLIT;
-    LexToken.boolLit = inputCheck;
-  }
-  else if (inputCheck == "bool")
-  {
-    LexToken.tag = BOOL;
-  }
-  else if (inputCheck == "string")
-  {
-    LexToken.tag = STRING;
-  }
-  else if (inputCheck == "int")
-  {
-    LexToken.tag = INT;
-  }
-  else if (inputCheck == "float")
-  {
-    LexToken.tag = FLOAT;
-  }
-  else if (inputCheck == "let")
-  {
-    LexToken.tag = LET;
-  }
-  else if (inputCheck == "in")
-  {
-    LexToken.tag = IN;
-  }
-  else if (inputCheck == "end")
-  {
-    LexToken.tag = END;
-  }
-  else
-  {
-    LexToken.tag = IDENT;
-    LexToken.ident = inputCheck;
-  } // if statement
-} // checkIdent
-
-void getNewDigitString(ifstream &inFile,       // *In-Out* Input file
-                       string &digitString,    // *In-Out* Hold next digit string
-                       char &next)             // *In-Out* Hold next input char
-{
-  inFile.get(next);
-
-  // While loop to add next into the string. Stops when not a digit
-  // or end of file.
-  while (isdigit(next) && inFile)
-  {
-    digitString += next;
-    inFile.get(next);
-  }
-}
+thread_local bool lexThrows = false; // Lexer errors thrown, not exited
 
-void lexIntLit(ifstream &inFile,     // *In-Out* Input file
-               LexToken &LexToken,   // *Out* Token lexed
-               ofstream &outFile)    // *In-Out* Output file   
-{ // lexIntLit checks for a int literal, and stores it into
-  // the correct token for output.
 
-  char next = '0';            // Holds a character for the next char of input
-  string digitString = "";    // Holds a string for the current input
-  int Num = 0;
 
-  LexToken.tag = INTLIT;      // Sets the token tag to a int lit.
+void lexFail(ostream &outFile,                     // *In-Out* Output file
+             const char *message,                  // *In* Error message
+             int code)                             // *In* Exit code
+{ // Writes a lexer error and terminates. exit does not run the destructor
+  // of the caller's ofstream, so the listing is flushed here, once. An
+  // error with no message exits without touching the listing.
 
-  getNewDigitString(inFile, digitString, next);
-
-  
-
-  // Checks if next char is ^ if so call exit and output appropriate error
-  // message.
-  if (next == '^')
+  if (lexThrows)
+    throw LexError{message, code};
+  if (message != NULL)
   {
-    outFile << "Lexer error : missing '.' in float." << endl;
-    exit(5);
+    outFile << message << '\n';
+    outFile.flush();
   }
-  
-  // Checks if next chat is . if so continues on with the lex analysis.
-  if (next == '.')
-  {
-    digitString += next;
-    inFile.get(next);
+  exit(code);
+} // lexFail
 
-    if (!isdigit(next))
-    {
-      outFile << "Lexer error : no digit after ." << endl;
-      exit(6);
-    }
-
-    getNewDigitString(inFile, digitString, next);
-
-    if (next == '.')
-    {
-      outFile << "Lexer error : multiple ." << endl;
-      exit(7);
-    }
-    else if (next == '^')
-    {
-      digitString += next;
-      inFile.get(next);
-
-      if (!isdigit(next))
-      {
-        outFile << "Lexer error : no digit after ^" << endl;
-        exit(8);
-      }
 
-      getNewDigitString(inFile, digitString, next);
 
-      if (next == '^')
-      {
-        outFile << "Lexer error : multiple ^" << endl;
-        exit(9);
-      }
-      else if (next == '.')
-      {
-        outFile << "Lexer eroor : multiple ." << endl;
-        exit(10);
-      }
-    }
-
-    LexToken.tag = FLOATLIT;
-    LexToken.floatLit = digitString;
-  }
-  else
-  {
-    LexToken.tag = INTLIT;
-
-    Num = atoi(digitString.c_str());
-
-    if (Num > 32767 || Num < -32768)
-    {
-      exit(3);
-    }
-    else
-    {
-      LexToken.intLit = Num;
-    }
-  }
-
-  inFile.putback(next); // Puts the input char that is not a digit back.
-
-} // lexIntLit
-
-void lexStringLit(ifstream &inFile,                // *In-Out* Input file
-                  ofstream &outFile,               // *In-Out* Output file
+void lexStringLit(istream &inFile,                 // *In-Out* Input file
+                  ostream &outFile,                // *In-Out* Output file
                   LexToken &lexToken)              // *Out* Token lexed
 { // Read first ", read string, read second ". Return STRINGLIT token.
   // Must check for unexpected EOF and for non-printable characters.
+  // The string is read up to the second " with one getline, which finds
+  // the " with a block search of the input buffer and appends to the
+  // token in blocks, so a long literal is read in linear time. The
+  // characters are then checked in one pass; the first bad one is the one
+  // a character by character read would have stopped at, so the errors
+  // are reported as before.
 
   char ch = ' ';                                  // Read " into here
 
   // Read first " and initialise token.
   inFile.get(ch);
   lexToken.tag = STRINGLIT;
-  lexToken.stringLit = "";
 
   // Read string characters until " or EOF encountered. If non-printable
   // character is encountered report lexer error and call exit to
   // terminate.
-  inFile.get(ch);
-  while ((ch != '\"') && inFile)
+  getline(inFile, lexToken.stringLit, '\"');
+  for (char c : lexToken.stringLit)
   {
-    if (iscntrl(ch) && (ch != '\n') && (ch != '\t'))
+    if (iscntrl(c) && (c != '\n') && (c != '\t'))
     {
-      outFile << "Lexer error : non printable character in string literal.\n";
-      exit(3);
+      lexFail(outFile,
+        "Lexer error : non printable character in string literal.", 3);
     }
-    lexToken.stringLit = lexToken.stringLit + ch;
-    inFile.get(ch);
   }
 
   // Check that second " was present. If not report a lexer error
-  // and call exit to terminate.
+  // and call exit to terminate. getline only reaches the end of the file
+  // if there was no second ". A " that ends the file is left for the next
+  // lexAnal to report as the end of the file.
 
-  if (ch != '\"')
+  if (inFile.eof() && !lexToken.stringLit.empty())
   {
-    outFile << "Lexer error : missing \" on string literal\n";
-    exit(4);
+    lexFail(outFile, "Lexer error : missing \" on string literal", 4);
   }
 } // lexStringLit
 
-void skipWhiteComments(ifstream &inFile)           // *In-Out* Input file
+static void lexBudget(streambuf *buf,              // *In-Out* Source buffer
+                      ostream &outFile)            // *In-Out* Output file
+{ // Checks the budgets before a token is lexed. A source larger than the
+  // byte budget is refused before its first token is read, so a huge
+  // string literal is never taken in. Then there may be no more tokens
+  // than the token budget, and the compile must be within its time.
+
+  long long lexed = budgetUse.tokens - 1;        // Tokens before this one
+
+  if (lexed == 0 && compileBudget.limit[BUDGETBYTES] > 0 &&
+      overBudget(BUDGETBYTES, sourceLeft(buf)))
+    lexFail(outFile, budgetMessages[BUDGETBYTES], limitExitCode);
+  if (overBudget(BUDGETTOKENS, lexed + 1))
+    lexFail(outFile, budgetMessages[BUDGETTOKENS], limitExitCode);
+  if (overTime())
+    lexFail(outFile, budgetMessages[BUDGETTIME], limitExitCode);
+
+  nextLexCheck(lexed);
+} // lexBudget
+
+void skipWhiteComments(istream &inFile)            // *In-Out* Input file
 { // skipWhiteComments reads from input until the next non-whitespace
   // character is encountered or until end of file.
   // If the comment indicator "//" is encountered then skipWhiteComments
   // ignores all text up to the end of the line and then carries on.
 
+  PhaseTimer timer(PHASESKIP);                    // Charges this call
   bool nonWhiteFound = false;                     // Carry on reading flag
   char next = ' ';                                // Next input character
 
@@ -266,7 +164,7 @@ void skipWhiteComments(ifstream &inFile)           // *In-Out* Input file
   }
 } // skipWhiteComments
 
-void writeToken(ofstream &outFile,                 // *In-Out* Output file
+void writeToken(OutSink  &outFile,                 // *In-Out* Output sink
                 LexToken lexToken)                 // *In* Token to print
 { // Write token to outFile.
 
@@ -340,169 +238,94 @@ void writeToken(ofstream &outFile,                 // *In-Out* Output file
   } // switch(lexToken.tag)
 } // writeToken
 
-void lexAnal(ifstream &inFile,                    // *In-Out* Input file
-             ofstream &outFile,                   // *In-Out* Output file
+void writeToken(ostream &outFile,                  // *In-Out* Output file
+                LexToken lexToken)                 // *In* Token to print
+{ // Write token to outFile through a sink of its own.
+
+  OutSink sink(outFile);                          // Buffered output
+
+  writeToken(sink, lexToken);
+} // writeToken
+
+void lexAnal(istream &inFile,                     // *In-Out* Input file
+             ostream &outFile,                    // *In-Out* Output file
              LexToken &LexToken)                  // *Out* Token lexed
 {
-  // LexAnal will get the next input character and attempt to give
-  // LexToken the correct tag for the output. It has various catches to
-  // be able to check for all token types. After the token has been checked
-  // it will call skipWhiteComments to skip to the next input that could be
-  // a token.
-
-  char next = ' '; // A char to hold the next input
-
-  // Gets the next char, then checks it for every single type of token
-  // when it finds which one will set the appropriate tags or call the
-  // approprate subprogam to deal with that type of token. If no match,
-  // then it will display charcater not recognised.
-  inFile.get(next);
-  if (!inFile)
+  // LexAnal scans the next token with the state transition table in
+  // lextable.h (see lexgen.cxx), which gives the token's action once the
+  // bytes read can be no other token. The action then sets the token's tag
+  // and field, hands a string literal to lexStringLit or reports a lexer
+  // error. After the token has been made it will call skipWhiteComments to
+  // skip to the next input that could be a token.
+
+  PhaseTimer timer(PHASELEX); // Charges this call
+  TraceSpan  span("lexAnal", TRACEFINE); // One span per token
+  AllocScope site(ALLOCTOKEN); // Allocations are token strings
+  streambuf *buf = inFile.rdbuf(); // Source buffer, read a byte at a time
+  string text; // The bytes scanned
+  int ch; // Byte read, or EOF
+  int entry = LEXSTART; // State moved to, or LEXSTATES plus the action
+
+  // The budgets are only looked at when the count of tokens lexed reaches
+  // the next check (see budget.h).
+  if (budgetUse.tokens++ == budgetUse.lexCheck)
+    lexBudget(buf, outFile);
+
+  // Scan one byte at a time until the table gives an action. The buffer
+  // is read directly, as it hands out the end of the file as EOF, which
+  // has a class of its own, rather than as a failed read.
+  for (;;)
   {
-    outFile << "End of file detected" << endl;
-    exit(1);
+    ch = buf->sbumpc();
+    entry = lexNext[entry][lexClass[ch + 1]];
+    if (entry >= LEXSTATES)
+      break;
+    text += (char)ch;
   }
-  else
+
+  const LexAction &action = lexActions[entry - LEXSTATES]; // What to make
+
+  // The stream is left as reading the byte through it, and putting it
+  // back, would have left it; putting back at the end of the file fails
+  // but clears eofbit.
+  if (ch == EOF && action.putback)
+    inFile.setstate(ios::failbit);
+  else if (ch == EOF)
+    inFile.setstate(ios::eofbit | ios::failbit);
+  else if (action.putback)
+    buf->sungetc();
+
+  switch (action.kind)
   {
-    if (isalpha(next))
-    {
-      inFile.putback(next);
-      checkIdent(inFile, LexToken);
-    }
-    else  if (next == '\"')
-    {
-      inFile.putback(next);
-      lexStringLit(inFile, outFile, LexToken);
-    }
-    else if (isdigit(next))
-    {
-      inFile.putback(next);
-      lexIntLit(inFile, LexToken, outFile);
-    }
-    else if (next == '=')
-    {
-      inFile.get(next);
-      if (next == '=')
-      {
-        LexToken.tag = RELOP;
-        LexToken.relOp = "==";
-      }
-      else
-      {
-        inFile.putback(next);
-        LexToken.tag = ASSIGN;
-      }
-    }
-    else if (next == '(')
-    {
-      LexToken.tag = LPAREN;
-    }
-    else if (next == ')')
-    {
-      LexToken.tag = RPAREN;
-    }
-    else if (next == '+')
-    {
-      LexToken.tag = ADDOP;
-      LexToken.addOp = '+';
-    }
-    else if (next == '-')
-    {
-      LexToken.tag = ADDOP;
-      LexToken.addOp = '-';
-    }
-    else if (next == '|')
-    {
-      inFile.get(next);
-      if (next == '|')
-      {
-        LexToken.tag = ADDOP;
-        LexToken.addOp = "||";
-      }
-      else
-      {
-        inFile.putback(next);
-        outFile << "Error Wrong Symbol";
-        exit(3);
-      }
-    }
-    else if (next == '<')
-    {
-      inFile.get(next);
-      if (next == '=')
-      {
-        LexToken.tag = RELOP;
-        LexToken.relOp = "<=";
-      }
-      else
-      {
-        inFile.putback(next);
-        LexToken.relOp = "<";
-      }
-    }
-    else if (next == '*')
-    {
-      LexToken.tag = MULOP;
-      LexToken.mulOp = "*";
-    }
-    else if (next == '/')
-    {
-      LexToken.tag = MULOP;
-      LexToken.mulOp = "/";
-    }
-    else if (next == '%')
-    {
-      LexToken.tag = MULOP;
-      LexToken.mulOp = "%";
-    }
-    else if (next == '&')
-    {
-      inFile.get(next);
-      if (next == '&')
-      {
-        LexToken.tag = MULOP;
-        LexToken.mulOp = "&&";
-      }
-      else
-      {
-        inFile.putback(next);
-      }
-    }
-    else if (next == '!')
-    {
-      inFile.get(next);
-      if (next == '=')
-      {
-        LexToken.tag = RELOP;
-        LexToken.relOp = "!=";
-      }
-      else
-      {
-        inFile.putback(next);
-        LexToken.tag = NOTOP;
-      }
-    }
-    else if (next == '>')
-    {
-      inFile.get(next);
-      if (next == '=')
-      {
-        LexToken.tag = RELOP;
-        LexToken.relOp = ">=";
-      }
-      else
-      {
-        inFile.putback(next);
-        LexToken.tag = RELOP;
-        LexToken.relOp = ">";
-      }
-    }
-    else
-    {
-      outFile << "ERROR: Char not recognised" << endl;
-      exit(2);
-    }
-    }// If statement
+  case LEXTOKEN   : { LexToken.tag = action.tag;
+                      if (action.field != NULL && action.text != NULL)
+                        LexToken.*action.field = action.text;
+                      else if (action.field != NULL)
+                        LexToken.*action.field = move(text);
+                    }
+                    break;
+  case LEXINTEGER : { int Num = atoi(text.c_str());
+
+                      LexToken.tag = INTLIT;
+                      if (Num > 32767 || Num < -32768)
+                      {
+                        lexFail(outFile, NULL, 3);
+                      }
+                      LexToken.intLit = Num;
+                    }
+                    break;
+  case LEXSTRING  : { lexStringLit(inFile, outFile, LexToken);
+                    }
+                    break;
+  case LEXKEEP    : { // A lone & makes no token.
+                    }
+                    break;
+  case LEXFAIL    : { lexFail(outFile, action.message, action.code);
+                    }
+                    break;
+  } // switch(action.kind)
+
+    compileStats.tokens[LexToken.tag]++;
 
     // Calls skipWhiteComments to skip to the next legal input
     skipWhiteComments(inFile);
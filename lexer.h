@@ -12,9 +12,11 @@
 // Using standard libraries.
 using namespace std;
 
-// Include file IO library and standard string library.
-#include <fstream> // Standard file I/O
-#include <string>  // Standard C++ strings librarys
+// Include file IO library, standard string library and the output sink
+// header file.
+#include <fstream>   // Standard file I/O and streams
+#include <string>    // Standard C++ strings librarys
+#include "outsink.h" // header for outsink.cxx
 
 
 
@@ -49,12 +51,38 @@ struct LexToken
 
 
 
+// lexTagNames holds the name of each LexTokenTag, in enum order.
+extern const char *const lexTagNames[END + 1];
+
+
+
+// A lexer error. Thrown by the lexer in place of exiting while lexThrows
+// is set on the thread lexing, so a lexer thread can hand its errors on to
+// the parser, which then fails with them as the lexer would have.
+struct LexError                                    // Lexer error
+{
+  const char *message;                            // Message, or null
+  int        code;                                // Exit code
+}; // LexError
+
+extern thread_local bool lexThrows;
+
+
+
+// lexFail writes message, if there is one, to outFile and exits with
+// code, or throws them as a LexError while lexThrows is set.
+void lexFail(ostream &outFile,         // *In-Out* Output file
+  const char *message,                 // *In* Error message or null
+  int code);                           // *In* Exit code
+
+
+
 // lexAnal reads the next token from input and puts it in token.
-// If a lexical error is detected calls exit to terminate the program.
+// If a lexical error is detected calls lexFail to terminate the program.
 // Assumes that the next input character is the start of the next lexical
-// token.
-void lexAnal(ifstream &inFile,         // *In-Out* Input file
-  ofstream &outFile,                   // *In-Out* Output file
+// token. Any input stream will do; its buffer is read directly.
+void lexAnal(istream &inFile,          // *In-Out* Input file
+  ostream &outFile,                    // *In-Out* Output file
   LexToken &lexToken);                 // *Out* Token lexed
 
 
@@ -63,14 +91,17 @@ void lexAnal(ifstream &inFile,         // *In-Out* Input file
 // character is encountered or until end of file.
 // If the comment indicator "//" is encountered then skipWhiteComments
 // ignores all text up to the end of the line and then carries on.
-void skipWhiteComments(ifstream &inFile);         // *In-Out* Input file
+void skipWhiteComments(istream &inFile);          // *In-Out* Input file
 
 
 
 
 // writeToken writes a lexical token to cout.
 
-void writeToken(ofstream &outFile,                 // *In-Out* Output file
+void writeToken(ostream &outFile,                  // *In-Out* Output file
+                LexToken lexToken);                // *In* Token to print
+
+void writeToken(OutSink  &outFile,                 // *In-Out* Output sink
                 LexToken lexToken);                // *In* Token to print
 #endif
 
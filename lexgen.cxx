@@ -0,0 +1,680 @@
+// Title   : lexgen.cxx
+// Purpose : Generates lextable.h, the state transition table lexAnal scans
+//           tokens with, from the description of the SCL tokens below.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     lexgen <table>
+//
+// Build and regenerate the table from the repository root with
+//
+//     g++ -std=c++20 -O2 -o lexgen lexgen.cxx && ./lexgen lextable.h
+//
+// lextable.h is checked in, so scl builds without lexgen; it only has to be
+// run again when the description changes.
+//
+// The table is a DFA over the bytes of the source and the end of the file.
+// Each entry is either the next state or, once the token is known, an
+// action saying what to make of the bytes scanned. Bytes that every state
+// treats alike are given one character class, so each state's row has a
+// column per class rather than per byte. lexAnal then scans with one class
+// load and one table load per byte, and only looks at what kind of token
+// it has once, at the end.
+//
+// The table makes the same tokens and errors as the if/else ladder it
+// replaced, in the same places, including where that ladder read the end
+// of the file: its failed get left the last character in place, so an
+// operator state moves at the end of the file as it would on its own last
+// character again ("=" at the end of the file is "==").
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <map>               // Standard C++ map library
+#include <stdlib.h>          // atoi
+#include <string>            // Standard C++ strings library
+#include <vector>            // Standard C++ vector library
+
+
+
+//***************************************************************************
+// The SCL tokens.
+//***************************************************************************
+
+// A word the identifier states recognise, and the token it makes. field is
+// the LexToken field the word is copied into, or null.
+struct WordRule                                    // Reserved word
+{
+  const char *word;                               // Word text
+  const char *tag;                                // Token tag
+  const char *field;                              // Field set
+}; // WordRule
+
+static const WordRule words[] = {
+  { "true",   "BOOLLIT", "boolLit" },
+  { "false",  "BOOLLIT", "boolLit" },
+  { "bool",   "BOOL",    NULL },
+  { "string", "STRING",  NULL },
+  { "int",    "INT",     NULL },
+  { "float",  "FLOAT",   NULL },
+  { "let",    "LET",     NULL },
+  { "in",     "IN",      NULL },
+  { "end",    "END",     NULL }
+};
+
+// Any other word is an identifier. Identifiers start with a letter and go
+// on with letters, digits and underscores.
+static const char identStart[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+static const char identPart[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_";
+
+// An operator and the token it makes. The longest operator matches, so
+// "<=" is one token, but an operator nothing longer starts with is taken
+// without reading the byte after it.
+struct OpRule                                      // Operator
+{
+  const char *op;                                 // Operator text
+  const char *tag;                                // Token tag
+  const char *field;                              // Field set
+}; // OpRule
+
+static const OpRule ops[] = {
+  { "=",  "ASSIGN", NULL },
+  { "(",  "LPAREN", NULL },
+  { ")",  "RPAREN", NULL },
+  { "+",  "ADDOP",  "addOp" },
+  { "-",  "ADDOP",  "addOp" },
+  { "||", "ADDOP",  "addOp" },
+  { "==", "RELOP",  "relOp" },
+  { "<",  "RELOP",  "relOp" },
+  { "<=", "RELOP",  "relOp" },
+  { ">",  "RELOP",  "relOp" },
+  { ">=", "RELOP",  "relOp" },
+  { "!=", "RELOP",  "relOp" },
+  { "*",  "MULOP",  "mulOp" },
+  { "/",  "MULOP",  "mulOp" },
+  { "%",  "MULOP",  "mulOp" },
+  { "&&", "MULOP",  "mulOp" },
+  { "!",  "NOTOP",  NULL }
+};
+
+// What happens when the start of an operator that is not an operator
+// itself is not followed by the rest of one. "keep" puts the byte back and
+// leaves the token as it was.
+struct PrefixRule                                  // Operator prefix
+{
+  const char *prefix;                             // Prefix text
+  const char *target;                             // Action taken
+}; // PrefixRule
+
+static const PrefixRule prefixes[] = {
+  { "&", "keep" },
+  { "|", "fail 3" }
+};
+
+// The number states. Each row gives a state's move on a digit, on '.', on
+// '^' and on any other byte or the end of the file. A move is to a state,
+// to "integer" or "float" for a finished literal, or to "fail <code>".
+struct NumberRow                                   // Number state
+{
+  const char *state;                              // State name
+  const char *digit;                              // On 0 to 9
+  const char *dot;                                // On .
+  const char *caret;                              // On ^
+  const char *other;                              // On anything else
+}; // NumberRow
+
+static const NumberRow numberRows[] = {
+  // state       digit        .          ^          other
+  { "int",       "int",       "dot",     "fail 5",  "integer" },
+  { "dot",       "frac",      "fail 6",  "fail 6",  "fail 6" },
+  { "frac",      "frac",      "fail 7",  "exp",     "float" },
+  { "exp",       "expdigits", "fail 8",  "fail 8",  "fail 8" },
+  { "expdigits", "expdigits", "fail 10", "fail 9",  "float" }
+};
+
+// The lexer errors, by exit code.
+struct FailRule                                    // Lexer error
+{
+  int        code;                                // Exit code
+  const char *message;                            // Error message
+}; // FailRule
+
+static const FailRule failures[] = {
+  { 1,  "End of file detected" },
+  { 2,  "ERROR: Char not recognised" },
+  { 3,  "Error Wrong Symbol" },
+  { 5,  "Lexer error : missing '.' in float." },
+  { 6,  "Lexer error : no digit after ." },
+  { 7,  "Lexer error : multiple ." },
+  { 8,  "Lexer error : no digit after ^" },
+  { 9,  "Lexer error : multiple ^" },
+  { 10, "Lexer eroor : multiple ." }
+};
+
+// A string literal starts with a double quote, which is put back for
+// lexStringLit to read the literal from. A byte that starts no token is
+// error 2, and the end of the file before a token is error 1.
+
+
+
+//***************************************************************************
+// The DFA.
+//***************************************************************************
+
+// Symbols are the end of the file, then the bytes: symbol b + 1 is byte b,
+// as lexAnal indexes lexClass with the int sbumpc returns plus one.
+const int SYMEOF = 0;
+const int SYMBOLS = 257;
+
+// What an action does; the names are those of LexActionKind.
+struct Action                                      // DFA action
+{
+  string kind;                                    // LexActionKind name
+  bool   putback;                                 // Byte put back
+  string tag;                                     // Token tag
+  string field;                                   // Field set, "" if none
+  string text;                                    // Fixed text, "" if none
+  int    code;                                    // Exit code
+  string message;                                 // Error message
+}; // Action
+
+// A state. next holds a state number for each symbol, or -1 - n for
+// action n.
+struct State                                       // DFA state
+{
+  string name;                                    // Row comment
+  int    next[SYMBOLS];                           // Moves
+}; // State
+
+static vector<State>  states;                      // States, start first
+static vector<Action> actions;                     // Distinct actions
+
+
+
+static int addState(const string &name)            // *In* Row comment
+{ // Adds a state with no moves and returns its number.
+
+  State state;                                    // New state
+
+  state.name = name;
+  for (int s = 0; s < SYMBOLS; s++)
+    state.next[s] = 0;
+  states.push_back(state);
+  return (int)states.size() - 1;
+} // addState
+
+
+
+static int addAction(const Action &action)         // *In* Action wanted
+{ // Returns the move to action, adding it if it is new.
+
+  for (size_t a = 0; a < actions.size(); a++)
+  {
+    const Action &old = actions[a];               // Action compared
+
+    if (old.kind == action.kind && old.putback == action.putback &&
+      old.tag == action.tag && old.field == action.field &&
+      old.text == action.text && old.code == action.code)
+      return -1 - (int)a;
+  }
+  actions.push_back(action);
+  return -(int)actions.size();
+} // addAction
+
+
+
+static int tokenAction(const char *tag,            // *In* Token tag
+  const char *field,                               // *In* Field or null
+  const string &text,                              // *In* Fixed text
+  bool putback)                                    // *In* Byte put back
+{ // The move to an action making a token. The text is only kept if there
+  // is a field to put it in.
+
+  Action action = { "LEXTOKEN", putback, tag, "", "", 0, "" };
+
+  if (field != NULL)
+  {
+    action.field = field;
+    action.text = text;
+  }
+  return addAction(action);
+} // tokenAction
+
+
+
+static int failAction(int code)                    // *In* Exit code
+{ // The move to the lexer error with exit code code.
+
+  Action action = { "LEXFAIL", false, "", "", "", code, "" };
+
+  for (const FailRule &f : failures)
+    if (f.code == code)
+      action.message = f.message;
+  if (action.message.empty())
+  {
+    cerr << "No message for lexer error " << code << ".\n";
+    exit(1);
+  }
+  return addAction(action);
+} // failAction
+
+
+
+static int namedMove(const string &target,         // *In* Move named
+  map<string, int> &named)                         // *In* Named states
+{ // The move a description names: a state, "integer", "float", "keep" or
+  // "fail <code>".
+
+  if (target == "integer")
+    return addAction({ "LEXINTEGER", true, "INTLIT", "", "", 0, "" });
+  if (target == "float")
+    return tokenAction("FLOATLIT", "floatLit", "", true);
+  if (target == "keep")
+    return addAction({ "LEXKEEP", true, "", "", "", 0, "" });
+  if (target.compare(0, 5, "fail ") == 0)
+    return failAction(atoi(target.c_str() + 5));
+  if (named.count(target) == 0)
+  {
+    cerr << "No state called " << target << ".\n";
+    exit(1);
+  }
+  return named[target];
+} // namedMove
+
+
+
+static void buildWords(int start)                  // *In* Start state
+{ // One state per prefix of a reserved word and one for any other
+  // identifier. A word ends at the first byte that cannot go on with it,
+  // which is put back.
+
+  map<string, int> prefix;                        // Prefix states
+  int              ident;                         // Any other identifier
+
+  for (const WordRule &w : words)
+    for (size_t n = 1; n <= string(w.word).size(); n++)
+      if (prefix.count(string(w.word, n)) == 0)
+        prefix[string(w.word, n)] = addState("word " + string(w.word, n));
+  ident = addState("identifier");
+
+  // The move from the state for text on byte c.
+  auto wordMove = [&](const string &text, char c) -> int
+  {
+    if (prefix.count(text + c) > 0)
+      return prefix[text + c];
+    return ident;
+  };
+
+  for (const char *c = identStart; *c != '\0'; c++)
+    states[start].next[(unsigned char)*c + 1] = wordMove("", *c);
+
+  // The moves out of each prefix state and the identifier state.
+  prefix[""] = ident;
+  for (auto &p : prefix)
+  {
+    State &state = states[p.second];              // State filled in
+    int   end = tokenAction("IDENT", "ident", "", true); // Identifier
+
+    for (const WordRule &w : words)
+      if (p.first == w.word)
+        end = tokenAction(w.tag, w.field, "", true);
+    for (int s = 0; s < SYMBOLS; s++)
+      state.next[s] = end;
+    for (const char *c = identPart; *c != '\0'; c++)
+      state.next[(unsigned char)*c + 1] =
+        p.second == ident ? ident : wordMove(p.first, *c);
+  }
+} // buildWords
+
+
+
+static bool isOp(const string &text,               // *In* Text looked up
+  const char *&tag,                                // *Out* Its tag
+  const char *&field)                              // *Out* Its field
+{ // True if text is an operator.
+
+  for (const OpRule &o : ops)
+    if (text == o.op)
+    {
+      tag = o.tag;
+      field = o.field;
+      return true;
+    }
+  return false;
+} // isOp
+
+
+
+static bool isOpPrefix(const string &text)         // *In* Text looked up
+{ // True if an operator longer than text starts with it.
+
+  for (const OpRule &o : ops)
+    if (string(o.op).size() > text.size() &&
+      string(o.op).compare(0, text.size(), text) == 0)
+      return true;
+  return false;
+} // isOpPrefix
+
+
+
+static int buildOp(const string &text)             // *In* Bytes so far
+{ // The move on reading the last byte of text, adding the state for text
+  // if an operator longer than it could follow.
+
+  const char *tag = NULL;                         // Operator tag
+  const char *field = NULL;                       // Operator field
+  bool       op = isOp(text, tag, field);         // text is an operator
+  int        self;                                // State for text
+  int        other;                               // Move on other bytes
+
+  if (!isOpPrefix(text))
+    return tokenAction(tag, field, text, false);
+
+  // Neither an operator nor the start of one is put back after an
+  // operator prefix, so it is a token only if it is an operator itself.
+  if (op)
+    other = tokenAction(tag, field, text, true);
+  else
+  {
+    map<string, int> none;                        // No named states
+
+    other = -1;
+    for (const PrefixRule &p : prefixes)
+      if (text == p.prefix)
+        other = namedMove(p.target, none);
+    if (other == -1)
+    {
+      cerr << "No rule for operator prefix " << text << ".\n";
+      exit(1);
+    }
+  }
+
+  self = addState("operator " + text);
+  for (int s = 0; s < SYMBOLS; s++)
+    states[self].next[s] = other;
+  for (int s = 1; s < SYMBOLS; s++)
+  {
+    string longer = text + (char)(s - 1);         // Text and byte
+
+    if (isOpPrefix(longer) || isOp(longer, tag, field))
+      states[self].next[s] = buildOp(longer);
+  }
+  states[self].next[SYMEOF] = states[self].next[(unsigned char)text.back() + 1];
+  return self;
+} // buildOp
+
+
+
+static void buildOps(int start)                    // *In* Start state
+{ // The operator states, from the first byte of each operator.
+
+  bool done[256] = {false};                       // First bytes built
+
+  for (const OpRule &o : ops)
+  {
+    unsigned char first = o.op[0];                // First byte
+
+    if (!done[first])
+      states[start].next[first + 1] = buildOp(string(1, (char)first));
+    done[first] = true;
+  }
+} // buildOps
+
+
+
+static void buildNumbers(int start)                // *In* Start state
+{ // The number states, entered on a digit.
+
+  map<string, int> named;                         // Number states
+
+  for (const NumberRow &row : numberRows)
+    named[row.state] = addState(string("number ") + row.state);
+
+  for (const NumberRow &row : numberRows)
+  {
+    State &state = states[named[row.state]];      // State filled in
+    int   other = namedMove(row.other, named);    // Move on other bytes
+
+    for (int s = 0; s < SYMBOLS; s++)
+      state.next[s] = other;
+    for (char c = '0'; c <= '9'; c++)
+      state.next[(unsigned char)c + 1] = namedMove(row.digit, named);
+    state.next['.' + 1] = namedMove(row.dot, named);
+    state.next['^' + 1] = namedMove(row.caret, named);
+  }
+
+  for (char c = '0'; c <= '9'; c++)
+    states[start].next[(unsigned char)c + 1] = named[numberRows[0].state];
+} // buildNumbers
+
+
+
+static void buildDFA()
+{ // Builds the states and actions, start state first.
+
+  int start = addState("start");                  // Start state
+
+  for (int s = 1; s < SYMBOLS; s++)
+    states[start].next[s] = failAction(2);
+  states[start].next[SYMEOF] = failAction(1);
+
+  states[start].next['\"' + 1] =
+    addAction({ "LEXSTRING", true, "", "", "", 0, "" });
+  buildWords(start);
+  buildOps(start);
+  buildNumbers(start);
+} // buildDFA
+
+
+
+//***************************************************************************
+// The table.
+//***************************************************************************
+
+static int compressClasses(vector<int> &symbolClass) // *Out* Class per symbol
+{ // Gives symbols that every state moves on alike the same class, in
+  // order of first symbol, and returns the number of classes. The end of
+  // the file is class 0.
+
+  vector<int> first;                              // First symbol per class
+
+  symbolClass.assign(SYMBOLS, -1);
+  for (int s = 0; s < SYMBOLS; s++)
+  {
+    for (size_t c = 0; c < first.size() && symbolClass[s] < 0; c++)
+    {
+      bool same = true;                           // Columns match
+
+      for (const State &state : states)
+        if (state.next[s] != state.next[first[c]])
+          same = false;
+      if (same)
+        symbolClass[s] = (int)c;
+    }
+    if (symbolClass[s] < 0)
+    {
+      symbolClass[s] = (int)first.size();
+      first.push_back(s);
+    }
+  }
+  return (int)first.size();
+} // compressClasses
+
+
+
+static string quoted(const string &text)           // *In* Text to quote
+{ // text as a C++ string literal.
+
+  string out = "\"";                              // Literal
+
+  for (char c : text)
+  {
+    if (c == '\"' || c == '\\')
+      out += '\\';
+    out += c;
+  }
+  return out + "\"";
+} // quoted
+
+
+
+static void writeTable(ofstream &out,              // *In-Out* Table file
+  const vector<int> &symbolClass,                  // *In* Class per symbol
+  int classes)                                     // *In* Classes
+{ // Writes lextable.h. Entries below LEXSTATES are states; entry
+  // LEXSTATES + n is action n.
+
+  int nStates = (int)states.size();               // States
+
+  if (nStates + actions.size() > 256)
+  {
+    cerr << "Too many states and actions for a byte table.\n";
+    exit(1);
+  }
+
+  out << "// Title   : lextable.h\n"
+         "// Purpose : State transition table for lexAnal. Generated by "
+         "lexgen.cxx\n"
+         "//           from its description of the SCL tokens; do not edit."
+         "\n"
+         "// Author  : Matthew Jacques\n"
+         "// Date    : 19/10/26\n\n"
+         "#ifndef LEXTABLE_H\n"
+         "#define LEXTABLE_H\n\n\n\n"
+         "// Include the lexer header file for LexToken.\n"
+         "#include \"lexer.h\"   // header for lexer.cxx\n\n\n\n"
+         "// What lexAnal does once the table gives an action.\n"
+         "enum LexActionKind {\n"
+         "  LEXTOKEN,                                        "
+         "// Make token tag\n"
+         "  LEXINTEGER,                                      "
+         "// Make an INTLIT\n"
+         "  LEXSTRING,                                       "
+         "// Call lexStringLit\n"
+         "  LEXKEEP,                                         "
+         "// Leave the token\n"
+         "  LEXFAIL                                          "
+         "// Lexer error\n"
+         "}; // LexActionKind\n\n"
+         "// An action. field is the LexToken field set, to text, or to "
+         "the bytes\n"
+         "// scanned if text is null. putback puts the last byte read "
+         "back.\n"
+         "struct LexAction                                   "
+         "// Table action\n"
+         "{\n"
+         "  LexActionKind kind;                             "
+         "// What is done\n"
+         "  bool          putback;                          "
+         "// Last byte put back\n"
+         "  LexTokenTag   tag;                              "
+         "// Token tag\n"
+         "  string LexToken::*field;                        "
+         "// Field set, or null\n"
+         "  const char    *text;                            "
+         "// Fixed text, or null\n"
+         "  int           code;                             "
+         "// Exit code\n"
+         "  const char    *message;                         "
+         "// Error message\n"
+         "}; // LexAction\n\n\n\n";
+
+  out << "const int LEXSTART = 0;                          "
+         "// Start state\n"
+      << "const int LEXSTATES = " << nStates << ";"
+      << string(26 - to_string(nStates).size(), ' ') << "// States\n"
+      << "const int LEXCLASSES = " << classes << ";"
+      << string(25 - to_string(classes).size(), ' ')
+      << "// Character classes\n\n";
+
+  out << "// The class of each symbol: lexClass[0] is the end of the file "
+         "and\n"
+         "// lexClass[b + 1] is byte b.\n"
+         "static const unsigned char lexClass[257] = {";
+  for (int s = 0; s < SYMBOLS; s++)
+  {
+    if (s % 16 == 0)
+      out << "\n ";
+    out << ' ' << symbolClass[s] << (s + 1 < SYMBOLS ? "," : "");
+  }
+  out << "\n};\n\n";
+
+  out << "// The move from each state on each class.\n"
+         "static const unsigned char lexNext[LEXSTATES][LEXCLASSES] = {\n";
+  for (int n = 0; n < nStates; n++)
+  {
+    vector<int> row(classes);                     // Row by class
+
+    for (int s = 0; s < SYMBOLS; s++)
+    {
+      int move = states[n].next[s];               // State or action
+
+      row[symbolClass[s]] = move >= 0 ? move : nStates + (-1 - move);
+    }
+    out << "  // " << states[n].name << "\n  {";
+    for (int c = 0; c < classes; c++)
+    {
+      if (c > 0 && c % 16 == 0)
+        out << "\n   ";
+      out << ' ' << row[c] << (c + 1 < classes ? "," : "");
+    }
+    out << " }" << (n + 1 < nStates ? "," : "") << '\n';
+  }
+  out << "};\n\n";
+
+  out << "// The actions, entry LEXSTATES + n being action n.\n"
+         "static const LexAction lexActions[" << actions.size() << "] = {\n";
+  for (size_t a = 0; a < actions.size(); a++)
+  {
+    const Action &act = actions[a];               // Action written
+
+    out << "  { " << act.kind << ", " << (act.putback ? "true" : "false")
+        << ", " << (act.tag.empty() ? "IDENT" : act.tag) << ", "
+        << (act.field.empty() ? "NULL" : "&LexToken::" + act.field) << ", "
+        << (act.text.empty() ? "NULL" : quoted(act.text)) << ", "
+        << act.code << ", "
+        << (act.message.empty() ? "NULL" : quoted(act.message)) << " }"
+        << (a + 1 < actions.size() ? "," : "") << '\n';
+  }
+  out << "};\n\n\n#endif\n";
+} // writeTable
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Builds the DFA and writes the table, reporting its size on cout.
+
+  vector<int> symbolClass;                        // Class per symbol
+  int         classes;                            // Classes
+  ofstream    out;                                // Table file
+
+  if (argc != 2)
+  {
+    cerr << "Usage : lexgen <table>\n";
+    return 2;
+  }
+
+  buildDFA();
+  classes = compressClasses(symbolClass);
+
+  out.open(argv[1]);
+  if (!out)
+  {
+    cerr << "Unable to open table file " << argv[1] << ".\n";
+    return 1;
+  }
+  writeTable(out, symbolClass, classes);
+  out.close();
+
+  cout << "States : " << states.size() << "\tClasses : " << classes
+       << "\tActions : " << actions.size() << '\n';
+  return 0;
+} // main
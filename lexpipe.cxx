@@ -0,0 +1,238 @@
+// Title   : lexpipe.cxx
+// Purpose : Pipelined lexer subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The ring has ringSize slots and two counters: tail, the slots the lexer
+// has filled, and head, the slots the parser has emptied. Each side only
+// writes its own counter, and publishes a slot by storing it with release
+// order once the slot is written, so the other side's acquire load of it
+// sees the slot. Each side also keeps the last value it read of the other's
+// counter and only reads the shared one again when that copy says the ring
+// is full (or empty), so the counters' cache lines only move between the
+// cores when the ring fills or drains.
+//
+// The lexer copies each token into its slot rather than moving it, as
+// lexAnal leaves the fields a token does not set as the last token left
+// them (a lone & leaves the whole token as it was), and the parser must see
+// them the same way. The parser swaps the token out of the slot, leaving
+// its previous token's strings there for the next copy to reuse, so a
+// steady stream of tokens allocates nothing.
+//
+// A side waiting on the other spins for a while before yielding, unless
+// there is only one hardware thread, when spinning only keeps the other
+// side off the core.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <atomic>            // Ring positions
+#include <thread>            // Lexer thread
+#include <utility>           // swap
+#include "lexpipe.h"         // header for lexpipe.cxx
+#include "stats.h"           // header for stats.cxx
+#include "allocstats.h"      // header for allocstats.cxx
+#include "trace.h"           // header for trace.cxx
+#include "budget.h"          // header for budget.cxx
+
+
+
+// Slots in the ring, a power of two, and the cache line size the ring's
+// counters are kept apart by.
+const size_t ringSize = 1024;
+const size_t cacheLine = 64;
+
+// Spins before a waiting side yields its core, on more than one hardware
+// thread.
+const int spinLimit = 256;
+
+
+
+// A token, or a lexer error in its place.
+struct TokenSlot                                   // Ring slot
+{
+  LexToken   token;                               // Token lexed
+  bool       error;                               // Slot is an error
+  const char *message;                            // Error message
+  int        code;                                // Error exit code
+}; // TokenSlot
+
+
+
+struct LexPipe                                     // Lexer thread and ring
+{
+  alignas(cacheLine) atomic<size_t> head;         // Slots emptied
+  size_t             tailSeen;                    // Parser's copy of tail
+  alignas(cacheLine) atomic<size_t> tail;         // Slots filled
+  size_t             headSeen;                    // Lexer's copy of head
+  alignas(cacheLine) atomic<bool> cancelled;      // Parser wants a stop
+  atomic<bool>       finished;                    // Lexer has stopped
+  istream            *inFile;                     // Input file
+  int                spins;                       // Spins before yielding
+  bool               timing;                      // Parser's statsTiming
+  bool               counting;                    // Parser's allocCounting
+  const char         *traceFile;                  // Parser's trace file
+  CompileBudget      budget;                      // Parser's limits
+  CompileStats       stats;                       // Lexer's statistics
+  AllocStats         allocs;                      // Lexer's allocations
+  thread             lexer;                       // Lexer thread
+  TokenSlot          slots[ringSize];             // The ring
+}; // LexPipe
+
+
+
+static void waitTurn(const LexPipe *pipe,          // *In* Pipe
+  int &spins)                                      // *In-Out* Spins so far
+{ // Spins for a while, then gives the core away on each call.
+
+  if (spins < pipe->spins)
+    spins++;
+  else
+    this_thread::yield();
+} // waitTurn
+
+
+
+static bool pushSlot(LexPipe *pipe,                // *In-Out* Pipe
+  const LexToken &token,                           // *In* Token lexed
+  const LexError *error)                           // *In* Error or null
+{ // Waits for a free slot and fills it. Returns false if the parser has
+  // stopped the pipe.
+
+  if (pipe->cancelled.load(memory_order_relaxed))
+    return false;
+
+  size_t tail = pipe->tail.load(memory_order_relaxed); // Slot to fill
+  int    spins = 0;                               // Waits so far
+
+  while (tail - pipe->headSeen == ringSize)
+  {
+    pipe->headSeen = pipe->head.load(memory_order_acquire);
+    if (tail - pipe->headSeen == ringSize)
+    {
+      if (pipe->cancelled.load(memory_order_relaxed))
+        return false;
+      waitTurn(pipe, spins);
+    }
+  }
+
+  TokenSlot &slot = pipe->slots[tail % ringSize]; // Slot filled
+
+  slot.token = token;
+  slot.error = error != NULL;
+  if (error != NULL)
+  {
+    slot.message = error->message;
+    slot.code = error->code;
+  }
+  pipe->tail.store(tail + 1, memory_order_release);
+  return true;
+} // pushSlot
+
+
+
+static void lexerThread(LexPipe *pipe)             // *In-Out* Pipe
+{ // Lexes until the end token, a lexer error or a stop. lexAnal is given
+  // an output file that is never opened, as its errors are thrown rather
+  // than written.
+
+  LexToken token;                                 // Token lexed
+  ofstream noFile;                                // Unused output file
+
+  setTraceFile(pipe->traceFile);
+  nameTraceThread("lexer");
+  clearCompileStats(pipe->timing, false);
+  clearAllocStats(pipe->counting);
+  compileBudget = pipe->budget;
+  startBudget();
+  lexThrows = true;
+
+  try
+  {
+    TraceSpan span("lexer");                      // The thread's work
+
+    skipWhiteComments(*pipe->inFile);
+    do
+    {
+      lexAnal(*pipe->inFile, noFile, token);
+    } while (pushSlot(pipe, token, NULL) && token.tag != END);
+  }
+  catch (LexError error)
+  {
+    pushSlot(pipe, token, &error);
+  }
+
+  pipe->stats = getCompileStats();
+  pipe->allocs = getAllocStats();
+  pipe->finished.store(true, memory_order_release);
+} // lexerThread
+
+
+
+LexPipe *startLexPipe(istream &inFile)             // *In-Out* Input file
+{ // The thread is timed and counts allocations if this thread does.
+
+  LexPipe *pipe = new LexPipe;                    // Pipe started
+
+  pipe->head.store(0, memory_order_relaxed);
+  pipe->tailSeen = 0;
+  pipe->tail.store(0, memory_order_relaxed);
+  pipe->headSeen = 0;
+  pipe->cancelled.store(false, memory_order_relaxed);
+  pipe->finished.store(false, memory_order_relaxed);
+  pipe->inFile = &inFile;
+  pipe->spins = thread::hardware_concurrency() > 1 ? spinLimit : 0;
+  pipe->timing = statsTiming;
+  pipe->counting = allocCounting;
+  pipe->traceFile = traceFileName();
+  pipe->budget = compileBudget;
+  pipe->lexer = thread(lexerThread, pipe);
+  return pipe;
+} // startLexPipe
+
+
+
+bool pipeToken(LexPipe *pipe,                      // *In-Out* Pipe
+  ostream &outFile,                                // *In-Out* Output file
+  LexToken &lexToken)                              // *Out* Token lexed
+{ // finished is only trusted after tail has been read again, as the last
+  // slot is filled before finished is set.
+
+  size_t head = pipe->head.load(memory_order_relaxed); // Slot to empty
+  int    spins = 0;                               // Waits so far
+
+  while (head == pipe->tailSeen)
+  {
+    bool finished = pipe->finished.load(memory_order_acquire);
+
+    pipe->tailSeen = pipe->tail.load(memory_order_acquire);
+    if (head == pipe->tailSeen)
+    {
+      if (finished)
+        return false;
+      waitTurn(pipe, spins);
+    }
+  }
+
+  TokenSlot &slot = pipe->slots[head % ringSize]; // Slot emptied
+
+  swap(lexToken, slot.token);
+  if (slot.error)
+    lexFail(outFile, slot.message, slot.code);
+  pipe->head.store(head + 1, memory_order_release);
+  return true;
+} // pipeToken
+
+
+
+void stopLexPipe(LexPipe *pipe)                    // *In* Pipe stopped
+{ // The lexer sees cancelled at its next push and stops, having lexed at
+  // most one token more.
+
+  pipe->cancelled.store(true, memory_order_relaxed);
+  pipe->lexer.join();
+  addCompileStats(pipe->stats);
+  addAllocStats(pipe->allocs);
+  delete pipe;
+} // stopLexPipe
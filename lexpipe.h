@@ -0,0 +1,52 @@
+// Title   : lexpipe.h
+// Purpose : Pipelined lexer header file for SCL. Runs the lexer on a
+//           thread of its own, ahead of the parser, for one parse.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef LEXPIPE_H
+#define LEXPIPE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include file IO library and the lexer header file for LexToken.
+#include <fstream>         // Standard file I/O
+#include "lexer.h"         // header for lexer.cxx
+
+
+
+// A LexPipe is a lexer thread and the ring of tokens it fills. The thread
+// calls skipWhiteComments and then lexAnal until it has lexed the end
+// token or met a lexer error. Tokens go into a bounded single producer,
+// single consumer ring, with the producer's and consumer's positions on
+// cache lines of their own, and the parser takes them out in order. A
+// lexer error goes into the ring in place of a token, so the parser fails
+// with it only when it reaches it, as it would lexing for itself. The
+// thread keeps its own statistics and allocation counts, which are added
+// to the parser thread's when it is stopped, and lexes to the parser
+// thread's budgets (see budget.h), counted from when it starts.
+struct LexPipe;
+
+
+
+// startLexPipe starts a lexer thread reading inFile, which the parser must
+// not touch until pipeToken returns false or the pipe is stopped.
+LexPipe *startLexPipe(istream &inFile);            // *In-Out* Input file
+
+// pipeToken puts the next token in lexToken, waiting for it if need be.
+// If the next item is a lexer error it calls lexFail with it on outFile.
+// Returns false once the thread has stopped after the end token, when the
+// caller may go on lexing inFile itself.
+bool pipeToken(LexPipe *pipe,                      // *In-Out* Pipe
+  ostream &outFile,                                // *In-Out* Output file
+  LexToken &lexToken);                             // *Out* Token lexed
+
+// stopLexPipe tells the thread to stop, waits for it, adds its statistics
+// to this thread's and deletes the pipe.
+void stopLexPipe(LexPipe *pipe);                   // *In* Pipe stopped
+
+
+#endif
@@ -0,0 +1,295 @@
+// Title   : lextable.h
+// Purpose : State transition table for lexAnal. Generated by lexgen.cxx
+//           from its description of the SCL tokens; do not edit.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef LEXTABLE_H
+#define LEXTABLE_H
+
+
+
+// Include the lexer header file for LexToken.
+#include "lexer.h"   // header for lexer.cxx
+
+
+
+// What lexAnal does once the table gives an action.
+enum LexActionKind {
+  LEXTOKEN,                                        // Make token tag
+  LEXINTEGER,                                      // Make an INTLIT
+  LEXSTRING,                                       // Call lexStringLit
+  LEXKEEP,                                         // Leave the token
+  LEXFAIL                                          // Lexer error
+}; // LexActionKind
+
+// An action. field is the LexToken field set, to text, or to the bytes
+// scanned if text is null. putback puts the last byte read back.
+struct LexAction                                   // Table action
+{
+  LexActionKind kind;                             // What is done
+  bool          putback;                          // Last byte put back
+  LexTokenTag   tag;                              // Token tag
+  string LexToken::*field;                        // Field set, or null
+  const char    *text;                            // Fixed text, or null
+  int           code;                             // Exit code
+  const char    *message;                         // Error message
+}; // LexAction
+
+
+
+const int LEXSTART = 0;                          // Start state
+const int LEXSTATES = 45;                        // States
+const int LEXCLASSES = 35;                       // Character classes
+
+// The class of each symbol: lexClass[0] is the end of the file and
+// lexClass[b + 1] is byte b.
+static const unsigned char lexClass[257] = {
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 2, 3, 1, 1, 4, 5, 1, 6, 7, 8, 9, 1, 10, 11,
+  12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 1, 1, 14, 15, 16,
+  1, 1, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+  17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 1, 1, 1, 18,
+  19, 1, 20, 21, 17, 22, 23, 24, 25, 17, 26, 17, 17, 27, 17, 28,
+  29, 17, 17, 30, 31, 32, 33, 17, 17, 17, 17, 17, 1, 34, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1
+};
+
+// The move from each state on each class.
+static const unsigned char lexNext[LEXSTATES][LEXCLASSES] = {
+  // start
+  { 46, 45, 38, 47, 73, 39, 59, 60, 71, 61, 62, 45, 72, 40, 36, 34,
+    37, 33, 45, 45, 33, 10, 33, 30, 5, 33, 20, 27, 33, 33, 33, 14,
+    1, 33, 35 },
+  // word t
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 2, 33,
+    33, 33, 48 },
+  // word tr
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 3, 48 },
+  // word tru
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 4, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word true
+  { 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 33, 51, 51,
+    51, 33, 51, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 51 },
+  // word f
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 6, 33, 33, 33, 33, 33, 33, 23, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word fa
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 7, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word fal
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 8,
+    33, 33, 48 },
+  // word fals
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 9, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word false
+  { 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 51, 33, 51, 51,
+    51, 33, 51, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 51 },
+  // word b
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 11, 33, 33,
+    33, 33, 48 },
+  // word bo
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 12, 33, 33,
+    33, 33, 48 },
+  // word boo
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 13, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word bool
+  { 49, 49, 49, 49, 49, 49, 49, 49, 49, 49, 49, 49, 49, 33, 49, 49,
+    49, 33, 49, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 49 },
+  // word s
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    15, 33, 48 },
+  // word st
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 16, 33,
+    33, 33, 48 },
+  // word str
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 17, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word stri
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 18, 33, 33, 33,
+    33, 33, 48 },
+  // word strin
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 19, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word string
+  { 56, 56, 56, 56, 56, 56, 56, 56, 56, 56, 56, 56, 56, 33, 56, 56,
+    56, 33, 56, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 56 },
+  // word i
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 21, 33, 33, 33,
+    33, 33, 48 },
+  // word in
+  { 53, 53, 53, 53, 53, 53, 53, 53, 53, 53, 53, 53, 53, 33, 53, 53,
+    53, 33, 53, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    22, 33, 53 },
+  // word int
+  { 54, 54, 54, 54, 54, 54, 54, 54, 54, 54, 54, 54, 54, 33, 54, 54,
+    54, 33, 54, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 54 },
+  // word fl
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 24, 33, 33,
+    33, 33, 48 },
+  // word flo
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 25, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word floa
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    26, 33, 48 },
+  // word float
+  { 52, 52, 52, 52, 52, 52, 52, 52, 52, 52, 52, 52, 52, 33, 52, 52,
+    52, 33, 52, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 52 },
+  // word l
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 28, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word le
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    29, 33, 48 },
+  // word let
+  { 55, 55, 55, 55, 55, 55, 55, 55, 55, 55, 55, 55, 55, 33, 55, 55,
+    55, 33, 55, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 55 },
+  // word e
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 31, 33, 33, 33,
+    33, 33, 48 },
+  // word en
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // word end
+  { 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 33, 50, 50,
+    50, 33, 50, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 50 },
+  // identifier
+  { 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 48, 33, 48, 48,
+    48, 33, 48, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+    33, 33, 48 },
+  // operator =
+  { 58, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 58,
+    57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57, 57,
+    57, 57, 57 },
+  // operator |
+  { 64, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 64 },
+  // operator <
+  { 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 66,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65 },
+  // operator >
+  { 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 68,
+    67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67, 67,
+    67, 67, 67 },
+  // operator !
+  { 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 70,
+    69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69, 69,
+    69, 69, 69 },
+  // operator &
+  { 75, 74, 74, 74, 74, 75, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74,
+    74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74, 74,
+    74, 74, 74 },
+  // number int
+  { 76, 76, 76, 76, 76, 76, 76, 76, 76, 76, 76, 41, 76, 40, 76, 76,
+    76, 76, 77, 76, 76, 76, 76, 76, 76, 76, 76, 76, 76, 76, 76, 76,
+    76, 76, 76 },
+  // number dot
+  { 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 42, 78, 78,
+    78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78, 78,
+    78, 78, 78 },
+  // number frac
+  { 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 80, 79, 42, 79, 79,
+    79, 79, 43, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79,
+    79, 79, 79 },
+  // number exp
+  { 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 44, 81, 81,
+    81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81, 81,
+    81, 81, 81 },
+  // number expdigits
+  { 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 82, 79, 44, 79, 79,
+    79, 79, 83, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79, 79,
+    79, 79, 79 }
+};
+
+// The actions, entry LEXSTATES + n being action n.
+static const LexAction lexActions[39] = {
+  { LEXFAIL, false, IDENT, NULL, NULL, 2, "ERROR: Char not recognised" },
+  { LEXFAIL, false, IDENT, NULL, NULL, 1, "End of file detected" },
+  { LEXSTRING, true, IDENT, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, IDENT, &LexToken::ident, NULL, 0, NULL },
+  { LEXTOKEN, true, BOOL, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, END, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, BOOLLIT, &LexToken::boolLit, NULL, 0, NULL },
+  { LEXTOKEN, true, FLOAT, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, IN, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, INT, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, LET, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, STRING, NULL, NULL, 0, NULL },
+  { LEXTOKEN, true, ASSIGN, NULL, NULL, 0, NULL },
+  { LEXTOKEN, false, RELOP, &LexToken::relOp, "==", 0, NULL },
+  { LEXTOKEN, false, LPAREN, NULL, NULL, 0, NULL },
+  { LEXTOKEN, false, RPAREN, NULL, NULL, 0, NULL },
+  { LEXTOKEN, false, ADDOP, &LexToken::addOp, "+", 0, NULL },
+  { LEXTOKEN, false, ADDOP, &LexToken::addOp, "-", 0, NULL },
+  { LEXFAIL, false, IDENT, NULL, NULL, 3, "Error Wrong Symbol" },
+  { LEXTOKEN, false, ADDOP, &LexToken::addOp, "||", 0, NULL },
+  { LEXTOKEN, true, RELOP, &LexToken::relOp, "<", 0, NULL },
+  { LEXTOKEN, false, RELOP, &LexToken::relOp, "<=", 0, NULL },
+  { LEXTOKEN, true, RELOP, &LexToken::relOp, ">", 0, NULL },
+  { LEXTOKEN, false, RELOP, &LexToken::relOp, ">=", 0, NULL },
+  { LEXTOKEN, true, NOTOP, NULL, NULL, 0, NULL },
+  { LEXTOKEN, false, RELOP, &LexToken::relOp, "!=", 0, NULL },
+  { LEXTOKEN, false, MULOP, &LexToken::mulOp, "*", 0, NULL },
+  { LEXTOKEN, false, MULOP, &LexToken::mulOp, "/", 0, NULL },
+  { LEXTOKEN, false, MULOP, &LexToken::mulOp, "%", 0, NULL },
+  { LEXKEEP, true, IDENT, NULL, NULL, 0, NULL },
+  { LEXTOKEN, false, MULOP, &LexToken::mulOp, "&&", 0, NULL },
+  { LEXINTEGER, true, INTLIT, NULL, NULL, 0, NULL },
+  { LEXFAIL, false, IDENT, NULL, NULL, 5, "Lexer error : missing '.' in float." },
+  { LEXFAIL, false, IDENT, NULL, NULL, 6, "Lexer error : no digit after ." },
+  { LEXTOKEN, true, FLOATLIT, &LexToken::floatLit, NULL, 0, NULL },
+  { LEXFAIL, false, IDENT, NULL, NULL, 7, "Lexer error : multiple ." },
+  { LEXFAIL, false, IDENT, NULL, NULL, 8, "Lexer error : no digit after ^" },
+  { LEXFAIL, false, IDENT, NULL, NULL, 10, "Lexer eroor : multiple ." },
+  { LEXFAIL, false, IDENT, NULL, NULL, 9, "Lexer error : multiple ^" }
+};
+
+
+#endif
@@ -0,0 +1,546 @@
+// Title   : main.cxx
+// Purpose : Driver for the SCL compiler. Parses an SCL program, prints the
+//           symbol table and AST and optionally evaluates the program over
+//           the rows of a data file.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     scl <source> <output> [--bind <data> <results>] [--threads <n>]
+//         [--adaptive | --kernels] [--image <image> [--verify-image]]
+//         [--json <dump> | --ndjson <dump>] [--stats] [--perf] [--allocs]
+//         [--trace <trace>] [--pipeline] [--errors <n>] [--share]
+//         [--simplify] [--prune] [--limit <budget> <n>]...
+//     scl --from-image <image> <output>
+//     scl --daemon <socket> [--threads <n>] [--limit <budget> <n>]...
+//
+// The listing (symbol table, AST and any errors) is written to output.
+// With --bind every row of the CSV or TSV file data is bound to the let
+// declarations named in its header line, the program is evaluated and one
+// result per row is written to results. The row rate is reported on cout.
+// --threads evaluates the rows on n worker threads (0 for one per hardware
+// thread); without it the rows are evaluated on the calling thread.
+// --adaptive reorders the operands of && and || chains by their profiled
+// cost and selectivity and reports how many operand evaluations it saved.
+// --kernels lowers the program once to type specialised kernels so that no
+// type or operator is looked at per row.
+// --image saves the parsed program as a binary image (see astimage.h) and
+// maps it back, which checks its structure. --verify-image also prints the
+// image and the parsed trees and checks that the listings match.
+// --from-image prints the listing of a saved image without parsing
+// anything.
+// --json and --ndjson write the tokens, symbols and AST as JSON (see
+// jsondump.h): one document, or one record per line.
+// --stats reports the time spent in each phase of the compile and counts
+// of tokens, nodes, symbol lookups and bytes read on cout (see stats.h).
+// --perf reports the CPU cycles, instructions, branch misses and cache
+// misses of each phase on cout, in total, per source byte and per token
+// (see perfcount.h). Where the counters cannot be read it says why and the
+// compile goes on.
+// --allocs reports the heap allocations and bytes of each phase on cout,
+// split by call site (token strings, AST nodes, symbols, reports and the
+// rest) and per source byte (see allocstats.h).
+// --trace writes spans of the compile and of any evaluation to trace as
+// Chrome trace-event JSON (see trace.h), even if the compile fails.
+// --daemon compiles the programs sent to socket by sclclient, with n
+// workers (one per hardware thread by default), until one asks it to stop
+// (see daemon.h). Each compile is held to tenantBudget (see budget.h).
+// --pipeline lexes on a thread of its own, ahead of the parser (see
+// lexpipe.h). The listing is the same either way.
+// --errors reports up to n errors in one pass rather than stopping at the
+// first (see synRecover in syner.h), and exits with the code the first
+// would have given. Tokens are then lexed on the parsing thread.
+// --share shares the identical subtrees of the parsed expression (see
+// hashcons.h) and reports the nodes and bytes it saved on cout. The
+// listing, image, dump and results are the same either way.
+// --simplify rewrites the parsed expression into a smaller one with the
+// same results (see simplify.h) and reports the rules it applied on cout.
+// The listing shows the simplified expression.
+// --prune deletes the let declarations the expression does not use (see
+// prune.h) before the listing is printed, and reports how many it removed
+// on cout. Columns of the data file named after them are then ignored.
+// --limit sets one of the compile's budgets (see budget.h): bytes, tokens,
+// nodes, symbols, depth or ms, with 0 for no limit, and is given once for
+// each budget set. A compile over budget fails with a limit error, code 11
+// from the lexer's (bytes, tokens and ms) and 1 from the parser's. scl has
+// no limits unless given; the daemon starts from tenantBudget.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>         // Standard file I/O
+#include <iostream>        // Standard console I/O
+#include <stdlib.h>        // atoi
+#include <string.h>        // strcmp
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "outsink.h"       // header for outsink.cxx
+#include "syner.h"         // header for syner.cxx
+#include "evaluator.h"     // header for evaluator.cxx
+#include "csvbind.h"       // header for csvbind.cxx
+#include "parallel.h"      // header for parallel.cxx
+#include "astimage.h"      // header for astimage.cxx
+#include "jsondump.h"      // header for jsondump.cxx
+#include "daemon.h"        // header for daemon.cxx
+#include "stats.h"         // header for stats.cxx
+#include "trace.h"         // header for trace.cxx
+#include "perfcount.h"     // header for perfcount.cxx
+#include "allocstats.h"    // header for allocstats.cxx
+#include "hashcons.h"      // header for hashcons.cxx
+#include "prune.h"         // header for prune.cxx
+#include "simplify.h"      // header for simplify.cxx
+#include "budget.h"        // header for budget.cxx
+
+
+
+static void usage()
+{ // Prints the command line summary.
+
+  cerr << "Usage : scl <source> <output> [--bind <data> <results>]"
+          " [--threads <n>] [--adaptive | --kernels]"
+          " [--image <image> [--verify-image]]"
+          " [--json <dump> | --ndjson <dump>] [--stats] [--perf] [--allocs]"
+          " [--trace <trace>] [--pipeline] [--errors <n>] [--share]"
+          " [--simplify] [--prune] [--limit <budget> <n>]...\n"
+          "        scl --from-image <image> <output>\n"
+          "        scl --daemon <socket> [--threads <n>]"
+          " [--limit <budget> <n>]...\n"
+          "Budgets : bytes tokens nodes symbols depth ms\n";
+} // usage
+
+
+
+static int runBind(const char *dataPath,           // *In* Data file name
+  const char *resultPath,                          // *In* Results file
+  int threads,                                     // *In* Workers or -1
+  EvalMode mode,                                   // *In* Evaluation mode
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Evaluates the program over every row of the data file. Returns the
+  // process exit code.
+
+  ofstream  results;                              // Results file
+  BindStats stats;                                // Row counts and time
+
+  results.open(resultPath);
+  if (!results)
+  {
+    cerr << "Unable to open results file " << resultPath << ".\n";
+    return 1;
+  }
+
+  try
+  {
+    if (threads < 0)
+      bindCSV(dataPath, st, ast, mode, results, stats);
+    else
+      bindCSVParallel(dataPath, st, ast, mode, results, threads, stats);
+  }
+  catch (RunReport r)
+  {
+    cerr << "Runtime error " << r.getNumber();
+    if (r.getRow() > 0)
+      cerr << " at row " << r.getRow();
+    if (r.getColumn() > 0)
+      cerr << " column " << r.getColumn();
+    cerr << ".\n";
+    if ((r.getNumber() > minRunError) &&
+      (r.getNumber() < maxRunError + minRunError))
+      cerr << runtime[r.getNumber() - minRunError];
+    return 1;
+  }
+
+  cout << "Rows : " << stats.rows
+       << "\tBytes : " << stats.bytes
+       << "\tSeconds : " << stats.seconds;
+  if (stats.seconds > 0.0)
+    cout << "\tRows/s : " << (long long)(stats.rows / stats.seconds)
+         << "\tMB/s : " << stats.bytes / stats.seconds / 1e6;
+  cout << '\n';
+
+  if (mode == ADAPTIVEEVAL)
+    cout << "Chains : " << stats.counters.chains
+         << "\tOperands : " << stats.counters.operands
+         << "\tSource order : " << stats.counters.sourceOrder
+         << "\tSaved : "
+         << stats.counters.sourceOrder - stats.counters.operands
+         << "\tSamples : " << stats.counters.samples
+         << "\tReorders : " << stats.counters.reorders << '\n';
+
+  return 0;
+} // runBind
+
+
+
+static int saveImage(const char *imagePath,        // *In* Image file name
+  bool verify,                                     // *In* Compare listings
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Writes the image and maps it back, and if asked to checks that it
+  // prints the same listing. Returns the process exit code.
+
+  AstImage image;                                 // Image mapped back
+  long long nodes = 0;                            // AST records
+
+  if (!writeImage(imagePath, st, ast))
+  {
+    cerr << "Unable to write image file " << imagePath << ".\n";
+    return 1;
+  }
+
+  if (!mapImage(imagePath, image))
+  {
+    cerr << "Image file " << imagePath << " does not load.\n";
+    return 1;
+  }
+
+  if (verify && !verifyImage(image, st, ast))
+  {
+    cerr << "Image file " << imagePath << " does not match the listing.\n";
+    unmapImage(image);
+    return 1;
+  }
+
+  for (int s = IMGEXPRESSIONS; s <= IMGFACTORS; s++)
+    nodes += image.header->count[s];
+  cout << "Image : Bytes : " << image.header->size
+       << "\tSymbols : " << image.header->count[IMGSYMBOLS]
+       << "\tNodes : " << nodes << '\n';
+
+  unmapImage(image);
+  return 0;
+} // saveImage
+
+
+
+static int listImage(const char *imagePath,        // *In* Image file name
+  const char *outPath)                             // *In* Listing file
+{ // Prints the listing of a saved image. Returns the process exit code.
+
+  AstImage image;                                 // Mapped image
+  ofstream outFile;                               // Listing
+
+  if (!mapImage(imagePath, image))
+  {
+    cerr << "Unable to load image file " << imagePath << ".\n";
+    return 1;
+  }
+
+  outFile.open(outPath);
+  if (!outFile)
+  {
+    cerr << "Unable to open output file " << outPath << ".\n";
+    unmapImage(image);
+    return 1;
+  }
+
+  {
+    OutSink listing(outFile);                     // Buffered listing
+
+    printImageST(listing, image);
+    listing << "\n\nExpression\n";
+    printImageAST(listing, image);
+    listing << '\n';
+  }
+  outFile.close();
+
+  unmapImage(image);
+  return 0;
+} // listImage
+
+
+
+static int dumpJson(const char *sourcePath,        // *In* Source file name
+  const char *dumpPath,                            // *In* Dump file name
+  JsonMode mode,                                   // *In* Output mode
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // The source is lexed a second time for the token records. Returns the
+  // process exit code.
+
+  ifstream inFile;                                // Source program
+  ofstream dumpFile;                              // Dump
+
+  inFile.open(sourcePath);
+  dumpFile.open(dumpPath);
+  if (!inFile || !dumpFile)
+  {
+    cerr << "Unable to open dump file " << dumpPath << ".\n";
+    return 1;
+  }
+
+  {
+    OutSink dump(dumpFile);                       // Buffered dump
+
+    if (mode == JSONDOC)
+      dump << "{\"tokens\":";
+    jsonTokens(inFile, dumpFile, dump, mode);
+    if (mode == JSONDOC)
+      dump << ",\"symbols\":";
+    jsonST(dump, st, mode);
+    if (mode == JSONDOC)
+      dump << ",\"ast\":";
+    jsonAST(dump, ast, mode);
+    if (mode == JSONDOC)
+      dump << "}\n";
+  }
+  dumpFile.close();
+  return 0;
+} // dumpJson
+
+
+
+static int runListing(ofstream &outFile,           // *In-Out* Listing
+  const char *imagePath,                           // *In* Image file or null
+  bool verify,                                     // *In* Compare listings
+  const char *dumpPath,                            // *In* Dump file or null
+  JsonMode jsonMode,                               // *In* Dump format
+  const char *sourcePath,                          // *In* Source file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Prints the listing, then saves the image and writes the dump if asked
+  // to. Returns the process exit code.
+
+  {
+    OutSink listing(outFile);                     // Buffered listing
+
+    printST(listing, st);
+    listing << "\n\nExpression\n";
+    printAST(listing, ast);
+    listing << '\n';
+  }
+  outFile.close();
+
+  if (imagePath != NULL && saveImage(imagePath, verify, st, ast) != 0)
+    return 1;
+
+  if (dumpPath != NULL &&
+    dumpJson(sourcePath, dumpPath, jsonMode, st, ast) != 0)
+    return 1;
+
+  return 0;
+} // runListing
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Parses the program and prints the listing, then binds if asked to.
+
+  ifstream inFile;                                // Source program
+  ofstream outFile;                               // Listing
+  SymTab   *st = NULL;                            // Symbol table
+  AST      *ast = NULL;                           // Abs syntax tree
+  int      label = 0;                             // Label number
+  char     *dataPath = NULL;                      // --bind data file
+  char     *resultPath = NULL;                    // --bind results file
+  int      threads = -1;                          // --threads count
+  EvalMode mode = TREEEVAL;                       // Row evaluation mode
+  char     *imagePath = NULL;                     // --image file
+  bool     verify = false;                        // --verify-image given
+  char     *dumpPath = NULL;                      // --json or --ndjson file
+  JsonMode jsonMode = JSONDOC;                    // Dump format
+  bool     stats = false;                         // --stats given
+  bool     perf = false;                          // --perf given
+  string   perfWhy;                               // Why no counters
+  bool     allocs = false;                        // --allocs given
+  AllocStats allocCounts;                         // Compile's allocations
+  char     *tracePath = NULL;                     // --trace file
+  ParseMode parseMode = PARSESEQUENTIAL;          // --pipeline given
+  int      maxErrors = 0;                         // --errors count
+  vector<Diagnostic> errors;                      // Errors found
+  bool     share = false;                         // --share given
+  ShareStats shareCounts;                         // What sharing saved
+  bool     prune = false;                         // --prune given
+  PruneStats pruneCounts;                         // What pruning removed
+  bool     simplify = false;                      // --simplify given
+  SimplifyStats simplifyCounts;                   // Rules applied
+  CompileBudget budget = {};                      // --limit budgets
+  int      status = 0;                            // Exit code
+
+  if (argc < 3)
+  {
+    usage();
+    return 2;
+  }
+
+  if (strcmp(argv[1], "--from-image") == 0)
+  {
+    if (argc != 4)
+    {
+      usage();
+      return 2;
+    }
+    return listImage(argv[2], argv[3]);
+  }
+
+  if (strcmp(argv[1], "--daemon") == 0)
+  {
+    budget = tenantBudget;
+    for (int i = 3; i < argc; i++)
+    {
+      if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        threads = atoi(argv[++i]);
+      else if (strcmp(argv[i], "--limit") == 0 && i + 2 < argc &&
+        setBudget(budget, argv[i + 1], argv[i + 2]))
+        i += 2;
+      else
+      {
+        usage();
+        return 2;
+      }
+    }
+    return runDaemon(argv[2], threads, budget);
+  }
+
+  // Options follow the source and output file names.
+  for (int i = 3; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--bind") == 0 && i + 2 < argc)
+    {
+      dataPath = argv[++i];
+      resultPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--adaptive") == 0)
+      mode = ADAPTIVEEVAL;
+    else if (strcmp(argv[i], "--kernels") == 0)
+      mode = KERNELEVAL;
+    else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+      imagePath = argv[++i];
+    else if (strcmp(argv[i], "--verify-image") == 0)
+      verify = true;
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+    {
+      dumpPath = argv[++i];
+      jsonMode = JSONDOC;
+    }
+    else if (strcmp(argv[i], "--ndjson") == 0 && i + 1 < argc)
+    {
+      dumpPath = argv[++i];
+      jsonMode = NDJSON;
+    }
+    else if (strcmp(argv[i], "--stats") == 0)
+      stats = true;
+    else if (strcmp(argv[i], "--perf") == 0)
+      perf = true;
+    else if (strcmp(argv[i], "--allocs") == 0)
+      allocs = true;
+    else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+      tracePath = argv[++i];
+    else if (strcmp(argv[i], "--pipeline") == 0)
+      parseMode = PARSEPIPELINED;
+    else if (strcmp(argv[i], "--errors") == 0 && i + 1 < argc)
+      maxErrors = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--share") == 0)
+      share = true;
+    else if (strcmp(argv[i], "--prune") == 0)
+      prune = true;
+    else if (strcmp(argv[i], "--simplify") == 0)
+      simplify = true;
+    else if (strcmp(argv[i], "--limit") == 0 && i + 2 < argc &&
+      setBudget(budget, argv[i + 1], argv[i + 2]))
+      i += 2;
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+
+  if (tracePath != NULL)
+  {
+    startTrace();
+    nameTraceThread("main");
+    setTraceFile(argv[1]);
+  }
+
+  {
+    TraceSpan span("read");                       // Source is read as lexed
+
+    inFile.open(argv[1]);
+  }
+  if (!inFile)
+  {
+    cerr << "Unable to open source file " << argv[1] << ".\n";
+    return 1;
+  }
+
+  outFile.open(argv[2]);
+  if (!outFile)
+  {
+    cerr << "Unable to open output file " << argv[2] << ".\n";
+    return 1;
+  }
+
+  if (perf && !openPerfCounters(perfWhy))
+  {
+    cout << "Counters : unavailable, " << perfWhy << ".\n";
+    perf = false;
+  }
+
+  // Allocations are charged to the phase running, which is only known
+  // while the phases are timed.
+  clearCompileStats(stats || perf || allocs, perf);
+  clearAllocStats(allocs);
+  compileBudget = budget;
+  if (maxErrors > 0)
+    synRecover(inFile, outFile, st, ast, label, errors, maxErrors);
+  else
+    synAnal(inFile, outFile, st, ast, label, parseMode);
+  if (!errors.empty())
+    status = errors[0].code;
+  else if (ast == NULL)
+    status = 1;
+  else
+  {
+    // Simplifying first leaves fewer identifiers to keep and fewer nodes
+    // to share.
+    if (simplify)
+    {
+      simplifyAST(ast, simplifyCounts);
+      reportSimplify(cout, simplifyCounts);
+    }
+    if (prune)
+    {
+      pruneST(st, ast, true, pruneCounts);
+      reportPruning(cout, pruneCounts);
+    }
+    if (share)
+    {
+      shareAST(ast, shareCounts);
+      reportSharing(cout, shareCounts);
+    }
+    status = runListing(outFile, imagePath, verify, dumpPath, jsonMode,
+      argv[1], st, ast);
+  }
+
+  // The reports below allocate, so the compile's counts are kept first.
+  allocCounts = getAllocStats();
+  clearAllocStats(false);
+
+  if (stats)
+    reportStats(cout, getCompileStats());
+  if (perf)
+  {
+    reportEvents(cout, getCompileStats());
+    closePerfCounters();
+  }
+  if (allocs)
+    reportAllocs(cout, allocCounts, getCompileStats().bytesRead);
+
+  if (status == 0 && dataPath != NULL)
+    status = runBind(dataPath, resultPath, threads, mode, st, ast);
+
+  if (tracePath != NULL && !writeTrace(tracePath))
+  {
+    cerr << "Unable to write trace file " << tracePath << ".\n";
+    status = 1;
+  }
+
+  freeTrees(st, ast);
+  return status;
+} // main
@@ -0,0 +1,75 @@
+// Title   : outsink.cxx
+// Purpose : Buffered output sink subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <ostream>       // Standard output streams
+#include <string.h>      // memcpy
+#include "outsink.h"     // header for outsink.cxx
+
+
+
+void OutSink::flush()
+{ // One write per buffer full; out decides for itself when to flush.
+
+  if (used == 0)
+    return;
+
+  out.write(buffer.data(), used);
+  writes++;
+  bytes += used;
+  used = 0;
+} // OutSink::flush
+
+
+
+void OutSink::writeLarge(const char *text,         // *In* Bytes to write
+  size_t length)                                   // *In* Byte count
+{ // Called when text does not fit in what is left of the buffer. Fills the
+  // buffer and hands it on; text longer than a whole buffer goes straight
+  // to out rather than being copied through.
+
+  size_t room = buffer.size() - used;             // Space left
+
+  if (length >= buffer.size())
+  {
+    flush();
+    out.write(text, length);
+    writes++;
+    bytes += length;
+    return;
+  }
+
+  memcpy(&buffer[used], text, room);
+  used += room;
+  flush();
+  memcpy(&buffer[0], text + room, length - room);
+  used = length - room;
+} // OutSink::writeLarge
+
+
+
+void OutSink::writeLong(long long n)               // *In* Number to write
+{ // Digits are produced backwards into a small scratch array and copied
+  // in one go.
+
+  char               digits[24];                  // Scratch, right aligned
+  int                pos = sizeof digits;         // First digit used
+  unsigned long long u = (n < 0) ? 0ULL - (unsigned long long)n :
+                                   (unsigned long long)n;
+
+  do
+  {
+    digits[--pos] = (char)('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+
+  if (n < 0)
+    digits[--pos] = '-';
+
+  write(digits + pos, sizeof digits - pos);
+} // OutSink::writeLong
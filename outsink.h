@@ -0,0 +1,117 @@
+// Title   : outsink.h
+// Purpose : Buffered output sink header file for SCL. Collects listing
+//           output in one reusable buffer and hands it to a stream in
+//           large blocks.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef OUTSINK_H
+#define OUTSINK_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream, string and vector libraries.
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <string.h>        // memcpy, strlen
+#include <vector>          // Standard C++ vector library
+
+
+
+// Bytes buffered before an OutSink passes them on.
+const size_t outSinkSize = 1 << 16;
+
+
+
+// An OutSink stands in for an ofstream in the printers and writeToken.
+// Writes go into buffer; the buffer is handed to out with a single write
+// when it fills, when flush is called or when the sink is destroyed. The
+// stream itself is never flushed, so a listing of any size costs one write
+// per outSinkSize bytes rather than one per line. Integers are formatted
+// by hand rather than through the stream's locale machinery.
+class OutSink                                      // Buffered writer
+{
+private:
+  // Data members.
+  ostream      &out;                              // Destination
+  vector<char> buffer;                            // Pending bytes
+  size_t       used;                              // Bytes in buffer
+  long long    writes;                            // Blocks written
+  long long    bytes;                             // Bytes written
+
+  void writeLarge(const char *text,                // *In* Bytes to write
+    size_t length);                                // *In* Byte count
+  void writeLong(long long n);                     // *In* Number to write
+
+public:
+  // Class constructor and destructor.
+  OutSink(ostream &o,                              // *In-Out* Destination
+    size_t capacity = outSinkSize)                 // *In* Buffer size
+    : out(o), buffer(capacity < 64 ? 64 : capacity), used(0), writes(0),
+      bytes(0)
+  {
+  }
+  ~OutSink()
+  {
+    flush();
+  }
+
+  // Hands the buffered bytes to out. Does not flush out.
+  void flush();
+
+  // Appends length bytes of text.
+  void write(const char *text, size_t length)
+  {
+    if (length <= buffer.size() - used)
+    {
+      memcpy(&buffer[used], text, length);
+      used += length;
+    }
+    else
+      writeLarge(text, length);
+  }
+
+  OutSink &operator<<(char c)
+  {
+    if (used == buffer.size())
+      flush();
+    buffer[used++] = c;
+    return *this;
+  }
+  OutSink &operator<<(const char *s)
+  {
+    write(s, strlen(s));
+    return *this;
+  }
+  OutSink &operator<<(const string &s)
+  {
+    write(s.data(), s.size());
+    return *this;
+  }
+  OutSink &operator<<(int n)
+  {
+    writeLong(n);
+    return *this;
+  }
+  OutSink &operator<<(long long n)
+  {
+    writeLong(n);
+    return *this;
+  }
+
+  // Accessor methods. Counts cover bytes already handed to out.
+  long long getWrites()
+  {
+    return writes;
+  }
+  long long getBytes()
+  {
+    return bytes;
+  }
+}; // class OutSink
+
+
+#endif
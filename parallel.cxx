@@ -0,0 +1,324 @@
+// Title   : parallel.cxx
+// Purpose : Multi-core row binder subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The calling thread is the dispatcher and the merger. It cuts the mapped
+// data into morsels, deals them round robin onto the workers' queues and
+// then writes the results of morsel 0, 1, 2, ... as each one completes.
+// A worker takes from the front of its own queue, which keeps it working
+// on the lowest (soonest to be written) morsels it holds, and steals from
+// the back of the other queues when its own is empty.
+//
+// Only window morsels are dispatched beyond the last one written. Each has
+// a slot in a ring holding its bounds and its result text, so memory is
+// bounded by window * (morsel results) whatever the size of the file.
+//
+// Evaluation only reads the AST and SymTab so the workers share them. Each
+// worker has its own bindings and row evaluator, and adds the evaluator's
+// counters to the pool's totals when it exits.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <chrono>              // Wall clock timing
+#include <condition_variable>  // Worker wake ups
+#include <deque>               // Work queues
+#include <mutex>               // Queue locks
+#include <ostream>             // Standard output streams
+#include <string>              // Standard C++ strings library
+#include <thread>              // Worker threads
+#include <vector>              // Standard C++ vector library
+#include "parallel.h"          // header for parallel.cxx
+#include "trace.h"             // header for trace.cxx
+
+
+
+// Morsels in flight per worker.
+const int morselsPerWorker = 4;
+
+
+
+// One morsel of the data file and, once done, its results. A failed morsel
+// keeps the error number, the row within the morsel and the column.
+struct MorselSlot                                  // In flight morsel
+{
+  size_t    begin;                                // First line start
+  size_t    end;                                  // Range end
+  string    results;                              // Result lines
+  long long rows;                                 // Rows evaluated
+  bool      done;                                 // Worker finished
+  bool      failed;                               // Row raised an error
+  int       errNumber;                            // Error number
+  long long errRow;                               // Row within morsel
+  int       errColumn;                            // Column of error
+}; // MorselSlot
+
+
+
+// A worker's queue of morsel numbers.
+struct WorkQueue                                   // Work-stealing deque
+{
+  mutex           lock;                           // Guards items
+  deque<long long> items;                         // Morsel numbers
+}; // WorkQueue
+
+
+
+// State shared between the dispatcher and the workers. lock guards
+// pending, stop, counters and the done flags of the slots.
+struct WorkPool                                    // Worker pool
+{
+  const MappedFile   *file;                       // Mapped data
+  const CsvLayout    *layout;                     // Header layout
+  SymTab             *st;                         // Symbol table
+  AST                *ast;                        // Abs syntax tree
+  EvalMode           mode;                        // Evaluation mode
+  const char         *traceFile;                  // Dispatcher's file
+  EvalCounters       counters;                    // Summed counters
+  vector<WorkQueue>  queues;                      // One per worker
+  vector<MorselSlot> slots;                       // Ring of window slots
+  mutex              lock;                        // Guards the below
+  condition_variable workReady;                   // pending rose or stop
+  condition_variable morselDone;                  // A slot became done
+  long long          pending;                     // Queued morsels
+  bool               stop;                        // Workers to exit
+}; // WorkPool
+
+
+
+//***************************************************************************
+//Worker subprograms.
+//***************************************************************************
+
+static bool takeWork(WorkPool &pool,               // *In-Out* Pool
+  int self,                                        // *In* Worker number
+  long long &morsel)                               // *Out* Morsel number
+{ // Waits until a morsel is queued, claims it and then finds it: first at
+  // the front of the worker's own queue, then at the back of the others.
+  // Returns false when the pool is stopping.
+
+  int workers = (int)pool.queues.size();          // Queue count
+
+  {
+    unique_lock<mutex> guard(pool.lock);
+    pool.workReady.wait(guard, [&pool]
+      { return pool.pending > 0 || pool.stop; });
+    if (pool.stop)
+      return false;
+    pool.pending--;
+  }
+
+  // Claiming decremented pending, and morsels are queued before pending
+  // is raised, so one is certain to be found.
+  for (;;)
+  {
+    for (int i = 0; i < workers; i++)
+    {
+      WorkQueue &queue = pool.queues[(self + i) % workers];
+      lock_guard<mutex> guard(queue.lock);
+
+      if (!queue.items.empty())
+      {
+        if (i == 0)
+        {
+          morsel = queue.items.front();
+          queue.items.pop_front();
+        }
+        else
+        {
+          morsel = queue.items.back();
+          queue.items.pop_back();
+        }
+        return true;
+      }
+    }
+  }
+} // takeWork
+
+
+
+static void worker(WorkPool *pool,                 // *In-Out* Pool
+  int self)                                        // *In* Worker number
+{ // Evaluates morsels until the pool stops.
+
+  vector<Value> env;                              // Worker's bindings
+  long long     morsel = 0;                       // Current morsel
+  int           window = (int)pool->slots.size(); // Ring size
+  RowEvaluator  *eval = newRowEvaluator(pool->mode, pool->ast);
+
+  setTraceFile(pool->traceFile);
+  nameTraceThread("worker " + to_string(self));
+  bindDefaults(pool->st, env);
+
+  while (takeWork(*pool, self, morsel))
+  {
+    MorselSlot &slot = pool->slots[morsel % window];
+    TraceSpan  span("morsel");                    // Traced as evaluation
+
+    slot.results.clear();
+    slot.rows = 0;
+    slot.failed = false;
+
+    try
+    {
+      bindRange(*pool->file, slot.begin, slot.end, *pool->layout, *eval,
+        env.data(), slot.results, slot.rows);
+    }
+    catch (RunReport r)
+    {
+      slot.failed = true;
+      slot.errNumber = r.getNumber();
+      slot.errRow = r.getRow();
+      slot.errColumn = r.getColumn();
+    }
+
+    {
+      lock_guard<mutex> guard(pool->lock);
+      slot.done = true;
+    }
+    pool->morselDone.notify_all();
+  }
+
+  {
+    lock_guard<mutex> guard(pool->lock);
+    eval->addCounters(pool->counters);
+  }
+  delete eval;
+} // worker
+
+//***************************************************************************
+//End of worker subprograms.
+//***************************************************************************
+
+
+
+static void stopPool(WorkPool &pool,               // *In-Out* Pool
+  vector<thread> &workers)                         // *In-Out* Threads
+{ // Tells the workers to exit once their current morsel is done and waits
+  // for them.
+
+  {
+    lock_guard<mutex> guard(pool.lock);
+    pool.stop = true;
+  }
+  pool.workReady.notify_all();
+
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+} // stopPool
+
+
+
+void bindCSVParallel(const char *dataPath,         // *In* Data file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  EvalMode mode,                                   // *In* Evaluation mode
+  ostream &out,                                    // *In-Out* Results
+  int threads,                                     // *In* Worker count
+  BindStats &stats)                                // *Out* Statistics
+{ // Maps the file, starts the workers and then alternates between topping
+  // up the window and writing the next morsel in order.
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  MappedFile     file;                            // Mapped data file
+  CsvLayout      layout;                          // Header layout
+  vector<thread> workers;                         // Worker threads
+  long long      dispatched = 0;                  // Morsels queued
+  long long      written = 0;                     // Morsels written
+  size_t         pos = 0;                         // Next morsel start
+  int            window = 0;                      // Morsels in flight
+  TraceSpan      span("bindCSVParallel");         // Traced as evaluation
+
+  stats.rows = 0;
+  stats.bytes = 0;
+  stats.seconds = 0.0;
+  clearCounters(stats.counters);
+
+  if (threads < 1)
+    threads = (int)thread::hardware_concurrency();
+  if (threads < 1)
+    threads = 1;
+  window = threads * morselsPerWorker;
+
+  if (!mapFile(dataPath, file))
+    throw RunReport(306);
+
+  readLayout(file, st, layout);
+  pos = layout.body;
+
+  WorkPool pool;
+  pool.file = &file;
+  pool.layout = &layout;
+  pool.st = st;
+  pool.ast = ast;
+  pool.mode = mode;
+  pool.traceFile = traceFileName();
+  clearCounters(pool.counters);
+  pool.queues = vector<WorkQueue>(threads);
+  pool.slots.resize(window);
+  pool.pending = 0;
+  pool.stop = false;
+
+  for (int i = 0; i < threads; i++)
+    workers.push_back(thread(worker, &pool, i));
+
+  for (;;)
+  {
+    // Top up the window.
+    while (dispatched - written < window && pos < file.size)
+    {
+      MorselSlot &slot = pool.slots[dispatched % window];
+
+      slot.begin = pos;
+      slot.end = lineStart(file, pos + morselSize);
+      slot.done = false;
+      pos = slot.end;
+
+      {
+        WorkQueue &queue = pool.queues[dispatched % threads];
+        lock_guard<mutex> guard(queue.lock);
+        queue.items.push_back(dispatched);
+      }
+      {
+        lock_guard<mutex> guard(pool.lock);
+        pool.pending++;
+      }
+      pool.workReady.notify_one();
+      dispatched++;
+    }
+
+    if (written == dispatched)
+      break;
+
+    // Wait for the oldest morsel and write it.
+    MorselSlot &slot = pool.slots[written % window];
+    {
+      unique_lock<mutex> guard(pool.lock);
+      pool.morselDone.wait(guard, [&slot] { return slot.done; });
+    }
+
+    out.write(slot.results.data(), slot.results.size());
+
+    if (slot.failed)
+    {
+      RunReport r(slot.errNumber, stats.rows + slot.errRow, slot.errColumn);
+
+      stopPool(pool, workers);
+      unmapFile(file);
+      throw r;
+    }
+
+    stats.rows += slot.rows;
+    written++;
+  }
+
+  stopPool(pool, workers);
+  stats.counters = pool.counters;
+  stats.bytes = file.size;
+  unmapFile(file);
+
+  stats.seconds = chrono::duration<double>(chrono::steady_clock::now() -
+    start).count();
+} // bindCSVParallel
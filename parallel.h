@@ -0,0 +1,38 @@
+// Title   : parallel.h
+// Purpose : Multi-core row binder header file for SCL. Evaluates the rows
+//           of a data file on a work-stealing pool of threads.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the row binder header file for the BindStats type.
+#include <ostream>         // Standard output streams
+#include "csvbind.h"       // header for csvbind.cxx
+
+
+
+// bindCSVParallel does the same job as bindCSV using threads workers. The
+// data rows are cut into morsels (see morselSize in csvbind.h) which are
+// handed to the workers' queues; a worker whose queue runs dry steals from
+// the back of another worker's queue. Results are written in row order, and
+// at most a fixed window of morsels is in flight at once so memory use does
+// not grow with the file. Row numbers in errors are the same as bindCSV
+// would give. A threads value below 1 means one per hardware thread. Each
+// worker has its own row evaluator of the given mode.
+void bindCSVParallel(const char *dataPath,         // *In* Data file name
+  SymTab *st,                                      // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  EvalMode mode,                                   // *In* Evaluation mode
+  ostream &out,                                    // *In-Out* Results
+  int threads,                                     // *In* Worker count
+  BindStats &stats);                               // *Out* Statistics
+
+
+#endif
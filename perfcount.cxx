@@ -0,0 +1,173 @@
+// Title   : perfcount.cxx
+// Purpose : Hardware performance counter subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The events are opened as one group with the first one opened as its
+// leader, so the kernel schedules them onto the CPU together and one read
+// of the leader returns them all. Reads use PERF_FORMAT_GROUP, which gives
+// the number of counters, the time the group was enabled and running, and
+// then the counts in the order the counters were opened.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <string.h>      // strerror
+#include <string>        // Standard C++ strings library
+#include "perfcount.h"   // header for perfcount.cxx
+
+#ifdef __linux__
+#include <errno.h>              // errno
+#include <linux/perf_event.h>   // perf_event_attr
+#include <sys/ioctl.h>          // ioctl
+#include <sys/syscall.h>        // SYS_perf_event_open
+#include <unistd.h>             // syscall, read, close
+#endif
+
+
+
+const char *const perfEventNames[PERFEVENTS] = {
+  "Cycles", "Instructions", "Branch misses", "Cache misses"
+};
+
+
+
+// This thread's counters. fds holds the descriptor for each event, -1 if
+// it is not counted; order holds the events in the order they were opened,
+// which is the order a group read returns them in.
+static thread_local int  perfFds[PERFEVENTS] = {-1, -1, -1, -1};
+static thread_local int  perfOrder[PERFEVENTS];
+static thread_local int  perfOpened = 0;
+static thread_local bool perfShared = false;
+
+
+
+#ifdef __linux__
+
+static int openEvent(PerfEvent event,              // *In* Event to count
+  int leader)                                      // *In* Group leader or -1
+{ // Returns the descriptor or -1, leaving errno set.
+
+  static const unsigned long long configs[PERFEVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+  };
+
+  struct perf_event_attr attr;                    // Event description
+
+  memset(&attr, 0, sizeof attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof attr;
+  attr.config = configs[event];
+  attr.disabled = (leader == -1);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+    PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+} // openEvent
+
+#endif
+
+
+
+bool openPerfCounters(string &why)                 // *Out* Reason if not
+{ // The leader is opened disabled and enabled once the group is complete.
+
+  closePerfCounters();
+
+#ifdef __linux__
+  int leader = -1;                                // Group leader
+  int firstErr = 0;                               // Why the first failed
+
+  for (int e = 0; e < PERFEVENTS; e++)
+  {
+    int fd = openEvent((PerfEvent)e, leader);     // Event's descriptor
+
+    if (fd < 0)
+    {
+      if (firstErr == 0)
+        firstErr = errno;
+      continue;
+    }
+    if (leader == -1)
+      leader = fd;
+    perfFds[e] = fd;
+    perfOrder[perfOpened++] = e;
+  }
+
+  if (leader == -1)
+  {
+    if (firstErr == ENOENT || firstErr == EOPNOTSUPP || firstErr == ENODEV)
+      why = "no hardware counters on this CPU";
+    else if (firstErr == EACCES || firstErr == EPERM)
+      why = "not permitted (see /proc/sys/kernel/perf_event_paranoid)";
+    else
+      why = string("perf_event_open failed: ") + strerror(firstErr);
+    return false;
+  }
+
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+#else
+  why = "hardware counters are only read on Linux";
+  return false;
+#endif
+} // openPerfCounters
+
+
+
+bool perfCounting(PerfEvent event)                 // *In* Event
+{ // Counted if it was opened.
+
+  return perfFds[event] != -1;
+} // perfCounting
+
+
+
+void readPerfCounters(long long values[PERFEVENTS]) // *Out* Counts
+{ // The leader is the first event opened.
+
+  for (int e = 0; e < PERFEVENTS; e++)
+    values[e] = 0;
+
+#ifdef __linux__
+  unsigned long long data[3 + PERFEVENTS];        // nr, enabled, running
+
+  if (perfOpened == 0 ||
+    read(perfFds[perfOrder[0]], data, sizeof data) < (ssize_t)(3 * 8))
+    return;
+
+  if (data[2] < data[1])
+    perfShared = true;
+  for (unsigned long long i = 0; i < data[0] && i < (unsigned)perfOpened; i++)
+    values[perfOrder[i]] = (long long)data[3 + i];
+#endif
+} // readPerfCounters
+
+
+
+bool perfMultiplexed()
+{ // Seen on some read.
+
+  return perfShared;
+} // perfMultiplexed
+
+
+
+void closePerfCounters()
+{ // Members are closed before the leader.
+
+#ifdef __linux__
+  for (int i = perfOpened - 1; i >= 0; i--)
+    close(perfFds[perfOrder[i]]);
+#endif
+
+  for (int e = 0; e < PERFEVENTS; e++)
+    perfFds[e] = -1;
+  perfOpened = 0;
+  perfShared = false;
+} // closePerfCounters
@@ -0,0 +1,58 @@
+// Title   : perfcount.h
+// Purpose : Hardware performance counter header file for SCL. Reads the
+//           CPU's cycle, instruction, branch miss and cache miss counters
+//           for the calling thread.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include string library.
+#include <string>          // Standard C++ strings library
+
+
+
+// The events counted. Only user space is counted, which is what an
+// unprivileged process may count, and is where the compiler's own work is.
+enum PerfEvent {
+  PERFCYCLES,                                      // CPU cycles
+  PERFINSTRUCTIONS,                                // Instructions retired
+  PERFBRANCHMISSES,                                // Mispredicted branches
+  PERFCACHEMISSES,                                 // Last level cache misses
+  PERFEVENTS
+}; // PerfEvent
+
+// Names of the events, in enum order.
+extern const char *const perfEventNames[PERFEVENTS];
+
+
+
+// openPerfCounters starts the counters for the calling thread, using the
+// Linux perf_event_open system call. Counters the CPU or the kernel does
+// not offer are left out; if none can be opened (no PMU, as in many
+// virtual machines, a perf_event_paranoid setting that forbids it, or not
+// Linux) it returns false and why says why.
+bool openPerfCounters(string &why);                // *Out* Reason if not
+
+// perfCounting tells whether event is being counted on this thread.
+bool perfCounting(PerfEvent event);                // *In* Event
+
+// readPerfCounters sets values to the counts since the counters were
+// opened, with 0 for events not counted. It costs one system call.
+void readPerfCounters(long long values[PERFEVENTS]); // *Out* Counts
+
+// perfMultiplexed tells whether the kernel has had to share the counters
+// with other users since they were opened, in which case counts are low.
+bool perfMultiplexed();
+
+// closePerfCounters stops this thread's counters.
+void closePerfCounters();
+
+
+#endif
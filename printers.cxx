@@ -4,38 +4,45 @@
 // Author  : Matthew Jacques
 // Date    : 24/11/13
 
-#include "syner.h" // header for syner.cxx
-#include <iomanip> // Standard IO manipulators library
+#include "syner.h"   // header for syner.cxx
+#include "outsink.h" // header for outsink.cxx
+#include "stats.h"   // header for stats.cxx
+#include "trace.h"   // header for trace.cxx
+#include <iomanip>   // Standard IO manipulators library
+#include <vector>    // Standard C++ vector library
 
 // ***************************************************************************
 // SymTab Output Subprograms.
 // ***************************************************************************
 
 // Forward declarations for every print function
-void printST(ofstream &outFile,                    // *In-Out* Output file
+void printST(OutSink  &outFile,                    // *In-Out* Output file
              SymTab   *st);                        // *In* Symbol table
 
-void printFactor(ofstream &outFile,                // *In-Out* Output file
+void printFactor(OutSink  &outFile,                // *In-Out* Output file
                  Factor   *fact);                  // *In* Factor
 
-void printTerm(ofstream &outFile,                  // *In-Out* Output file
+void printTerm(OutSink  &outFile,                  // *In-Out* Output file
                Term     *term);                    // *In* Term
 
-void printBasicExp(ofstream &outFile,              // *In-Out* Output file
+void printBasicExp(OutSink  &outFile,              // *In-Out* Output file
                    BasicExp *bexp);                // *In* BasicExp
 
-void printExpression(ofstream   &outFile,          // *In-Out* Output file
+void printExpression(OutSink    &outFile,          // *In-Out* Output file
                      Expression *expr);            // *In* Expression
 
-void printAST(ofstream &outFile,                   // *In-Out* Output file
+void printAST(OutSink  &outFile,                   // *In-Out* Output file
               AST      *ast);                      // *In* Abst. syntax tree
 
 
 
-void printST(ofstream &outFile,                    // *In-Out* Output file
+void printST(OutSink  &outFile,                    // *In-Out* Output file
              SymTab   *st)                         // *In* Symbol table
 { // Prints out the Symbol Table.
 
+  PhaseTimer timer(PHASEPRINT);                   // Charged to printers
+  TraceSpan  span("printST");                     // Traced as printST
+
   outFile << "\n\nName\tType\tValue\n" ;
   while (st != NULL)
   { // Print the current datatype entry.
@@ -52,13 +59,13 @@ void printST(ofstream &outFile,                    // *In-Out* Output file
     // Print the current literal of the datatype
     if (st->initialise != NULL)
     { if (st->initialise->type == BOOLDATA)
-        outFile << '\t' << st->initialise->litBool << endl ;
+        outFile << '\t' << st->initialise->litBool << '\n' ;
       else if (st->initialise->type == STRINGDATA)
-        outFile << '\t' << st->initialise->litString << endl ;
+        outFile << '\t' << st->initialise->litString << '\n' ;
       else if (st->initialise->type == INTDATA)
-        outFile << '\t' << st->initialise->litInt << endl ;
+        outFile << '\t' << st->initialise->litInt << '\n' ;
       else if (st->initialise->type == FLOATDATA)
-        outFile << '\t' << st->initialise->litFloat << endl ;
+        outFile << '\t' << st->initialise->litFloat << '\n' ;
     }
     else
       outFile << "\tNone\n" ;
@@ -69,101 +76,160 @@ void printST(ofstream &outFile,                    // *In-Out* Output file
 } // printST
 
 
-void printFactor(ofstream &outFile,                // *In-Out* Output file
+// The expression printers use an explicit stack of PrintSteps instead of
+// recursion, so neither a long chain of operators nor deep brackets can run
+// out of stack. Each step prints one node; a node with children pushes
+// them, and the text that follows them, in reverse so they pop in print
+// order. A chain pushes only its first operand, its operator and the rest
+// of the chain, so the stack grows with bracket depth and not with the
+// length of a chain.
+enum PrintStepKind {
+  PRINTEXPRESSION, PRINTBASICEXP, PRINTTERM, PRINTFACTOR, PRINTOP, PRINTTEXT
+}; // PrintStepKind
+
+struct PrintStep                                   // Node still to print
+{
+  PrintStepKind kind;                             // What node is
+  const void    *node;                            // Node, operator or text
+}; // PrintStep
+
+
+
+static void printSteps(OutSink &outFile,           // *In-Out* Output file
+                       PrintStep first)            // *In* Node to print
+{ // Prints first and everything below it.
+
+  vector<PrintStep> steps(1, first);              // Steps still to do
+
+  while (!steps.empty())
+  {
+    PrintStep step = steps.back();                // Step to do now
+    steps.pop_back();
+
+    switch (step.kind)
+    {
+    case PRINTEXPRESSION :
+      { // be1 [relOp be2]
+        Expression *expr = (Expression *)step.node;
+        if (expr->be2 != NULL)
+        {
+          steps.push_back({ PRINTBASICEXP, expr->be2 });
+          steps.push_back({ PRINTOP, &expr->relOp });
+        }
+        steps.push_back({ PRINTBASICEXP, expr->be1 });
+      }
+      break;
+    case PRINTBASICEXP :
+      { // term [addOp rest]
+        BasicExp *bexp = (BasicExp *)step.node;
+        if (bexp->bexp != NULL)
+        {
+          steps.push_back({ PRINTBASICEXP, bexp->bexp });
+          steps.push_back({ PRINTOP, &bexp->addOp });
+        }
+        steps.push_back({ PRINTTERM, bexp->term });
+      }
+      break;
+    case PRINTTERM :
+      { // fact [mulOp rest]
+        Term *term = (Term *)step.node;
+        if (term->term != NULL)
+        {
+          steps.push_back({ PRINTTERM, term->term });
+          steps.push_back({ PRINTOP, &term->mulOp });
+        }
+        steps.push_back({ PRINTFACTOR, term->fact });
+      }
+      break;
+    case PRINTFACTOR :
+      {
+        Factor *fact = (Factor *)step.node;
+
+        // Check for a literal and print it if present.
+        if (fact->literal)
+        { if (fact->type == BOOLDATA)
+            outFile << fact->litBool ;
+          else if (fact->type == STRINGDATA)
+            outFile << fact->litString ;
+          else if (fact->type == INTDATA)
+            outFile << fact->litInt ;
+          else if (fact->type == FLOATDATA)
+            outFile << fact->litFloat ;
+          else
+            outFile << "Error : claimed literal is not a literal.\n" ;
+        }
+
+        // Must be either an identifier, a bracketed expression or a negated
+        // boolean factor. Brackets print the opening text now and leave the
+        // closing text to follow the contents.
+        else if (fact->ident != NULL)
+          outFile << fact->ident->ident ;
+        else if (fact->bExp != NULL)
+        { outFile << '(' ;
+          steps.push_back({ PRINTTEXT, ")" });
+          steps.push_back({ PRINTEXPRESSION, fact->bExp });
+        }
+        else if (fact->nFactor != NULL)
+        { outFile << "!(" ;
+          steps.push_back({ PRINTTEXT, ")" });
+          steps.push_back({ PRINTFACTOR, fact->nFactor });
+        }
+        else
+          outFile << "Error : empty factor.\n" ;
+      }
+      break;
+    case PRINTOP :
+      outFile << ' ' << *(const string *)step.node << ' ' ;
+      break;
+    case PRINTTEXT :
+      outFile << (const char *)step.node ;
+      break;
+    } // switch (step.kind)
+  } // while
+} // printSteps
+
+
+
+void printFactor(OutSink  &outFile,                // *In-Out* Output file
                  Factor   *fact)                   // *In* Factor
 { // Prints out a Factor.
 
-  // Check for a literal and print it if present.
-  if (fact->literal)
-  { if (fact->type == BOOLDATA)
-      outFile << fact->litBool ;
-    else if (fact->type == STRINGDATA)
-      outFile << fact->litString ;
-    else if (fact->type == INTDATA)
-      outFile << fact->litInt ;
-    else if (fact->type == FLOATDATA)
-      outFile << fact->litFloat ;
-    else
-      outFile << "Error : claimed literal is not a literal.\n" ;
-  }
-
-  // Must be either an identifier, a bracketed expression or a negated
-  // boolean factor. Check for each and print if present.
-  else
-  { if (fact->ident != NULL)
-      outFile << fact->ident->ident  ;
-    else if (fact->bExp != NULL)
-      { outFile << '(' ;
-        printExpression(outFile, fact->bExp) ;
-        outFile << ')' ;
-      }
-    else if (fact->nFactor != NULL)
-      { outFile << "!(" ;
-        printFactor(outFile, fact->nFactor) ;
-        outFile << ')' ;
-      }
-    else
-      outFile << "Error : empty factor.\n" ;
-  }
+  printSteps(outFile, { PRINTFACTOR, fact });
 } // printFactor
 
 
-void printTerm(ofstream &outFile,                  // *In-Out* Output file
+void printTerm(OutSink  &outFile,                  // *In-Out* Output file
                Term     *term)                     // *In* Term
 { // Prints out a Term.
 
-  // Call printFactor to print the factor.
-  printFactor(outFile, term->fact) ;
-
-  // If there is another term print the mulOp and call printTerm to
-  // print the rest of the terms.
-  if (term->term != NULL)
-  { outFile << ' ' << term->mulOp << ' ' ;
-    term = term->term ;
-    printTerm(outFile, term) ;
-  }
+  printSteps(outFile, { PRINTTERM, term });
 } // printTerm
 
 
-void printBasicExp(ofstream &outFile,              // *In-Out* Output file
+void printBasicExp(OutSink  &outFile,              // *In-Out* Output file
                    BasicExp *bexp)                 // *In* BasicExp
 { // Prints out a BasicExp.
 
-  // Call printTerm to print the term.
-  printTerm(outFile, bexp->term) ;
-
-  // If there is another basicexp print the addOp and call printBasicExp to
-  // print the rest of the basicexps.
-  if (bexp->bexp != NULL)
-  { outFile << ' ' << bexp->addOp << ' ' ;
-    bexp = bexp->bexp ;
-    printBasicExp(outFile, bexp) ;
-  }
+  printSteps(outFile, { PRINTBASICEXP, bexp });
 } // printBasicExp
 
 
 
-void printExpression(ofstream   &outFile,          // *In-Out* Output file
+void printExpression(OutSink    &outFile,          // *In-Out* Output file
                      Expression *expr)             // *In* Expression
 { // Prints out an Expression.
 
-  // Call printBasicExp to print the basicexp.
-  printBasicExp(outFile, expr->be1) ;
-
-  // If there is another basicexp print the relOp and call printBasicExp to
-  // print the rest of the basicexps.
-  if (expr->be2 != NULL)
-  { outFile << ' ' << expr->relOp << ' ' ;
-    printBasicExp(outFile, expr->be2) ;
-  }
+  printSteps(outFile, { PRINTEXPRESSION, expr });
 } // printExpression
 
 
 
-void printAST(ofstream &outFile,                   // *In-Out* Output file
+void printAST(OutSink  &outFile,                   // *In-Out* Output file
               AST      *ast)                       // *In* Abst. syntax tree
 { // Prints the AST
- 
+
+  PhaseTimer timer(PHASEPRINT);                   // Charged to printers
+  TraceSpan  span("printAST");                    // Traced as printAST
 
   // While loop to print each statement in turn.
   while  (ast != NULL)
@@ -177,6 +243,28 @@ void printAST(ofstream &outFile,                   // *In-Out* Output file
 
 } // printAST
 
+
+
+void printST(ostream &outFile,                     // *In-Out* Output file
+             SymTab   *st)                         // *In* Symbol table
+{ // Prints the Symbol Table through a sink of its own.
+
+  OutSink sink(outFile);                          // Buffered output
+
+  printST(sink, st);
+} // printST
+
+
+
+void printAST(ostream &outFile,                    // *In-Out* Output file
+              AST      *ast)                       // *In* Abst. syntax tree
+{ // Prints the AST through a sink of its own.
+
+  OutSink sink(outFile);                          // Buffered output
+
+  printAST(sink, ast);
+} // printAST
+
 //***************************************************************************
 // End of SymTab Output Subprograms.
 //***************************************************************************
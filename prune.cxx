@@ -0,0 +1,132 @@
+// Title   : prune.cxx
+// Purpose : Dead declaration subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// The marks are kept by slot rather than in the SymTab, so nothing the
+// parser builds changes. An entry's slot is its position in source order,
+// and the table is in reverse source order, so renumbering walks the table
+// counting down from the number of entries kept.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <ostream>         // Standard output streams
+#include <unordered_set>   // Shared brackets walked
+#include <vector>          // Standard C++ vector library
+#include "prune.h"         // header for prune.cxx
+
+
+
+// The marks so far, and the brackets of a shared AST already walked.
+struct Marking                                     // Marking in progress
+{
+  vector<bool>                         &used;     // Used by slot
+  bool                                 shared;    // AST is a DAG
+  unordered_set<const Expression *>    walked;    // Brackets walked
+}; // Marking
+
+
+
+//***************************************************************************
+//Marking subprograms.
+//***************************************************************************
+
+static void markExpression(Marking &marking,       // *In-Out* Marking
+  Expression *expr)                                // *In* Expression
+{ // Every operand of both sides; a ! is followed down to its operand.
+
+  for (BasicExp *bexp : { expr->be1, expr->be2 })
+    for (; bexp != NULL; bexp = bexp->bexp)
+      for (Term *term = bexp->term; term != NULL; term = term->term)
+      {
+        Factor *fact = term->fact;                // Operand
+
+        while (fact->nFactor != NULL)
+          fact = fact->nFactor;
+
+        if (fact->ident != NULL)
+          marking.used[fact->ident->slot] = true;
+        else if (fact->bExp != NULL &&
+          (!marking.shared || marking.walked.insert(fact->bExp).second))
+          markExpression(marking, fact->bExp);
+      }
+} // markExpression
+
+//***************************************************************************
+//End of marking subprograms.
+//***************************************************************************
+
+
+
+void markUsed(SymTab *st,                          // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  vector<bool> &used)                              // *Out* Used by slot
+{ // Every statement's expression is walked.
+
+  used.assign(st == NULL ? 0 : st->slot + 1, false);
+
+  for (; ast != NULL; ast = ast->next)
+  {
+    Marking marking = { used, ast->shared, {} };  // This expression
+
+    if (ast->expr != NULL)
+      markExpression(marking, ast->expr);
+  }
+} // markUsed
+
+
+
+void pruneST(SymTab *&st,                          // *In-Out* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  bool drop,                                       // *In* Delete unused
+  PruneStats &stats)                               // *Out* Counts
+{ // The unused entries are unlinked and deleted in one pass, then the
+  // slots of the rest are numbered down from the head.
+
+  vector<bool> used;                              // Used by slot
+  SymTab       **link = &st;                      // Link to the entry
+  int          slot;                              // Next slot down
+
+  markUsed(st, ast, used);
+
+  stats.declared = (int)used.size();
+  stats.used = 0;
+  stats.removed = 0;
+  for (bool mark : used)
+    if (mark)
+      stats.used++;
+
+  if (!drop)
+    return;
+
+  while (*link != NULL)
+  {
+    SymTab *entry = *link;                        // Entry looked at
+
+    if (used[entry->slot])
+      link = &entry->next;
+    else
+    {
+      *link = entry->next;
+      delete entry->initialise;
+      delete entry;
+      stats.removed++;
+    }
+  }
+
+  slot = stats.used;
+  for (SymTab *entry = st; entry != NULL; entry = entry->next)
+    entry->slot = --slot;
+} // pruneST
+
+
+
+void reportPruning(ostream &out,                   // *In-Out* Output
+  const PruneStats &stats)                         // *In* Counts
+{ // Counts only.
+
+  out << "Symbols : Declared : " << stats.declared << "\tUsed : "
+      << stats.used << "\tRemoved : " << stats.removed << '\n';
+} // reportPruning
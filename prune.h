@@ -0,0 +1,70 @@
+// Title   : prune.h
+// Purpose : Dead declaration header file for SCL. Finds the let bindings
+//           the expression never uses and optionally drops them.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef PRUNE_H
+#define PRUNE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard output streams, the vector library and the syntax
+// analysis header file for the SymTab and AST types.
+#include <ostream>         // Standard output streams
+#include <vector>          // Standard C++ vector library
+#include "syner.h"         // header for syner.cxx
+
+
+
+// Generated programs declare hundreds of lets of which the expression uses
+// a handful, yet every one is printed by printST, dumped, saved in images
+// and bound by the evaluators for every row. markUsed walks the expression
+// from the AST and marks each SymTab entry an identifier Factor points at;
+// pruneST then deletes the entries left unmarked and gives the rest slots
+// 0, 1, ... in source order again, so the binding arrays shrink with the
+// table. The symbol table keeps its order and the expression's Factors
+// keep pointing at the same entries, so the listing of the expression does
+// not change.
+//
+// The walk follows Term and BasicExp lists in loops and recurses only into
+// brackets, as deep as the parser did. A shared AST (see hashcons.h) has
+// each bracketed Expression walked once.
+
+
+
+// What pruneST found. removed is zero unless it was asked to drop the
+// unused entries.
+struct PruneStats                                  // Pruning results
+{
+  int declared;                                   // Entries in the table
+  int used;                                       // Entries referenced
+  int removed;                                    // Entries deleted
+}; // PruneStats
+
+
+
+// markUsed sets used[slot] for the slot of every declaration in st that
+// the expression of ast refers to, and clears it for the rest. ast may be
+// NULL.
+void markUsed(SymTab *st,                          // *In* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  vector<bool> &used);                             // *Out* Used by slot
+
+// pruneST counts the declarations of st that ast uses and, if drop is
+// true, deletes the others and renumbers the slots of those left. st and
+// ast must be the result of a successful synAnal.
+void pruneST(SymTab *&st,                          // *In-Out* Symbol table
+  AST *ast,                                        // *In* Abs syntax tree
+  bool drop,                                       // *In* Delete unused
+  PruneStats &stats);                              // *Out* Counts
+
+// reportPruning writes stats as one line to out.
+void reportPruning(ostream &out,                   // *In-Out* Output
+  const PruneStats &stats);                        // *In* Counts
+
+
+#endif
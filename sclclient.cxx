@@ -0,0 +1,107 @@
+// Title   : sclclient.cxx
+// Purpose : Client for the SCL compile daemon. Compiles one program with
+//           a running daemon as scl would compile it.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Usage :
+//
+//     sclclient <socket> <source> <output>
+//     sclclient <socket> --stop
+//
+// The listing is written to output, any errors to cerr, and the client
+// exits with the code scl would have exited with, so it can stand in for
+// scl in a build. source is sent to the daemon as an absolute file name,
+// for it to read; a source of - sends the text of standard input instead.
+// --stop asks the daemon to stop. Exits with 2 if the daemon cannot be
+// reached.
+//
+// The client links only the protocol and is best linked statically, as
+// loading the shared C++ library is most of the time it takes to start.
+// Build from the repository root with
+//
+//     g++ -std=c++20 -O2 -static -o sclclient sclclient.cxx wire.cxx
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>           // Standard file I/O
+#include <iostream>          // Standard console I/O
+#include <iterator>          // istreambuf_iterator
+#include <limits.h>          // PATH_MAX
+#include <stdlib.h>          // realpath
+#include <string.h>          // strcmp
+#include <string>            // Standard C++ strings library
+#include <unistd.h>          // close
+#include "wire.h"            // header for wire.cxx
+
+
+
+int main(int argc,                                 // *In* Argument count
+  char *argv[])                                    // *In* Arguments
+{ // Sends one request and writes out its reply.
+
+  int       fd;                                   // Daemon connection
+  string    why;                                  // Why it failed
+  WireKind  kind = WIREPATH;                      // Request kind
+  string    text;                                 // Request text
+  WireReply reply;                                // Daemon's reply
+  ofstream  outFile;                              // Listing
+
+  if (!(argc == 3 && strcmp(argv[2], "--stop") == 0) && argc != 4)
+  {
+    cerr << "Usage : sclclient <socket> <source> <output>\n"
+            "        sclclient <socket> --stop\n";
+    return 2;
+  }
+
+  if (argc == 3)
+    kind = WIRESTOP;
+  else if (strcmp(argv[2], "-") == 0)
+  {
+    kind = WIRESOURCE;
+    text.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+  }
+  else
+  {
+    char path[PATH_MAX];                          // Absolute source name
+
+    if (realpath(argv[2], path) == NULL)
+    {
+      cerr << "Unable to open source file " << argv[2] << ".\n";
+      return 1;
+    }
+    text = path;
+  }
+
+  // The output file is opened first, as scl opens it before compiling.
+  if (kind != WIRESTOP)
+  {
+    outFile.open(argv[3]);
+    if (!outFile)
+    {
+      cerr << "Unable to open output file " << argv[3] << ".\n";
+      return 1;
+    }
+  }
+
+  fd = connectDaemon(argv[1], why);
+  if (fd < 0)
+  {
+    cerr << "Unable to reach the daemon on " << argv[1] << ", " << why
+         << ".\n";
+    return 2;
+  }
+  if (!sendRequest(fd, kind, text) || !readReply(fd, reply))
+  {
+    cerr << "The daemon on " << argv[1] << " did not reply.\n";
+    close(fd);
+    return 2;
+  }
+  close(fd);
+
+  outFile << reply.listing;
+  cerr << reply.errors;
+  return reply.status;
+} // main
@@ -0,0 +1,887 @@
+// Title   : sclconst.h
+// Purpose : Compile time SCL. A constexpr version of the lexer and parser
+//           for SCL programs written as string literals in C++ source.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef SCLCONST_H
+#define SCLCONST_H
+
+
+
+// An SCL program that is fixed in the C++ source need not be lexed and
+// parsed at run time. Written as
+//
+//     using Margin = constscl::Compiled<
+//       "let int cost = 40 in let int price = 55 in price - cost end">;
+//
+// the program is lexed, parsed and type checked by the compiler. Any
+// lexical, syntax, static semantic or type error stops the compile with
+// one of the scl_*_error functions below in the diagnostic. The result
+// type of the program is a C++ type:
+//
+//     Margin::Result          is int
+//     Margin::eval()          evaluates with the initialisers (constexpr)
+//     Margin::Env env = Margin::defaults();
+//     env[Margin::slot("cost")] = constscl::ConstValue::ofInt(45);
+//     Margin::eval(env)       evaluates with new bindings at run time
+//
+// The rules follow lexer.cxx and syner.cxx: 16 bit int literals, floats
+// spelt digits.digits[^digits], // comments, declarations of the form
+// "let type ident = literal in", chains applied left to right with &&
+// and || short circuiting, and the same type rules as synTerm, synBasicExp
+// and synExpression. Needs C++20.
+
+#include <array>         // Binding arrays
+#include <cstddef>       // size_t
+#include <stdexcept>     // logic_error
+#include <string_view>   // String literal values
+#include <type_traits>   // conditional_t
+
+
+
+namespace constscl
+{
+
+// The SCL data types, as in syner.h.
+enum ConstType { VOIDTYPE, BOOLTYPE, STRINGTYPE, INTTYPE, FLOATTYPE };
+
+
+
+//***************************************************************************
+//Error reporting. These are not constexpr, so reaching one while the
+//compiler is evaluating a program is a compile error that names it.
+//***************************************************************************
+
+inline void scl_lexical_error(const char *message)
+{
+  throw std::logic_error(message);
+}
+
+inline void scl_syntax_error(const char *message)
+{
+  throw std::logic_error(message);
+}
+
+inline void scl_static_error(const char *message)
+{
+  throw std::logic_error(message);
+}
+
+inline void scl_type_error(const char *message)
+{
+  throw std::logic_error(message);
+}
+
+inline void scl_runtime_error(const char *message)
+{
+  throw std::logic_error(message);
+}
+
+//***************************************************************************
+//End of error reporting.
+//***************************************************************************
+
+
+
+// A program's source as a template argument.
+template <size_t N>
+struct FixedString                                 // String literal
+{
+  char text[N] = {};                              // Characters and NUL
+  static constexpr size_t length = N - 1;         // Without the NUL
+
+  constexpr FixedString(const char (&s)[N])
+  {
+    for (size_t i = 0; i < N; i++)
+      text[i] = s[i];
+  }
+}; // FixedString
+
+
+
+// A value; strings are views of the program's own copy of its source.
+struct ConstValue                                  // Runtime value
+{
+  ConstType        type = VOIDTYPE;               // Tag field
+  bool             boolVal = false;               // Boolean value
+  int              intVal = 0;                    // Integer value
+  double           floatVal = 0.0;                // Float value
+  std::string_view stringVal;                     // String value
+
+  static constexpr ConstValue ofBool(bool b)
+  {
+    ConstValue v;
+    v.type = BOOLTYPE;
+    v.boolVal = b;
+    return v;
+  }
+  static constexpr ConstValue ofInt(int i)
+  {
+    ConstValue v;
+    v.type = INTTYPE;
+    v.intVal = (short)i;
+    return v;
+  }
+  static constexpr ConstValue ofFloat(double f)
+  {
+    ConstValue v;
+    v.type = FLOATTYPE;
+    v.floatVal = f;
+    return v;
+  }
+  static constexpr ConstValue ofString(std::string_view s)
+  {
+    ConstValue v;
+    v.type = STRINGTYPE;
+    v.stringVal = s;
+    return v;
+  }
+}; // ConstValue
+
+
+
+//***************************************************************************
+//Tokens and the lexer.
+//***************************************************************************
+
+// Token tags, as LexTokenTag in lexer.h plus an end of input marker.
+enum ConstTag {
+  CIDENT, CBOOLLIT, CSTRINGLIT, CINTLIT, CFLOATLIT, CASSIGN, CLPAREN,
+  CRPAREN, CADDOP, CRELOP, CMULOP, CNOTOP, CBOOL, CSTRING, CINT, CFLOAT,
+  CLET, CIN, CEND, CEOF
+};
+
+// Operators, for ADDOP, MULOP and RELOP tokens and for tree nodes.
+enum ConstOp {
+  NOOP, OPADD, OPSUB, OPOR, OPMUL, OPDIV, OPMOD, OPAND,
+  OPEQ, OPNE, OPLT, OPLE, OPGT, OPGE
+};
+
+
+
+struct ConstToken                                  // Lexical token
+{
+  ConstTag tag = CEOF;                            // Tag field
+  ConstOp  op = NOOP;                             // Operator
+  size_t   begin = 0;                             // Text start
+  size_t   length = 0;                            // Text length
+  int      intLit = 0;                            // Integer literal
+  double   floatLit = 0.0;                        // Float literal
+}; // ConstToken
+
+
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr bool isAlpha(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+    c == '\v';
+}
+
+
+
+// The lexer works over a string_view and keeps its position.
+struct ConstLexer                                  // Lexer state
+{
+  std::string_view src;                           // Program source
+  size_t           pos = 0;                       // Next character
+
+  constexpr char peek(size_t ahead = 0) const
+  {
+    return (pos + ahead < src.size()) ? src[pos + ahead] : '\0';
+  }
+
+  // As skipWhiteComments.
+  constexpr void skipWhiteComments()
+  {
+    for (;;)
+    {
+      if (isSpace(peek()))
+        pos++;
+      else if (peek() == '/' && peek(1) == '/')
+      {
+        while (pos < src.size() && src[pos] != '\n')
+          pos++;
+      }
+      else
+        return;
+    }
+  }
+
+  constexpr void digits(double &value, double &scale, bool fraction)
+  {
+    while (isDigit(peek()))
+    {
+      if (fraction)
+      {
+        scale = scale / 10.0;
+        value = value + (peek() - '0') * scale;
+      }
+      else
+        value = value * 10.0 + (peek() - '0');
+      pos++;
+    }
+  }
+
+  // As the number states of lexAnal (see lexgen.cxx).
+  constexpr void number(ConstToken &tok)
+  {
+    double whole = 0.0;                           // Digits before .
+    double scale = 1.0;                           // Unused for whole
+    long   intValue = 0;                          // Integer value
+
+    while (isDigit(peek()))
+    {
+      if (intValue <= 100000)
+        intValue = intValue * 10 + (peek() - '0');
+      pos++;
+    }
+    whole = (double)intValue;
+
+    if (peek() == '^')
+      scl_lexical_error("missing '.' in float");
+
+    if (peek() != '.')
+    {
+      if (intValue > 32767)
+        scl_lexical_error("integer literal out of range");
+      tok.tag = CINTLIT;
+      tok.intLit = (int)intValue;
+      return;
+    }
+
+    pos++;
+    if (!isDigit(peek()))
+      scl_lexical_error("no digit after .");
+    digits(whole, scale, true);
+    if (peek() == '.')
+      scl_lexical_error("multiple .");
+
+    if (peek() == '^')
+    {
+      double power = 0.0;                         // Exponent
+      double unused = 1.0;                        // Unused scale
+
+      pos++;
+      if (!isDigit(peek()))
+        scl_lexical_error("no digit after ^");
+      digits(power, unused, false);
+      if (peek() == '^')
+        scl_lexical_error("multiple ^");
+      if (peek() == '.')
+        scl_lexical_error("multiple .");
+      for (int i = 0; i < (int)power && i < 400; i++)
+        whole = whole * 10.0;
+    }
+
+    tok.tag = CFLOATLIT;
+    tok.floatLit = whole;
+  }
+
+  // As the word states of lexAnal (see lexgen.cxx).
+  constexpr void word(ConstToken &tok)
+  {
+    std::string_view text;                        // Identifier text
+
+    while (isAlpha(peek()) || isDigit(peek()) || peek() == '_')
+      pos++;
+    text = src.substr(tok.begin, pos - tok.begin);
+
+    if (text == "true" || text == "false")
+      tok.tag = CBOOLLIT;
+    else if (text == "bool")
+      tok.tag = CBOOL;
+    else if (text == "string")
+      tok.tag = CSTRING;
+    else if (text == "int")
+      tok.tag = CINT;
+    else if (text == "float")
+      tok.tag = CFLOAT;
+    else if (text == "let")
+      tok.tag = CLET;
+    else if (text == "in")
+      tok.tag = CIN;
+    else if (text == "end")
+      tok.tag = CEND;
+    else
+      tok.tag = CIDENT;
+  }
+
+  // As lexAnal. String literal bounds exclude the quotes.
+  constexpr ConstToken next()
+  {
+    ConstToken tok;                               // Token lexed
+    char       c = '\0';                          // First character
+
+    skipWhiteComments();
+    tok.begin = pos;
+    if (pos >= src.size())
+      return tok;
+
+    c = src[pos];
+    if (isAlpha(c))
+      word(tok);
+    else if (isDigit(c))
+      number(tok);
+    else if (c == '\"')
+    {
+      pos++;
+      tok.begin = pos;
+      while (pos < src.size() && src[pos] != '\"')
+      {
+        char ch = src[pos];
+        if ((unsigned char)ch < 32 && ch != '\n' && ch != '\t')
+          scl_lexical_error("non printable character in string literal");
+        pos++;
+      }
+      if (pos >= src.size())
+        scl_lexical_error("missing \" on string literal");
+      tok.tag = CSTRINGLIT;
+      tok.length = pos - tok.begin;
+      pos++;
+      return tok;
+    }
+    else
+    {
+      char d = peek(1);                           // Second character
+
+      pos++;
+      if (c == '=' && d == '=')
+        { tok.tag = CRELOP; tok.op = OPEQ; pos++; }
+      else if (c == '=')
+        tok.tag = CASSIGN;
+      else if (c == '(')
+        tok.tag = CLPAREN;
+      else if (c == ')')
+        tok.tag = CRPAREN;
+      else if (c == '+')
+        { tok.tag = CADDOP; tok.op = OPADD; }
+      else if (c == '-')
+        { tok.tag = CADDOP; tok.op = OPSUB; }
+      else if (c == '|' && d == '|')
+        { tok.tag = CADDOP; tok.op = OPOR; pos++; }
+      else if (c == '<' && d == '=')
+        { tok.tag = CRELOP; tok.op = OPLE; pos++; }
+      else if (c == '<')
+        { tok.tag = CRELOP; tok.op = OPLT; }
+      else if (c == '>' && d == '=')
+        { tok.tag = CRELOP; tok.op = OPGE; pos++; }
+      else if (c == '>')
+        { tok.tag = CRELOP; tok.op = OPGT; }
+      else if (c == '*')
+        { tok.tag = CMULOP; tok.op = OPMUL; }
+      else if (c == '/')
+        { tok.tag = CMULOP; tok.op = OPDIV; }
+      else if (c == '%')
+        { tok.tag = CMULOP; tok.op = OPMOD; }
+      else if (c == '&' && d == '&')
+        { tok.tag = CMULOP; tok.op = OPAND; pos++; }
+      else if (c == '!' && d == '=')
+        { tok.tag = CRELOP; tok.op = OPNE; pos++; }
+      else if (c == '!')
+        tok.tag = CNOTOP;
+      else
+        scl_lexical_error("character not recognised");
+    }
+
+    tok.length = pos - tok.begin;
+    return tok;
+  }
+}; // ConstLexer
+
+//***************************************************************************
+//End of tokens and the lexer.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//The parsed program.
+//***************************************************************************
+
+enum ConstKind { KLITERAL, KIDENT, KNOT, KBINARY, KCOMPARE };
+
+// Names and string literals are kept as offsets into the program's copy of
+// its source, since a pointer into the parser's working copy cannot be
+// part of a constant.
+struct ConstSpan                                   // Source text
+{
+  size_t begin = 0;                               // First character
+  size_t length = 0;                              // Character count
+}; // ConstSpan
+
+// One node of the expression. Chains are stored left deep, so
+// a - b - c is BINARY(-, BINARY(-, a, b), c).
+struct ConstNode                                   // Expression node
+{
+  ConstKind  kind = KLITERAL;                     // Node kind
+  ConstType  type = VOIDTYPE;                     // Result type
+  ConstOp    op = NOOP;                           // Operator
+  int        left = -1;                           // Left / only child
+  int        right = -1;                          // Right child
+  int        slot = -1;                           // KIDENT binding slot
+  ConstValue value;                               // KLITERAL value
+  ConstSpan  text;                                // KLITERAL string text
+}; // ConstNode
+
+
+
+struct ConstSymbol                                 // Declaration
+{
+  ConstSpan  ident;                               // Name
+  ConstValue init;                                // Initialiser
+  ConstSpan  text;                                // String initialiser
+}; // ConstSymbol
+
+
+
+// A parsed program with room for as many nodes and symbols as the source
+// could possibly hold. N is the source length.
+template <size_t N>
+struct ConstProgram                                // Parsed program
+{
+  char        src[N + 1] = {};                    // Copy of the source
+  ConstNode   nodes[N + 1] = {};                  // Expression nodes
+  ConstSymbol symbols[N / 4 + 1] = {};            // Declarations
+  int         nodeCount = 0;                      // Nodes used
+  int         symbolCount = 0;                    // Declarations made
+  int         root = -1;                          // Expression node
+  ConstType   type = VOIDTYPE;                    // Program type
+
+  constexpr std::string_view view(const ConstSpan &span) const
+  {
+    return std::string_view(src + span.begin, span.length);
+  }
+
+  // A literal's value, with its string text if it has any.
+  constexpr ConstValue value(const ConstValue &lit,
+    const ConstSpan &span) const
+  {
+    if (lit.type == STRINGTYPE)
+      return ConstValue::ofString(view(span));
+    return lit;
+  }
+}; // ConstProgram
+
+
+
+// The recursive descent parser, after synDec, synFactor, synTerm,
+// synBasicExp and synExpression.
+template <size_t N>
+struct ConstParser                                 // Parser state
+{
+  ConstProgram<N> &prog;                          // Program being built
+  ConstLexer      lex;                            // Lexer
+  ConstToken      tok;                            // Lookahead token
+
+  constexpr ConstParser(ConstProgram<N> &p, std::string_view s)
+    : prog(p), lex{ s, 0 }
+  {
+    tok = lex.next();
+  }
+
+  constexpr void advance()
+  {
+    tok = lex.next();
+  }
+
+  constexpr ConstSpan span(const ConstToken &t) const
+  {
+    ConstSpan s;                                  // Token text
+    s.begin = t.begin;
+    s.length = t.length;
+    return s;
+  }
+
+  constexpr std::string_view text(const ConstToken &t) const
+  {
+    return prog.view(span(t));
+  }
+
+  constexpr int addNode(const ConstNode &node)
+  {
+    prog.nodes[prog.nodeCount] = node;
+    return prog.nodeCount++;
+  }
+
+  constexpr ConstValue literal(const ConstToken &t) const
+  {
+    if (t.tag == CBOOLLIT)
+      return ConstValue::ofBool(text(t) == "true");
+    else if (t.tag == CSTRINGLIT)
+      return ConstValue::ofString(std::string_view());
+    else if (t.tag == CINTLIT)
+      return ConstValue::ofInt(t.intLit);
+    else
+      return ConstValue::ofFloat(t.floatLit);
+  }
+
+  constexpr int lookup(std::string_view name) const
+  {
+    for (int i = 0; i < prog.symbolCount; i++)
+      if (prog.view(prog.symbols[i].ident) == name)
+        return i;
+    return -1;
+  }
+
+  // As synDec; tok holds LET.
+  constexpr void declaration()
+  {
+    ConstType  type = VOIDTYPE;                   // Declared type
+    ConstToken name;                              // Identifier
+
+    advance();
+    if (tok.tag == CBOOL)
+      type = BOOLTYPE;
+    else if (tok.tag == CSTRING)
+      type = STRINGTYPE;
+    else if (tok.tag == CINT)
+      type = INTTYPE;
+    else if (tok.tag == CFLOAT)
+      type = FLOATTYPE;
+    else
+      scl_syntax_error("expected type identifier in declaration");
+
+    advance();
+    if (tok.tag != CIDENT)
+      scl_syntax_error("expected identifier in declaration");
+    name = tok;
+    if (lookup(text(name)) >= 0)
+      scl_static_error("attempt to re-declare identifier");
+
+    advance();
+    if (tok.tag != CASSIGN)
+      scl_syntax_error("expected = in declaration");
+
+    advance();
+    if (tok.tag != CBOOLLIT && tok.tag != CSTRINGLIT &&
+      tok.tag != CINTLIT && tok.tag != CFLOATLIT)
+      scl_syntax_error("expected literal in declaration");
+    if (literal(tok).type != type)
+      scl_type_error("mismatch between types in a declaration");
+
+    prog.symbols[prog.symbolCount].ident = span(name);
+    prog.symbols[prog.symbolCount].init = literal(tok);
+    prog.symbols[prog.symbolCount].text = span(tok);
+    prog.symbolCount++;
+
+    advance();
+    if (tok.tag != CIN)
+      scl_syntax_error("expected in after declaration");
+    advance();
+  }
+
+  // As synFactor.
+  constexpr int factor()
+  {
+    ConstNode node;                               // New node
+
+    if (tok.tag == CBOOLLIT || tok.tag == CSTRINGLIT ||
+      tok.tag == CINTLIT || tok.tag == CFLOATLIT)
+    {
+      node.kind = KLITERAL;
+      node.value = literal(tok);
+      node.text = span(tok);
+      node.type = node.value.type;
+      advance();
+    }
+    else if (tok.tag == CIDENT)
+    {
+      node.kind = KIDENT;
+      node.slot = lookup(text(tok));
+      if (node.slot < 0)
+        scl_static_error("attempt to use undeclared identifier");
+      node.type = prog.symbols[node.slot].init.type;
+      advance();
+    }
+    else if (tok.tag == CLPAREN)
+    {
+      int inner = 0;                              // Bracketed expression
+
+      advance();
+      inner = expression();
+      if (tok.tag != CRPAREN)
+        scl_syntax_error("expected right parenthesis in factor");
+      advance();
+      return inner;
+    }
+    else if (tok.tag == CNOTOP)
+    {
+      advance();
+      node.kind = KNOT;
+      node.left = factor();
+      if (prog.nodes[node.left].type != BOOLTYPE)
+        scl_type_error("attempt to use ! operator with non-boolean operand");
+      node.type = BOOLTYPE;
+    }
+    else
+      scl_syntax_error("expected factor");
+
+    return addNode(node);
+  }
+
+  // Shared by term and basicExp: checks an operator against its operand
+  // type and builds the left deep node.
+  constexpr int binary(ConstOp op, int left, int right, bool isTerm)
+  {
+    ConstNode node;                               // New node
+    ConstType type = prog.nodes[left].type;       // Operand type
+
+    if (type != prog.nodes[right].type)
+      scl_type_error(isTerm ? "mismatch between types in a term" :
+        "mismatch between types in a basic expression");
+    if ((op == OPAND || op == OPOR) && type != BOOLTYPE)
+      scl_type_error(op == OPAND ?
+        "attempt to use && operator with non-boolean operands" :
+        "attempt to use || operator with non-boolean operands");
+    if (op != OPAND && op != OPOR && type != INTTYPE)
+      scl_type_error(isTerm ?
+        "attempt to use * / or % operator with non-numeric operands" :
+        "attempt to use + or - operator with non-numeric operands");
+
+    node.kind = KBINARY;
+    node.op = op;
+    node.left = left;
+    node.right = right;
+    node.type = type;
+    return addNode(node);
+  }
+
+  // As synTerm.
+  constexpr int term()
+  {
+    int left = factor();                          // Result so far
+
+    while (tok.tag == CMULOP)
+    {
+      ConstOp op = tok.op;                        // Operator
+
+      advance();
+      left = binary(op, left, factor(), true);
+    }
+    return left;
+  }
+
+  // As synBasicExp.
+  constexpr int basicExp()
+  {
+    int left = term();                            // Result so far
+
+    while (tok.tag == CADDOP)
+    {
+      ConstOp op = tok.op;                        // Operator
+
+      advance();
+      left = binary(op, left, term(), false);
+    }
+    return left;
+  }
+
+  // As synExpression.
+  constexpr int expression()
+  {
+    ConstNode node;                               // Comparison node
+    int       left = basicExp();                  // First basic exp
+
+    if (tok.tag != CRELOP)
+      return left;
+
+    node.kind = KCOMPARE;
+    node.op = tok.op;
+    advance();
+    node.left = left;
+    node.right = basicExp();
+    node.type = BOOLTYPE;
+
+    if (prog.nodes[node.left].type != prog.nodes[node.right].type)
+      scl_type_error("mismatch between types in an expression");
+    if (prog.nodes[node.left].type == STRINGTYPE)
+      scl_type_error("attempt to use a relational operator with a string");
+
+    return addNode(node);
+  }
+
+  // As synAnal.
+  constexpr void program()
+  {
+    while (tok.tag == CLET)
+      declaration();
+
+    prog.root = expression();
+    prog.type = prog.nodes[prog.root].type;
+
+    if (tok.tag != CEND)
+      scl_syntax_error("expected end after expression");
+    advance();
+    if (tok.tag != CEOF)
+      scl_syntax_error("unexpected token after end");
+  }
+}; // ConstParser
+
+
+
+// Parses and type checks an SCL program at compile time.
+template <size_t N>
+consteval ConstProgram<N - 1> parse(const FixedString<N> &source)
+{
+  ConstProgram<N - 1> prog;                       // Program built
+
+  for (size_t i = 0; i < N; i++)
+    prog.src[i] = source.text[i];
+
+  ConstParser<N - 1> parser(prog, std::string_view(prog.src, N - 1));
+  parser.program();
+  return prog;
+}
+
+//***************************************************************************
+//End of the parsed program.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Evaluation.
+//***************************************************************************
+
+// The C++ type of a program's result.
+template <ConstType T> struct ResultOf;
+template <> struct ResultOf<BOOLTYPE>   { using type = bool; };
+template <> struct ResultOf<INTTYPE>    { using type = int; };
+template <> struct ResultOf<FLOATTYPE>  { using type = double; };
+template <> struct ResultOf<STRINGTYPE> { using type = std::string_view; };
+
+
+
+// Evaluates node n of prog. Chains fold left to right because they are
+// stored left deep; && and || short circuit.
+template <size_t N>
+constexpr ConstValue evalNode(const ConstProgram<N> &prog, int n,
+  const ConstValue *env)
+{
+  const ConstNode &node = prog.nodes[n];          // Node to evaluate
+  ConstValue      left;                           // Left operand
+  ConstValue      right;                          // Right operand
+  double          l = 0.0;                        // Left as a number
+  double          r = 0.0;                        // Right as a number
+
+  switch (node.kind)
+  {
+  case KLITERAL : return prog.value(node.value, node.text);
+  case KIDENT   : return env[node.slot];
+  case KNOT     : return ConstValue::ofBool(
+                    !evalNode(prog, node.left, env).boolVal);
+  default       : break;
+  }
+
+  left = evalNode(prog, node.left, env);
+  if (node.op == OPAND && !left.boolVal)
+    return left;
+  if (node.op == OPOR && left.boolVal)
+    return left;
+  right = evalNode(prog, node.right, env);
+
+  switch (node.op)
+  {
+  case OPAND : case OPOR : return right;
+  case OPADD : return ConstValue::ofInt(left.intVal + right.intVal);
+  case OPSUB : return ConstValue::ofInt(left.intVal - right.intVal);
+  case OPMUL : return ConstValue::ofInt(left.intVal * right.intVal);
+  case OPDIV : if (right.intVal == 0)
+                 scl_runtime_error("attempt to divide by zero");
+               return ConstValue::ofInt(left.intVal / right.intVal);
+  case OPMOD : if (right.intVal == 0)
+                 scl_runtime_error("attempt to use % with zero divisor");
+               return ConstValue::ofInt(left.intVal % right.intVal);
+  default    : break;
+  }
+
+  if (left.type == FLOATTYPE)
+    { l = left.floatVal; r = right.floatVal; }
+  else if (left.type == INTTYPE)
+    { l = left.intVal; r = right.intVal; }
+  else
+    { l = left.boolVal; r = right.boolVal; }
+
+  switch (node.op)
+  {
+  case OPEQ : return ConstValue::ofBool(l == r);
+  case OPNE : return ConstValue::ofBool(l != r);
+  case OPLT : return ConstValue::ofBool(l < r);
+  case OPLE : return ConstValue::ofBool(l <= r);
+  case OPGT : return ConstValue::ofBool(l > r);
+  default   : return ConstValue::ofBool(l >= r);
+  }
+}
+
+
+
+// A program compiled from the string literal Source. See the top of this
+// file for how it is used.
+template <FixedString Source>
+struct Compiled                                    // Compiled program
+{
+  static constexpr auto program = parse(Source);
+  static constexpr int  slots = program.symbolCount;
+
+  using Result = typename ResultOf<program.type>::type;
+  using Env = std::array<ConstValue, slots>;
+
+  // The slot of the declaration called name.
+  static consteval int slot(std::string_view name)
+  {
+    for (int i = 0; i < slots; i++)
+      if (program.view(program.symbols[i].ident) == name)
+        return i;
+    scl_static_error("attempt to use undeclared identifier");
+    return -1;
+  }
+
+  // Every identifier bound to its initialiser.
+  static constexpr Env defaults()
+  {
+    Env env{};
+    for (int i = 0; i < slots; i++)
+      env[i] = program.value(program.symbols[i].init,
+        program.symbols[i].text);
+    return env;
+  }
+
+  // Evaluates the program with the given bindings. Each binding must have
+  // the declared type.
+  static constexpr Result eval(const Env &env)
+  {
+    ConstValue v = evalNode(program, program.root, env.data());
+
+    if constexpr (program.type == BOOLTYPE)
+      return v.boolVal;
+    else if constexpr (program.type == INTTYPE)
+      return v.intVal;
+    else if constexpr (program.type == FLOATTYPE)
+      return v.floatVal;
+    else
+      return v.stringVal;
+  }
+
+  // Evaluates the program with its initialisers.
+  static constexpr Result eval()
+  {
+    return eval(defaults());
+  }
+}; // Compiled
+
+//***************************************************************************
+//End of evaluation.
+//***************************************************************************
+
+} // namespace constscl
+
+
+#endif
@@ -0,0 +1,571 @@
+// Title   : simplify.cxx
+// Purpose : Algebraic simplification subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// A Term or BasicExp list is copied into a vector of its nodes and their
+// operators, and rebuilt from the nodes the rules keep. Each node holds the
+// operator to its right, so the operators are relinked with the nodes. A
+// rule that makes everything so far one literal keeps the literal's node
+// and deletes the rest; a rule that changes a literal operand changes it
+// in place. Each subprogram also says whether what it returns is pure,
+// that is cannot throw, so that no list is walked twice to find out.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <ostream>         // Standard output streams
+#include <string>          // Standard C++ strings library
+#include <vector>          // Standard C++ vector library
+#include "simplify.h"      // header for simplify.cxx
+
+
+
+const char *const ruleNames[RULES] = {
+  "mulOne", "addZero", "andTrue", "orFalse", "mulZero", "modOne",
+  "andFalse", "orTrue", "notNot", "bracket"
+};
+
+
+
+// A list being rebuilt: the nodes kept, the operator after each but the
+// last, and what is known of the value so far.
+template <class N>
+struct Rebuild                                     // List being rebuilt
+{
+  vector<N *>    nodes;                           // Nodes kept
+  vector<string> ops;                             // Operators between them
+  bool           pure;                            // Nothing kept can throw
+  bool           dead;                            // The rest is never run
+}; // Rebuild
+
+
+
+//***************************************************************************
+//Operand subprograms.
+//***************************************************************************
+
+static bool intLiteral(Factor *fact,               // *In* Factor
+  int value)                                       // *In* Literal value
+{ // Whether fact is the int literal value.
+
+  return fact->literal && fact->type == INTDATA && fact->litInt == value;
+} // intLiteral
+
+
+
+static bool boolLiteral(Factor *fact,              // *In* Factor
+  const char *value)                               // *In* true or false
+{ // Whether fact is the bool literal value.
+
+  return fact->literal && fact->type == BOOLDATA && fact->litBool == value;
+} // boolLiteral
+
+
+
+static bool literalTerm(Term *term)                // *In* Term list
+{ // A single literal operand.
+
+  return term->term == NULL && term->fact->literal;
+} // literalTerm
+
+
+
+static bool pureOp(const string &op,               // *In* Operator
+  Factor *right)                                   // *In* Right operand
+{ // Only / and % throw, and not by a non-zero literal.
+
+  return (op != "/" && op != "%") ||
+    (right->literal && right->type == INTDATA && right->litInt != 0);
+} // pureOp
+
+
+
+static void dropTerm(Term *term)                   // *In* Term node
+{ // Deletes one node of a term list and its operand.
+
+  freeFactor(term->fact);
+  delete term;
+} // dropTerm
+
+
+
+static void dropBasicExp(BasicExp *bexp)           // *In* BasicExp node
+{ // Deletes one node of a basic expression list and its term list.
+
+  Term *term = bexp->term;                        // Term list
+
+  while (term != NULL)
+  {
+    Term *rest = term->term;                      // Rest of the term
+
+    dropTerm(term);
+    term = rest;
+  }
+  delete bexp;
+} // dropBasicExp
+
+//***************************************************************************
+//End of operand subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//List subprograms.
+//***************************************************************************
+
+template <class N>
+static void keep(Rebuild<N> &list,                 // *In-Out* List so far
+  const string &op,                                // *In* Operator before
+  N *node,                                         // *In* Node kept
+  bool pure)                                       // *In* Node is pure
+{ // Adds node after op.
+
+  if (!list.nodes.empty())
+    list.ops.push_back(op);
+  list.nodes.push_back(node);
+  list.pure = list.pure && pure;
+} // keep
+
+
+
+template <class N>
+static void restart(Rebuild<N> &list,              // *In-Out* List so far
+  N *node,                                         // *In* Node kept
+  bool pure,                                       // *In* Node is pure
+  void (*drop)(N *))                               // *In* Deletes a node
+{ // Everything so far is dropped for node alone.
+
+  for (N *old : list.nodes)
+    drop(old);
+  list.nodes.assign(1, node);
+  list.ops.clear();
+  list.pure = pure;
+} // restart
+
+
+
+template <class N>
+static bool single(const Rebuild<N> &list,         // *In* List so far
+  bool (*test)(N *))                               // *In* Node test
+{ // Whether the list so far is one node that passes test.
+
+  return list.nodes.size() == 1 && test(list.nodes[0]);
+} // single
+
+
+
+static void simplifyExpression(SimplifyStats &stats, // *In-Out* Rules
+  Expression *expr,                                // *In-Out* Expression
+  bool &pure);                                     // *Out* Cannot throw
+
+
+
+static Factor *simplifyFactor(SimplifyStats &stats, // *In-Out* Rules
+  Factor *fact,                                    // *In* Factor
+  bool &pure)                                      // *Out* Cannot throw
+{ // Returns the factor that replaces fact, which may be fact itself.
+
+  Factor *inner;                                  // Factor kept
+
+  pure = true;
+
+  if (fact->bExp != NULL)
+  {
+    Expression *bracket = fact->bExp;             // Bracketed expression
+
+    simplifyExpression(stats, bracket, pure);
+    if (bracket->be2 != NULL || bracket->be1->bexp != NULL ||
+      bracket->be1->term->term != NULL)
+      return fact;
+
+    inner = bracket->be1->term->fact;
+    delete bracket->be1->term;
+    delete bracket->be1;
+    delete bracket;
+    delete fact;
+    stats.hits[RULEBRACKET]++;
+    return inner;
+  }
+
+  if (fact->nFactor != NULL)
+  {
+    fact->nFactor = simplifyFactor(stats, fact->nFactor, pure);
+    if (fact->nFactor->nFactor == NULL)
+      return fact;
+
+    inner = fact->nFactor->nFactor;
+    delete fact->nFactor;
+    delete fact;
+    stats.hits[RULENOTNOT]++;
+    return inner;
+  }
+
+  return fact;
+} // simplifyFactor
+
+
+
+static bool zeroTerm(Term *term)                   // *In* Term node
+{ // Its operand is the int literal 0.
+
+  return intLiteral(term->fact, 0);
+} // zeroTerm
+
+
+
+static bool oneTerm(Term *term)                    // *In* Term node
+{ // Its operand is the int literal 1.
+
+  return intLiteral(term->fact, 1);
+} // oneTerm
+
+
+
+static bool trueTerm(Term *term)                   // *In* Term node
+{ // Its operand is the bool literal true.
+
+  return boolLiteral(term->fact, "true");
+} // trueTerm
+
+
+
+static bool falseTerm(Term *term)                  // *In* Term node
+{ // Its operand is the bool literal false.
+
+  return boolLiteral(term->fact, "false");
+} // falseTerm
+
+
+
+static void intTerm(SimplifyStats &stats,           // *In-Out* Rules applied
+  Rebuild<Term> &list,                             // *In-Out* List so far
+  const string &op,                                // *In* Operator before
+  Term *node,                                      // *In* Next node
+  bool pure)                                       // *In* Operand is pure
+{ // Applies the int rules to node, which comes after op.
+
+  Factor *fact = node->fact;                      // Operand
+
+  pure = pure && pureOp(op, fact);
+
+  if ((op == "*" || op == "/") && intLiteral(fact, 1))
+  {
+    dropTerm(node);
+    stats.hits[RULEMULONE]++;
+  }
+  else if (op == "*" && single(list, oneTerm))
+  {
+    restart(list, node, pure, dropTerm);
+    stats.hits[RULEMULONE]++;
+  }
+  else if (op == "*" && intLiteral(fact, 0) && list.pure)
+  {
+    restart(list, node, true, dropTerm);
+    stats.hits[RULEMULZERO]++;
+  }
+  else if (op == "*" && single(list, zeroTerm) && pure)
+  {
+    dropTerm(node);
+    stats.hits[RULEMULZERO]++;
+  }
+  else if (op == "%" && intLiteral(fact, 1) && list.pure)
+  {
+    fact->litInt = 0;
+    restart(list, node, true, dropTerm);
+    stats.hits[RULEMODONE]++;
+  }
+  else
+    keep(list, op, node, pure);
+} // intTerm
+
+
+
+static void boolTerm(SimplifyStats &stats,          // *In-Out* Rules applied
+  Rebuild<Term> &list,                             // *In-Out* List so far
+  Term *node,                                      // *In* Next node
+  bool pure)                                       // *In* Operand is pure
+{ // Applies the && rules to node.
+
+  if (list.dead)
+  {
+    dropTerm(node);
+    stats.hits[RULEANDFALSE]++;
+  }
+  else if (falseTerm(node) && list.pure)
+  {
+    restart(list, node, true, dropTerm);
+    list.dead = true;
+    stats.hits[RULEANDFALSE]++;
+  }
+  else if (trueTerm(node))
+  {
+    dropTerm(node);
+    stats.hits[RULEANDTRUE]++;
+  }
+  else if (single(list, trueTerm))
+  {
+    restart(list, node, pure, dropTerm);
+    stats.hits[RULEANDTRUE]++;
+  }
+  else
+  {
+    keep(list, string("&&"), node, pure);
+    list.dead = falseTerm(node);
+  }
+} // boolTerm
+
+
+
+static Term *simplifyTerm(SimplifyStats &stats,     // *In-Out* Rules applied
+  Term *term,                                      // *In* Term list
+  bool &pure)                                      // *Out* Cannot throw
+{ // Every operand is simplified first, then the list rebuilt.
+
+  vector<Term *> nodes;                           // The list's nodes
+  vector<string> ops;                             // Operator after each
+  vector<bool>   pures;                           // Each operand pure
+  Rebuild<Term>  list;                            // List rebuilt
+  bool           logical;                         // An && list
+
+  for (; term != NULL; term = term->term)
+  {
+    bool factPure;                                // Operand pure
+
+    term->fact = simplifyFactor(stats, term->fact, factPure);
+    nodes.push_back(term);
+    ops.push_back(term->mulOp);
+    pures.push_back(factPure);
+  }
+  logical = ops[0] == "&&";
+
+  list.nodes.push_back(nodes[0]);
+  list.pure = pures[0];
+  list.dead = falseTerm(nodes[0]);
+  for (size_t i = 1; i < nodes.size(); i++)
+    if (logical)
+      boolTerm(stats, list, nodes[i], pures[i]);
+    else
+      intTerm(stats, list, ops[i - 1], nodes[i], pures[i]);
+
+  for (size_t i = 0; i + 1 < list.nodes.size(); i++)
+  {
+    list.nodes[i]->mulOp = list.ops[i];
+    list.nodes[i]->term = list.nodes[i + 1];
+  }
+  list.nodes.back()->mulOp.clear();
+  list.nodes.back()->term = NULL;
+
+  pure = list.pure;
+  return list.nodes[0];
+} // simplifyTerm
+
+
+
+static bool zeroBasicExp(BasicExp *bexp)           // *In* BasicExp node
+{ // Its term is the int literal 0 alone.
+
+  return literalTerm(bexp->term) && zeroTerm(bexp->term);
+} // zeroBasicExp
+
+
+
+static bool trueBasicExp(BasicExp *bexp)           // *In* BasicExp node
+{ // Its term is the bool literal true alone.
+
+  return literalTerm(bexp->term) && trueTerm(bexp->term);
+} // trueBasicExp
+
+
+
+static bool falseBasicExp(BasicExp *bexp)          // *In* BasicExp node
+{ // Its term is the bool literal false alone.
+
+  return literalTerm(bexp->term) && falseTerm(bexp->term);
+} // falseBasicExp
+
+
+
+static void intBasicExp(SimplifyStats &stats,       // *In-Out* Rules applied
+  Rebuild<BasicExp> &list,                         // *In-Out* List so far
+  const string &op,                                // *In* Operator before
+  BasicExp *node,                                  // *In* Next node
+  bool pure)                                       // *In* Term is pure
+{ // Applies the + and - rules to node, which comes after op.
+
+  if (zeroBasicExp(node))
+  {
+    dropBasicExp(node);
+    stats.hits[RULEADDZERO]++;
+  }
+  else if (op == "+" && single(list, zeroBasicExp))
+  {
+    restart(list, node, pure, dropBasicExp);
+    stats.hits[RULEADDZERO]++;
+  }
+  else
+    keep(list, op, node, pure);
+} // intBasicExp
+
+
+
+static void boolBasicExp(SimplifyStats &stats,      // *In-Out* Rules applied
+  Rebuild<BasicExp> &list,                         // *In-Out* List so far
+  BasicExp *node,                                  // *In* Next node
+  bool pure)                                       // *In* Term is pure
+{ // Applies the || rules to node.
+
+  if (list.dead)
+  {
+    dropBasicExp(node);
+    stats.hits[RULEORTRUE]++;
+  }
+  else if (trueBasicExp(node) && list.pure)
+  {
+    restart(list, node, true, dropBasicExp);
+    list.dead = true;
+    stats.hits[RULEORTRUE]++;
+  }
+  else if (falseBasicExp(node))
+  {
+    dropBasicExp(node);
+    stats.hits[RULEORFALSE]++;
+  }
+  else if (single(list, falseBasicExp))
+  {
+    restart(list, node, pure, dropBasicExp);
+    stats.hits[RULEORFALSE]++;
+  }
+  else
+  {
+    keep(list, string("||"), node, pure);
+    list.dead = trueBasicExp(node);
+  }
+} // boolBasicExp
+
+
+
+static BasicExp *simplifyBasicExp(SimplifyStats &stats, // *In-Out* Rules
+  BasicExp *bexp,                                  // *In* BasicExp list
+  bool &pure)                                      // *Out* Cannot throw
+{ // As simplifyTerm.
+
+  vector<BasicExp *> nodes;                       // The list's nodes
+  vector<string>     ops;                         // Operator after each
+  vector<bool>       pures;                       // Each term pure
+  Rebuild<BasicExp>  list;                        // List rebuilt
+  bool               logical;                     // An || list
+
+  for (; bexp != NULL; bexp = bexp->bexp)
+  {
+    bool termPure;                                // Term pure
+
+    bexp->term = simplifyTerm(stats, bexp->term, termPure);
+    nodes.push_back(bexp);
+    ops.push_back(bexp->addOp);
+    pures.push_back(termPure);
+  }
+  logical = ops[0] == "||";
+
+  list.nodes.push_back(nodes[0]);
+  list.pure = pures[0];
+  list.dead = trueBasicExp(nodes[0]);
+  for (size_t i = 1; i < nodes.size(); i++)
+    if (logical)
+      boolBasicExp(stats, list, nodes[i], pures[i]);
+    else
+      intBasicExp(stats, list, ops[i - 1], nodes[i], pures[i]);
+
+  for (size_t i = 0; i + 1 < list.nodes.size(); i++)
+  {
+    list.nodes[i]->addOp = list.ops[i];
+    list.nodes[i]->bexp = list.nodes[i + 1];
+  }
+  list.nodes.back()->addOp.clear();
+  list.nodes.back()->bexp = NULL;
+
+  pure = list.pure;
+  return list.nodes[0];
+} // simplifyBasicExp
+
+
+
+static void simplifyExpression(SimplifyStats &stats, // *In-Out* Rules
+  Expression *expr,                                // *In-Out* Expression
+  bool &pure)                                      // *Out* Cannot throw
+{ // Both sides; a relational operator cannot throw.
+
+  bool rightPure = true;                          // Second side pure
+
+  expr->be1 = simplifyBasicExp(stats, expr->be1, pure);
+  if (expr->be2 != NULL)
+    expr->be2 = simplifyBasicExp(stats, expr->be2, rightPure);
+  pure = pure && rightPure;
+} // simplifyExpression
+
+//***************************************************************************
+//End of list subprograms.
+//***************************************************************************
+
+
+
+static long long countNodes(Expression *expr)      // *In* Expression
+{ // The lists are walked with loops and brackets recursed into.
+
+  long long nodes = 1;                            // The Expression
+
+  for (BasicExp *bexp : { expr->be1, expr->be2 })
+    for (; bexp != NULL; bexp = bexp->bexp)
+    {
+      nodes++;
+      for (Term *term = bexp->term; term != NULL; term = term->term)
+      {
+        nodes++;
+        for (Factor *fact = term->fact; fact != NULL; fact = fact->nFactor)
+        {
+          nodes++;
+          if (fact->bExp != NULL)
+            nodes += countNodes(fact->bExp);
+        }
+      }
+    }
+
+  return nodes;
+} // countNodes
+
+
+
+void simplifyAST(AST *ast,                         // *In-Out* Abs syntax tree
+  SimplifyStats &stats)                            // *Out* Rules applied
+{ // The node counts are taken before and after.
+
+  bool pure;                                      // Expression is pure
+
+  stats.nodesBefore = 0;
+  stats.nodesAfter = 0;
+  for (int r = 0; r < RULES; r++)
+    stats.hits[r] = 0;
+
+  if (ast == NULL || ast->shared || ast->expr == NULL)
+    return;
+
+  stats.nodesBefore = countNodes(ast->expr);
+  simplifyExpression(stats, ast->expr, pure);
+  stats.nodesAfter = countNodes(ast->expr);
+} // simplifyAST
+
+
+
+void reportSimplify(ostream &out,                  // *In-Out* Output
+  const SimplifyStats &stats)                      // *In* Rules applied
+{ // Rules that never applied are left out.
+
+  out << "Simplified : Nodes : " << stats.nodesBefore << " -> "
+      << stats.nodesAfter << "\tRules :";
+  for (int r = 0; r < RULES; r++)
+    if (stats.hits[r] > 0)
+      out << ' ' << ruleNames[r] << ' ' << stats.hits[r];
+  out << '\n';
+} // reportSimplify
@@ -0,0 +1,82 @@
+// Title   : simplify.h
+// Purpose : Algebraic simplification header file for SCL. Rewrites the
+//           type checked expression tree into a smaller one with the same
+//           results.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard output streams and the syntax analysis header file for
+// the AST types.
+#include <ostream>         // Standard output streams
+#include "syner.h"         // header for syner.cxx
+
+
+
+// Once synAnal has type checked the tree, every Term and BasicExp list is
+// known to be all int operators or all && or ||, so simple rules can be
+// applied to the lists left to right, as they are evaluated:
+//
+//     identities     x * 1, 1 * x, x / 1, x + 0, 0 + x, x - 0,
+//                    b && true, true && b, b || false, false || b
+//     annihilators   x * 0, 0 * x, x % 1 (all 0), b && false (false),
+//                    b || true (true)
+//     negation       !!b, and redundant brackets round a single operand,
+//                    so that !(!b) goes too
+//
+// An operand is only dropped if evaluating it cannot throw: it has no / or
+// % by anything but a non-zero literal. An operand after a false in an &&
+// chain, or a true in an || chain, was never evaluated and always goes.
+// The rules apply bottom up, so an operand that simplifies to a literal
+// takes part in the rules of the list round it. Every rule leaves SCL that
+// the parser could have built, so the listing of the result is a program.
+// Multiplying, dividing and taking the remainder by a power of two are
+// left as they are for lowerAST to reduce (see kernels.h).
+//
+// Results, and runtime errors up to the row they happen in, are those of
+// the tree before.
+
+
+
+// The rules, in the order of the table above. RULES is the count.
+enum SimplifyRule { RULEMULONE, RULEADDZERO, RULEANDTRUE, RULEORFALSE,
+  RULEMULZERO, RULEMODONE, RULEANDFALSE, RULEORTRUE, RULENOTNOT,
+  RULEBRACKET, RULES };
+
+// Names of the rules, in enum order.
+extern const char *const ruleNames[RULES];
+
+
+
+// What simplification did. Nodes are the Expression, BasicExp, Term and
+// Factor nodes of the expression.
+struct SimplifyStats                               // Simplification results
+{
+  long long nodesBefore;                          // Nodes in the tree
+  long long nodesAfter;                           // Nodes left
+  long long hits[RULES];                          // Times each rule applied
+}; // SimplifyStats
+
+
+
+// simplifyAST applies the rules to the expression of ast, which must be the
+// result of a successful synAnal, deleting the nodes they drop. A shared
+// AST (see hashcons.h) is left as it is, as its nodes may have more than
+// one parent; simplify before sharing.
+void simplifyAST(AST *ast,                         // *In-Out* Abs syntax tree
+  SimplifyStats &stats);                           // *Out* Rules applied
+
+// reportSimplify writes the node counts and the rules that applied as one
+// line to out.
+void reportSimplify(ostream &out,                  // *In-Out* Output
+  const SimplifyStats &stats);                     // *In* Rules applied
+
+
+#endif
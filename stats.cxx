@@ -0,0 +1,198 @@
+// Title   : stats.cxx
+// Purpose : Compile statistics subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <ostream>       // Standard output streams
+#include <string.h>      // memset
+#include "stats.h"       // header for stats.cxx
+
+
+
+thread_local CompileStats compileStats;            // This thread's counts
+thread_local bool         statsTiming = false;     // Phases being timed
+thread_local bool         statsCounting = false;   // Events being charged
+thread_local int          statsPhase = -1;         // Phase running
+thread_local long long    statsMark = 0;           // Last charged
+
+static thread_local long long eventMark[PERFEVENTS]; // Counts last charged
+
+
+
+// Names of the phases and node kinds, in enum order.
+const char *const phaseNames[PHASES] = {
+  "lexAnal", "skipWhiteComments", "synDec", "expression", "printers"
+};
+
+static const char *nodeNames[NODEKINDS] = {
+  "SymTab", "AST", "Expression", "BasicExp", "Term", "Factor"
+};
+
+
+
+void clearCompileStats(bool timing,                // *In* Time the phases
+  bool counting)                                   // *In* Count events
+{ // Timing must not be turned on or off while a phase is running.
+
+  memset(&compileStats, 0, sizeof compileStats);
+  statsTiming = timing;
+  statsCounting = timing && counting;
+  statsMark = statsClock();
+  if (statsCounting)
+    readPerfCounters(eventMark);
+} // clearCompileStats
+
+
+
+void chargeEvents()
+{ // Events outside every phase are not charged.
+
+  long long now[PERFEVENTS];                      // Counts read
+
+  readPerfCounters(now);
+  for (int e = 0; e < PERFEVENTS; e++)
+  {
+    if (statsPhase >= 0)
+      compileStats.events[statsPhase][e] += now[e] - eventMark[e];
+    eventMark[e] = now[e];
+  }
+} // chargeEvents
+
+
+
+void addCompileStats(const CompileStats &stats)    // *In* Statistics added
+{ // Every counter is a sum, so they are added field by field.
+
+  for (int p = 0; p < PHASES; p++)
+  {
+    compileStats.nanos[p] += stats.nanos[p];
+    compileStats.calls[p] += stats.calls[p];
+    for (int e = 0; e < PERFEVENTS; e++)
+      compileStats.events[p][e] += stats.events[p][e];
+  }
+  for (int t = 0; t <= END; t++)
+    compileStats.tokens[t] += stats.tokens[t];
+  for (int n = 0; n < NODEKINDS; n++)
+    compileStats.nodes[n] += stats.nodes[n];
+  compileStats.lookups += stats.lookups;
+  compileStats.probes += stats.probes;
+  compileStats.bytesRead += stats.bytesRead;
+} // addCompileStats
+
+
+
+const CompileStats &getCompileStats()
+{ // This thread's statistics.
+
+  return compileStats;
+} // getCompileStats
+
+
+
+void reportStats(ostream &out,                     // *In-Out* Report
+  const CompileStats &stats)                       // *In* Statistics
+{ // Zero token counts are left out.
+
+  long long total = 0;                            // All phases
+  long long lexing = 0;                           // Lexer phases
+
+  out << "Phase\tCalls\tSeconds\n";
+  for (int p = 0; p < PHASES; p++)
+  {
+    out << phaseNames[p] << '\t' << stats.calls[p] << '\t'
+        << stats.nanos[p] / 1e9 << '\n';
+    total += stats.nanos[p];
+  }
+  out << "total\t\t" << total / 1e9 << '\n';
+
+  out << "Tokens :";
+  for (int t = 0; t <= END; t++)
+    if (stats.tokens[t] > 0)
+      out << ' ' << lexTagNames[t] << ' ' << stats.tokens[t];
+  out << '\n';
+
+  out << "Nodes :";
+  for (int n = 0; n < NODEKINDS; n++)
+    out << ' ' << nodeNames[n] << ' ' << stats.nodes[n];
+  out << '\n';
+
+  out << "Lookups : " << stats.lookups << "\tProbes : " << stats.probes;
+  if (stats.lookups > 0)
+    out << "\tMean probe : " << (double)stats.probes / stats.lookups;
+  out << '\n';
+
+  lexing = stats.nanos[PHASELEX] + stats.nanos[PHASESKIP];
+  out << "Bytes read : " << stats.bytesRead;
+  if (lexing > 0)
+    out << "\tLexer MB/s : " << stats.bytesRead * 1e3 / lexing;
+  out << '\n';
+} // reportStats
+
+
+
+static void eventTable(ostream &out,               // *In-Out* Report
+  const CompileStats &stats,                       // *In* Statistics
+  const char *title,                               // *In* Table title
+  double per)                                      // *In* Divisor
+{ // One row per phase with a column per event counted. Counts are written
+  // whole when they are not divided.
+
+  long long total[PERFEVENTS] = {0};              // Column totals
+
+  out << title;
+  for (int e = 0; e < PERFEVENTS; e++)
+    if (perfCounting((PerfEvent)e))
+      out << '\t' << perfEventNames[e];
+  out << '\n';
+
+  for (int p = 0; p < PHASES; p++)
+  {
+    out << phaseNames[p];
+    for (int e = 0; e < PERFEVENTS; e++)
+      if (perfCounting((PerfEvent)e))
+      {
+        if (per == 1.0)
+          out << '\t' << stats.events[p][e];
+        else
+          out << '\t' << stats.events[p][e] / per;
+        total[e] += stats.events[p][e];
+      }
+    out << '\n';
+  }
+
+  out << "total";
+  for (int e = 0; e < PERFEVENTS; e++)
+  {
+    if (!perfCounting((PerfEvent)e))
+      continue;
+    if (per == 1.0)
+      out << '\t' << total[e];
+    else
+      out << '\t' << total[e] / per;
+  }
+  out << '\n';
+} // eventTable
+
+
+
+void reportEvents(ostream &out,                    // *In-Out* Report
+  const CompileStats &stats)                       // *In* Statistics
+{ // The tables per byte and per token are left out if there were none.
+
+  long long tokens = 0;                           // Tokens lexed
+
+  for (int t = 0; t <= END; t++)
+    tokens += stats.tokens[t];
+
+  eventTable(out, stats, "Events", 1.0);
+  if (stats.bytesRead > 0)
+    eventTable(out, stats, "Per byte", (double)stats.bytesRead);
+  if (tokens > 0)
+    eventTable(out, stats, "Per token", (double)tokens);
+  if (perfMultiplexed())
+    out << "Counters were shared with other users; counts are low.\n";
+} // reportEvents
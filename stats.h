@@ -0,0 +1,165 @@
+// Title   : stats.h
+// Purpose : Compile statistics header file for SCL. Per phase timers and
+//           counters for the lexer, parser and printers.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef STATS_H
+#define STATS_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include standard stream library, the time library for the monotonic
+// clock, the lexer header file for LexTokenTag and the performance counter
+// header file for PerfEvent.
+#include <ostream>         // Standard output streams
+#include <time.h>          // clock_gettime
+#include "lexer.h"         // header for lexer.cxx
+#include "perfcount.h"     // header for perfcount.cxx
+
+
+
+// The phases of a compile. Time is charged to the innermost phase running,
+// so the time lexAnal spends in skipWhiteComments is skipWhiteComments
+// time, and the time synDec spends in lexAnal is lexAnal time. Time spent
+// in no phase at all is not charged.
+enum StatsPhase {
+  PHASELEX,                                        // lexAnal
+  PHASESKIP,                                       // skipWhiteComments
+  PHASEDECL,                                       // synDec
+  PHASEEXPR,                                       // synExpression and below
+  PHASEPRINT,                                      // Printers and dumps
+  PHASES
+}; // StatsPhase
+
+// Names of the phases, in enum order.
+extern const char *const phaseNames[PHASES];
+
+// The kinds of node synAnal allocates.
+enum StatsNode {
+  NODESYMTAB, NODEAST, NODEEXPRESSION, NODEBASICEXP, NODETERM, NODEFACTOR,
+  NODEKINDS
+}; // StatsNode
+
+
+
+// Counters for the compiles run on one thread since clearCompileStats.
+// probes is the number of SymTab entries lookup compared, so probes /
+// lookups is the mean probe length. bytesRead counts source bytes. events
+// holds the hardware counts per phase when they are being counted.
+struct CompileStats                                // Compile statistics
+{
+  long long nanos[PHASES];                        // Time per phase
+  long long calls[PHASES];                        // Entries per phase
+  long long events[PHASES][PERFEVENTS];           // Hardware counts
+  long long tokens[END + 1];                      // Tokens per tag
+  long long nodes[NODEKINDS];                     // Nodes per kind
+  long long lookups;                              // SymTab lookups
+  long long probes;                               // Entries compared
+  long long bytesRead;                            // Source bytes
+}; // CompileStats
+
+
+
+// The statistics are per thread, so compiles on different threads do not
+// share counters. The counters are always kept, but phases are only timed
+// while statsTiming is set, as the clock reads cost more than the lexer
+// does per token, and hardware events are only charged to phases while
+// statsCounting is set as well. statsPhase is the phase running (-1 for
+// none) and statsMark when it was last charged.
+extern thread_local CompileStats compileStats;
+extern thread_local bool         statsTiming;
+extern thread_local bool         statsCounting;
+extern thread_local int          statsPhase;
+extern thread_local long long    statsMark;
+
+
+
+// statsClock reads the monotonic clock in nanoseconds.
+inline long long statsClock()
+{
+  struct timespec now;                            // Clock reading
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// chargeEvents adds the hardware events counted since the last charge to
+// the phase running.
+void chargeEvents();
+
+
+
+// A PhaseTimer charges the time until it is destroyed to phase, pausing the
+// phase that was running and resuming it afterwards. Each one costs two
+// clock reads when timing, two counter reads as well when counting, and
+// a test otherwise.
+class PhaseTimer                                   // Scoped phase timer
+{
+private:
+  int outer;                                      // Phase paused, -2 if off
+public:
+  // Class constructor and destructor.
+  PhaseTimer(StatsPhase phase)                     // *In* Phase entered
+  {
+    if (!statsTiming)
+    {
+      outer = -2;
+      return;
+    }
+
+    long long now = statsClock();                 // Time of entry
+
+    if (statsCounting)
+      chargeEvents();
+    if (statsPhase >= 0)
+      compileStats.nanos[statsPhase] += now - statsMark;
+    statsMark = now;
+    outer = statsPhase;
+    statsPhase = phase;
+    compileStats.calls[phase]++;
+  }
+  ~PhaseTimer()
+  {
+    if (outer == -2)
+      return;
+
+    long long now = statsClock();                 // Time of exit
+
+    if (statsCounting)
+      chargeEvents();
+    compileStats.nanos[statsPhase] += now - statsMark;
+    statsMark = now;
+    statsPhase = outer;
+  }
+}; // class PhaseTimer
+
+
+
+// clearCompileStats zeroes this thread's statistics and turns the timing
+// of phases on or off, and the counting of hardware events per phase.
+// Counting needs timing, and the thread's counters opened with
+// openPerfCounters.
+void clearCompileStats(bool timing,                // *In* Time the phases
+  bool counting);                                  // *In* Count events
+
+// addCompileStats adds stats, kept on another thread, to this thread's.
+void addCompileStats(const CompileStats &stats);   // *In* Statistics added
+
+// getCompileStats returns this thread's statistics.
+const CompileStats &getCompileStats();
+
+// reportStats writes stats as a table of phases followed by the counters.
+void reportStats(ostream &out,                     // *In-Out* Report
+  const CompileStats &stats);                      // *In* Statistics
+
+// reportEvents writes the hardware events of each phase, in total, per
+// source byte and per token.
+void reportEvents(ostream &out,                    // *In-Out* Report
+  const CompileStats &stats);                      // *In* Statistics
+
+
+#endif
@@ -34,11 +34,18 @@ using namespace std;
 #include <stddef.h>
 #include <stdlib.h>
 
-//Include string library, the syntax analysis header file and the lexical
-///analysis header file.
+//Include string library, hash set library for shared trees, utility
+//library for move, the syntax analysis header file, the lexical analysis header file and the pipelined lexer
+//header file.
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include "syner.h"
 #include "lexer.h"
+#include "budget.h"
+#include "lexpipe.h"
+#include "stats.h"
+#include "trace.h"
 
 
 
@@ -47,6 +54,273 @@ using namespace std;
 
 
 
+//***************************************************************************
+//Error recording subprograms
+//***************************************************************************
+
+//What synRecover has found so far.
+struct Recovery
+{
+  vector<Diagnostic> *errors;                     //Errors found
+  int                maxErrors;                   //Errors before giving up
+}; //Recovery
+
+//The errors of a recovering parse on this thread, or NULL.
+static thread_local Recovery *recovery = NULL;
+
+//Sets a recovering parse on this thread, with lexer errors thrown so
+//that nextToken can record them, and restores both however it ends.
+class RecoveryScope
+{
+private:
+  bool outer;                                     //lexThrows restored
+public:
+  RecoveryScope(Recovery *state)
+  {
+    outer = lexThrows;
+    lexThrows = true;
+    recovery = state;
+  }
+  ~RecoveryScope() { recovery = NULL; lexThrows = outer; }
+}; //class RecoveryScope
+
+//Thrown when the tokens skipped after an error reach a let, in or end
+//before the ) closing the bracket it was found in, to go on from there.
+struct Resync {};
+
+//Thrown when a recovering parse gives up.
+struct GiveUp {};
+
+
+
+static void writeReport(ostream &outFile,          //*In-Out* Output file
+  Report r)                              //*In* Error found
+{ //writeReport writes the error message for r and uses writeToken to
+  //write the lexical token at which it was found.
+  //For a list of the error numbers and corresponding error message RTFC.
+  //Error numbers from 1 to 99 are for syntax errors; error numbers from
+  //101 to 199 are static semantic errors; error number from 201 to 299
+  //are for type errors; error numbers from 401 to 499 are for breaches of
+  //the compile's budgets.
+
+  AllocScope site(ALLOCREPORT);           // Charge the listing copies
+
+  // If syntax error, output error type and error number
+  if ((r.getNumber() > minSyntaxError) &&
+    (r.getNumber() < maxSyntaxError))
+  {
+    outFile << "Syntax error " << r.getNumber();
+    outFile << ".\n";
+    outFile << syntax[r.getNumber() - minSyntaxError];
+  }
+  // If semantic error, output error type and error number
+  else if ((r.getNumber() > minStaticError) &&
+    (r.getNumber() < maxStaticError + minStaticError))
+  {
+    outFile << "Static semantic error " << r.getNumber();
+    outFile << ".\n";
+    outFile << statics[r.getNumber() - minStaticError];
+  }
+  // If type error, output error type and error number
+  else if ((r.getNumber() > minTypeError) &&
+    (r.getNumber() < maxTypeError + minTypeError))
+  {
+    outFile << "Type error " << r.getNumber();
+    outFile << ".\n";
+    outFile << ::type[r.getNumber() - minTypeError];
+  }
+  // If limit error, output error type and error number
+  else if ((r.getNumber() > minLimitError) &&
+    (r.getNumber() < maxLimitError + minLimitError))
+  {
+    outFile << "Limit error " << r.getNumber();
+    outFile << ".\n";
+    outFile << limits[r.getNumber() - minLimitError];
+  }
+  // output unknown error type
+  else
+    outFile << "Unknown parse error.\n";
+
+  outFile << "Found : ";
+  writeToken(outFile, r.getLexToken());
+  outFile << '\n';
+} //writeReport
+
+
+
+static void recordError(Diagnostic error)          //*In* Error found
+{ //recordError adds an error, already written, to the recovering parse's
+  //list and gives up once the list is full, or at a breach of a budget,
+  //as going on would only spend more of it.
+
+  AllocScope site(ALLOCREPORT);           // The list holds copies
+  bool breach = (error.code == limitExitCode) ||
+    ((error.number > minLimitError) &&
+    (error.number < maxLimitError + minLimitError)); // Over a budget
+
+  recovery->errors->push_back(move(error));
+  if (breach || ((int)recovery->errors->size() >= recovery->maxErrors))
+    throw GiveUp();
+} //recordError
+
+
+
+static void recordReport(ostream &outFile,         //*In-Out* Output file
+  Report r)                              //*In* Error found
+{ //recordReport writes and records a Report.
+
+  writeReport(outFile, r);
+  recordError(Diagnostic{r.getNumber(), r.getLexToken(), NULL, 1});
+} //recordReport
+
+
+
+static void semanticError(ostream &outFile,        //*In-Out* Output file
+  int number,                            //*In* Error number
+  LexToken &lexToken)                    //*In* Current token
+{ //semanticError throws a static semantic or type error, or records it
+  //if the parse is recovering. Such an error leaves the parse where it
+  //was, so no tokens need skipping; the caller goes on with ERRORDATA as
+  //the type of what was wrong.
+
+  if (recovery == NULL)
+    throw Report(number, lexToken);
+
+  recordReport(outFile, Report(number, lexToken));
+} //semanticError
+
+//***************************************************************************
+//End of error recording subprograms
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Budget subprograms
+//***************************************************************************
+
+static void chargeNode(LexToken &lexToken)         //*In* Current token
+{ //chargeNode counts a node about to be built, and throws error 403
+  //instead if it is one more than the node budget allows.
+
+  if (budgetUse.nodesLeft == 0)
+    throw Report(403, lexToken);
+  budgetUse.nodesLeft--;
+} //chargeNode
+
+
+
+//Counts a bracket or ! the parse is inside for as long as it is, so the
+//count is right however the parse leaves it. Throws error 405 if it is one
+//more than the depth budget allows.
+class NestScope
+{
+public:
+  NestScope(LexToken &lexToken)
+  {
+    if (budgetUse.depthLeft == 0)
+      throw Report(405, lexToken);
+    budgetUse.depthLeft--;
+  }
+  ~NestScope() { budgetUse.depthLeft++; }
+}; //class NestScope
+
+//***************************************************************************
+//End of budget subprograms
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Token subprograms
+//***************************************************************************
+
+//The lexer thread of a pipelined parse on this thread, or NULL.
+static thread_local LexPipe *lexPipe = NULL;
+
+
+
+static void nextToken(istream &inFile,             //*In-Out* Input file
+  ostream &outFile,                      //*In-Out* Output file
+  LexToken &lexToken)                    //*Out* Token lexed
+{ //nextToken is where the parser gets its tokens: from the lexer thread
+  //of a pipelined parse, or from lexAnal. Once the lexer thread has
+  //stopped after the end token the parser lexes any more it wants itself.
+  //While recovering, a lexer error is written and recorded and the token
+  //after it lexed, until the end of the file.
+
+  if (lexPipe != NULL && pipeToken(lexPipe, outFile, lexToken))
+    return;
+  if (recovery == NULL)
+  {
+    lexAnal(inFile, outFile, lexToken);
+    return;
+  }
+
+  for (;;)
+  {
+    try
+    {
+      lexAnal(inFile, outFile, lexToken);
+      return;
+    }
+    catch (LexError error)
+    {
+      if (error.message != NULL)
+        outFile << error.message << '\n';
+      recordError(Diagnostic{0, LexToken(), error.message, error.code});
+      skipWhiteComments(inFile);
+      if (inFile.rdbuf()->sgetc() == EOF)
+        throw GiveUp();
+    }
+  }
+} //nextToken
+
+
+
+static void syncToken(istream &inFile,             //*In-Out* Input file
+  ostream &outFile,                      //*In-Out* Output file
+  LexToken &lexToken,                    //*In-Out* Current token
+  bool inBracket)                        //*In* Stop at its )
+{ //syncToken skips tokens after an error, from the one it was found at,
+  //to the next let, in or end, or if inBracket to the ) closing the
+  //bracket it was found in, whichever comes first. Brackets opened on the
+  //way are skipped whole. lexToken is left holding the token stopped at.
+
+  int depth = 0;                                  //Brackets skipped into
+
+  while ((lexToken.tag != LET) && (lexToken.tag != IN) &&
+    (lexToken.tag != END))
+  {
+    if (lexToken.tag == LPAREN)
+      depth++;
+    else if ((lexToken.tag == RPAREN) && (depth > 0))
+      depth--;
+    else if ((lexToken.tag == RPAREN) && inBracket)
+      return;
+
+    nextToken(inFile, outFile, lexToken);
+  }
+} //syncToken
+
+
+
+static void endLexPipe()
+{ //endLexPipe stops this thread's lexer thread, if it has one.
+
+  if (lexPipe != NULL)
+  {
+    stopLexPipe(lexPipe);
+    lexPipe = NULL;
+  }
+} //endLexPipe
+
+//***************************************************************************
+//End of token subprograms
+//***************************************************************************
+
+
+
 //***************************************************************************
 //Symbol table lookup subprogram
 //***************************************************************************
@@ -66,10 +340,13 @@ bool lookup(LexToken lexToken,                     //*In* Identifier token
 
   bool  found = false;                            //Entry found flag
 
+  compileStats.lookups++;
+
   //Search Symbol table until a match is found or we reach the end
   //of the list.
   while ((st != NULL) && !found)
   {
+    compileStats.probes++;
     if (st->ident == lexToken.ident)
     {
       found = true;
@@ -104,9 +381,29 @@ bool lookup(LexToken lexToken,                     //*In* Identifier token
 //Variable / Constant Declaration Syntax analysis subprograms.
 //***************************************************************************
 
+//Deletes the entry synDec is building, and its initialiser, if synDec
+//leaves by an error before linking it into the symbol table, where
+//freeTrees would find it.
+class EntryScope
+{
+private:
+  SymTab *entry;                                  //Entry, or NULL if kept
+public:
+  EntryScope(SymTab *newEntry) { entry = newEntry; }
+  void keep() { entry = NULL; }
+  ~EntryScope()
+  {
+    if (entry != NULL)
+    {
+      delete entry->initialise;
+      delete entry;
+    }
+  }
+}; //class EntryScope
 
-void synDec(ifstream &inFile,                      // *In-Out* Input file
-  ofstream &outFile,                     // *In-Out Output file
+
+void synDec(istream &inFile,                       // *In-Out* Input file
+  ostream &outFile,                      // *In-Out Output file
   SymTab   *&st,                         // *In-Out* Symbol table
   LexToken &lexToken)                    // *In-Out* Current token
 { // synDec gets lexical tokens from lexAnal and attempts to parse them
@@ -115,21 +412,24 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
   // If the parse is unsuccessful synDec throws an exception.
 
   SymTab* newEntry; //For this Declaration
-  SymTab* dummy;    //For the lookup
+  SymTab* match = NULL; //For the lookup
+
+  // The slot of the last entry is one less than the number of entries, so
+  // the symbol budget needs no count of its own.
+  if (overBudget(BUDGETSYMBOLS, (st == NULL) ? 1 : st->slot + 2))
+    throw Report(404, lexToken);
 
   newEntry = new SymTab;              // Sets new SymTab for newEntry
+  compileStats.nodes[NODESYMTAB]++;
   newEntry->ident = "";               // Initialise the ident tag
   newEntry->type = VOIDDATA;          // Initialise newEntry type
   newEntry->initialise = NULL;        // Initialise newEntry
+  newEntry->slot = (st == NULL) ? 0 : st->slot + 1; // Next binding slot
   newEntry->next = st;                // Sets next tag to st
 
-  dummy = new SymTab;              // Sets new SymTab for dummy
-  dummy->ident = "";               // Initialise the ident tag
-  dummy->type = VOIDDATA;          // Initialise dummy type
-  dummy->initialise = NULL;        // Initialise dummy
-  dummy->next = NULL;                // Sets next tag to st
+  EntryScope pending(newEntry);       // Deleted unless linked into st
 
-  lexAnal(inFile, outFile, lexToken);
+  nextToken(inFile, outFile, lexToken);
 
   // Checks if the tokens tag is BOOL, if so it will pass the
   // type onto newEntry. If it is not a ident it will throw
@@ -161,7 +461,7 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
     throw Report(18, lexToken); // If no type is found, throws error 18.
   }
 
-  lexAnal(inFile, outFile, lexToken);
+  nextToken(inFile, outFile, lexToken);
 
   // Checks if the tokens tag is IDENT, if so it will pass the
   // identifier onto newEntry. If it is not a ident it will throw
@@ -174,17 +474,19 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
   // Calls lookup to make sure that the variable has not already been declared
   // as you cannot have 2 identifiers with the same name. If an identifier
   // already exists with that name then it will throw report case 101.
-  if (lookup(lexToken, st, dummy))
+  if (lookup(lexToken, st, match))
     throw Report(101, lexToken);
 
-  lexAnal(inFile, outFile, lexToken); // Get the next token.
+  nextToken(inFile, outFile, lexToken); // Get the next token.
 
   // If the lexToken tag is ASSIGN, then the code will initialise newEntry
   // to a new factor and then lex the next token.
   if (lexToken.tag == ASSIGN)
   {
+    chargeNode(lexToken);
     newEntry->initialise = new Factor;
-    lexAnal(inFile, outFile, lexToken);
+    compileStats.nodes[NODEFACTOR]++;
+    nextToken(inFile, outFile, lexToken);
 
     // If the lexToken tag is BOOLLIT, then the code will first check if
     // newEntry type is BOOLDATA, if the tag is BOOLLIT and the type is not
@@ -212,6 +514,8 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
 
       newEntry->initialise->literal = true;
       newEntry->initialise->type = STRINGDATA;
+      // Copied, not moved: a lone & after the literal is reported with the
+      // token left as it is, literal included.
       newEntry->initialise->litString = lexToken.stringLit;
     }
     // If the lexToken tag is INTLIT, then the code will first check if
@@ -244,7 +548,7 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
       throw Report(2, lexToken);
     }
 
-    lexAnal(inFile, outFile, lexToken); // Get the next lextoken.
+    nextToken(inFile, outFile, lexToken); // Get the next lextoken.
   }
   else
   {
@@ -252,6 +556,7 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
   }
 
   st = newEntry; // Adds new entry to the end of the stack.
+  pending.keep();
 
   if (lexToken.tag != IN)
     throw Report(6, lexToken);
@@ -302,8 +607,8 @@ void synDec(ifstream &inFile,                      // *In-Out* Input file
 //***************************************************************************
 //synExpression must be forward declared as it is mutually recursive with
 //synFactor.
-void synExpression(ifstream   &inFile,             //*In-Out* Input file
-  ofstream   &outFile,            //*In-Out Output file
+void synExpression(istream    &inFile,             //*In-Out* Input file
+  ostream    &outFile,            //*In-Out Output file
   SymTab     *st,                 //*In* Symbol table
   Expression *&expr,              //*Out* Expression parsed
   LexToken   &lexToken,           //*In-Out* Current token
@@ -311,8 +616,8 @@ void synExpression(ifstream   &inFile,             //*In-Out* Input file
 
 
 
-void synFactor(ifstream   &inFile,                 //*In-Out* Input file
-  ofstream   &outFile,                //*In-Out Output file
+void synFactor(istream    &inFile,                 //*In-Out* Input file
+  ostream    &outFile,                //*In-Out Output file
   SymTab *st,                         //*In* Symbol table
   Factor *&fact,                      //*Out* Factor parsed
   LexToken &lexToken)                 //*In-Out* Current token
@@ -323,7 +628,9 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
   //Factor via the fact parameter.
 
   SymTab *dummy = NULL;         // Initialises dummy to null.
+  chargeNode(lexToken);
   fact = new Factor;           // Sets new Factor for fact.
+  compileStats.nodes[NODEFACTOR]++;
   fact->type = VOIDDATA;        // Initialise type to VOIDDATA.
   fact->ident = NULL;           // Initialise ident tag.
   fact->bExp = NULL;            // Initialise basic expression
@@ -337,7 +644,7 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
     fact->literal = true;
     fact->type = BOOLDATA;
     fact->litBool = lexToken.boolLit;
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
   }
   // Checks if the lexToken tag is STRINGLIT, if so sets literal
   // to true, sets the type to STRINGDATA and then stores the literal
@@ -346,8 +653,8 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
   {
     fact->literal = true;
     fact->type = STRINGDATA;
-    fact->litString = lexToken.stringLit;
-    lexAnal(inFile, outFile, lexToken);
+    fact->litString = lexToken.stringLit; // Copied, as in synDec
+    nextToken(inFile, outFile, lexToken);
   }
   // Checks if the lexToken tag is INTLIT, if so sets literal
   // to true, sets the type to INTDATA and then stores the literal
@@ -357,42 +664,65 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
     fact->literal = true;
     fact->type = INTDATA;
     fact->litInt = lexToken.intLit;
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
   }
   else if (lexToken.tag == FLOATLIT)
   {
     fact->literal = true;
     fact->type = FLOATDATA;
     fact->litFloat = lexToken.floatLit;
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
   }
   // Checks if the lexToken tag is IDENT, then calls lookup to see
   // if it is already decared, if not throws the correct case.
   // If already declared then sets ident, literal and type.
   else if (lexToken.tag == IDENT)
   {
-    if (!lookup(lexToken, st, dummy))
-      throw Report(102, lexToken);
-
-    fact->ident = dummy;
     fact->literal = false;
-    fact->type = fact->ident->type;
-    lexAnal(inFile, outFile, lexToken);
+    if (lookup(lexToken, st, dummy))
+    {
+      fact->ident = dummy;
+      fact->type = fact->ident->type;
+    }
+    else
+    {
+      semanticError(outFile, 102, lexToken);
+      fact->type = ERRORDATA;
+    }
+    nextToken(inFile, outFile, lexToken);
   }
   // Checks if the tag is LPAREN, if so sets literal to false and
   // calls synExpression. If after the expression a RPAREN is not found
-  // then throws the correct report case.
+  // then throws the correct report case. A recovering parse records an
+  // error in the bracket and skips to its ), or if a let, in or end comes
+  // first throws Resync for synAnal to go on from there.
   else if (lexToken.tag == LPAREN)
   {
-    lexAnal(inFile, outFile, lexToken);
+    NestScope nest(lexToken);     // Inside the bracket
+
+    nextToken(inFile, outFile, lexToken);
     fact->literal = false;
 
-    synExpression(inFile, outFile, st, fact->bExp, lexToken, fact->type);
+    try
+    {
+      synExpression(inFile, outFile, st, fact->bExp, lexToken, fact->type);
 
-    if (lexToken.tag != RPAREN)
-      throw Report(17, lexToken);
+      if (lexToken.tag != RPAREN)
+        throw Report(17, lexToken);
+    }
+    catch (Report r)
+    {
+      if (recovery == NULL)
+        throw;
+
+      recordReport(outFile, r);
+      syncToken(inFile, outFile, lexToken, true);
+      if (lexToken.tag != RPAREN)
+        throw Resync();
+      fact->type = ERRORDATA;
+    }
 
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
 
   }
   // Checks to see if the tag is a NOTOP, if so gets the next token and calls
@@ -400,12 +730,15 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
   // case. Sets literal to false and type to BOOLDATA.
   else if (lexToken.tag == NOTOP)
   {
-    lexAnal(inFile, outFile, lexToken);
+    NestScope nest(lexToken);     // Inside the !
+
+    nextToken(inFile, outFile, lexToken);
 
     synFactor(inFile, outFile, st, fact->nFactor, lexToken);
 
-    if (fact->nFactor->type != BOOLDATA)
-      throw Report(215, lexToken);
+    if ((fact->nFactor->type != BOOLDATA) &&
+      (fact->nFactor->type != ERRORDATA))
+      semanticError(outFile, 215, lexToken);
 
     fact->literal = false;
     fact->type = BOOLDATA;
@@ -415,8 +748,8 @@ void synFactor(ifstream   &inFile,                 //*In-Out* Input file
 
 
 
-void synTerm(ifstream &inFile,                     //*In-Out* Input file
-  ofstream &outFile,                    //*In-Out Output file
+void synTerm(istream &inFile,                      //*In-Out* Input file
+  ostream &outFile,                     //*In-Out Output file
   SymTab   *st,                         //*In* Symbol table
   Term     *&term,                      //*Out* Term parsed
   LexToken &lexToken,                   //*In-Out* Current token
@@ -431,9 +764,12 @@ void synTerm(ifstream &inFile,                     //*In-Out* Input file
   DataType type1 = VOIDDATA;    // Type1 declaration and initialised
   DataType type2 = VOIDDATA;    // Type2 declaration and initialised
 
+  chargeNode(lexToken);
   term = new Term;              // Creates new Term for term
+  compileStats.nodes[NODETERM]++;
   term->fact = NULL;            // Initialise fact
   term->term = NULL;            // Initialise term
+  term->chain = -1;             // Initialise chain
 
   type = VOIDDATA;              // Initialise type to VOIDDATA
 
@@ -448,34 +784,36 @@ void synTerm(ifstream &inFile,                     //*In-Out* Input file
   {
     term->mulOp = lexToken.mulOp;
 
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
 
     synTerm(inFile, outFile, st, term->term, lexToken, type2);
 
+    // An operand already in error has been reported.
+    if ((type1 == ERRORDATA) || (type2 == ERRORDATA))
+      type1 = ERRORDATA;
     // Compares the types to make sure there is not a mismatch.
-    if (type1 != type2)
-      throw Report(210, lexToken);
-
-    // Checks to see if a mulOp is being used on a non-int.
-    // If found, then throws the appropriate case.
-    if (type1 != INTDATA)
+    else if (type1 != type2)
     {
-      if (term->mulOp == "*")
-        throw Report(211, lexToken);
-
-      if (term->mulOp == "/")
-        throw Report(212, lexToken);
-
-      if (term->mulOp == "%")
-        throw Report(213, lexToken);
+      semanticError(outFile, 210, lexToken);
+      type1 = ERRORDATA;
     }
-
-    // Checks to see if && is being used on something other than
-    // a bool. If so, throws the appropriate case.
-    if (type1 != BOOLDATA)
+    // Checks to see if a mulOp is being used on a non-int, or && on
+    // something other than a bool. If found, then throws the appropriate
+    // case.
+    else if (((type1 != INTDATA) &&
+      ((term->mulOp == "*") || (term->mulOp == "/") ||
+      (term->mulOp == "%"))) ||
+      ((type1 != BOOLDATA) && (term->mulOp == "&&")))
     {
-      if (term->mulOp == "&&")
-        throw Report(214, lexToken);
+      if (term->mulOp == "*")
+        semanticError(outFile, 211, lexToken);
+      else if (term->mulOp == "/")
+        semanticError(outFile, 212, lexToken);
+      else if (term->mulOp == "%")
+        semanticError(outFile, 213, lexToken);
+      else
+        semanticError(outFile, 214, lexToken);
+      type1 = ERRORDATA;
     }
   }
 
@@ -485,8 +823,8 @@ void synTerm(ifstream &inFile,                     //*In-Out* Input file
 
 
 
-void synBasicExp(ifstream &inFile,                 //*In-Out* Input file
-  ofstream &outFile,                //*In-Out Output file
+void synBasicExp(istream &inFile,                  //*In-Out* Input file
+  ostream &outFile,                 //*In-Out Output file
   SymTab   *st,                     //*In* Symbol table
   BasicExp *&bexp,                  //*Out* BExp parsed
   LexToken &lexToken,               //*In-Out* Current token
@@ -501,10 +839,13 @@ void synBasicExp(ifstream &inFile,                 //*In-Out* Input file
   DataType type1 = VOIDDATA;        // Type1 declaration and initialised
   DataType type2 = VOIDDATA;        // Type2 declaration and initialised
 
+  chargeNode(lexToken);
   bexp = new BasicExp;              // Creates a new BasicExp for bexp.
+  compileStats.nodes[NODEBASICEXP]++;
 
   bexp->term = NULL;                // Initialise term to null
   bexp->bexp = NULL;                // Initialise bexp to null
+  bexp->chain = -1;                 // Initialise chain to none
 
   type = VOIDDATA;                  // Initialise type to VOIDDATA
 
@@ -517,35 +858,32 @@ void synBasicExp(ifstream &inFile,                 //*In-Out* Input file
   {
     bexp->addOp = lexToken.addOp;
 
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
     synBasicExp(inFile, outFile, st, bexp->bexp, lexToken, type2);
 
+    // An operand already in error has been reported.
+    if ((type1 == ERRORDATA) || (type2 == ERRORDATA))
+      type1 = ERRORDATA;
     // Makes sure there is no type mismatch, if there is, throws
     // the correct case.
-    if (type1 != type2)
-      throw Report(206, lexToken);
-
-    // Checks to see if an addop is being used on a non-int,
-    // if so throws case
-    if (type1 != INTDATA)
+    else if (type1 != type2)
     {
-      if (bexp->addOp == "+")
-      {
-        throw Report(207, lexToken);
-      }
-      if (bexp->addOp == "-")
-      {
-        throw Report(208, lexToken);
-      }
+      semanticError(outFile, 206, lexToken);
+      type1 = ERRORDATA;
     }
-    // Check to see if or operator is being used on anything
-    // non-nool
-    if (type1 != BOOLDATA)
+    // Checks to see if an addop is being used on a non-int, or the or
+    // operator on anything non-bool, if so throws case
+    else if (((type1 != INTDATA) &&
+      ((bexp->addOp == "+") || (bexp->addOp == "-"))) ||
+      ((type1 != BOOLDATA) && (bexp->addOp == "||")))
     {
-      if (bexp->addOp == "||")
-      {
-        throw Report(209, lexToken);
-      }
+      if (bexp->addOp == "+")
+        semanticError(outFile, 207, lexToken);
+      else if (bexp->addOp == "-")
+        semanticError(outFile, 208, lexToken);
+      else
+        semanticError(outFile, 209, lexToken);
+      type1 = ERRORDATA;
     }
   }
 
@@ -556,8 +894,8 @@ void synBasicExp(ifstream &inFile,                 //*In-Out* Input file
 
 
 
-void synExpression(ifstream   &inFile,             // *In-Out* Input file
-  ofstream   &outFile,            // *In-Out Output file
+void synExpression(istream    &inFile,             // *In-Out* Input file
+  ostream    &outFile,            // *In-Out Output file
   SymTab     *st,                 // *In* Symbol table
   Expression *&expr,              // *Out* Expression parsed
   LexToken   &lexToken,           // *In-Out* Current token
@@ -576,7 +914,9 @@ void synExpression(ifstream   &inFile,             // *In-Out* Input file
   DataType type1 = VOIDDATA;            // Type1 declaration and initialised
   DataType type2 = VOIDDATA;            // Type2 declaration and initialised
 
+  chargeNode(lexToken);
   expr = new Expression;                // Creates new Expression for expr
+  compileStats.nodes[NODEEXPRESSION]++;
   expr->be1 = NULL;                     // Initialise be1 to null
   expr->be2 = NULL;                     // Initialise be2 to null
   type = VOIDDATA;                      // Set type to VOIDDATA
@@ -590,40 +930,43 @@ void synExpression(ifstream   &inFile,             // *In-Out* Input file
   {
     expr->relOp = lexToken.relOp;
 
-    lexAnal(inFile, outFile, lexToken);
+    nextToken(inFile, outFile, lexToken);
     synBasicExp(inFile, outFile, st, expr->be2, lexToken, type2);
 
-    // Checks for type mismatch if found throws report
-    if (type1 != type2)
-      throw Report(204, lexToken);
-
+    // Checks for type mismatch if found throws report. An operand
+    // already in error has been reported, and the comparison is a bool
+    // whatever its errors.
+    if ((type1 == ERRORDATA) || (type2 == ERRORDATA))
+      type1 = BOOLDATA;
+    else if (type1 != type2)
+      semanticError(outFile, 204, lexToken);
     // Checks if relOp is attempted to be used on STRINGDATA, if so
     // throws the appropriate report.
-    if (type1 == STRINGDATA)
+    else if (type1 == STRINGDATA)
     {
       if (expr->relOp == "==")
       {
-        throw Report(218, lexToken);
+        semanticError(outFile, 218, lexToken);
       }
       else if (expr->relOp == "!=")
       {
-        throw Report(219, lexToken);
+        semanticError(outFile, 219, lexToken);
       }
       else if (expr->relOp == ">")
       {
-        throw Report(220, lexToken);
+        semanticError(outFile, 220, lexToken);
       }
       else if (expr->relOp == "<")
       {
-        throw Report(221, lexToken);
+        semanticError(outFile, 221, lexToken);
       }
       else if (expr->relOp == ">=")
       {
-        throw Report(222, lexToken);
+        semanticError(outFile, 222, lexToken);
       }
       else if (expr->relOp == "<=")
       {
-        throw Report(223, lexToken);
+        semanticError(outFile, 223, lexToken);
       }
     }
 
@@ -1036,17 +1379,154 @@ void synExpression(ifstream   &inFile,             // *In-Out* Input file
 
 
 
+//***************************************************************************
+//Tree release subprograms.
+//***************************************************************************
+
+static void freeExpression(Expression *expr);      // *In* Expression
+
+
+
+void freeFactor(Factor *fact)                      // *In* Factor
+{ // Brackets and ! recurse; their depth is the program's nesting depth.
+
+  while (fact != NULL)
+  {
+    Factor *next = fact->nFactor;                 // ! operand
+
+    if (fact->bExp != NULL)
+      freeExpression(fact->bExp);
+    delete fact;
+    fact = next;
+  }
+} // freeFactor
+
+
+
+static void freeBasicExp(BasicExp *bexp)           // *In* BasicExp list
+{ // The term and basic expression lists are walked with loops.
+
+  while (bexp != NULL)
+  {
+    BasicExp *next = bexp->bexp;                  // Rest of the list
+    Term     *term = bexp->term;                  // Term list
+
+    while (term != NULL)
+    {
+      Term *rest = term->term;                    // Rest of the term
+
+      freeFactor(term->fact);
+      delete term;
+      term = rest;
+    }
+    delete bexp;
+    bexp = next;
+  }
+} // freeBasicExp
+
+
+
+static void freeExpression(Expression *expr)       // *In* Expression
+{ // Both sides.
+
+  freeBasicExp(expr->be1);
+  freeBasicExp(expr->be2);
+  delete expr;
+} // freeExpression
+
+
+
+static void freeShared(Expression *expr)           // *In* Expression DAG
+{ // The nodes of a DAG made by shareAST are found each once, with a
+  // worklist of the bracketed expressions rather than recursion, then
+  // deleted. A node already in nodes was reached before, and so was
+  // everything below it.
+
+  unordered_set<void *> nodes;                    // Every node found
+  vector<Expression *>  exprs;                    // Of each type
+  vector<BasicExp *>    bexps;
+  vector<Term *>        terms;
+  vector<Factor *>      factors;
+
+  exprs.push_back(expr);
+  nodes.insert(expr);
+  for (size_t e = 0; e < exprs.size(); e++)
+    for (BasicExp *bexp : { exprs[e]->be1, exprs[e]->be2 })
+      for (; bexp != NULL && nodes.insert(bexp).second; bexp = bexp->bexp)
+      {
+        bexps.push_back(bexp);
+        for (Term *term = bexp->term;
+          term != NULL && nodes.insert(term).second; term = term->term)
+        {
+          terms.push_back(term);
+          for (Factor *fact = term->fact;
+            fact != NULL && nodes.insert(fact).second; fact = fact->nFactor)
+          {
+            factors.push_back(fact);
+            if (fact->bExp != NULL && nodes.insert(fact->bExp).second)
+              exprs.push_back(fact->bExp);
+          }
+        }
+      }
+
+  for (Expression *e : exprs)
+    delete e;
+  for (BasicExp *bexp : bexps)
+    delete bexp;
+  for (Term *term : terms)
+    delete term;
+  for (Factor *fact : factors)
+    delete fact;
+} // freeShared
+
+
+
+void freeTrees(SymTab *st,                  // *In* Symbol table
+  AST *ast)                                        // *In* Abs syntax tree
+{ // Releases what synAnal built, so repeated compiles do not pile up
+  // memory.
+
+  while (st != NULL)
+  {
+    SymTab *next = st->next;                      // Next entry
+
+    delete st->initialise;
+    delete st;
+    st = next;
+  }
+
+  while (ast != NULL)
+  {
+    AST *next = ast->next;                        // Next statement
+
+    if (ast->expr != NULL && ast->shared)
+      freeShared(ast->expr);
+    else if (ast->expr != NULL)
+      freeExpression(ast->expr);
+    delete ast;
+    ast = next;
+  }
+} // freeTrees
+
+//***************************************************************************
+//End of tree release subprograms.
+//***************************************************************************
+
+
+
 //***************************************************************************
 //Syntax analysis subprogram.
 //***************************************************************************
 
-void synAnal(ifstream &inFile,                     //*In-Out* Input file
-  ofstream &outFile,                    //*In-Out Output file
+void synAnal(istream &inFile,                      //*In-Out* Input file
+  ostream &outFile,                     //*In-Out Output file
   SymTab   *&st,                        //*Out* Symbol table
   AST      *&ast,                       //*Out* Abs syntax tree
-  int      &label)                      //*In-Out* Label number
+  int      &label,                      //*In-Out* Label number
+  ParseMode mode)                       //*In* Where tokens are lexed
 { //Syntax analysis for C--. Calls skipWhiteComments to set things up
-  //for the lexer, call lexAnal to set lookahead correctly, sets
+  //for the lexer (or starts a lexer thread, which does), gets the first
+  //token to set lookahead correctly, sets
   //the SymTab and AST to NULL, sets the label number to 0, syntax analyses
   //the declarations and statements.
   //Returns the SymTab and AST which results if the syntax analysis is
@@ -1057,11 +1537,6 @@ void synAnal(ifstream &inFile,                     //*In-Out* Input file
   AST* stCheck;                             // Declare statement check
   bool isStValid = false;                   // Declare intialise stValid
 
-  //Call skipWhiteComments to set things up for the lexer ; call lexAnal
-  //to set lookahead up for synDeclarations.
-  skipWhiteComments(inFile);
-  lexAnal(inFile, outFile, lexToken);
-
   //Set SynTab and AST to NULL.
   st = NULL;
   ast = NULL;
@@ -1069,19 +1544,100 @@ void synAnal(ifstream &inFile,                     //*In-Out* Input file
   try //try-catch block for trapping syntax, static semantic and
     //type errors.
   {
-    while (lexToken.tag == LET)
-    //Parse the declarations.
-    synDec(inFile, outFile, st, lexToken);
+    //Call skipWhiteComments to set things up for the lexer, or start the
+    //lexer thread that does ; get a token to set lookahead up for
+    //synDeclarations. The budgets are counted from here.
+    startBudget();
+    if (mode == PARSEPIPELINED)
+      lexPipe = startLexPipe(inFile);
+    else
+      skipWhiteComments(inFile);
+    nextToken(inFile, outFile, lexToken);
 
-    lexAnal(inFile, outFile, lexToken);
+    //A recovering parse goes round again from a let or in that the
+    //tokens skipped after an error in the expression reached.
+    for (;;)
+    {
+      //Parse the declarations. synDec leaves the IN token in lexToken so
+      //lex past it before looking for the next LET. A recovering parse
+      //skips a bad declaration to its in, or to the next let or end.
+      while (lexToken.tag == LET)
+      {
+        PhaseTimer timer(PHASEDECL);        // Charged to synDec
+        TraceSpan  span("synDec");          // One span per declaration
+        AllocScope site(ALLOCSYMBOL);       // Allocations are symbols
+
+        try
+        {
+          synDec(inFile, outFile, st, lexToken);
+        }
+        catch (Report r)
+        {
+          if (recovery == NULL)
+            throw;
+
+          recordReport(outFile, r);
+          syncToken(inFile, outFile, lexToken, false);
+          if (lexToken.tag != IN)
+            continue;
+        }
+        nextToken(inFile, outFile, lexToken);
+      }
+
+      // Parse the statements.
+      if (ast == NULL)
+      {
+        {
+          AllocScope site(ALLOCNODE);       // The statement entry
+
+          ast = new AST;                    // Create the statement entry
+        }
+        compileStats.nodes[NODEAST]++;
+        ast->expr = NULL;                   // Initialise expr
+        ast->next = NULL;                   // Initialise next
+        ast->shared = false;                // Initialise shared
+      }
+      else if (ast->expr != NULL)
+      {
+        freeExpression(ast->expr);          // Expression gone round
+        ast->expr = NULL;
+      }
+
+      try
+      {
+        PhaseTimer timer(PHASEEXPR);        // Charged to expression
+        TraceSpan  span("synExpression");   // The whole expression
+        AllocScope site(ALLOCNODE);         // Allocations are nodes
+
+        synExpression(inFile, outFile, st, ast->expr, lexToken, type);
+
+        if (lexToken.tag != END)  // if lexToken.tag is not END
+        { // Throws error 8 "Expected end after expression." with lexToken
+          throw Report(8, lexToken);
+        }  // End of while
+      }
+      catch (Report r)
+      {
+        if (recovery == NULL)
+          throw;
+
+        recordReport(outFile, r);
+        syncToken(inFile, outFile, lexToken, false);
+      }
+      catch (Resync)
+      {
+        //lexToken holds the let, in or end the tokens were skipped to.
+      }
 
-    // Parse the statements.
-    synExpression(inFile, outFile, st, ast->expr, lexToken, type);
-    if (lexToken.tag != END)  // if lexToken.tag is not END
-    { // Throws error 8 "Expected end after expression." with lexToken
-      throw Report(8, lexToken);
-    }  // End of while
+      if (lexToken.tag == END)
+        break;
+      if (lexToken.tag == IN)
+        nextToken(inFile, outFile, lexToken);
+    }
 
+    //The lexer thread stops after the end token, leaving inFile as
+    //lexAnal would have.
+    endLexPipe();
     if (inFile)  // If lexToken.tag = END was not the last statement
     { // Throws error 9 "Unexpected Token after end." with lexToken
       throw Report(9, lexToken);
@@ -1089,48 +1645,75 @@ void synAnal(ifstream &inFile,                     //*In-Out* Input file
   }
   //Catch syntax, static semantic and type errors.
   //r contains the lexical token at which the error was discovered
-  //and the number of the error. This handler prints an error message to
-  //outFile and uses writeToken to print the lexical token to outFile.
-  //For a list of the error numbers and corresponding error message RTFC.
-  //Error numbers from 1 to 99 are for syntax errors; error numbers from
-  //101 to 199 are static semantic errors; error number from 201 to 299
-  //are for type errors.
+  //and the number of the error. This handler uses writeReport to print
+  //the error to outFile, or records it if the parse is recovering.
   catch (Report r)
   {
-    // If syntax error, output error type and error number
-    if ((r.getNumber() > minSyntaxError) &&
-      (r.getNumber() < maxSyntaxError))
-    {
-      outFile << "Syntax error " << r.getNumber();
-      outFile << ".\n";
-      outFile << syntax[r.getNumber() - minSyntaxError];
-    }
-    // If semantic error, output error type and error number
-    else if ((r.getNumber() > minStaticError) &&
-      (r.getNumber() < maxStaticError + minStaticError))
-    {
-      outFile << "Static semantic error " << r.getNumber();
-      outFile << ".\n";
-      outFile << statics[r.getNumber() - minStaticError];
-    }
-    // If type error, output error type and error number
-    else if ((r.getNumber() > minTypeError) &&
-      (r.getNumber() < maxTypeError + minTypeError))
+    if (recovery == NULL)
+      writeReport(outFile, r);
+    else
     {
-      outFile << "Type error " << r.getNumber();
-      outFile << ".\n";
-      outFile << type[r.getNumber() - minTypeError];
+      try
+      {
+        recordReport(outFile, r);
+      }
+      catch (GiveUp)
+      {
+        //It was the last the parse records anyway.
+      }
     }
-    // output unknown error type
-    else
-      outFile << "Unknown parse error.\n";
 
-    outFile << "Found : ";
-    writeToken(outFile, r.getLexToken());
-    outFile << endl;
+    // A failed parse leaves no AST for the caller to use. Every node is
+    // linked into the tree as it is made, with its children NULL, so the
+    // part built is released whole.
+    freeTrees(NULL, ast);
+    ast = NULL;
   } // catch report
+  catch (GiveUp)
+  {
+    //A recovering parse that found its last error.
+  }
+
+  //A recovering parse that found errors leaves no AST either.
+  if ((recovery != NULL) && !recovery->errors->empty())
+  {
+    freeTrees(NULL, ast);
+    ast = NULL;
+  }
+
+  //A failed parse can leave the lexer thread running ahead of it.
+  endLexPipe();
+
+  // Count the source read. The buffer is asked rather than the stream,
+  // as the stream has failed once the end of the file is read past.
+  streamoff read = inFile.rdbuf()->pubseekoff(0, ios::cur, ios::in);
+  if (read > 0)
+    compileStats.bytesRead += read;
 } //synAnal
 
+
+
+void synRecover(istream &inFile,                   //*In-Out* Input file
+  ostream &outFile,                     //*In-Out Output file
+  SymTab   *&st,                        //*Out* Symbol table
+  AST      *&ast,                       //*Out* Abs syntax tree
+  int      &label,                      //*In-Out* Label number
+  vector<Diagnostic> &errors,           //*Out* Errors found
+  int      maxErrors)                   //*In* Errors before giving up
+{ //synRecover runs synAnal with this thread's recovery state set, and
+  //with lexer errors thrown so that nextToken can record them.
+
+  Recovery      state;                            //Errors found
+
+  errors.clear();
+  state.errors = &errors;
+  state.maxErrors = (maxErrors < 1) ? 1 : maxErrors;
+
+  RecoveryScope scope(&state);                    //Until synAnal returns
+
+  synAnal(inFile, outFile, st, ast, label, PARSESEQUENTIAL);
+} //synRecover
+
 //***************************************************************************
 //End Of syntax analysis subprogram.
 //***************************************************************************
@@ -20,9 +20,12 @@ using namespace std;
 
 
 
-// Include standard string library and lexer header file for LexToken type.
-#include <string>  // Standard C++ strings library
-#include "lexer.h" // header for lexer.cxx
+// Include standard string library, lexer header file for LexToken type and
+// allocation statistics header file for AllocScope.
+#include <string>       // Standard C++ strings library
+#include <vector>       // Standard C++ vector library
+#include "lexer.h"      // header for lexer.cxx
+#include "allocstats.h" // header for allocstats.cxx
 
 
 // Forward declaration of structs for the Abstract Syntax Tree (AST) and
@@ -44,8 +47,16 @@ struct SymTab;                                // Symbol Table
 // The different kinds of SCL data types. VOIDDATA is included
 // to allow a DataType variable to be initialised to a value which
 // is not a possible type for a variable/constant in SCL. Its major
-// use is when parsing a factor (see below).
-enum DataType { VOIDDATA, BOOLDATA, STRINGDATA, INTDATA, FLOATDATA };
+// use is when parsing a factor (see below). ERRORDATA is the type of a
+// factor synRecover has found an error in, so that the expressions round it
+// report nothing more; it is never left in a tree a parse returns.
+enum DataType { VOIDDATA, BOOLDATA, STRINGDATA, INTDATA, FLOATDATA,
+  ERRORDATA };
+
+// How synAnal gets its tokens. PARSESEQUENTIAL calls lexAnal as each token
+// is wanted; PARSEPIPELINED lexes on a thread of its own ahead of the
+// parse (see lexpipe.h).
+enum ParseMode { PARSESEQUENTIAL, PARSEPIPELINED };
 
 
 
@@ -56,11 +67,14 @@ enum DataType { VOIDDATA, BOOLDATA, STRINGDATA, INTDATA, FLOATDATA };
 // Each SymTab entry contains the variable or constant identifier, its type,
 // whether it's a constant, a pointer to its initialisation literal (or NULL)
 // and a pointer to the rest of the entries in the table (or NULL).
+// The slot is the position of the declaration in source order (0 for the
+// first let) and is used by the evaluators to index their binding arrays.
 struct SymTab                                       // Symbol Table
 {
   string     ident;                          // Var name
   DataType   type;                          // Var type
   Factor     *initialise;                          // Initialisation literal
+  int        slot;                          // Declaration order slot
   SymTab     *next;                          // Rest of entries
 }; // SymTab
 
@@ -72,10 +86,13 @@ struct SymTab                                       // Symbol Table
 // Each AST entry contains a pointer to a structure representing a statement
 // (assignment, if, while, input or output) and a pointer to the entry for
 // the rest of the statements (or NULL).
+// shared is set once shareAST has made the expression a DAG (see
+// hashcons.h).
 struct AST                                         // AST for statements
 {
   Expression  *expr;                              // Expression to assign
   AST         *next;                              // Rest of statements
+  bool        shared;                             // Expression is a DAG
 }; // AST
 
 
@@ -94,11 +111,14 @@ struct Expression                                  // Expressions
 // A basic expression is a pointer to a term, potentially followed
 // by zero or more - i.e. a list - of additional operators and terms. If there
 // are no further operators and terms bexp is set to NULL.
+// chain is the number of the || chain headed here, given by the adaptive
+// evaluator (see adaptive.h), or -1.
 struct BasicExp                                     // Basic expression
 {
   Term     *term;                           // First Term
   string   addOp;                           // Addition operator
   BasicExp *bexp;                           // List of terms
+  int      chain;                           // Adaptive chain, or -1
 }; // BasicExp
 
 
@@ -106,11 +126,13 @@ struct BasicExp                                     // Basic expression
 // A term is a pointer to a factor followed by zero or more - i.e. a list -
 // of multiplicative operators and factors. If there are no further operators
 // and factors term is set to NULL.
+// chain is the number of the && chain headed here, as for BasicExp.
 struct Term                                        // Term
 {
   Factor *fact;                            // First factor
   string mulOp;                            // Multiplicative operator
   Term   *term;                            // List of factors
+  int    chain;                            // Adaptive chain, or -1
 }; // Term
 
 
@@ -163,6 +185,8 @@ public:
   Report(int n,                                  // *In* number value
     LexToken lT)                            // *In* lexToken value
   {
+    AllocScope site(ALLOCREPORT);           // Charge the copy to reports
+
     number = n;                            // Copy parameters
     lexToken = lT;                            // into data members
   }
@@ -185,9 +209,11 @@ public:
 const int maxSyntaxError = 10;                   // Nmr of syntax errors
 const int maxStaticError = 4;                   // Nmr of static errors
 const int maxTypeError = 20;                   // Nmr of type errors
+const int maxLimitError = 8;                   // Nmr of limit errors
 const int minSyntaxError = 0;                   // First syntax error
 const int minStaticError = 100;                   // First static error
 const int minTypeError = 200;                   // First type error
+const int minLimitError = 400;                   // First limit error
 
 const string syntax[maxSyntaxError]                // Syntax error messages
 = { "Not a syntax error.\n",                                        //  0
@@ -246,25 +272,98 @@ const string type[maxTypeError]                  // Type error messages
 "Unknown type error.\n"
 };
 
+// Breaches of the compile's budgets (see budget.h). 401, 402 and 406 are
+// found by the lexer, which writes them itself.
+const string limits[maxLimitError]               // Limit error messages
+= { "Not a limit error.\n",                                         // 400
+
+"Source is larger than the byte budget.\n",                     // 401
+"More tokens than the token budget.\n",                         // 402
+"More nodes than the node budget.\n",                           // 403
+"More declarations than the symbol budget.\n",                  // 404
+"Nested deeper than the depth budget.\n",                       // 405
+"Compile ran past the time budget.\n",                          // 406
+
+"Unknown limit error.\n"
+};
+
 
 // synAnal parses a complete SCL program. Calls skipWhiteComments to set
 // things up for the lexer, then parses the declarations and statements.
 // Returns the SymTab and AST which results if the parse is
-// successful and terminates with an error message otherwise.
-void synAnal(ifstream &inFile,                    // *In-Out* Input file
-  ofstream &outFile,                   // *In-Out* Output file
+// successful. Otherwise writes an error message and sets ast to NULL.
+// Either mode gives the same result, listing and exit code. The compile is
+// held to this thread's budgets (see budget.h).
+void synAnal(istream &inFile,                     // *In-Out* Input file
+  ostream &outFile,                    // *In-Out* Output file
+  SymTab *&st,                         // *Out* Symbol table
+  AST *&ast,                           // *Out* Abs syntax tree
+  int &label,                          // *In-Out* Label number
+  ParseMode mode = PARSESEQUENTIAL);   // *In* Where tokens are lexed
+
+
+
+// A Diagnostic is one error found by synRecover: a Report, with its number
+// and offending token, or a lexer error, with its message (which may be
+// NULL, as lexFail's may) and number 0. code is the exit code scl gives
+// for the error: 1 for a Report and lexFail's code for a lexer error.
+struct Diagnostic                                  // Error found
+{
+  int        number;                              // Report number, or 0
+  LexToken   lexToken;                            // Offending token
+  const char *message;                            // Lexer error message
+  int        code;                                // Exit code
+}; // Diagnostic
+
+// Errors synRecover records by default before it gives up.
+const int defaultMaxErrors = 100;
+
+// synRecover parses a complete SCL program as synAnal does, but where
+// synAnal stops at the first error synRecover records it and recovers in
+// panic mode, so that one pass finds every error. Tokens are skipped to
+// the ) closing the bracket the error is in, or to the next let, in or
+// end, and the parse goes on from there. Type errors and undeclared
+// identifiers need no tokens skipped. A bad character is recorded and
+// lexing goes on after it. Each error is written to outFile as synAnal or
+// the lexer would write it, and errors holds them in the order found.
+// The parse gives up after maxErrors of them, or at the end of the file.
+// ast is NULL if there were any. Tokens are always lexed on this thread.
+void synRecover(istream &inFile,                  // *In-Out* Input file
+  ostream &outFile,                    // *In-Out* Output file
   SymTab *&st,                         // *Out* Symbol table
   AST *&ast,                           // *Out* Abs syntax tree
-  int &label);                        // *In-Out* Label number
+  int &label,                          // *In-Out* Label number
+  vector<Diagnostic> &errors,          // *Out* Errors found
+  int maxErrors = defaultMaxErrors);   // *In* Errors before giving up
+
+
+
+// freeTrees deletes a symbol table and AST built by synAnal. Either may be
+// NULL. After a failed parse only the symbol table is left to delete. The
+// nodes of a shared AST are each deleted once.
+void freeTrees(SymTab *st,                         // *In* Symbol table
+  AST *ast);                                       // *In* Abs syntax tree
+
+// freeFactor deletes a Factor of an unshared AST and everything below it,
+// for passes that drop part of a tree.
+void freeFactor(Factor *fact);                     // *In* Factor
 
 
 
 // Prints out the Symbol Table to cout.
-void printST(ofstream &outFile,                    // *In-Out* Output file
+void printST(ostream &outFile,                     // *In-Out* Output file
   SymTab   *st);                       // *In* Symbol table
 
 // Prints the Abstract Syntax Tree to cout.
-void printAST(ofstream &outFile,                   // *In-Out* Output file
+void printAST(ostream &outFile,                    // *In-Out* Output file
+  AST *ast);                           // *In* Abs syntax tree
+
+// The same into an OutSink, so that a caller printing several things to
+// one file buffers them all together.
+void printST(OutSink &outFile,                     // *In-Out* Output sink
+  SymTab   *st);                       // *In* Symbol table
+
+void printAST(OutSink &outFile,                    // *In-Out* Output sink
   AST *ast);                           // *In* Abs syntax tree
 
 
@@ -0,0 +1,186 @@
+// Title   : tokengen.cxx
+// Purpose : Lazy token generator subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Every source is lexed through an istream, as lexAnal reads, so a buffer
+// and a chunk source are given stream buffers of their own: one over the
+// caller's bytes, and one that asks for the next chunk when the lexer has
+// used the last. The coroutine frame owns them, and the token, so nothing
+// lives longer than the generator.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <memory>            // unique_ptr
+#include <ostream>           // Unused error stream
+#include <string.h>          // memmove
+#include <utility>           // move
+#include <vector>            // Chunk buffer
+#include "tokengen.h"        // header for tokengen.cxx
+
+
+
+// Bytes asked of a chunk source at a time, and bytes of the last chunk kept
+// in front of the next so skipWhiteComments can put back what it read.
+const size_t chunkSize = 65536;
+const size_t putbackSize = 16;
+
+
+
+// A stream buffer over the caller's bytes.
+class MemoryBuf : public streambuf                 // Buffer source
+{
+public:
+  MemoryBuf(const char *data,                      // *In* Source text
+    size_t size)                                   // *In* Its length
+  { // The bytes are only read; putting back a byte read does not write it.
+    char *start = const_cast<char *>(data);       // Start of the text
+
+    setg(start, start, start + size);
+  }
+}; // class MemoryBuf
+
+
+
+// A stream buffer that reads from a chunk source.
+class ChunkBuf : public streambuf                  // Chunk source
+{
+private:
+  function<size_t(char *, size_t)> read;         // Chunk source
+  vector<char> buffer;                            // Kept bytes and chunk
+public:
+  ChunkBuf(function<size_t(char *, size_t)> source) // *In* Chunk source
+    : read(move(source)), buffer(putbackSize + chunkSize)
+  {
+    setg(&buffer[putbackSize], &buffer[putbackSize], &buffer[putbackSize]);
+  }
+protected:
+  int_type underflow()
+  { // Moves the last bytes read to the front and reads the next chunk
+    // after them. At the end the bytes kept can still be put back.
+
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+
+    size_t kept = gptr() - eback();               // Bytes kept
+    char   *chunk = &buffer[putbackSize];         // Where chunks go
+
+    if (kept > putbackSize)
+      kept = putbackSize;
+    memmove(chunk - kept, gptr() - kept, kept);
+    size_t got = read(chunk, chunkSize);          // Bytes read
+
+    setg(chunk - kept, chunk, chunk + got);
+    if (got == 0)
+      return traits_type::eof();
+    return traits_type::to_int_type(*chunk);
+  } // underflow
+}; // class ChunkBuf
+
+
+
+// Sets lexThrows while lexAnal runs, so a lexer error is thrown to the
+// caller rather than exiting, and restores it however lexAnal leaves.
+class ThrowScope                                   // Scoped lexThrows
+{
+private:
+  bool outer;                                     // Value restored
+public:
+  ThrowScope() { outer = lexThrows; lexThrows = true; }
+  ~ThrowScope() { lexThrows = outer; }
+}; // class ThrowScope
+
+
+
+static TokenGenerator lexSource(istream *stream,   // *In-Out* Source or null
+  unique_ptr<streambuf> owned)                     // *In* Buffer if no stream
+{ // The coroutine behind every lexTokens. It lexes stream, or a stream on
+  // owned if stream is null, a token each time it is resumed. lexAnal
+  // writes no errors while lexThrows is set, so its error stream has no
+  // buffer.
+
+  istream  ownStream(owned.get());                // Stream on owned
+  istream  &in = stream != NULL ? *stream : ownStream; // Source
+  ostream  noFile(NULL);                          // Unused error stream
+  LexToken token = LexToken();                    // Token lexed
+
+  skipWhiteComments(in);
+  do
+  {
+    {
+      ThrowScope throwing;                        // Errors thrown
+
+      lexAnal(in, noFile, token);
+    }
+    co_yield token;
+  } while (token.tag != END);
+} // lexSource
+
+
+
+TokenGenerator lexTokens(istream &in)              // *In-Out* Source
+{
+  return lexSource(&in, NULL);
+} // lexTokens
+
+TokenGenerator lexTokens(const char *data,         // *In* Source text
+  size_t size)                                     // *In* Its length
+{
+  return lexSource(NULL, make_unique<MemoryBuf>(data, size));
+} // lexTokens
+
+TokenGenerator lexTokens(
+  function<size_t(char *buffer, size_t size)> read) // *In* Chunk source
+{
+  return lexSource(NULL, make_unique<ChunkBuf>(move(read)));
+} // lexTokens
+
+
+
+TokenGenerator::TokenGenerator(TokenGenerator &&other) noexcept // *In-Out*
+  : handle(other.handle)
+{
+  other.handle = NULL;
+} // TokenGenerator
+
+TokenGenerator &TokenGenerator::operator=(TokenGenerator &&other) noexcept
+{ // *In-Out* other, moved from.
+
+  if (this != &other)
+  {
+    if (handle)
+      handle.destroy();
+    handle = other.handle;
+    other.handle = NULL;
+  }
+  return *this;
+} // operator=
+
+TokenGenerator::~TokenGenerator()
+{ // Destroying the frame destroys the token and any buffer it owns.
+
+  if (handle)
+    handle.destroy();
+} // ~TokenGenerator
+
+
+
+bool TokenGenerator::next()
+{ // A lexer error ends the coroutine, which is left at its final suspend
+  // with the error; it is thrown once and the generator is then done.
+
+  if (!handle || handle.done())
+    return false;
+  handle.resume();
+
+  exception_ptr error = handle.promise().error;   // Lexer error thrown
+
+  if (error)
+  {
+    handle.promise().error = NULL;
+    rethrow_exception(error);
+  }
+  return !handle.done();
+} // next
@@ -0,0 +1,136 @@
+// Title   : tokengen.h
+// Purpose : Lazy token generator header file for SCL. Lexes a buffer, a
+//           stream or a source of chunks one token at a time, as the
+//           caller asks for them, with a C++20 coroutine.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef TOKENGEN_H
+#define TOKENGEN_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the coroutine, exception, function, stream and iterator
+// libraries and the lexer header file for LexToken and LexError.
+#include <coroutine>       // Coroutine handles
+#include <exception>       // exception_ptr
+#include <functional>      // Chunk sources
+#include <istream>         // Standard input streams
+#include <iterator>        // default_sentinel_t
+#include <stddef.h>        // size_t
+#include "lexer.h"         // header for lexer.cxx
+
+
+
+// A TokenGenerator lexes its source as its tokens are asked for, so a
+// caller that wants only the first few tokens of a file reads only the
+// first few blocks of it and holds one token at a time. It stops after the
+// END token. Tokens are lexed by lexAnal, skipping white space and comments
+// before the first as synAnal does, and are made exactly as lexAnal makes
+// them: a field the token does not set keeps its value from the token
+// before, which is the same LexToken each time.
+//
+// A lexer error does not exit: next, or ++ on an iterator, throws it as a
+// LexError with lexAnal's message and exit code, and the generator is then
+// done. The message is null for an integer literal out of range (code 3).
+//
+//     TokenGenerator tokens = lexTokens(inFile);
+//
+//     for (const LexToken &token : tokens)
+//       if (token.tag == IN)
+//         break;
+//
+// The generator runs on the thread that asks for its tokens, and is charged
+// to its compile statistics. It can be moved but not copied.
+class TokenGenerator                               // Lazy token stream
+{
+public:
+  // The coroutine's state: the token last yielded and any error thrown.
+  struct promise_type                              // Coroutine promise
+  {
+    const LexToken *token = NULL;                 // Token last yielded
+    exception_ptr  error;                         // Lexer error thrown
+
+    TokenGenerator get_return_object()
+    {
+      return TokenGenerator(
+        coroutine_handle<promise_type>::from_promise(*this));
+    }
+    suspend_always initial_suspend() noexcept { return {}; }
+    suspend_always final_suspend() noexcept { return {}; }
+    suspend_always yield_value(const LexToken &next) // *In* Token lexed
+    {
+      token = &next;
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() { error = current_exception(); }
+  }; // promise_type
+
+  // Walks the tokens left, for a range for. ++ lexes the next one.
+  class iterator                                   // Token iterator
+  {
+  private:
+    TokenGenerator *gen;                          // Null once done
+  public:
+    iterator(TokenGenerator *from) : gen(from) {} // *In* Generator or null
+    const LexToken &operator*() const { return gen->token(); }
+    iterator &operator++()
+    {
+      if (!gen->next())
+        gen = NULL;
+      return *this;
+    }
+    bool operator==(default_sentinel_t) const { return gen == NULL; }
+  }; // class iterator
+
+private:
+  coroutine_handle<promise_type> handle;          // The lexing coroutine
+
+  TokenGenerator(coroutine_handle<promise_type> from) : handle(from) {}
+
+public:
+  // Class constructors, assignment and destructor. Destroying a generator
+  // that is not done leaves its source where the last token left it.
+  TokenGenerator(TokenGenerator &&other) noexcept; // *In-Out* Moved from
+  TokenGenerator &operator=(TokenGenerator &&other) noexcept; // *In-Out*
+  TokenGenerator(const TokenGenerator &) = delete;
+  TokenGenerator &operator=(const TokenGenerator &) = delete;
+  ~TokenGenerator();
+
+  // next lexes the next token. Returns false, with no token, once the
+  // END token has been returned. Throws a LexError on a lexer error.
+  bool next();
+
+  // token is the token the last successful next returned.
+  const LexToken &token() const { return *handle.promise().token; }
+
+  // begin lexes the first token not yet returned.
+  iterator begin() { return iterator(next() ? this : NULL); }
+  default_sentinel_t end() { return default_sentinel; }
+}; // class TokenGenerator
+
+
+
+// lexTokens returns a generator over the tokens of in, which must outlive
+// it. in is left just past the last token returned and the white space
+// and comments after it, so a caller that stops early can go on reading.
+TokenGenerator lexTokens(istream &in);             // *In-Out* Source
+
+// lexTokens returns a generator over the tokens of the size bytes at data,
+// which must outlive it. Nothing is copied.
+TokenGenerator lexTokens(const char *data,         // *In* Source text
+  size_t size);                                    // *In* Its length
+
+// lexTokens returns a generator over the tokens of the text read calls
+// give it. Each call fills up to size bytes at buffer and returns how many
+// it filled, 0 at the end of the text, and is only made when the lexer
+// has used the text it had. Tokens may span chunks.
+TokenGenerator lexTokens(
+  function<size_t(char *buffer, size_t size)> read); // *In* Chunk source
+
+
+#endif
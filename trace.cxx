@@ -0,0 +1,223 @@
+// Title   : trace.cxx
+// Purpose : Trace event subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Each thread appends to a buffer of its own, so recording a span takes no
+// lock. The buffers are owned by a list shared by all threads rather than
+// by the threads themselves, so a worker's spans outlive the worker; the
+// list's lock is only taken when a thread records its first span and when
+// the trace is written.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <fstream>         // Standard file I/O
+#include <mutex>           // Buffer list lock
+#include <string>          // Standard C++ strings library
+#include <unistd.h>        // getpid
+#include <vector>          // Standard C++ vector library
+#include "trace.h"         // header for trace.cxx
+#include "outsink.h"       // header for outsink.cxx
+#include "jsondump.h"      // header for jsondump.cxx (jsonString)
+
+
+
+// A finished span.
+struct TraceEvent                                  // Recorded span
+{
+  const char *name;                               // Span name
+  const char *file;                               // File being worked on
+  long long  start;                               // Start (ns)
+  long long  end;                                 // End (ns)
+}; // TraceEvent
+
+// One thread's spans. tid numbers the threads from 1 in the order they
+// first record a span.
+struct TraceBuffer                                 // Per thread spans
+{
+  int                tid;                         // Thread number
+  string             name;                        // Thread name
+  vector<TraceEvent> events;                      // Spans recorded
+  long long          fine;                        // Fine spans seen
+  long long          dropped;                     // Fine spans not kept
+}; // TraceBuffer
+
+
+
+bool traceOn = false;                              // Spans being recorded
+
+static long long                  traceStart = 0;  // Time zero
+static mutex                      traceLock;       // Guards traceBuffers
+static vector<TraceBuffer *>      traceBuffers;    // Every thread's buffer
+static thread_local TraceBuffer   *traceBuffer = NULL; // This thread's
+static thread_local const char    *traceFile = ""; // This thread's file
+
+
+
+//***************************************************************************
+//Recording subprograms.
+//***************************************************************************
+
+void startTrace()
+{ // Time zero is now.
+
+  traceStart = statsClock();
+  traceOn = true;
+} // startTrace
+
+
+
+void setTraceFile(const char *file)                // *In* File name
+{ // Later spans on this thread are tagged with file.
+
+  traceFile = file;
+} // setTraceFile
+
+
+
+const char *traceFileName()
+{ // This thread's file.
+
+  return traceFile;
+} // traceFileName
+
+
+
+static TraceBuffer *threadBuffer()
+{ // This thread's buffer, made and listed the first time it is needed.
+
+  if (traceBuffer == NULL)
+  {
+    lock_guard<mutex> guard(traceLock);
+
+    traceBuffer = new TraceBuffer;
+    traceBuffer->tid = (int)traceBuffers.size() + 1;
+    traceBuffer->fine = 0;
+    traceBuffer->dropped = 0;
+    traceBuffers.push_back(traceBuffer);
+  }
+  return traceBuffer;
+} // threadBuffer
+
+
+
+void nameTraceThread(const string &name)           // *In* Thread name
+{ // Nothing is kept when tracing is off, so untraced threads cost no
+  // buffer.
+
+  if (!traceOn)
+    return;
+
+  TraceBuffer *buffer = threadBuffer();           // This thread's
+
+  lock_guard<mutex> guard(traceLock);
+  buffer->name = name;
+} // nameTraceThread
+
+
+
+void addTraceSpan(const char *name,                // *In* Span name
+  long long start,                                 // *In* Start (ns)
+  long long end,                                   // *In* End (ns)
+  TraceGrain grain)                                // *In* Span grain
+{ // Fine spans past the limit are only counted.
+
+  TraceBuffer *buffer = threadBuffer();           // This thread's
+  TraceEvent  event;                              // Span to keep
+
+  if (grain == TRACEFINE && buffer->fine++ >= traceFineLimit)
+  {
+    buffer->dropped++;
+    return;
+  }
+
+  event.name = name;
+  event.file = traceFile;
+  event.start = start;
+  event.end = end;
+  buffer->events.push_back(event);
+} // addTraceSpan
+
+//***************************************************************************
+//End of recording subprograms.
+//***************************************************************************
+
+
+
+//***************************************************************************
+//Output subprograms.
+//***************************************************************************
+
+static void writeMicros(OutSink &out,              // *In-Out* Output sink
+  long long nanos)                                 // *In* Time (ns)
+{ // Writes nanos as microseconds with three decimal places.
+
+  int frac = (int)(nanos % 1000);                 // Nanoseconds over
+
+  out << nanos / 1000 << '.'
+      << (char)('0' + frac / 100) << (char)('0' + frac / 10 % 10)
+      << (char)('0' + frac % 10);
+} // writeMicros
+
+
+
+bool writeTrace(const char *path)                  // *In* Trace file name
+{ // Metadata naming each thread comes before its spans. Spans are written
+  // in the order they finished, which viewers do not mind.
+
+  ofstream file;                                  // Trace file
+  int      pid = (int)getpid();                   // Process id
+  bool     first = true;                          // No event written yet
+
+  file.open(path);
+  if (!file)
+    return false;
+
+  {
+    OutSink out(file);                            // Buffered trace
+
+    lock_guard<mutex> guard(traceLock);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (size_t b = 0; b < traceBuffers.size(); b++)
+    {
+      TraceBuffer *buffer = traceBuffers[b];      // Thread to write
+
+      if (!first)
+        out << ',';
+      first = false;
+      out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+          << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+      if (buffer->name.empty())
+        jsonString(out, "thread " + to_string(buffer->tid));
+      else
+        jsonString(out, buffer->name);
+      out << ",\"dropped\":" << buffer->dropped << "}}";
+
+      for (size_t e = 0; e < buffer->events.size(); e++)
+      {
+        TraceEvent &event = buffer->events[e];    // Span to write
+
+        out << ",\n{\"name\":\"" << event.name
+            << "\",\"cat\":\"scl\",\"ph\":\"X\",\"ts\":";
+        writeMicros(out, event.start - traceStart);
+        out << ",\"dur\":";
+        writeMicros(out, event.end - event.start);
+        out << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+            << ",\"args\":{\"file\":";
+        jsonString(out, event.file);
+        out << "}}";
+      }
+    }
+    out << "\n]}\n";
+  }
+
+  file.close();
+  return !file.fail();
+} // writeTrace
+
+//***************************************************************************
+//End of output subprograms.
+//***************************************************************************
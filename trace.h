@@ -0,0 +1,98 @@
+// Title   : trace.h
+// Purpose : Trace event header file for SCL. Records spans of the compile
+//           and of evaluation for a Chrome or Perfetto trace viewer.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef TRACE_H
+#define TRACE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include the string library and the statistics header file for the
+// monotonic clock.
+#include <string>          // Standard C++ strings library
+#include "stats.h"         // header for stats.cxx
+
+
+
+// A span is a named stretch of one thread's time, tagged with the file
+// the thread is working on. Spans are kept in memory, one buffer per
+// thread, and written by writeTrace as Chrome trace-event JSON:
+//
+//     {"traceEvents":[
+//       {"name":"synDec","cat":"scl","ph":"X","ts":12.5,"dur":3.25,
+//        "pid":4242,"tid":1,"args":{"file":"prog.scl"}},
+//       ...]}
+//
+// with times in microseconds from startTrace. Spans opened inside another
+// span on the same thread nest inside it in the viewer.
+//
+// Fine spans (one per token) are only kept for the first traceFineLimit
+// per thread, so a large program still gives a trace a viewer can open;
+// the number dropped is written in the thread's metadata. Other spans are
+// always kept.
+const long long traceFineLimit = 100000;
+
+enum TraceGrain { TRACECOARSE, TRACEFINE };
+
+
+
+// traceOn is set by startTrace. Spans cost a test of it when tracing is
+// off.
+extern bool traceOn;
+
+// startTrace turns tracing on and sets time zero. It must be called before
+// any thread that is to be traced starts.
+void startTrace();
+
+// setTraceFile names the file this thread's spans are tagged with. The
+// name is not copied and must outlive the trace. traceFileName returns it.
+void setTraceFile(const char *file);               // *In* File name
+const char *traceFileName();
+
+// nameTraceThread names this thread in the viewer. It does nothing unless
+// tracing is on.
+void nameTraceThread(const string &name);          // *In* Thread name
+
+// writeTrace writes the spans of every thread to path. Returns false if
+// the file cannot be written. No spans may be open on other threads.
+bool writeTrace(const char *path);                 // *In* Trace file name
+
+// addTraceSpan records a finished span on this thread.
+void addTraceSpan(const char *name,                // *In* Span name
+  long long start,                                 // *In* Start (ns)
+  long long end,                                   // *In* End (ns)
+  TraceGrain grain);                               // *In* Span grain
+
+
+
+// A TraceSpan records the time from its construction to its destruction
+// as a span called name, which must be a string literal.
+class TraceSpan                                    // Scoped trace span
+{
+private:
+  const char *name;                               // Span name
+  long long  start;                               // Start, 0 if off
+  TraceGrain grain;                               // Span grain
+public:
+  // Class constructor and destructor.
+  TraceSpan(const char *spanName,                  // *In* Span name
+    TraceGrain spanGrain = TRACECOARSE)            // *In* Span grain
+  {
+    name = spanName;
+    grain = spanGrain;
+    start = traceOn ? statsClock() : 0;
+  }
+  ~TraceSpan()
+  {
+    if (start != 0)
+      addTraceSpan(name, start, statsClock(), grain);
+  }
+}; // class TraceSpan
+
+
+#endif
@@ -0,0 +1,171 @@
+// Title   : wire.cxx
+// Purpose : Compile daemon protocol subprograms for SCL.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+// Sends use MSG_NOSIGNAL, so writing to a connection the other end has
+// closed fails with EPIPE rather than killing the process with SIGPIPE.
+
+
+//Using standard libraries.
+using namespace std;
+
+#include <errno.h>           // errno, EINTR
+#include <string.h>          // strerror, strlen
+#include <sys/socket.h>      // Sockets
+#include <sys/un.h>          // Unix socket addresses
+#include <unistd.h>          // close
+#include "wire.h"            // header for wire.cxx
+
+
+
+static bool sendAll(int fd,                        // *In* Socket
+  const void *data,                                // *In* Bytes to send
+  size_t size)                                     // *In* Byte count
+{ // Sends until every byte has gone.
+
+  const char *next = (const char *)data;          // Next byte to send
+
+  while (size > 0)
+  {
+    ssize_t sent = send(fd, next, size, MSG_NOSIGNAL); // Bytes sent
+
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent <= 0)
+      return false;
+    next += sent;
+    size -= sent;
+  }
+  return true;
+} // sendAll
+
+
+
+static bool readAll(int fd,                        // *In* Socket
+  void *data,                                      // *Out* Bytes read
+  size_t size)                                     // *In* Byte count
+{ // Reads exactly size bytes.
+
+  char *next = (char *)data;                      // Where the next go
+
+  while (size > 0)
+  {
+    ssize_t got = recv(fd, next, size, 0);        // Bytes read
+
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return false;
+    next += got;
+    size -= got;
+  }
+  return true;
+} // readAll
+
+
+
+static bool sendText(int fd,                       // *In* Socket
+  const string &text)                              // *In* Text sent
+{ // The length, then the text.
+
+  uint32_t length = (uint32_t)text.size();        // Text length
+
+  if (text.size() > wireLimit)
+    return false;
+  return sendAll(fd, &length, sizeof length) &&
+    sendAll(fd, text.data(), text.size());
+} // sendText
+
+
+
+static bool readText(int fd,                       // *In* Socket
+  string &text)                                    // *Out* Text read
+{ // The length, then the text. text keeps its capacity between calls.
+
+  uint32_t length;                                // Text length
+
+  if (!readAll(fd, &length, sizeof length) || length > wireLimit)
+    return false;
+  text.resize(length);
+  return length == 0 || readAll(fd, &text[0], length);
+} // readText
+
+
+
+int connectDaemon(const char *path,                // *In* Socket path
+  string &why)                                     // *Out* Reason if not
+{ // A path too long for a socket address is refused.
+
+  sockaddr_un address;                            // Daemon's address
+  int         fd;                                 // Socket
+
+  memset(&address, 0, sizeof address);
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof address.sun_path)
+  {
+    why = "socket path too long";
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof address) != 0)
+  {
+    why = strerror(errno);
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  return fd;
+} // connectDaemon
+
+
+
+bool sendRequest(int fd,                           // *In* Socket
+  WireKind kind,                                   // *In* Request kind
+  const string &text)                              // *In* Source or path
+{
+  char byte = (char)kind;                         // Kind on the wire
+
+  return sendAll(fd, &byte, 1) && sendText(fd, text);
+} // sendRequest
+
+
+
+bool readRequest(int fd,                           // *In* Socket
+  char &kind,                                      // *Out* Request kind
+  string &text)                                    // *Out* Source or path
+{ // kind is 0 if the connection closed before the request began.
+
+  if (!readAll(fd, &kind, 1))
+  {
+    kind = 0;
+    return false;
+  }
+  return readText(fd, text);
+} // readRequest
+
+
+
+bool sendReply(int fd,                             // *In* Socket
+  const WireReply &reply)                          // *In* Reply
+{
+  int32_t status = reply.status;                  // Status on the wire
+
+  return sendAll(fd, &status, sizeof status) &&
+    sendText(fd, reply.listing) && sendText(fd, reply.errors);
+} // sendReply
+
+
+
+bool readReply(int fd,                             // *In* Socket
+  WireReply &reply)                                // *Out* Reply
+{
+  int32_t status;                                 // Status on the wire
+
+  if (!readAll(fd, &status, sizeof status))
+    return false;
+  reply.status = status;
+  return readText(fd, reply.listing) && readText(fd, reply.errors);
+} // readReply
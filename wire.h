@@ -0,0 +1,83 @@
+// Title   : wire.h
+// Purpose : Compile daemon protocol header file for SCL. Frames the
+//           requests and replies sent over the daemon's Unix socket.
+// Author  : Matthew Jacques
+// Date    : 19/10/26
+
+#ifndef WIRE_H
+#define WIRE_H
+
+
+
+// Using standard libraries.
+using namespace std;
+
+// Include fixed size integer and standard string libraries.
+#include <stdint.h>        // Fixed size integers
+#include <string>          // Standard C++ strings library
+
+
+
+// A connection carries any number of requests, each answered with a reply
+// before the next is read. All integers are in the host's byte order, as
+// both ends are on the same machine.
+//
+//     request : kind (1 byte), length (4 bytes), length bytes of text
+//     reply   : status (4 bytes), listing length (4 bytes), listing,
+//               errors length (4 bytes), errors
+//
+// The text of a WIRESOURCE request is an SCL program; of a WIREPATH
+// request, the name of a file holding one, opened by the daemon. A
+// WIRESTOP request has no text; the daemon replies, then stops. Neither
+// is checked against who sent it, so the socket must only be reachable by
+// those trusted as the daemon's user (see runDaemon). The reply's
+// status is the exit code scl would have given, its listing what scl would
+// have written to the output file and its errors what scl would have
+// written to cerr.
+enum WireKind {
+  WIRESOURCE = 'S',                                // Program text
+  WIREPATH = 'P',                                  // Program file name
+  WIRESTOP = 'X'                                   // Stop the daemon
+}; // WireKind
+
+// The longest text either end will read, so a bad length cannot make the
+// other end allocate without limit.
+const uint32_t wireLimit = 1u << 28;
+
+
+
+// A reply.
+struct WireReply                                   // Daemon reply
+{
+  int    status;                                  // scl's exit code
+  string listing;                                 // Output file contents
+  string errors;                                  // cerr contents
+}; // WireReply
+
+
+
+// Each function returns false if the connection fails or closes, or a
+// length is over wireLimit. readRequest also returns false, with kind 0,
+// if the connection closes before a request begins.
+
+// connectDaemon connects to the daemon listening on path. Returns the
+// socket, or -1 with why set.
+int connectDaemon(const char *path,                // *In* Socket path
+  string &why);                                    // *Out* Reason if not
+
+bool sendRequest(int fd,                           // *In* Socket
+  WireKind kind,                                   // *In* Request kind
+  const string &text);                             // *In* Source or path
+
+bool readRequest(int fd,                           // *In* Socket
+  char &kind,                                      // *Out* Request kind
+  string &text);                                   // *Out* Source or path
+
+bool sendReply(int fd,                             // *In* Socket
+  const WireReply &reply);                         // *In* Reply
+
+bool readReply(int fd,                             // *In* Socket
+  WireReply &reply);                               // *Out* Reply
+
+
+#endif